@@ -82,7 +82,7 @@ class TwoCanAis {
 public:
 	TwoCanAis();
 	~TwoCanAis(void);
-	bool ParseAisMessage(VDM aisMessage, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
+	bool ParseAisMessage(VDM aisMessage, PayloadWriter *payload, unsigned int *parameterGroupNumber);
 	
 private:
 	// AIS VDM 6bit twiddling routines
@@ -98,17 +98,17 @@ private:
 	std::string GetStringV3(std::vector<bool> binaryData, int start, int length);
 	
 	// AIS Decoding/Encoding routines
-	bool EncodePGN129038(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129039(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129040(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129041(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129793(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129794(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129798(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129801(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129802(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129809(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
-	bool EncodePGN129810(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129038(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129039(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129040(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129041(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129793(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129794(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129798(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129801(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129802(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129809(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
+	bool EncodePGN129810(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber);
 
 	// Array used to re-assemble multi sentence AIS messages
 	// The AIS Sequence Id is the index into the array
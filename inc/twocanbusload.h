@@ -0,0 +1,90 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_BUSLOAD_H
+#define TWOCAN_BUSLOAD_H
+
+// Constants, typedefs and utility functions
+#include "twocanutils.h"
+
+// STL
+#include <mutex>
+
+// NMEA 2000 bit rate, 250 kbit/s
+#define CONST_BUSLOAD_BIT_RATE 250000
+
+// Statistics are accumulated in 100 millisecond buckets, retaining 10 seconds
+#define CONST_BUSLOAD_BUCKET_DURATION 100000
+#define CONST_BUSLOAD_BUCKETS 100
+
+// Sliding windows over which statistics are reported, in buckets
+#define CONST_BUSLOAD_WINDOW_SHORT 10
+#define CONST_BUSLOAD_WINDOW_LONG 100
+
+// Bus load (percent) above which the transmit scheduler slows and the gateway discards non essential sentences
+#define CONST_BUSLOAD_THROTTLE_LIMIT 70
+#define CONST_BUSLOAD_GATEWAY_LIMIT 80
+
+// Statistics for a window, per priority and in total
+typedef struct BusLoadStatistics {
+	double loadPercent;
+	double framesPerSecond;
+	double bytesPerSecond;
+	double priorityFramesPerSecond[8];
+	double priorityBytesPerSecond[8];
+} BusLoadStatistics;
+
+// Estimates the utilisation of the NMEA 2000 network from the frames received and transmitted.
+// Each frame is charged its worst case length, including bit stuffing, which is a pessimistic but safe estimate.
+// Record and the Get functions may be called from any thread.
+class TwoCanBusLoad {
+
+public:
+	TwoCanBusLoad(void);
+	~TwoCanBusLoad(void);
+
+	// Account for a frame, using the CAN Id's priority and the data length
+	void Record(const unsigned int id, const unsigned int dataLength);
+	void Record(const byte *frame);
+
+	// Bus load as a percentage over the window (number of 100 millisecond buckets)
+	double GetLoad(const int window = CONST_BUSLOAD_WINDOW_SHORT);
+
+	// Load, frame and byte rates, total and per priority, over the window
+	void GetStatistics(BusLoadStatistics *statistics, const int window = CONST_BUSLOAD_WINDOW_SHORT);
+
+	// Worst case number of bits on the wire for an extended frame, including stuff bits and interframe space
+	static unsigned int FrameBits(const unsigned int dataLength);
+
+private:
+	typedef struct BusLoadBucket {
+		unsigned long long index;
+		unsigned int bits;
+		unsigned int frames[8];
+		unsigned int bytes[8];
+	} BusLoadBucket;
+
+	BusLoadBucket buckets[CONST_BUSLOAD_BUCKETS];
+	std::mutex bucketMutex;
+
+	// Locate the bucket for the current time, resetting it if stale
+	BusLoadBucket *CurrentBucket(const unsigned long long now);
+};
+
+#endif
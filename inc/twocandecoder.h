@@ -0,0 +1,272 @@
+// Copyright(C) 2018-2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_DECODER_H
+#define TWOCAN_DECODER_H
+
+// Error constants and macros
+#include "twocanerror.h"
+
+// Constants, typedefs and utility functions for bit twiddling and array manipulation for NMEA 2000 messages
+#include "twocanutils.h"
+
+// STL
+// used for AIS stuff
+#include <vector>
+#include <algorithm>
+#include <bitset>
+
+// wxWidgets, only the base library so that the decoder may be linked by the headless converter
+#include <wx/defs.h>
+// String Format, Comparisons etc.
+#include <wx/string.h>
+// For converting NMEA 2000 date & time data
+#include <wx/datetime.h>
+// Logging (Info & Errors)
+#include <wx/log.h>
+
+// Flag of bit values indicating what PGN's are converted
+extern int supportedPGN;
+
+// Used to determine the preferred GPS if multiple sources present (eg. GPS receiver and AIS transceiver)
+typedef struct PreferredGPS {
+	byte sourceAddress;
+	unsigned short hdop;
+	unsigned int hdopRetry;
+	wxDateTime lastUpdate;
+} PreferredGPS;
+
+// Converts NMEA 2000 messages to NMEA 0183 sentences, without any dependency on the OpenCPN plugin API
+// so that it may be used by both the TwoCan device and the headless converter
+class TwoCanDecoder {
+
+public:
+	TwoCanDecoder(void);
+	virtual ~TwoCanDecoder(void);
+
+	// Switch statement to determine which function is called to convert each NMEA 2000 message
+	// Returns TRUE if any NMEA 0183 sentences (without checksums) were appended to nmeaSentences
+	bool DecodeMessage(const CanHeader& header, const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Computes the NMEA 0183 XOR checksum
+	wxString ComputeChecksum(wxString sentence);
+
+protected:
+	// Positions, waypoints & routes that the OpenCPN plugin inserts into its database. By default, ignored
+	virtual void OnManOverboard(const wxString& markName, const double latitude, const double longitude);
+	virtual void OnWaypointReceived(const wxString& waypointName, const double latitude, const double longitude);
+	virtual void OnRouteReceived(const wxString& routeName);
+
+	// The following are stored for use in constructing NMEA 183 sentences from disparate NMEA 2000 messages
+	// Difference between computer time and gps time, used to calculate NMEA 183 RMC sentences
+	wxTimeSpan gpsTimeOffset;
+	// Compass variation, also used in NMEA 183 RMC sentence
+	short magneticVariation;
+	// COG, SOG, again used in NMEA 183 RMC sentence
+	unsigned short vesselCOG;
+	unsigned short vesselSOG;
+	// If Multiple GPS Sources present, automagically prioritise
+	PreferredGPS preferredGPS;
+
+	// Flag to indicate whether vessel has single or multiple engines
+	// Used to format the MAIN, PORT or STBD XDR & RPM NMEA 0183 sentences depending on NMEA 2000 Engine Instance.
+	bool IsMultiEngineVessel;
+
+	// Decode PGN 126992 NMEA System Time
+	bool DecodePGN126992(const byte *payload, std::vector<wxString> *nmeaSentences);
+	
+	// Decode PGN 127233 NMEA Man Overboard 
+	bool DecodePGN127233(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127237 NMEA Heading Track control 
+	bool DecodePGN127237(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127245 NMEA Rudder
+	bool DecodePGN127245(const byte *payload, std::vector<wxString> *nmeaSentences);
+	
+	// Decode PGN 127250 NMEA Vessel Heading
+	bool DecodePGN127250(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127251 NMEA Rate of Turn (ROT)
+	bool DecodePGN127251(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127257 NMEA Attitude
+	bool DecodePGN127257(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127258 NMEA Magnetic Variation
+	bool DecodePGN127258(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127488 NMEA Engine Parameters, Rapid Update
+	bool DecodePGN127488(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127489 NMEA Engine Paramters, Dynamic
+	bool DecodePGN127489(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 127505 NMEA Fluid Levels
+	bool DecodePGN127505(const byte *payload, std::vector<wxString> *nmeaSentences);
+	
+	// Decode PGN 127508 NMEA Battery Status
+	bool DecodePGN127508(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 128259 NMEA Speed & Heading
+	bool DecodePGN128259(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 128267 NMEA Depth
+	bool DecodePGN128267(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 128275 Distance Log
+	bool DecodePGN128275(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129025 NMEA Position Rapid Update
+	bool DecodePGN129025(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
+
+	// Decode PGN 129026 NMEA COG SOG Rapid Update
+	bool DecodePGN129026(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
+
+	// Decode PGN 129029 NMEA GNSS Position
+	bool DecodePGN129029(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
+
+	// Decode PGN 129033 NMEA Date & Time
+	bool DecodePGN129033(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129038 AIS Class A Position Report
+	bool DecodePGN129038(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Deocde PGN 129039 AIS Class B Position Report
+	bool DecodePGN129039(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129040 AIS Class B Extended Position Report
+	bool DecodePGN129040(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129041 AIS Aids To Navigation (AToN) Report
+	bool DecodePGN129041(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129283 NMEA Cross Track Error (XTE)
+	bool DecodePGN129283(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129284 Navigation Data
+	bool DecodePGN129284(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129285 Navigation Route/WP Information
+	bool DecodePGN129285(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129539 GNSS DOP's
+	bool DecodePGN129539(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129540 NMEA GNSS Satellites in view
+	bool DecodePGN129540(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129793 AIS Date and Time report
+	bool DecodePGN129793(const byte * payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129794 AIS Class A Static Data
+	bool DecodePGN129794(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129796 AIS Acknowledge 
+	// Decode PGN 129797 AIS Binary Broadcast Message 
+
+	//	Decode PGN 129798 AIS SAR Aircraft Position Report
+	bool DecodePGN129798(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	//	Decode PGN 129801 AIS Addressed Safety Related Message
+	bool DecodePGN129801(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129802 AIS Safety Related Broadcast Message 
+	bool DecodePGN129802(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129803 AIS Interrogation
+	// Decode PGN 129804 AIS Assignment Mode Command 
+	// Decode PGN 129805 AIS Data Link Management Message 
+	// Decode PGN 129806 AIS Channel Management
+	// Decode PGN 129807 AIS Group Assignment
+
+	// Decode PGN 129808 DSC Message
+	bool DecodePGN129808(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129809 AIS Class B Static Data Report, Part A 
+	bool DecodePGN129809(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 129810 AIS Class B Static Data Report, Part B 
+	bool DecodePGN129810(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130065 Route & Waypoint Service - Route List
+	bool DecodePGN130065(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130074 Route & Waypoint Service - Waypoint List
+	bool DecodePGN130074(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130306 NMEA Wind
+	bool DecodePGN130306(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130310 NMEA Water & Air Temperature and Pressure
+	bool DecodePGN130310(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130311 NMEA Environmental Parameters (supercedes 130310)
+	bool DecodePGN130311(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130312 NMEA Temperature
+	bool DecodePGN130312(const byte *payload, std::vector<wxString> *nmeaSentences);
+	
+	// Decode PGN 130316 NMEA Temperature Extended Range
+	bool DecodePGN130316(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130323 NMEA Meteorological Station Data
+	bool DecodePGN130323(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Decode PGN 130577 NMEA Direction Data
+	bool DecodePGN130577(const byte *payload, std::vector<wxString> *nmeaSentences);
+
+	// Assemnble NMEA 183 VDM & VDO sentences
+	// BUG BUG is this used anywhere ??
+	std::vector<wxString> AssembleAISMessage(const std::vector<bool> binaryPayload, const int messageType);
+
+	// Insert an integer value into AIS 6 bit encoded binary data, prior to AIS encoding
+	void AISInsertInteger(std::vector<bool>& binaryData, int start, int length, int value);
+
+	// Insert a date value into AIS 6 bit encoded binary data, prior to AIS encoding
+	void AISInsertDate(std::vector<bool>& binaryData, int start, int length, int day, int month, int hour, int minute);
+
+	// Insert a string value into AIS 6 bit encoded binary data, prior to AIS encoding
+	void AISInsertString(std::vector<bool>& binaryData, int start, int length, std::string value);
+
+	// Encode an 8 bit ASCII character using NMEA 0183 6 bit encoding
+	char AISEncodeCharacter(char value);
+
+	// Create the NMEA 0183 AIS VDM/VDO payload from the 6 bit encoded binary data
+	wxString AISEncodePayload(std::vector<bool>& binaryData);
+
+	// Just for completeness, in case one day we convert NMEA 183 to NMEA 2000 
+	// and need to decode NMEA183 VDM/VDO messages to NMEA 2000 PGN's
+	// although we may be able to use the OpenCPN WANTS_AIS_SENTENCES setting.
+
+	// Decode an 8 bit ASCII character using NMEA 0183 6 bit encoding
+	char AISDecodeCharacter(char value);
+
+	// Decode the NMEA 0183 AIS VDM/VDO payload to a bit array of 6 bit characters
+	std::vector<bool> AISDecodePayload(wxString SixBitData);
+
+	// AIS VDM Sequential message ID, 0 - 9 used to distinguish multi-sentence NMEA 183 VDM messages
+	int AISsequentialMessageId;
+
+	// Decode table from ITU-R M.825 for DSE Sentences
+	wxString DecodeDSEExpansionCharacters(std::vector<byte> dseData);
+
+};
+
+#endif
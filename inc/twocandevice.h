@@ -39,9 +39,25 @@
 // Constants, typedefs and utility functions for bit twiddling and array manipulation for NMEA 2000 messages
 #include "twocanutils.h"
 
+// Conversion of NMEA 2000 messages to NMEA 0183 sentences
+#include "twocandecoder.h"
+
+// Flight recorder
+#include "twocanrecorder.h"
+
+// Prioritised, paced transmission of frames
+#include "twocanscheduler.h"
+
+// Network utilisation
+#include "twocanbusload.h"
+
+// Maximum number of frames converted from raw messages before they are queued for transmission
+#define CONST_TRANSMIT_BATCH_FRAMES 256
+
 #if defined (__APPLE__) && defined (__MACH__)
 	#include "twocanlogreader.h"
 	#include "twocanpcap.h"
+	#include "twocangenerator.h"
 	#include "twocanmacserial.h"
 	#include "twocanmactoucan.h"
 	#include "twocanmackvaser.h"
@@ -51,7 +67,11 @@
 	// For Linux , "baked in" classes for the Log File reader and SocketCAN interface
 	#include "twocanlogreader.h"
 	#include "twocanpcap.h"
+	#include "twocangenerator.h"
 	#include "twocansocket.h"
+	#include "twocanmultisocket.h"
+	#include "twocannetwork.h"
+	#include "twocanserial.h"
 #endif
 
 // STL
@@ -147,6 +167,17 @@ extern bool enableAutopilot;
 // Whether to Log raw NMEA 2000 messages
 extern int logLevel;
 
+// Flight recorder settings
+extern bool enableRecorder;
+extern int recorderSeconds;
+extern int recorderFormat;
+
+// Traffic generator settings
+extern int generatorRate;
+extern int generatorTargets;
+extern double generatorLoss;
+extern double generatorReorder;
+
 // List of devices discovered on the NMEA 2000 network
 extern NetworkInformation networkMap[CONST_MAX_DEVICES];
 
@@ -184,16 +215,8 @@ typedef struct FastMessageEntry {
 	byte *data; // pointer to memory allocated for the data. Note: must be freed when IsFree is set to TRUE.
 } FastMessageEntry;
 
-// Used to determine the preferred GPS if multiple sources present (eg. GPS receiver and AIS transceiver)
-typedef struct PreferredGPS {
-	byte sourceAddress;
-	unsigned short hdop;
-	unsigned int hdopRetry;
-	wxDateTime lastUpdate;
-} PreferredGPS;
-
 // Implements a NMEA 2000 Network device
-class TwoCanDevice : public wxThread {
+class TwoCanDevice : public wxThread, public TwoCanDecoder {
 
 public:
 	// Constructor and destructor
@@ -205,6 +228,8 @@ public:
 #if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
 	// wxMessage Queue to receive CAN Frames from either the Generic LogFile Reader, SocketCAN interface or Mac OSX Canable Cantact device
 	wxMessageQueue<std::vector<byte>> *canQueue;
+	// Frames received on each interface of a multi interface adapter
+	unsigned long long interfaceFrames[CONST_MAX_INTERFACES];
 #endif
 	// Event raised when a NMEA 2000 message is received and converted to a NMEA 0183 sentence
 	void RaiseEvent(wxString sentence);
@@ -214,16 +239,39 @@ public:
 	int Init(wxString driverPath);
 	int DeInit(void);
 
+#if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
+	// Wake the read thread so that it may be terminated, invoke prior to Delete
+	void Interrupt(void);
+#endif
+
 	// Fragment a fast message into 8 byte messages
 	int FragmentFastMessage(CanHeader *header, unsigned int payloadLength, byte *payload);
-	// Transmit the frame onto the NMEA 2000 network
-	int TransmitFrame(unsigned int id, byte *data);
+	// Queue the frame(s) for transmission onto the NMEA 2000 network, returns immediately
+	int TransmitFrame(unsigned int id, byte *data, const size_t frameCount = 1);
+	// Queue a span of encoded frames for transmission, returns immediately
+	int TransmitFrames(const CanFrame *frames, const size_t frameCount);
+	// Queue messages (autopilot & media player), the frames are queued together so they are transmitted back to back
+	int TransmitMessages(std::vector<CanMessage> *messages);
+	// Queue raw messages from other plugins, in batches of frames, reporting how many messages were queued
+	int TransmitRawMessages(const TwoCanRawMessage *messages, const size_t messageCount, size_t *messagesQueued);
+
+	// Write the flight recorder's recent traffic to disk
+	void TriggerRecorder(const wxString& reason);
+
+	// Estimated network utilisation (percent) and detailed statistics, over the last second or last 10 seconds
+	double GetBusLoad(const int window = CONST_BUSLOAD_WINDOW_SHORT);
+	void GetBusLoadStatistics(BusLoadStatistics *statistics, const int window = CONST_BUSLOAD_WINDOW_SHORT);
 
 protected:
 	// wxThread overridden functions
 	virtual wxThread::ExitCode Entry();
 	virtual void OnExit();
 
+	// TwoCanDecoder overridden functions, insert positions, waypoints & routes into OpenCPN
+	virtual void OnManOverboard(const wxString& markName, const double latitude, const double longitude);
+	virtual void OnWaypointReceived(const wxString& waypointName, const double latitude, const double longitude);
+	virtual void OnRouteReceived(const wxString& routeName);
+
 private:
 	byte canFrame[CONST_FRAME_LENGTH];
 #if defined (__WXMSW__) 
@@ -254,22 +302,22 @@ private:
 	int ReadLinuxOrMacDriver(void);
 #endif
 
+	// Flight recorder, retains recent traffic to be written to disk upon an incident
+	TwoCanRecorder *flightRecorder;
+
+	// Network utilisation, fed from both the receive and transmit paths
+	TwoCanBusLoad busLoad;
+
+	// Transmit scheduler, only present in active mode
+	TwoCanScheduler *transmitScheduler;
+	// Write frames to the CAN adapter, invoked by the transmit scheduler
+	int WriteAdapterFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten);
+
 	// Heartbeat timer
 	wxTimer *heartbeatTimer;
 	void OnHeartbeat(wxEvent &event);
 	byte heartbeatCounter;
 
-	// The following are stored for use in constructing NMEA 183 sentences from disparate NMEA 2000 messages
-	// Difference between computer time and gps time, used to calculate NMEA 183 RMC sentences
-	wxTimeSpan gpsTimeOffset;
-	// Compass variation, also used in NMEA 183 RMC sentence
-	short magneticVariation;
-	// COG, SOG, again used in NMEA 183 RMC sentence
-	unsigned short vesselCOG;
-	unsigned short vesselSOG;
-	// If Multiple GPS Sources present, automagically prioritise
-	PreferredGPS preferredGPS;
-
 	// Statistics
 	int receivedFrames;
 	int transmittedFrames;
@@ -279,10 +327,6 @@ private:
 	// File handle for logging raw frame data
 	wxFile rawLogFile;
 
-	// Flag to indicate whether vessel has single or multiple engines
-	// Used to format the MAIN, PORT or STBD XDR & RPM NMEA 0183 sentences depending on NMEA 2000 Engine Instance.
-	bool IsMultiEngineVessel;
-
 	// Protect simultaneous write operations 
 	std::mutex writeMutex;
 
@@ -343,9 +387,6 @@ private:
 	// Decode PGN 126720 Manufacturer Proprietary Message
 	bool DecodePGN126720(const byte *payload);
 
-	// Decode PGN 126992 NMEA System Time
-	bool DecodePGN126992(const byte *payload, std::vector<wxString> *nmeaSentences);
-	
 	// Decode PGN 126993 NMEA heartbeat
 	bool DecodePGN126993(const int source, const byte *payload);
 
@@ -355,147 +396,6 @@ private:
 	// Decode PGN 126998 NMEA Configuration Information
 	int DecodePGN126998(const byte *payload);
 
-	// Decode PGN 127233 NMEA Man Overboard 
-	bool DecodePGN127233(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127237 NMEA Heading Track control 
-	bool DecodePGN127237(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127245 NMEA Rudder
-	bool DecodePGN127245(const byte *payload, std::vector<wxString> *nmeaSentences);
-	
-	// Decode PGN 127250 NMEA Vessel Heading
-	bool DecodePGN127250(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127251 NMEA Rate of Turn (ROT)
-	bool DecodePGN127251(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127257 NMEA Attitude
-	bool DecodePGN127257(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127258 NMEA Magnetic Variation
-	bool DecodePGN127258(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127488 NMEA Engine Parameters, Rapid Update
-	bool DecodePGN127488(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127489 NMEA Engine Paramters, Dynamic
-	bool DecodePGN127489(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 127505 NMEA Fluid Levels
-	bool DecodePGN127505(const byte *payload, std::vector<wxString> *nmeaSentences);
-	
-	// Decode PGN 127508 NMEA Battery Status
-	bool DecodePGN127508(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 128259 NMEA Speed & Heading
-	bool DecodePGN128259(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 128267 NMEA Depth
-	bool DecodePGN128267(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 128275 Distance Log
-	bool DecodePGN128275(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129025 NMEA Position Rapid Update
-	bool DecodePGN129025(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
-
-	// Decode PGN 129026 NMEA COG SOG Rapid Update
-	bool DecodePGN129026(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
-
-	// Decode PGN 129029 NMEA GNSS Position
-	bool DecodePGN129029(const byte *payload, std::vector<wxString> *nmeaSentences, byte address);
-
-	// Decode PGN 129033 NMEA Date & Time
-	bool DecodePGN129033(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129038 AIS Class A Position Report
-	bool DecodePGN129038(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Deocde PGN 129039 AIS Class B Position Report
-	bool DecodePGN129039(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129040 AIS Class B Extended Position Report
-	bool DecodePGN129040(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129041 AIS Aids To Navigation (AToN) Report
-	bool DecodePGN129041(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129283 NMEA Cross Track Error (XTE)
-	bool DecodePGN129283(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129284 Navigation Data
-	bool DecodePGN129284(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129285 Navigation Route/WP Information
-	bool DecodePGN129285(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129539 GNSS DOP's
-	bool DecodePGN129539(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129540 NMEA GNSS Satellites in view
-	bool DecodePGN129540(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129793 AIS Date and Time report
-	bool DecodePGN129793(const byte * payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129794 AIS Class A Static Data
-	bool DecodePGN129794(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129796 AIS Acknowledge 
-	// Decode PGN 129797 AIS Binary Broadcast Message 
-
-	//	Decode PGN 129798 AIS SAR Aircraft Position Report
-	bool DecodePGN129798(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	//	Decode PGN 129801 AIS Addressed Safety Related Message
-	bool DecodePGN129801(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129802 AIS Safety Related Broadcast Message 
-	bool DecodePGN129802(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129803 AIS Interrogation
-	// Decode PGN 129804 AIS Assignment Mode Command 
-	// Decode PGN 129805 AIS Data Link Management Message 
-	// Decode PGN 129806 AIS Channel Management
-	// Decode PGN 129807 AIS Group Assignment
-
-	// Decode PGN 129808 DSC Message
-	bool DecodePGN129808(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129809 AIS Class B Static Data Report, Part A 
-	bool DecodePGN129809(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 129810 AIS Class B Static Data Report, Part B 
-	bool DecodePGN129810(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130065 Route & Waypoint Service - Route List
-	bool DecodePGN130065(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130074 Route & Waypoint Service - Waypoint List
-	bool DecodePGN130074(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130306 NMEA Wind
-	bool DecodePGN130306(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130310 NMEA Water & Air Temperature and Pressure
-	bool DecodePGN130310(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130311 NMEA Environmental Parameters (supercedes 130310)
-	bool DecodePGN130311(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130312 NMEA Temperature
-	bool DecodePGN130312(const byte *payload, std::vector<wxString> *nmeaSentences);
-	
-	// Decode PGN 130316 NMEA Temperature Extended Range
-	bool DecodePGN130316(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130323 NMEA Meteorological Station Data
-	bool DecodePGN130323(const byte *payload, std::vector<wxString> *nmeaSentences);
-
-	// Decode PGN 130577 NMEA Direction Data
-	bool DecodePGN130577(const byte *payload, std::vector<wxString> *nmeaSentences);
-
 	// Decode Manufacturer Proprietary Fast Message (used by the Fusion Media Player thingy)
 	bool DecodePGN130820(const byte *payload, std::vector<wxString> *nmeaSentences);
 
@@ -529,44 +429,6 @@ private:
 	// Appends '*' and Checksum to NMEA 183 Sentence prior to sending to OpenCPN
 	void SendNMEASentence(wxString sentence);
 
-	// Computes the NMEA 0183 XOR checksum
-	wxString ComputeChecksum(wxString sentence);
-
-	// Assemnble NMEA 183 VDM & VDO sentences
-	// BUG BUG is this used anywhere ??
-	std::vector<wxString> AssembleAISMessage(const std::vector<bool> binaryPayload, const int messageType);
-
-	// Insert an integer value into AIS 6 bit encoded binary data, prior to AIS encoding
-	void AISInsertInteger(std::vector<bool>& binaryData, int start, int length, int value);
-
-	// Insert a date value into AIS 6 bit encoded binary data, prior to AIS encoding
-	void AISInsertDate(std::vector<bool>& binaryData, int start, int length, int day, int month, int hour, int minute);
-
-	// Insert a string value into AIS 6 bit encoded binary data, prior to AIS encoding
-	void AISInsertString(std::vector<bool>& binaryData, int start, int length, std::string value);
-
-	// Encode an 8 bit ASCII character using NMEA 0183 6 bit encoding
-	char AISEncodeCharacter(char value);
-
-	// Create the NMEA 0183 AIS VDM/VDO payload from the 6 bit encoded binary data
-	wxString AISEncodePayload(std::vector<bool>& binaryData);
-
-	// Just for completeness, in case one day we convert NMEA 183 to NMEA 2000 
-	// and need to decode NMEA183 VDM/VDO messages to NMEA 2000 PGN's
-	// although we may be able to use the OpenCPN WANTS_AIS_SENTENCES setting.
-
-	// Decode an 8 bit ASCII character using NMEA 0183 6 bit encoding
-	char AISDecodeCharacter(char value);
-
-	// Decode the NMEA 0183 AIS VDM/VDO payload to a bit array of 6 bit characters
-	std::vector<bool> AISDecodePayload(wxString SixBitData);
-
-	// AIS VDM Sequential message ID, 0 - 9 used to distinguish multi-sentence NMEA 183 VDM messages
-	int AISsequentialMessageId;
-
-	// Decode table from ITU-R M.825 for DSE Sentences
-	wxString DecodeDSEExpansionCharacters(std::vector<byte> dseData);
-
 };
 
 #endif
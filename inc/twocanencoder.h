@@ -30,6 +30,9 @@
 // AIS Decoding/Encoding (also includes the usual twocan & nmea183 includes)
 #include "twocanais.h"
 
+// OpenCPN routes & waypoints for export
+#include "ocpn_plugin.h"
+
 // NMEA 183 GNSS Satellite information
 #include "satinfo.h"
 
@@ -39,6 +42,7 @@
 #include <bitset>
 #include <iostream>
 #include <functional>
+#include <unordered_map>
 //#include <bits/stdc++.h> 
 //#include <typeinfo>
 
@@ -149,6 +153,50 @@ extern int supportedPGN;
 // Whether we can export waypoints from OpenCPN to external NMEA 2000 devices
 extern bool enableWaypoint;
 
+// Period over which PGN's generated by several sentences are coalesced (milliseconds), zero disables coalescing
+extern int gatewayCoalesceWindow;
+
+// A PGN that several NMEA 183 sentences convert to. The first message is sent immediately and opens a window,
+// the latest of any that follow within the window is held until it closes
+typedef struct CoalescedMessage {
+	CanHeader header;
+	PayloadWriter payload;
+	unsigned long long deadline; // Zero when no window is open
+	bool isPending; // Whether a message is held
+} CoalescedMessage;
+
+// Route & waypoint export, longer names are truncated so that several waypoints fit in each message
+#define CONST_EXPORT_NAME_LENGTH 32
+
+// Number of DSC messages that may concurrently await their DSE sentences, eg. a burst of calls from coast stations
+#define CONST_DSC_PENDING_ENTRIES 16
+
+// Period to wait for a DSE sentence before sending the DSC message without it (microseconds)
+#define CONST_DSE_TIMEOUT 2000000ULL
+
+// Timing wheel used to expire DSC messages, the slots must span more than the DSE timeout (tick in microseconds)
+#define CONST_DSC_WHEEL_SLOTS 32
+#define CONST_DSC_WHEEL_TICK 125000ULL
+
+// DSC message (PGN 129808) awaiting the DSE sentence from the same MMSI number.
+// Entries are pooled, a zero deadline indicates the entry is free
+typedef struct PendingDscMessage {
+	unsigned long long mmsiNumber;
+	unsigned long long deadline;
+	int nextEntry; // Next entry in the same slot of the timing wheel, -1 if none
+	PayloadWriter payload;
+} PendingDscMessage;
+
+// Converts a type of NMEA 183 sentence, the parser holds the parsed sentence
+class TwoCanEncoder;
+typedef bool (TwoCanEncoder::*SentenceHandler)(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+
+// Entry in the encoder's dispatch table, a null handler indicates the sentence is recognised but not converted
+typedef struct SentenceDispatch {
+	int sentenceKey;
+	SentenceHandler handler;
+} SentenceDispatch;
+
 // Events passed up to the plugin
 extern const wxEventType wxEVT_SENTENCE_RECEIVED_EVENT;
 
@@ -163,110 +211,124 @@ public:
 	// Reference to event handler address, ie. the TwoCan PlugIn
 	wxEvtHandler *eventHandlerAddress;
 
-	// Raise events to plugin, in particular a dsc sentence that time out waiting for a dse sentence
-	void RaiseEvent(int pgn, std::vector<byte> *data);
-
 	// Validate XDR Transducer Names
 	int GetInstanceNumber(wxString transducerName);
 
-	// Handles DSE sentence receive timeout
-	void OnDseTimerExpired(wxEvent &event);
+	// Handles DSE sentence receive timeout, appends the incomplete PGN 129808 message once the deadline has passed
+	// and the latest value of each coalesced message whose window has closed
+	bool EncodeExpiredMessages(std::vector<CanFrame> *canFrames);
+
+	// Earliest deadline of the pending DSE sentences and held coalesced messages, zero if none
+	unsigned long long GetNextDeadline(void);
 
-	// Fragment fast messages into sequences of messages
-	void FragmentFastMessage(CanHeader *header, std::vector<byte> *payload, std::vector<CanMessage> *canMessages);
+	// Number of messages held for coalescing, most of which were superseded rather than sent
+	unsigned long long coalescedMessagesCount;
+
+	// Fragment fast messages into sequences of frames, unless the message is held for coalescing
+	void FragmentFastMessage(CanHeader *header, PayloadWriter *payload, std::vector<CanFrame> *canFrames);
 
 	// The big switch statement that determines the conversion of 
 	// NMEA 183 sentences to NMEA 2000 messages
-	bool EncodeMessage(wxString sentence, std::vector<CanMessage> *canMessages);
+	// Frames are appended to canFrames, which the caller may reuse to avoid reallocation
+	bool EncodeMessage(wxString sentence, std::vector<CanFrame> *canFrames);
+
+	// Whether EncodeMessage may convert sentences with this key (see NMEA0183_KEY), used to reject other sentences before they are parsed
+	static bool IsEncodable(const int sentenceKey);
+
+	// Route & waypoint export, appends as few payloads as possible and returns the number appended.
+	// Stateless, so may be used by the OpenCPN main thread while the gateway's thread encodes sentences
+	static size_t EncodeWaypointLists(const std::vector<const PlugIn_Waypoint *>& waypoints, std::vector<PayloadWriter> *payloads);
+	static size_t EncodeRouteInformation(const wxString& routeName, const unsigned short routeId, const std::vector<const PlugIn_Waypoint *>& waypoints, std::vector<PayloadWriter> *payloads);
+	static unsigned short GetExportRouteId(const wxString& guid);
 
 	// The following routines convert a NMEA 183 sentence to a NMEA 2000 message
 
 	// Encode PGN 126992 NMEA System Time
-	bool EncodePGN126992(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN126992(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode payload PGN 127233 NMEA Man Overboard (MOB)
-	bool EncodePGN127233(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127233(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127245 NMEA Rudder Angle
-	bool EncodePGN127245(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127245(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127250 NMEA Vessel Heading
-	bool EncodePGN127250(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127250(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127251 NMEA Rate of Turn (ROT)
-	bool EncodePGN127251(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127251(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 1272571 NMEA Attitude
-	bool EncodePGN127257(const short yaw, const short pitch, const short roll, std::vector<byte> *n2kMessage);
+	bool EncodePGN127257(const short yaw, const short pitch, const short roll, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127258 NMEA Magnetic Variation
-	bool EncodePGN127258(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127258(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127488 NMEA Engine Rapid Update
-	bool EncodePGN127488(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN127488(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 127489 NMEA Engine Static Parameters
-	bool EncodePGN127250(const byte engineInstance, const unsigned short oilPressure, const unsigned short engineTemperature, const unsigned short alternatorPotential, std::vector<byte> *n2kMessage);
+	bool EncodePGN127250(const byte engineInstance, const unsigned short oilPressure, const unsigned short engineTemperature, const unsigned short alternatorPotential, PayloadWriter *n2kMessage);
 
 	// Encode PGN 128259 NMEA Speed & Heading
-	bool EncodePGN128259(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN128259(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 128267 NMEA Depth
-	bool EncodePGN128267(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN128267(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 128275 Distance Log
-	bool EncodePGN128275(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN128275(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129025 NMEA Position Rapid Update
-	bool EncodePGN129025(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129025(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129026 NMEA COG SOG Rapid Update
-	bool EncodePGN129026(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129026(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129029 NMEA GNSS Position
-	bool EncodePGN129029(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129029(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129033 NMEA Date & Time
-	bool EncodePGN129033(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129033(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129283 NMEA Cross Track Error (XTE)
-	bool EncodePGN129283(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129283(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129284 Navigation Data
-	bool EncodePGN129284(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129284(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129285 Navigation Route/WP Information
-	bool EncodePGN129285(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129285(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129540 GNSS Satellites in View
-	bool EncodePGN129540(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129540(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 129796 AIS Acknowledge 
 	// Encode PGN 129797 AIS Binary Broadcast Message 
 
 	// Encode PGN 129808 DSC Message
-	bool EncodePGN129808(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN129808(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130074 NMEA Route & Waypoint Service - Waypoint List
-	bool EncodePGN130074(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130074(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130306 NMEA Wind
-	bool EncodePGN130306(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130306(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130310 NMEA Water & Air Temperature and Pressure
-	bool EncodePGN130310(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130310(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130311 NMEA Environmental Parameters (supercedes 130310)
-	bool EncodePGN130311(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130311(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130312 NMEA Temperature
-	bool EncodePGN130312(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130312(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130316 NMEA Temperature Extended Range
-	bool EncodePGN130316(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130316(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 
 	// Encode PGN 130577 NMEA Direction Data
-	bool EncodePGN130577(const NMEA0183 *parser, std::vector<byte> *n2kMessage);
+	bool EncodePGN130577(const NMEA0183 *parser, PayloadWriter *n2kMessage);
 		
 	private:	
 	// NMEA 0183 parser
@@ -285,10 +347,69 @@ public:
 	// BUG BUG Is this used ??
 	NavigationData navigationData;
 
-	//If DSC sentence has a following DSE sentence, wait until it is received or times out, before transmitting PGN 129808 
-	wxTimer *dseTimer;
-	unsigned long long dseMMSINumber;
-	std::vector<byte> dscPayload;
+	// If DSC sentence has a following DSE sentence, wait until it is received or times out, before transmitting PGN 129808 
+	// Pending messages are keyed by MMSI number, each slot of the timing wheel lists the messages that expire during its tick
+	PendingDscMessage pendingDscMessages[CONST_DSC_PENDING_ENTRIES];
+	int dscWheel[CONST_DSC_WHEEL_SLOTS];
+	unsigned long long dscWheelTick;
+
+	int FindPendingDsc(const unsigned long long mmsiNumber);
+	void ArmPendingDsc(const int entry, const unsigned long long deadline);
+	void ReleasePendingDsc(const int entry);
+	static void PutEmptyDseFields(PayloadWriter *payload);
+
+	// Messages held for coalescing, indexed by PGN, and the coalescing period (microseconds)
+	std::unordered_map<unsigned int, CoalescedMessage> coalescedMessages;
+	unsigned long long coalesceWindow;
+
+	// Returns TRUE if the message is held rather than sent now
+	bool CoalesceMessage(const CanHeader *header, const PayloadWriter *payload);
+
+	// Append the frames for a message to the frame arena
+	void AppendFrames(CanHeader *header, PayloadWriter *payload, std::vector<CanFrame> *canFrames);
+
+	// Sentences dispatched by EncodeMessage and accepted by IsEncodable, and their handlers
+	static const SentenceDispatch sentenceDispatch[];
+	static const SentenceDispatch *FindSentenceDispatch(const int sentenceKey);
+	bool EncodeSentenceAPB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceBWC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceBWR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceDBT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceDPT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceDSC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceDSE(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceGGA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceGLL(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceGNS(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceGSA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceGSV(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceHDG(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceHDM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceHDT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceMOB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceMTW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceMWD(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceMWV(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceRMB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceRMC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceROT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceRPM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceRSA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceVDM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceVDR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceVHW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceVLW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceVTG(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceWPL(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceXDR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceXTE(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+	bool EncodeSentenceZDA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence);
+
+	// Route & waypoint export helpers
+	static size_t GetExportNameLength(const wxString& name);
+	static void PutExportName(const wxString& name, PayloadWriter *payload);
+	static void PutExportWaypoint(const unsigned short waypointId, const PlugIn_Waypoint *waypoint, PayloadWriter *payload);
+	static size_t CountExportWaypoints(const std::vector<const PlugIn_Waypoint *>& waypoints, const size_t firstWaypoint, size_t headerLength);
 	
 };
 
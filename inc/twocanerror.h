@@ -20,12 +20,20 @@
 #ifndef TWOCAN_ERROR_H
 #define TWOCAN_ERROR_H
 
+#if defined (TWOCAN_HEADLESS)
+// The headless converter only uses the wxWidgets base library
+#include <wx/defs.h>
+#include <wx/string.h>
+#include <wx/datetime.h>
+#include <wx/log.h>
+#else
 // Pre compiled headers 
 #include "wx/wxprec.h"
 
 #ifndef WX_PRECOMP
 #include <wx/wx.h>
 #endif
+#endif
 
 #if defined (__WXMSW__) 
 	#define WINDOWS_LEAN_AND_MEAN
@@ -124,4 +132,8 @@ void DebugPrintf(wchar_t *fmt, ...);
 #define TWOCAN_ERROR_SOCKET_DOWN 45
 #define TWOCAN_ERROR_SOCKET_WRITE 46
 #define TWOCAN_ERROR_INVALID_WRITE_FUNCTION 47
+#define TWOCAN_ERROR_FILE_MAP 48
+#define TWOCAN_ERROR_TRANSMIT_QUEUE_FULL 49
+#define TWOCAN_ERROR_SOCKET_CONNECT 50
+#define TWOCAN_ERROR_GATEWAY_QUEUE_FULL 51
 #endif
@@ -0,0 +1,170 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_GATEWAY_H
+#define TWOCAN_GATEWAY_H
+
+// Pre compiled headers
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif
+
+// Error constants and macros
+#include "twocanerror.h"
+
+// NMEA 183 to NMEA 2000 conversion
+#include "twocanencoder.h"
+
+// Encode sentences in a background thread
+#include <wx/thread.h>
+
+// Logging (Info & Errors)
+#include <wx/log.h>
+
+// Parse the list of ignored talker id's
+#include <wx/tokenzr.h>
+
+// STL
+#include <atomic>
+#include <vector>
+#include <functional>
+
+// Number of sentences that may be waiting to be encoded, must be a power of two
+#define CONST_GATEWAY_QUEUE_SIZE 256
+
+// Slots held back for safety related sentences (MOB, DSC & DSE) when the queue is nearly full
+#define CONST_GATEWAY_RESERVED_SLOTS 32
+
+// Initial capacity of the frame arena, a sentence typically encodes to a few frames
+#define CONST_GATEWAY_ARENA_FRAMES 256
+
+// Interval at which the worker wakes to check for termination and expired DSC sentences (milliseconds)
+#define CONST_GATEWAY_POLL_INTERVAL 100
+
+// Number of recently sent sentences remembered for echo cancellation, and how long they are remembered (microseconds)
+#define CONST_GATEWAY_ECHO_ENTRIES 64
+#define CONST_GATEWAY_ECHO_WINDOW 2000000
+
+// Default period over which PGN's generated by several sentences are coalesced (milliseconds)
+#define CONST_GATEWAY_COALESCE_WINDOW 250
+
+// Longest sentence accepted by the front end, NMEA 0183 limits sentences to 82 characters although some devices exceed it
+#define CONST_GATEWAY_MAX_SENTENCE 128
+
+// Maximum number of talker id's that may be ignored
+#define CONST_GATEWAY_MAX_TALKERS 16
+
+// Fingerprint of a sentence the plugin has sent to OpenCPN
+typedef struct EchoFingerprint {
+	unsigned int hash;
+	unsigned long long timestamp;
+} EchoFingerprint;
+
+// Transmits a span of encoded frames, either to the transmit scheduler or directly to the adapter
+typedef std::function<int(const CanFrame *frames, const size_t frameCount)> GatewayTransmitFunction;
+
+// Asynchronous NMEA 183 to NMEA 2000 gateway. OpenCPN delivers sentences on its main thread, which copies them
+// into a bounded single producer, single consumer ring and returns immediately. The gateway's thread encodes them
+// into a reusable frame arena and hands each span of frames to the transmit function.
+// When the ring is full, non essential sentences are discarded first, safety related sentences may use the reserved slots.
+class TwoCanGateway : public wxThread {
+
+public:
+	TwoCanGateway(TwoCanEncoder *encoder, GatewayTransmitFunction transmitFunction);
+	~TwoCanGateway(void);
+
+	// Queue a sentence to be encoded, invoked only from the OpenCPN main thread
+	int Enqueue(const wxString& sentence);
+
+	// Safety related sentences (MOB, DSC & DSE) are never throttled and may use the reserved slots
+	static bool IsEssential(const wxString& sentence);
+
+	// Front end, validates the format, checksum and sentence id on a narrow copy of the sentence before any NMEA 0183 parsing.
+	// Rejects corrupt sentences and those the encoder would ignore, invoked only from the OpenCPN main thread
+	bool IsAccepted(const wxString& sentence);
+
+	// Remember a sentence converted from NMEA 2000 and sent to OpenCPN, invoked only from the OpenCPN main thread
+	void RecordOutbound(const wxString& sentence);
+
+	// Whether a sentence received from OpenCPN is an echo of one we sent, or from an ignored talker,
+	// invoked only from the OpenCPN main thread before the sentence is queued
+	bool IsSuppressed(const wxString& sentence);
+
+	// Comma separated list of talker id's whose sentences are not converted, eg. "II,YD"
+	void SetIgnoredTalkers(const wxString& talkerIds);
+
+	// Number of sentences waiting to be encoded
+	size_t GetQueueDepth(void);
+
+protected:
+	// wxThread overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	// The ring, the producer only advances tail and the consumer only advances head
+	wxString sentenceQueue[CONST_GATEWAY_QUEUE_SIZE];
+	std::atomic<size_t> queueHead;
+	std::atomic<size_t> queueTail;
+
+	// Wakes the worker when sentences are queued
+	wxSemaphore queueSemaphore;
+
+	// Converts NMEA 183 sentences, only ever used by the gateway's thread
+	TwoCanEncoder *twoCanEncoder;
+
+	// Frames for each sentence are encoded into this arena, reused to avoid reallocation
+	std::vector<CanFrame> transmitFrames;
+
+	// Performs the actual transmission
+	GatewayTransmitFunction transmitFrameSpan;
+
+	// Ring of fingerprints of the sentences most recently sent to OpenCPN
+	EchoFingerprint echoFingerprints[CONST_GATEWAY_ECHO_ENTRIES];
+	unsigned int echoIndex;
+
+	// Ignored talker id's, the two characters packed into an integer
+	unsigned short ignoredTalkers[CONST_GATEWAY_MAX_TALKERS];
+	unsigned int ignoredTalkerCount;
+
+	// FNV-1a hash of the sentence excluding the trailing line terminator
+	static unsigned int HashSentence(const wxString& sentence);
+
+	// Statistics, overflow counters are updated by the producer
+	std::atomic<unsigned long long> droppedSentences;
+	std::atomic<unsigned long long> droppedEssentialSentences;
+	std::atomic<size_t> highWaterMark;
+	std::atomic<unsigned long long> suppressedEchoes;
+	std::atomic<unsigned long long> suppressedTalkers;
+	std::atomic<unsigned long long> corruptSentences;
+	std::atomic<unsigned long long> ignoredSentences;
+	bool isOverflowing;
+	unsigned long long encodedSentences;
+	unsigned long long failedTransmissions;
+
+	// Encode a sentence and transmit the resulting frames
+	void EncodeSentence(const wxString& sentence);
+
+	// Transmit any DSC message whose DSE sentence has not arrived in time and any coalesced messages that are due
+	void CheckExpiredMessages(void);
+};
+
+#endif
@@ -0,0 +1,148 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_GENERATOR_H
+#define TWOCAN_GENERATOR_H
+
+#include "twocaninterface.h"
+
+// wxMicroSleep
+#include <wx/utils.h>
+
+// STL
+#include <random>
+#include <algorithm>
+
+// Generation interval (milliseconds), frames that fall due within an interval are posted as a single batch
+#define CONST_GENERATOR_TICK 10
+
+// Seed for the random number generator, so that successive runs produce identical traffic
+#define CONST_GENERATOR_SEED 2019
+
+// Defaults, nominal rate (percent), number of AIS targets, frame loss & reordering (percent)
+#define CONST_GENERATOR_RATE 100
+#define CONST_GENERATOR_TARGETS 20
+#define CONST_GENERATOR_MAX_TARGETS 500
+
+// Source addresses of the simulated devices
+#define CONST_GENERATOR_GNSS_ADDRESS 10
+#define CONST_GENERATOR_COMPASS_ADDRESS 11
+#define CONST_GENERATOR_WIND_ADDRESS 12
+#define CONST_GENERATOR_DEPTH_ADDRESS 13
+#define CONST_GENERATOR_ENGINE_ADDRESS 14
+#define CONST_GENERATOR_AIS_ADDRESS 15
+
+// Simulated vessel's starting position (degrees)
+#define CONST_GENERATOR_LATITUDE -33.85
+#define CONST_GENERATOR_LONGITUDE 151.25
+
+// A periodic message and the time (microseconds) at which it is next due
+typedef struct GeneratorSchedule {
+	unsigned int pgn;
+	byte source;
+	byte priority;
+	unsigned long long interval;
+	unsigned long long nextDue;
+	// For AIS messages, the index of the target
+	int target;
+} GeneratorSchedule;
+
+// Simulated AIS target, positioned relative to our own vessel
+typedef struct GeneratorTarget {
+	unsigned int mmsi;
+	bool isClassB;
+	double range; // nautical miles
+	double bearing; // degrees
+	double course; // degrees
+	double speed; // knots
+} GeneratorTarget;
+
+// Synthesises NMEA 2000 traffic without any hardware; position, heading, wind, depth, engine,
+// AIS position & static data for a number of targets and periodic address claims.
+// Intended for reproducible throughput & latency measurements, optionally discarding or reordering frames
+// to exercise the fast message assembly.
+class TwoCanGenerator : public TwoCanInterface {
+
+public:
+	// Constructor and destructor
+	TwoCanGenerator(wxMessageQueue<std::vector<byte>> *messageQueue, const int rate = CONST_GENERATOR_RATE,
+		const int targets = CONST_GENERATOR_TARGETS, const double loss = 0, const double reorder = 0);
+	~TwoCanGenerator(void);
+
+	// TwoCan Interface overridden functions
+	int Open(const wxString& portName);
+	int Close(void);
+	void Read();
+
+protected:
+	// TwoCan Interface overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	// Percentage of the nominal transmission rates
+	int generatorRate;
+	// Probability (percent) that a frame is discarded or is swapped with the following frame
+	double frameLoss;
+	double frameReorder;
+
+	std::vector<GeneratorSchedule> schedule;
+	std::vector<GeneratorTarget> aisTargets;
+
+	// Fast message sequence identifiers, per source address
+	byte sequenceIds[CONST_GLOBAL_ADDRESS];
+
+	// Simulated vessel
+	double latitude;
+	double longitude;
+	double heading;
+	double speed;
+	unsigned long long startTime;
+	unsigned long long updateTime;
+
+	// Reproducible random numbers
+	std::mt19937 randomGenerator;
+	std::uniform_real_distribution<double> percentDistribution;
+
+	// Frame held back to be reordered, valid if frameHeld is true
+	byte heldFrame[CONST_FRAME_LENGTH];
+	bool frameHeld;
+
+	// Statistics
+	unsigned long long generatedFrames;
+	unsigned long long discardedFrames;
+	unsigned long long reorderedFrames;
+
+	// Add a periodic message, interval is at the nominal rate (milliseconds)
+	void AddSchedule(const unsigned int pgn, const byte source, const byte priority, const unsigned int interval, const int target = -1);
+
+	// Advance the simulated vessel & targets to the current time
+	void UpdateVessel(const unsigned long long now);
+
+	// Construct the payload for a scheduled message, returns the payload length
+	unsigned int EncodePayload(const GeneratorSchedule *entry, byte *payload);
+
+	// Convert the message to frames, fragmenting fast messages, and append them to the batch
+	void AppendMessage(const GeneratorSchedule *entry, const byte *payload, const unsigned int payloadLength, std::vector<byte> *postedFrames);
+
+	// Append a single frame to the batch, applying frame loss & reordering
+	void AppendFrame(const byte *frame, std::vector<byte> *postedFrames);
+};
+
+#endif
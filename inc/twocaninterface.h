@@ -68,6 +68,12 @@
 #include <vector>
 
 
+// Adapters serving several CAN interfaces identify the interface a frame was received on using bits 29 & 30 of the frame's
+// 32 bit header (bits 5 & 6 of byte 3), which are otherwise unused as NMEA 2000 uses 29 bit Id's
+#define CONST_INTERFACE_TAG_SHIFT 5
+#define CONST_INTERFACE_TAG_MASK 0x60
+#define CONST_MAX_INTERFACES 4
+
 // abstract class for CAN Adapter interfaces (Mac OSX & Linux Log File Readers, Linux SocketCAN, Mac OSX Serial USB devices such as Canable Cantact)
 class TwoCanInterface : public wxThread {
 
@@ -85,6 +91,14 @@ public:
 	virtual void Read();
 	virtual int Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload);
 	virtual int GetUniqueNumber(unsigned long *uniqueNumber);
+	// Write a batch of frames, by default one at a time using Write
+	virtual int WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten);
+	// Data queued within the adapter awaiting transmission in adapter specific units, zero if unknown
+	virtual int GetTransmitQueueDepth(void);
+	// Wake a blocked Read so that it may exit, invoked prior to Delete. Adapters that poll need not override this
+	virtual void Interrupt(void);
+	// Number of CAN interfaces served by the adapter, used to report per interface statistics
+	virtual int GetInterfaceCount(void);
 	
 	
 protected:
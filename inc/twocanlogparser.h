@@ -0,0 +1,89 @@
+// Copyright(C) 2018-2021 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_LOGPARSER_H
+#define TWOCAN_LOGPARSER_H
+
+#include "twocanutils.h"
+
+// Number of lines sampled from the start of a log file to determine its format
+#define CONST_LOGFILE_SAMPLE_LINES 10
+
+// Supported text log file formats
+// TwoCanRaw    0x01,0x01,0xF8,0x09,0x64,0xD9,0xDF,0x19,0xC7,0xB9,0x0A,0x08
+// CanDump      (1542794024.886119) can0 09F50303#030000FFFF00FFFF
+// Kees         2009-06-18Z09:46:01.129,2,127251,1,255,8,ff,ff,ff,ff,ff,ff,ff,ff
+// SignalK      1588169627365;A;2020-04-29T14:13:47.365Z,2,127251,1,255,8,ff,ff,ff,ff,ff,ff,ff,ff
+// YachtDevices 09:06:35.596 R 09F80203 FF FC 43 1E 00 00 FF FF
+// Note SignalK differs from Kees only in its header, so it is parsed by the Kees parser
+enum LogFileFormat { Undefined, TwoCanRaw, CanDump, Kees, YachtDevices };
+
+// Hand written, single pass scanners for each of the text log file formats.
+// Each parser works directly on the raw character buffer (which need not be null terminated),
+// and on success populates a 12 byte TwoCan frame, 4 byte header (LSB first) followed by 8 data bytes.
+// Shared by the log file reader and any other adapter that receives these formats as text.
+class TwoCanLogParser {
+
+public:
+	// Determine which log file format a single line conforms to
+	static int DetectFormat(const char *line, const size_t length);
+
+	// Dispatch to the parser for the given format
+	static bool ParseLine(const int format, const char *line, const size_t length, byte *frame);
+
+	// Parse each of the different log file formats
+	static bool ParseTwoCan(const char *line, const size_t length, byte *frame);
+	static bool ParseCanDump(const char *line, const size_t length, byte *frame);
+	static bool ParseKees(const char *line, const size_t length, byte *frame);
+	static bool ParseYachtDevices(const char *line, const size_t length, byte *frame);
+
+	// Actisense N2K ASCII, A173321.107 23FF7 1F513 012F3070002F30709F
+	// Unlike the frame based formats each line is a complete message, which for fast messages may exceed 8 bytes
+	static bool ParseActisense(const char *line, const size_t length, CanHeader *header, byte *payload, unsigned int *payloadLength);
+
+	// Lookup table mapping an ASCII character to its hexadecimal value, 0xFF if not a hex digit
+	static const byte hexTable[256];
+
+	// Decode a pair of hexadecimal characters, returns false if either character is not a hex digit
+	static inline bool DecodeHexByte(const char *pair, byte *value) {
+		byte high = hexTable[(byte)pair[0]];
+		byte low = hexTable[(byte)pair[1]];
+		*value = (high << 4) | low;
+		return ((high | low) & 0xF0) == 0;
+	}
+
+private:
+	// Parse an unsigned decimal number, advances the cursor past the digits
+	static bool ScanDecimal(const char **cursor, const char *end, unsigned int *value);
+	// Parse an unsigned hexadecimal number, advances the cursor past the digits
+	static bool ScanHex(const char **cursor, const char *end, unsigned int *value);
+	// Skip past the next occurrence of the delimiter
+	static bool SkipPast(const char **cursor, const char *end, const char delimiter);
+	// Checks that the characters match a digit/punctuation template such as "99:99:99.999"
+	static bool MatchTemplate(const char *line, const size_t length, const char *pattern);
+	// Encode a 32 bit CAN Id into the first four bytes of the frame, LSB first
+	static inline void EncodeId(const unsigned int id, byte *frame) {
+		frame[0] = id & 0xFF;
+		frame[1] = (id >> 8) & 0xFF;
+		frame[2] = (id >> 16) & 0xFF;
+		frame[3] = (id >> 24) & 0xFF;
+	}
+};
+
+#endif
@@ -22,13 +22,15 @@
 
 #include "twocaninterface.h"
 
+// Hand written log file format parsers
+#include "twocanlogparser.h"
+
+// Memory mapped file access
+#include "twocanmappedfile.h"
+
+// Maximum length of a line in a log file
+#define CONST_LOGFILE_MAX_LINE 1024
 
-#define CONST_TWOCAN_REGEX "^0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2}),0x([0-9A-Fa-f]{2})"
-#define CONST_CANDUMP_REGEX "^\\([0-9]+.[0-9]+\\)\\s(slcan|vcan|can)[0-9]\\s([0-9A-F]{8})#([0-9A-F]{16})"
-#define CONST_KEES_REGEX "^[0-9]{4}-[0-9]{2}-[0-9]{2}[TZ][0-9]{2}:[0-9]{2}:[0-9]{2}.[0-9]{3},([0-9]),([0-9]{5,6}),([0-9]+),([0-9]+),([0-9]),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2})"
-#define CONST_YACHTDEVICES_REGEX "^[0-9]{2}:[0-9]{2}:[0-9]{2}.[0-9]{3}\\sR\\s([0-9A-F]{8})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})[\\s]([0-9A-F]{2})"
-#define CONST_SIGNALK_REGEX "^[0-9]{13};A;[0-9]{4}-[0-9]{2}-[0-9]{2}[TZ][0-9]{2}:[0-9]{2}:[0-9]{2}.[0-9]{3}Z,([0-9]),([0-9]{5,6}),([0-9]+),([0-9]+),([0-9]),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2}),([0-9A-Fa-f]{2})"
-enum LogFileFormat { Undefined, TwoCanRaw, CanDump, Kees, YachtDevices};
 
 // Implements the generic log file reader on Linux & Mac OSX devices
 class TwoCanLogReader : public TwoCanInterface {
@@ -46,13 +48,8 @@ public:
 	int Close(void);
 	void Read();
 
-	// Detect which log file format is used
-	int TestFormat(std::string line);
-	// Parse each of the different log file formats
-	void ParseTwoCan(std::string str);
-	void ParseCanDump(std::string str);
-	void ParseKees(std::string str);
-	void ParseYachtDevices(std::string str);
+	// Detect which log file format is used, by sampling the first few lines
+	int TestFormat(void);
 	
 protected:
 	// TwoCan Interface overridden functions
@@ -64,10 +61,15 @@ private:
 	int logFileFormat;
 	// Full path of the log file, fileName appended to the user's documents directory
 	wxString logFileName;
-	// File stream used to read lines from the log file
-	std::ifstream logFileStream;
-	// Regular expression to parse the log file format
-	wxRegEx twoCanRegEx;
+	// Memory mapped log file and the offset of the next line to be read
+	TwoCanMappedFile logFile;
+	unsigned long long readOffset;
+	// Count of lines longer than CONST_LOGFILE_MAX_LINE, which are discarded
+	unsigned long long malformedLines;
+	// Returns the next line in place, without the line terminator. Returns false at the end of the file
+	bool NextLine(const char **line, size_t *length);
+	// Advance past the remainder of an overlong line
+	bool SkipLine(void);
 };
 
 #endif
@@ -0,0 +1,76 @@
+// Copyright(C) 2018-2021 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_MAPPEDFILE_H
+#define TWOCAN_MAPPEDFILE_H
+
+#include "twocanerror.h"
+#include "twocanutils.h"
+
+// Memory mapping
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Size of the window of the file that is mapped at any one time. 
+// Allows files much larger than physical memory (or the address space on 32 bit systems) to be read
+#define CONST_MMAP_WINDOW_SIZE (64 * 1024 * 1024)
+
+// Size of the region ahead of the current read position that the kernel is asked to prefetch
+#define CONST_MMAP_PREFETCH_SIZE (4 * 1024 * 1024)
+
+// Read only, windowed memory mapped file used by the log file & pcap readers
+// Records are accessed in place, the returned pointer remains valid until the next call to Map
+class TwoCanMappedFile {
+
+public:
+	TwoCanMappedFile(void);
+	~TwoCanMappedFile(void);
+
+	// Open and close the file
+	int Open(const wxString& fileName);
+	void Close(void);
+	bool IsOpen(void) const { return fileDescriptor != -1; }
+
+	// Total size of the file
+	unsigned long long Size(void) const { return fileSize; }
+
+	// Returns a pointer to length bytes at the given file offset, remapping the window if required.
+	// The returned length may be less than requested if the end of the file is reached.
+	// Returns NULL if the region cannot be mapped
+	const byte *Map(const unsigned long long offset, size_t *length);
+
+private:
+	int fileDescriptor;
+	unsigned long long fileSize;
+	// Currently mapped window
+	byte *windowAddress;
+	unsigned long long windowOffset;
+	size_t windowLength;
+	// Offset up to which the kernel has been asked to prefetch
+	unsigned long long prefetchOffset;
+	// Mapping offsets must be multiples of the page size
+	unsigned long long pageSize;
+	
+	int MapWindow(const unsigned long long offset);
+	void UnmapWindow(void);
+};
+
+#endif
@@ -0,0 +1,73 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_MULTISOCKET_H
+#define TWOCAN_MULTISOCKET_H
+
+#include "twocansocket.h"
+
+#include <vector>
+
+// Parse the list of interface names
+#include <wx/tokenzr.h>
+
+// Duplicate detection, a frame received on one interface is a duplicate if an identical frame
+// was received on another interface within the window (microseconds)
+#define CONST_DEDUP_TABLE_SIZE 1024
+#define CONST_DEDUP_WINDOW 20000
+
+// Implements a reader for several SocketCAN interfaces (eg. separate instrument & engine buses),
+// merging their frames into the single TwoCan Device queue. Each frame is tagged with the index of its interface
+// and frames bridged onto more than one of the buses are only posted once.
+// Frames are transmitted on the first interface.
+class TwoCanMultiSocket : public TwoCanSocket {
+
+public:
+	TwoCanMultiSocket(wxMessageQueue<std::vector<byte>> *messageQueue);
+	~TwoCanMultiSocket(void);
+
+	// Open a comma separated list of interfaces, eg. "can0,can1"
+	int Open(const wxString& portNames);
+	int Close(void);
+	void Read();
+	int GetInterfaceCount(void);
+
+protected:
+	// Discards duplicates of frames received on another interface
+	bool AcceptFrame(const byte *frame, const int interfaceIndex);
+
+private:
+	// One socket per interface
+	std::vector<int> canSockets;
+	std::vector<wxString> interfaceNames;
+
+	// Recently received frames, indexed by their hash
+	typedef struct DedupEntry {
+		unsigned long long hash;
+		unsigned long long timestamp;
+		int interfaceIndex;
+	} DedupEntry;
+
+	DedupEntry dedupTable[CONST_DEDUP_TABLE_SIZE];
+	unsigned long long duplicateFrames;
+
+	bool IsDuplicate(const byte *frame, const int interfaceIndex, const unsigned long long now);
+};
+
+#endif
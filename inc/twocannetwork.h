@@ -0,0 +1,142 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_NETWORK_H
+#define TWOCAN_NETWORK_H
+
+#include "twocaninterface.h"
+
+// Reuse the log file format scanners
+#include "twocanlogparser.h"
+
+// Sockets
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// STL
+#include <unordered_map>
+#include <mutex>
+
+// Receive buffer, holds any partial line carried over from the previous read
+#define CONST_NETWORK_BUFFER_SIZE 65536
+
+// Maximum number of UDP datagrams read in a single recvmmsg call and the maximum size of each datagram
+#define CONST_NETWORK_DATAGRAMS 16
+#define CONST_NETWORK_DATAGRAM_SIZE 1500
+
+// Interval between attempts to reconnect a TCP gateway (milliseconds)
+#define CONST_NETWORK_RECONNECT 2000
+
+// Longest line that may be written, Actisense ASCII encoding of a maximum length fast message
+#define CONST_NETWORK_MAX_LINE 512
+
+// Network gateway protocols, selected by the prefix of the adapter name
+// udp://host:port        Yacht Devices RAW over UDP (eg. YDWG-02, YDEN-02)
+// tcp://host:port        Yacht Devices RAW over TCP
+// actisense://host:port  Actisense N2K ASCII over TCP (eg. W2K-1)
+enum NetworkProtocol { NetworkYachtDevicesUdp, NetworkYachtDevicesTcp, NetworkActisenseTcp };
+
+// Outgoing fast message being reassembled for gateways that accept complete messages
+typedef struct NetworkMessage {
+	unsigned int length;
+	unsigned int cursor;
+	byte data[CONST_MAX_FAST_PACKET_LENGTH];
+} NetworkMessage;
+
+// Implements Ethernet/WiFi NMEA 2000 gateways on Linux.
+// Sockets are non blocking, the read thread waits in poll until data arrives or Interrupt signals the shutdown event.
+// Each read drains as much data as is available and the lines are parsed in place in the receive buffer.
+class TwoCanNetwork : public TwoCanInterface {
+
+public:
+	// Constructor and destructor
+	TwoCanNetwork(wxMessageQueue<std::vector<byte>> *messageQueue);
+	~TwoCanNetwork(void);
+
+	// TwoCan Interface overridden functions
+	int Open(const wxString& portName);
+	int Close(void);
+	void Read();
+	int Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload);
+	int WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten);
+	int GetUniqueNumber(unsigned long *uniqueNumber);
+	void Interrupt(void);
+
+	// Whether the adapter name refers to a network gateway
+	static bool IsNetworkAdapter(const wxString& portName);
+
+protected:
+	// TwoCan Interface overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	int protocol;
+	wxString hostName;
+	unsigned short portNumber;
+	struct sockaddr_storage gatewayAddress;
+	socklen_t gatewayAddressLength;
+
+	int networkSocket;
+	int shutdownEvent;
+	// Serialises replacing the socket on reconnection with writes from the device thread
+	std::mutex socketMutex;
+
+	// Received data, lines are parsed in place, a trailing partial line is moved to the start of the buffer
+	char receiveBuffer[CONST_NETWORK_BUFFER_SIZE];
+	size_t receiveLength;
+
+	// Fast message sequence identifiers (per source address) for Actisense messages that are fragmented into frames
+	byte sequenceIds[CONST_GLOBAL_ADDRESS + 1];
+
+	// Outgoing fast messages being reassembled for Actisense, indexed by CAN Id, guarded by the socket mutex
+	std::unordered_map<unsigned int, NetworkMessage> outgoingMessages;
+
+	// Statistics
+	unsigned long long receivedLines;
+	unsigned long long invalidLines;
+	unsigned int reconnections;
+
+	// Resolve the gateway address and create the socket, for TCP connect to the gateway
+	int Connect(void);
+	void Disconnect(void);
+
+	// Wait for the socket to become readable or the shutdown event to be signalled, returns false if shutting down
+	bool WaitForData(const int timeout);
+
+	// Parse each complete line in the buffer, appending the frames to be posted, returns the number of bytes consumed
+	size_t ParseLines(const char *buffer, const size_t length, std::vector<byte> *postedFrames);
+	void ParseLine(const char *line, const size_t length, std::vector<byte> *postedFrames);
+
+	// Encode a frame (or for Actisense, a completed message) as a line of text, returns the length of the line.
+	// Invoked with the socket mutex held
+	size_t EncodeFrame(const CanFrame *frame, char *line);
+
+	// Send the encoded lines to the gateway, invoked with the socket mutex held
+	int SendLines(const char *lines, const size_t length);
+};
+
+#endif
@@ -17,16 +17,55 @@
 //
 // NMEA2000® is a registered Trademark of the National Marine Electronics Association
 
+
 #ifndef TWOCAN_PCAP_H
 #define TWOCAN_PCAP_H
 
 #include "twocaninterface.h"
 
+// Memory mapped file access
+#include "twocanmappedfile.h"
+
 
 #define PCAP_FILE_HEADER_LENGTH 24
 #define PCAP_PACKET_HEADER_LENGTH 16
 //Refer to pcap-common.c
 #define LINKTYPE_CAN_SOCKETCAN  227
+// SocketCAN flag indicating a 29 bit extended frame
+#define PCAP_CAN_EFF_FLAG 0x80
+// SocketCAN frame header (can_id, can_dlc & padding) precedes the data
+#define PCAP_CAN_HEADER_LENGTH 8
+// Sanity check for corrupt packet headers
+#define PCAP_MAX_PACKET_LENGTH 0x40000
+
+// Classic pcap magic numbers, microsecond and nanosecond resolution, as read on a little endian file
+#define PCAP_MAGIC_MICROSECONDS 0xA1B2C3D4
+#define PCAP_MAGIC_NANOSECONDS 0xA1B23C4D
+#define PCAP_MAGIC_MICROSECONDS_SWAPPED 0xD4C3B2A1
+#define PCAP_MAGIC_NANOSECONDS_SWAPPED 0x4D3CB2A1
+
+// pcapng, refer to https://www.ietf.org/archive/id/draft-tuexen-opsawg-pcapng-03.html
+#define PCAPNG_BLOCK_HEADER_LENGTH 8
+#define PCAPNG_MIN_BLOCK_LENGTH 12
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_BYTE_ORDER_MAGIC_SWAPPED 0x4D3C2B1A
+// Block types
+#define PCAPNG_SECTION_HEADER_BLOCK 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK 1
+#define PCAPNG_SIMPLE_PACKET_BLOCK 3
+#define PCAPNG_ENHANCED_PACKET_BLOCK 6
+// Interface Description Block options
+#define PCAPNG_OPTION_END 0
+#define PCAPNG_OPTION_IF_TSRESOL 9
+
+// Maximum number of frames posted to the TwoCan device in a single message
+#define PCAP_BATCH_FRAMES 64
+// Maximum capture time spanned by the frames posted in a single message (microseconds)
+#define PCAP_BATCH_INTERVAL 50000
+// Gaps in the capture longer than this are not replayed (microseconds)
+#define PCAP_MAX_REPLAY_GAP 1000000
+// Longest single sleep while waiting for a frame to be due, so that a request to exit is not delayed (milliseconds)
+#define PCAP_REPLAY_SLEEP_SLICE 100
 
 // Can Frame format used in Pcap
 typedef struct PcapCanFrame {
@@ -36,8 +75,66 @@ byte reserved[3]; // 3 bytes reserved to pad to 8 byte boundary
 byte   data[8];
 } PcapCanFrame;
 
+// pcapng interface, as described by an Interface Description Block
+typedef struct PcapInterface {
+	unsigned int linkType;
+	// Timestamp units per second, from the if_tsresol option (defaults to microseconds)
+	double unitsPerSecond;
+} PcapInterface;
+
+// Result of reading the next packet from a pcap or pcapng file
+enum PcapPacketResult { PcapPacketFrame, PcapPacketSkip, PcapPacketEnd };
+
+// Walks the packets in a classic pcap or pcapng file, in place, from a memory mapped file
+// Independent of the adapter thread so that it can also be used by the offline converter
+class TwoCanPcapFile {
+
+public:
+	TwoCanPcapFile(void);
+	~TwoCanPcapFile(void);
+
+	// Open the file and validate the file header
+	int Open(const wxString& fileName);
+	void Close(void);
+	bool IsOpen(void) const { return logFile.IsOpen(); }
+
+	// Position the cursor at the first packet
+	void Rewind(void);
+
+	// Read the next packet, on success frame contains a TwoCan frame and timestamp is in microseconds
+	int NextPacket(byte *frame, unsigned long long *timestamp);
+
+	// Convert a SocketCAN packet to a TwoCan frame, returns false if not a 29 bit extended frame
+	static bool DecodePacket(const byte *packetData, const unsigned int packetLength, byte *frame);
+
+private:
+	TwoCanMappedFile logFile;
+	unsigned long long readOffset;
+	bool isPcapNg;
+	// File was written on a host with the opposite byte order
+	bool isSwapped;
+	// Classic pcap, timestamp fraction units per second
+	double unitsPerSecond;
+	// Classic pcap, link type from the file header
+	unsigned int linkType;
+	// pcapng, interfaces in the current section
+	std::vector<PcapInterface> interfaces;
+	// pcapng, most recent timestamp, used for Simple Packet Blocks which have no timestamp
+	unsigned long long lastTimestamp;
+
+	int NextPcapPacket(byte *frame, unsigned long long *timestamp);
+	int NextPcapNgPacket(byte *frame, unsigned long long *timestamp);
+	void ParseInterfaceDescription(const byte *body, const unsigned int bodyLength);
 
-// Implements the generic log file reader on Linux & Mac OSX devices
+	unsigned short Read16(const byte *buf) const {
+		return isSwapped ? (buf[0] << 8) | buf[1] : buf[0] | (buf[1] << 8);
+	}
+	unsigned int Read32(const byte *buf) const {
+		return isSwapped ? (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3] : buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
+	}
+};
+
+// Implements the pcap & pcapng log file reader on Linux & Mac OSX devices
 class TwoCanPcap : public TwoCanInterface {
 
 public:
@@ -45,9 +142,6 @@ public:
 	TwoCanPcap(wxMessageQueue<std::vector<byte>> *messageQueue);
 	~TwoCanPcap(void);
 
-	// Raw CAN Frames
-	byte canFrame[CONST_FRAME_LENGTH];
-
 	// TwoCan Interface overridden functions
 	int Open(const wxString& fileName);
 	int Close(void);
@@ -62,9 +156,8 @@ protected:
 private:
 	// Full path of the pcap log file, fileName appended to the user's documents directory
 	wxString logFileName;
-	// File stream used to read lines from the log file
-	std::ifstream logFileStream;
-	
+	// pcap or pcapng file
+	TwoCanPcapFile pcapFile;
 };
 
 #endif
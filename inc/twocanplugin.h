@@ -39,8 +39,9 @@
 // Icons Use png2wx.pl perl script to convert png images to wxWidgets memory streams
 #include "twocanicons.h"
 
-// NMEA 183 to NMEA 2000 Encoding
+// NMEA 183 to NMEA 2000 Encoding, performed by the gateway's thread
 #include "twocanencoder.h"
+#include "twocangateway.h"
 
 // BUG BUG check which wxWidget includes we really need
 // Arrays of Strings
@@ -58,6 +59,26 @@
 #include <wx/jsonreader.h>
 #include <wx/jsonwriter.h>
 
+// Payloads of TWOCAN_TRANSMIT_FRAMES messages may be base64 encoded
+#include <wx/base64.h>
+
+// Serialises the transmit function invoked by other plugins with the device being stopped or started
+#include <mutex>
+
+// Exported messages waiting for space in the transmit queue
+#include <deque>
+
+// Interval at which exported messages that did not fit in the transmit queue are resubmitted (milliseconds),
+// and the number of consecutive attempts without any progress after which the export is abandoned
+#define CONST_EXPORT_RETRY_INTERVAL 100
+#define CONST_EXPORT_RETRY_LIMIT 100
+
+// An exported waypoint list (PGN 130074) or route (PGN 129285) message waiting to be queued for transmission
+typedef struct ExportMessage {
+	unsigned int pgn;
+	PayloadWriter payload;
+} ExportMessage;
+
 // Plugin receives FrameReceived events from the TwoCan device
 const wxEventType wxEVT_SENTENCE_RECEIVED_EVENT = wxNewEventType();
 // Globally accessible variables used by the plugin, device and the settings dialog.
@@ -79,6 +100,10 @@ bool enableHeartbeat;
 bool enableWaypoint;
 // If we are in active mode whether we act as a bidirectional gateway, converting NMEA183 to NMEA2000
 bool enableGateway;
+// Comma separated talker id's whose NMEA 183 sentences the gateway does not convert
+wxString gatewayIgnoredTalkers;
+// Period over which the gateway coalesces PGN's generated by several sentences (milliseconds)
+int gatewayCoalesceWindow;
 // If we act as a SignalK server
 bool enableSignalK;
 // If we can control a Fusion Media Player
@@ -87,6 +112,15 @@ bool enableMusic;
 int autopilotModel; 
 // If any logging is to be performed and in what format (twocan raw, candump, canboat, yacht devices or csv)
 int logLevel;
+// Whether the flight recorder retains recent traffic, the number of seconds retained and the recording format (pcap or binary)
+bool enableRecorder;
+int recorderSeconds;
+int recorderFormat;
+// Traffic generator settings, percentage of nominal rates, number of AIS targets, frame loss & reordering (percent)
+int generatorRate;
+int generatorTargets;
+double generatorLoss;
+double generatorReorder;
 // A 29bit number that uniqiuely identifies the TwoCan device if it is an Active Device
 unsigned long uniqueId;
 // A 1 byte CAN bus network address for this device if it is an Active device (0-253)
@@ -154,10 +188,35 @@ private:
 
 	// TwoCanEncoder is used to convert NMEA 183 sentences to NMEA 2000 messages 
 	TwoCanEncoder *twoCanEncoder;
+
+	// Transmit exported waypoints (PGN 130074) and routes (PGN 129285)
+	int TransmitExportPayloads(const std::vector<PayloadWriter>& payloads, const size_t waypointListCount);
+
+	// A long route exceeds the transmit queue, the messages that did not fit are resubmitted by the timer as the queue drains
+	std::deque<ExportMessage> exportMessages;
+	wxTimer *exportTimer;
+	unsigned int exportRetries;
+	int SubmitExportMessages(void);
+	void OnExportTimer(wxTimerEvent &event);
+	void StopExport(void);
+
+	// Transmit function returned to co-loaded plugins, see TwoCanTransmitFunction
+	static int TransmitRawMessages(const TwoCanRawMessage *messages, const size_t messageCount, size_t *messagesQueued);
+
+	// Decode the hexadecimal "data" or base64 "base64" payload of a TWOCAN_TRANSMIT_FRAMES message
+	static bool DecodeRawPayload(wxJSONValue &message, PayloadWriter *payload);
+
+	// TwoCanGateway owns the use of the encoder, sentences are queued to it and encoded on its thread
+	TwoCanGateway *twoCanGateway;
+	void StopGateway(void);
 		
 	// Prevent events occurring whilst in process of shutting down. 
 	// ie. the rug has been pulled from underneath us.
 	bool isRunning;
+
+	// Gateway is discarding non essential sentences as the network is busy
+	bool isGatewayThrottled;
+	unsigned int throttledSentences;
 };
 
 #endif 
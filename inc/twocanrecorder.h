@@ -0,0 +1,124 @@
+// Copyright(C) 2018-2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+
+#ifndef TWOCAN_RECORDER_H
+#define TWOCAN_RECORDER_H
+
+// Pre compiled headers 
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif
+
+// Error constants and macros
+#include "twocanerror.h"
+
+// Constants, typedefs and utility functions
+#include "twocanutils.h"
+
+// Dump the recording in a background thread
+#include <wx/thread.h>
+
+// Logging (Info & Errors)
+#include <wx/log.h>
+
+// Recording file
+#include <wx/file.h>
+
+// User's paths/documents folder
+#include <wx/stdpaths.h>
+
+// For path separator
+#include <wx/filename.h>
+
+// STL
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+// Default number of seconds of traffic retained prior to a trigger
+#define CONST_RECORDER_SECONDS 60
+
+// Number of seconds of traffic recorded after a trigger
+#define CONST_RECORDER_POST_TRIGGER 5
+
+// Approximately the maximum frame rate of a fully loaded 250 kbit/s NMEA 2000 network, used to size the ring buffer
+#define CONST_RECORDER_MAX_FRAME_RATE 2000
+
+// Recording file formats, pcap (LINKTYPE_CAN_SOCKETCAN) or binary (8 byte timestamp in microseconds followed by the 12 byte TwoCan frame)
+enum RecorderFormat { RecorderPcap, RecorderBinary };
+
+// Frames retained in the ring buffer
+typedef struct RecorderFrame {
+	unsigned long long timestamp;
+	byte frame[CONST_FRAME_LENGTH];
+} RecorderFrame;
+
+// Flight recorder. Retains the most recent frames in a ring buffer, which is written to disk when triggered by an incident.
+// Record is invoked from the device's receive thread and never blocks. Triggers may be raised from any thread, 
+// the recording is written by the recorder's own thread.
+class TwoCanRecorder : public wxThread {
+
+public:
+	TwoCanRecorder(const int seconds, const int format);
+	~TwoCanRecorder(void);
+
+	// Add a received frame to the ring buffer. Only to be called from a single (the receive) thread.
+	void Record(const byte *frame) {
+		unsigned long long index = writeIndex.load(std::memory_order_relaxed);
+		RecorderFrame *entry = &ringBuffer[index % ringCapacity];
+		entry->timestamp = TwoCanUtils::GetTimeInMicroseconds();
+		memcpy(entry->frame, frame, CONST_FRAME_LENGTH);
+		writeIndex.store(index + 1, std::memory_order_release);
+	}
+
+	// Request the recording be written to disk, triggers raised while a recording is pending are coalesced
+	void Trigger(const wxString& reason);
+
+protected:
+	// wxThread overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	// Ring buffer
+	std::vector<RecorderFrame> ringBuffer;
+	unsigned long long ringCapacity;
+	// Total number of frames recorded, the next entry to be written is writeIndex % ringCapacity
+	std::atomic<unsigned long long> writeIndex;
+
+	int recordSeconds;
+	int recordFormat;
+
+	// Signals the recorder thread that a trigger has been raised
+	wxSemaphore triggerSemaphore;
+	wxMutex triggerMutex;
+	wxString triggerReason;
+	bool isTriggered;
+
+	// Copy the ring buffer and write it to disk
+	int Dump(const wxString& reason);
+	void AppendPcapHeader(std::vector<byte> *buffer);
+	void AppendPcapFrame(std::vector<byte> *buffer, const RecorderFrame *recorderFrame);
+	void AppendBinaryFrame(std::vector<byte> *buffer, const RecorderFrame *recorderFrame);
+};
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_SCHEDULER_H
+#define TWOCAN_SCHEDULER_H
+
+// Pre compiled headers
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif
+
+// Error constants and macros
+#include "twocanerror.h"
+
+// Constants, typedefs and utility functions
+#include "twocanutils.h"
+
+// Throttle transmissions when the network is busy
+#include "twocanbusload.h"
+
+// Transmit frames in a background thread
+#include <wx/thread.h>
+
+// Logging (Info & Errors)
+#include <wx/log.h>
+
+// wxMicroSleep
+#include <wx/utils.h>
+
+// STL
+#include <deque>
+#include <functional>
+
+// Number of CAN priorities, 0 (highest) to 7 (lowest)
+#define CONST_SCHEDULER_PRIORITIES 8
+
+// Percentage of the 250 kbit/s bus capacity that our own transmissions may occupy
+#define CONST_SCHEDULER_TARGET_LOAD 25
+
+// Approximate duration of an extended frame with an 8 byte payload, including bit stuffing and interframe space, at 250 kbit/s
+#define CONST_SCHEDULER_FRAME_TIME 600
+
+// Number of frames that may be sent back to back after the scheduler has been idle
+#define CONST_SCHEDULER_BURST 4
+
+// Maximum number of frames queued across all priorities
+#define CONST_SCHEDULER_MAX_FRAMES 2048
+
+// Writes a batch of frames to the CAN adapter, returning the number actually written
+typedef std::function<int(const CanFrame *frames, const size_t frameCount, size_t *framesWritten)> SchedulerWriteFunction;
+
+// Asynchronous transmit scheduler. Callers enqueue frames and return immediately, the scheduler's thread
+// transmits them highest CAN priority first, paced to a target bus load rather than by fixed delays.
+// Frames of the same priority are transmitted in the order in which they were queued, so fast message frames remain in sequence.
+// Frames that are due are written to the adapter as a batch, up to the permitted burst.
+class TwoCanScheduler : public wxThread {
+
+public:
+	TwoCanScheduler(SchedulerWriteFunction writeFunction, const int targetLoad, TwoCanBusLoad *networkLoad = nullptr);
+	~TwoCanScheduler(void);
+
+	// Queue one or more consecutive 8 byte payloads sharing the same CAN Id, either all are queued or none are
+	int Enqueue(const unsigned int id, const byte *data, const size_t frameCount = 1);
+	// Queue a span of encoded frames, either all are queued or none are
+	int Enqueue(const CanFrame *frames, const size_t frameCount);
+
+	// Number of frames waiting to be transmitted
+	size_t GetQueueDepth(void);
+
+protected:
+	// wxThread overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	// Per priority queues, index is the CAN priority
+	std::deque<CanFrame> frameQueues[CONST_SCHEDULER_PRIORITIES];
+	size_t queuedFrames;
+	wxMutex queueMutex;
+	wxCondition queueCondition;
+
+	// Performs the actual write to the CAN adapter
+	SchedulerWriteFunction writeFrames;
+
+	// Pacing, minimum interval between frames and the earliest time the next frame may be sent (microseconds)
+	unsigned long long frameInterval;
+	unsigned long long nextTransmitTime;
+
+	// Measured network load, when busy frames are sent singly at half the target rate
+	TwoCanBusLoad *busLoad;
+
+	// Statistics
+	unsigned long long transmittedFrames;
+	unsigned long long failedFrames;
+};
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+#ifndef TWOCAN_SERIAL_H
+#define TWOCAN_SERIAL_H
+
+#include "twocaninterface.h"
+#include "twocanlogparser.h"
+
+// Reuse the MAC address derived unique number
+#include "twocansocket.h"
+
+// Serial port
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <dirent.h>
+
+#include <vector>
+
+// Size of the buffer read from the tty device in a single call
+#define SLCAN_READ_BUFFER_SIZE 4096
+
+// Maximum number of frames posted to the TwoCan Device in a single message
+#define SLCAN_BATCH_FRAMES 64
+
+// Read timeout, 100 milliseconds, so that thread termination is detected promptly
+#define SLCAN_READ_TIMEOUT 100000
+
+// SLCAN (Lawicel) commands, close the bus, set bus speed to 250k, open the bus
+#define SLCAN_CLOSE "C\r"
+#define SLCAN_250K "S5\r"
+#define SLCAN_OPEN "O\r"
+
+// SLCAN line terminator and error response
+#define SLCAN_LINE_TERMINATOR '\r'
+#define SLCAN_BELL '\a'
+
+// SLCAN character used to indicate a CAN 2.0 extended frame, 29 bit Id
+#define SLCAN_EXTENDED_FRAME 'T'
+
+// Minimum length of an extended frame, 'T' + 8 hex characters for the CAN Id + 1 digit length
+#define SLCAN_EXTENDED_HEADER_LENGTH 10
+
+// Maximum length of an extended frame, header + 16 hex characters for the payload + terminator
+#define SLCAN_EXTENDED_FRAME_LENGTH 27
+
+// Implements a SLCAN (Lawicel) serial USB interface on Linux, for CANtact, CANable, USBTin and similar adapters,
+// accessed directly via their tty device rather than via slcand and SocketCAN
+class TwoCanSerial : public TwoCanInterface {
+
+public:
+	// Constructor and destructor
+	TwoCanSerial(wxMessageQueue<std::vector<byte>> *messageQueue);
+	~TwoCanSerial(void);
+
+	// Open, Close, Read and Write to the tty device
+	int Open(const wxString& portName);
+	int Close(void);
+	void Read();
+	int Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload);
+
+	// Derive a 29 bit Unique Number form the computer's MAC Address
+	int GetUniqueNumber(unsigned long *uniqueNumber);
+
+	// List the USB serial devices, used by the Preferences Dialog to select an adapter
+	static std::vector<wxString> ListSerialInterfaces();
+
+	// Whether the adapter name is a tty device, including pseudo terminals
+	static bool IsSerialInterface(const wxString& portName);
+
+	// Decode a single SLCAN extended frame (excluding the terminator) into a TwoCan frame
+	static bool ParseFrame(const char *line, const size_t length, byte *frame);
+
+protected:
+	// wxThread overridden functions
+	virtual wxThread::ExitCode Entry();
+	virtual void OnExit();
+
+private:
+	// tty device file handle
+	int serialPortHandle;
+	// Write a SLCAN command to the adapter
+	bool SendCommand(const char *command);
+};
+
+#endif
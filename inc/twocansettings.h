@@ -28,6 +28,7 @@
 
 #if defined (__LINUX__)
 #include "twocansocket.h"
+#include "twocanserial.h"
 #endif
 
 // wxWidgets includes 
@@ -24,12 +24,19 @@
 
 // SocketCAN
 #include <sys/ioctl.h>
-#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <linux/sockios.h>
 #include <net/if.h>
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
 #include <vector>
+#include <algorithm>
 
 // wxWidgets
 // BUG BUG work out which ones we really need
@@ -51,7 +58,20 @@
 // Message Queue
 #include <wx/msgqueue.h>
 
-// Implements the SocketCAN interface on Linux devices
+// Maximum number of frames written in a single sendmmsg call
+#define CONST_SOCKET_BATCH_FRAMES 64
+
+// Maximum time to wait for space in the interface's transmit queue before abandoning a write (milliseconds)
+#define CONST_SOCKET_BACKPRESSURE_TIMEOUT 100
+
+// Maximum number of frames read from a socket in a single recvmmsg call
+#define CONST_SOCKET_RECEIVE_FRAMES 64
+
+// epoll data identifying the shutdown event, sockets are identified by their interface index
+#define CONST_SOCKET_SHUTDOWN_EVENT 0xFFFFFFFF
+
+// Implements the SocketCAN interface on Linux devices.
+// The read thread blocks in epoll until frames arrive or Interrupt signals the shutdown event, so it consumes no CPU on an idle network
 class TwoCanSocket : public TwoCanInterface {
 
 public:
@@ -64,9 +84,13 @@ public:
 	int Open(const wxString& portName);
 	int Close(void);
 	int Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload);
+	int WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten);
+	int GetTransmitQueueDepth(void);
 	void Read();
+	void Interrupt(void);
 	static std::vector<wxString> ListCanInterfaces();
 	int GetUniqueNumber(unsigned long *uniqueNumber);
+	static int DeriveUniqueNumber(unsigned long *uniqueNumber);
 
 
 protected:
@@ -74,16 +98,30 @@ protected:
 	virtual wxThread::ExitCode Entry();
 	virtual void OnExit();
 
-private:
-	// CAN connection variables
-	struct sockaddr_can canAddress;
-	// Interface Request
-	struct ifreq canRequest;
-	// Socket Descriptor
+	// Create, configure and bind a socket for the named CAN interface
+	int OpenSocket(const wxString& portName, int *socketDescriptor);
+
+	// Create the epoll instance and the shutdown event, then add sockets to be waited upon
+	int OpenEventLoop(void);
+	int WatchSocket(const int socketDescriptor, const unsigned int interfaceIndex);
+	void CloseEventLoop(void);
+
+	// Read all pending frames from the socket, appending them (tagged with the interface index) to the frames to be posted
+	int ReceiveFrames(const int socketDescriptor, const int interfaceIndex, std::vector<byte> *postedFrames);
+
+	// Filter applied to each received frame, by default all frames are posted
+	virtual bool AcceptFrame(const byte *frame, const int interfaceIndex);
+
+	// Socket Descriptor, used for transmission
 	int canSocket;
-	int flags;
-	// Socket Timeouts
-	struct timeval socketTimeout;
+
+	// epoll instance and the eventfd used to wake the read thread
+	int epollDescriptor;
+	int shutdownEvent;
+
+private:
+	// Number of times a write has waited for space in the transmit queue
+	unsigned int backpressureEvents;
 	
 };
 
@@ -52,6 +52,10 @@
 // For transmitting N2K Messages
 #include <vector>
 
+// Fast message sequence identifiers
+#include <unordered_map>
+#include <mutex>
+
 // Some NMEA 2000 constants
 #define CONST_HEADER_LENGTH 4
 #define CONST_PAYLOAD_LENGTH 8
@@ -63,7 +67,10 @@
 #define CONST_NULL_ADDRESS 254
 
 // Maximum payload for NMEA multi-frame Fast Message
-#define CONST_MAX_FAST_PACKET 223_LENGTH
+#define CONST_MAX_FAST_PACKET_LENGTH 223
+
+// Maximum number of frames in a Fast Message, the first frame carries 6 bytes and each subsequent frame 7 bytes
+#define CONST_MAX_FAST_PACKET_FRAMES 32
 
 // Maximum payload for ISO 11783-3 Multi Packet
 #define CONST_MAX_ISO_MULTI_PACKET_LENGTH 1785 
@@ -290,6 +297,82 @@ typedef struct CanMessage {
 	std::vector<byte> payload;
 } CanMessage;
 
+// NMEA 2000 message supplied by another plugin, either decoded from a TWOCAN_TRANSMIT_FRAMES plugin message,
+// or passed directly to the function returned in response to a TWOCAN_TRANSMIT_REQUEST plugin message.
+// The source address is always that of the TwoCan device. Messages longer than 8 bytes or with fast message PGN's are fragmented.
+typedef struct TwoCanRawMessage {
+	unsigned int pgn;
+	byte priority;
+	byte destination;
+	unsigned short length;
+	const byte *data;
+} TwoCanRawMessage;
+
+// Transmit function that may be invoked by co-loaded plugins from any thread, bypassing JSON encoding.
+// Messages are queued in order, messagesQueued reports how many were accepted before the transmit queue became full
+typedef int (*TwoCanTransmitFunction)(const TwoCanRawMessage *messages, const size_t messageCount, size_t *messagesQueued);
+#define CONST_TRANSMIT_FUNCTION_VERSION 1
+
+// Encoded CAN v2.0 frame, 29 bit Id and 8 byte payload, as queued for transmission
+typedef struct CanFrame {
+	unsigned int id;
+	byte data[CONST_PAYLOAD_LENGTH];
+} CanFrame;
+
+// Builds a NMEA 2000 payload in a fixed buffer large enough for the longest fast message, so encoding does not allocate.
+// push_back, size, data & clear mirror std::vector so that existing encoders need not change.
+// Multi byte values are written little endian. Bytes beyond the capacity are discarded and the payload marked as overflowed.
+class PayloadWriter {
+
+public:
+	PayloadWriter(void) : length(0), isOverflowed(false) { }
+
+	void clear(void) { length = 0; isOverflowed = false; }
+	size_t size(void) const { return length; }
+	bool empty(void) const { return length == 0; }
+	const byte *data(void) const { return buffer; }
+	bool IsOverflowed(void) const { return isOverflowed; }
+
+	void push_back(const byte value) {
+		if (length < CONST_MAX_FAST_PACKET_LENGTH) {
+			buffer[length++] = value;
+		}
+		else {
+			isOverflowed = true;
+		}
+	}
+
+	void PutUInt16(const unsigned short value) { PutLittleEndian(value, 2); }
+	void PutInt16(const short value) { PutLittleEndian((unsigned short)value, 2); }
+	void PutUInt32(const unsigned int value) { PutLittleEndian(value, 4); }
+	void PutInt32(const int value) { PutLittleEndian((unsigned int)value, 4); }
+	void PutUInt64(const unsigned long long value) { PutLittleEndian(value, 8); }
+	void PutInt64(const long long value) { PutLittleEndian((unsigned long long)value, 8); }
+
+	// Scale is the reciprocal of the field's resolution, eg. 1e7 for a position with a resolution of 1e-7 degrees.
+	// The scaled value is truncated towards zero, as the encoders have always done.
+	void PutScaledUInt16(const double value, const double scale) { PutUInt16((unsigned short)(value * scale)); }
+	void PutScaledInt16(const double value, const double scale) { PutInt16((short)(value * scale)); }
+	void PutScaledUInt32(const double value, const double scale) { PutUInt32((unsigned int)(value * scale)); }
+	void PutScaledInt32(const double value, const double scale) { PutInt32((int)(value * scale)); }
+	void PutScaledInt64(const double value, const double scale) { PutInt64((long long)(value * scale)); }
+
+private:
+	byte buffer[CONST_MAX_FAST_PACKET_LENGTH];
+	size_t length;
+	bool isOverflowed;
+
+	void PutLittleEndian(const unsigned long long value, const size_t byteCount) {
+		if (length + byteCount > CONST_MAX_FAST_PACKET_LENGTH) {
+			isOverflowed = true;
+			return;
+		}
+		for (size_t i = 0; i < byteCount; i++) {
+			buffer[length++] = (value >> (i * 8)) & 0xFF;
+		}
+	}
+};
+
 // NMEA 2000 Product Information, transmitted in PGN 126996 NMEA Product Information
 typedef struct ProductInformation {
 	unsigned int dataBaseVersion;
@@ -343,8 +426,14 @@ public:
 	static int EncodeCanHeader(unsigned int *id, const CanHeader *header);
 	// Convert a string of hex characters to the corresponding byte array
 	static int ConvertHexStringToByteArray(const byte *hexstr, const unsigned int len, byte *buf);
+	// Whether the PGN is transmitted as a multi-frame Fast Message
+	static bool IsFastMessage(const unsigned int pgn);
 	// Generates the ID for Fast Messages. 3 high bits are ID, lower 5 bits are the sequence number
 	static byte GenerateID(unsigned char previousSID);
+	// Returns the sequence identifier for the next transmitted fast message of the PGN to the destination
+	static byte NextSequenceId(const unsigned int pgn, const byte destination);
+	// Fragment a fast message directly into frames (room for CONST_MAX_FAST_PACKET_FRAMES), returns the number of frames or zero if too long
+	static size_t FragmentFastMessage(const CanHeader *header, const unsigned int payloadLength, const byte *payload, CanFrame *frames);
 	// Calculate the number of microsoeconds since Posix Epoch
 	static unsigned long long GetTimeInMicroseconds(void);
 	// BUG BUG Any other conversion functions required ??
@@ -130,6 +130,15 @@
 
 WX_DECLARE_LIST(RESPONSE, MRL);
 
+/*
+** Sentence identifiers, the three letters of the mnemonic (eg. RMC) packed into a dense integer key
+** so that a sentence is dispatched with a single table lookup rather than comparing strings
+*/
+
+#define NMEA0183_KEY( a, b, c ) ( ( ( ( (a) - 'A' ) * 26 ) + ( (b) - 'A' ) ) * 26 + ( (c) - 'A' ) )
+#define NMEA0183_NUMBER_OF_KEYS ( 26 * 26 * 26 )
+#define NMEA0183_KEY_UNKNOWN ( -1 )
+
 class NMEA0183
 {
 
@@ -143,8 +152,13 @@ class NMEA0183
 
       MRL response_table;
 
+      // Index into responses (plus one) for each sentence key, zero if the sentence is not understood
+      unsigned char response_index[ NMEA0183_NUMBER_OF_KEYS ];
+      std::vector<RESPONSE *> responses;
+
       void set_container_pointers( void );
       void sort_response_table( void );
+      void index_response_table( void );
 
    public:
 
@@ -222,6 +236,7 @@ class NMEA0183
       wxString ErrorMessage; // Filled when Parse returns FALSE
       wxString LastSentenceIDParsed; // ID of the last sentence successfully parsed
       wxString LastSentenceIDReceived; // ID of the last sentence received, may not have parsed successfully
+      int LastSentenceKeyReceived; // Key of the last sentence received, NMEA0183_KEY_UNKNOWN if not three letters
 
       wxString TalkerID;
       wxString ExpandedTalkerID;
@@ -232,6 +247,8 @@ class NMEA0183
       virtual bool Parse( void );
       virtual bool PreParse( void );
 
+      static int MnemonicKey( const char *mnemonic, size_t length );
+
       NMEA0183& operator << ( wxString& source );
       NMEA0183& operator >> ( wxString& destination );
 };
@@ -33,6 +33,9 @@
 #if ! defined( SENTENCE_CLASS_HEADER )
 #define SENTENCE_CLASS_HEADER
 
+#include <string>
+#include <vector>
+
 /*
 ** Author: Samuel R. Blackburn
 ** CI$: 76300,326
@@ -43,6 +46,17 @@
 
 class LATLONG;
 
+/*
+** A field of the sentence, not NULL terminated, data points into the sentence's
+** narrow (UTF-8) copy and is only valid until the sentence is next modified
+*/
+
+typedef struct _SENTENCE_FIELD
+{
+   const char *data;
+   size_t length;
+} SENTENCE_FIELD;
+
 class SENTENCE 
 {
 //   DECLARE_DYNAMIC( SENTENCE )
@@ -68,7 +82,8 @@ class SENTENCE
       virtual double Double( int field_number ) const;
       virtual double DecimalDegrees( int field_number ) const;
       virtual EASTWEST EastOrWest( int field_number ) const;
-      virtual const wxString& Field( int field_number ) const;
+      virtual wxString Field( int field_number ) const;
+      virtual SENTENCE_FIELD FieldView( int field_number ) const;
       virtual void Finish( void );
       virtual int GetNumberOfDataFields( void ) const;
       virtual int Integer( int field_number ) const;
@@ -101,6 +116,29 @@ class SENTENCE
       virtual const SENTENCE& operator += ( TRANSDUCER_TYPE transducer );
       virtual const SENTENCE& operator += ( NMEA0183_BOOLEAN boolean );
       virtual const SENTENCE& operator += ( LATLONG& source );
+
+   private:
+
+      /*
+      ** The sentence is tokenised once, into a narrow copy and a table of field offsets,
+      ** rather than rescanning it for every field. Modifying the sentence discards the table.
+      */
+
+      typedef struct _FIELD_OFFSET
+      {
+         int start;
+         int length;
+      } FIELD_OFFSET;
+
+      mutable std::string narrow_sentence;
+      mutable std::vector<FIELD_OFFSET> field_offsets;
+      mutable int number_of_data_fields;
+      mutable bool checksum_present;
+      mutable bool is_tokenised;
+      mutable size_t tokenised_length;
+
+      void Tokenise( void ) const;
+      void Invalidate( void ) { is_tokenised = false; }
 };
  
 #endif // SENTENCE_CLASS_HEADER
@@ -31,6 +31,7 @@
 
 
 #include "nmea0183.h"
+#include <string.h>
 
 /*
 ** Author: Samuel R. Blackburn
@@ -135,6 +136,7 @@ NMEA0183::NMEA0183()
 */
    sort_response_table();
    set_container_pointers();
+   index_response_table();
 }
 
 NMEA0183::~NMEA0183()
@@ -147,6 +149,57 @@ void NMEA0183::initialize( void )
 //   ASSERT_VALID( this );
 
    ErrorMessage.Empty();
+   LastSentenceKeyReceived = NMEA0183_KEY_UNKNOWN;
+}
+
+/*
+** Packs a three letter mnemonic into a key, returns NMEA0183_KEY_UNKNOWN for anything else
+*/
+
+int NMEA0183::MnemonicKey( const char *mnemonic, size_t length )
+{
+   if ( length != 3 )
+   {
+      return( NMEA0183_KEY_UNKNOWN );
+   }
+
+   for ( size_t index = 0; index < length; index++ )
+   {
+      if ( mnemonic[ index ] < 'A' || mnemonic[ index ] > 'Z' )
+      {
+         return( NMEA0183_KEY_UNKNOWN );
+      }
+   }
+
+   return( NMEA0183_KEY( mnemonic[ 0 ], mnemonic[ 1 ], mnemonic[ 2 ] ) );
+}
+
+/*
+** Build the dense lookup table from the response table, as with the list
+** the first response registered for a mnemonic takes precedence
+*/
+
+void NMEA0183::index_response_table( void )
+{
+   memset( response_index, 0, sizeof( response_index ) );
+   responses.clear();
+
+   wxMRLNode *node = response_table.GetFirst();
+
+   while( node )
+   {
+      RESPONSE *resp = node->GetData();
+      wxCharBuffer abuf = resp->Mnemonic.ToUTF8();
+      int key = abuf.data() ? MnemonicKey( abuf.data(), strlen( abuf.data() ) ) : NMEA0183_KEY_UNKNOWN;
+
+      if ( key != NMEA0183_KEY_UNKNOWN && response_index[ key ] == 0 && responses.size() < 255 )
+      {
+         responses.push_back( resp );
+         response_index[ key ] = (unsigned char) responses.size();
+      }
+
+      node = node->GetNext();
+   }
 }
 
 void NMEA0183::set_container_pointers( void )
@@ -254,27 +307,25 @@ bool NMEA0183::IsGood( void ) const
 
 bool NMEA0183::PreParse( void )
 {
-      wxCharBuffer buf = sentence.Sentence.ToUTF8();
-      if( !buf.data() )      {                      // badly formed sentence?
-         return false;
-      }
-    
       if ( IsGood() )
       {
-            wxString mnemonic = sentence.Field( 0 );
+            SENTENCE_FIELD mnemonic = sentence.FieldView( 0 );
 
       /*
             ** See if this is a proprietary field
       */
 
-            if ( mnemonic.Left( 1 ) == 'P' )
-                  mnemonic = _T("P");
-
+            if ( mnemonic.length > 0 && mnemonic.data[ 0 ] == 'P' )
+            {
+                  LastSentenceIDReceived = _T("P");
+                  LastSentenceKeyReceived = NMEA0183_KEY_UNKNOWN;
+            }
             else
-                  mnemonic = mnemonic.Right( 3 );
-
-
-            LastSentenceIDReceived = mnemonic;
+            {
+                  size_t offset = ( mnemonic.length > 3 ) ? mnemonic.length - 3 : 0;
+                  LastSentenceIDReceived = wxString::FromUTF8( mnemonic.data + offset, mnemonic.length - offset );
+                  LastSentenceKeyReceived = MnemonicKey( mnemonic.data + offset, mnemonic.length - offset );
+            }
 
             return true;
       }
@@ -291,71 +342,40 @@ bool NMEA0183::Parse( void )
    if(PreParse())
    {
 
-      wxString mnemonic = sentence.Field( 0 );
-
-      /*
-      ** See if this is a proprietary field
-      */
-
-      if ( mnemonic.Left( 1 ) == 'P' )
-      {
-          mnemonic = _T("P");
-      }
-      else
-      {
-         mnemonic = mnemonic.Right( 3 );
-      }
-
       /*
       ** Set up our default error message
       */
 
-      ErrorMessage = mnemonic;
+      ErrorMessage = LastSentenceIDReceived;
       ErrorMessage += _T(" is an unknown type of sentence");
 
-      LastSentenceIDReceived = mnemonic;
-
       RESPONSE *response_p = (RESPONSE *) NULL;
 
+      /*
+      ** A single lookup, rather than traversing the response list
+      */
 
-//          Traverse the response list to find a mnemonic match
-
-       wxMRLNode *node = response_table.GetFirst();
-
-       int comparison  = 0;
-
-        while(node)
-        {
-           RESPONSE *resp = node->GetData();
+      if ( LastSentenceKeyReceived != NMEA0183_KEY_UNKNOWN && response_index[ LastSentenceKeyReceived ] != 0 )
+      {
+         response_p = responses[ response_index[ LastSentenceKeyReceived ] - 1 ];
+         return_value = response_p->Parse( sentence );
 
-            comparison = mnemonic.Cmp( resp->Mnemonic );
+         /*
+         ** Set your ErrorMessage
+         */
 
-            if ( comparison == 0 )
-            {
-                        response_p = (RESPONSE *) resp;
-                        return_value = response_p->Parse( sentence );
-
-                        /*
-                        ** Set your ErrorMessage
-                        */
-
-                        if ( return_value == TRUE )
-                        {
-                           ErrorMessage = _T("No Error");
-                           LastSentenceIDParsed = response_p->Mnemonic;
-                           TalkerID = talker_id( sentence );
-                           ExpandedTalkerID = expand_talker_id( TalkerID );
-                        }
-                        else
-                        {
-                           ErrorMessage = response_p->ErrorMessage;
-                        }
-
-                        break;
-                   }
-
-              node = node->GetNext();
-        }
+         if ( return_value == TRUE )
+         {
+            ErrorMessage = _T("No Error");
+            LastSentenceIDParsed = response_p->Mnemonic;
+            TalkerID = talker_id( sentence );
+            ExpandedTalkerID = expand_talker_id( TalkerID );
+         }
+         else
+         {
+            ErrorMessage = response_p->ErrorMessage;
+         }
+      }
 
    }
    else
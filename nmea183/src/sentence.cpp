@@ -32,6 +32,7 @@
 
 #include "nmea0183.h"
 #include <math.h>
+#include <stdlib.h>
 
 #if !defined(NAN)
 
@@ -58,6 +59,19 @@ static const long long lNaN = 0xfff8000000000000;
 SENTENCE::SENTENCE()
 {
    Sentence.Empty();
+   number_of_data_fields = 0;
+   checksum_present = false;
+   is_tokenised = false;
+   tokenised_length = 0;
+}
+
+/*
+** Single character fields such as N, S, E, W
+*/
+
+static bool FieldEquals( const SENTENCE_FIELD& field, char value )
+{
+   return( field.length == 1 && field.data[ 0 ] == value );
 }
 
 SENTENCE::~SENTENCE()
@@ -69,15 +83,13 @@ NMEA0183_BOOLEAN SENTENCE::Boolean( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   field_data = Field( field_number );
-
-   if ( field_data.StartsWith(_T("A")) )
+   if ( field_data.length > 0 && field_data.data[ 0 ] == 'A' )
    {
       return( NTrue );
    }
-   else if ( field_data.StartsWith(_T("V")) )
+   else if ( field_data.length > 0 && field_data.data[ 0 ] == 'V' )
    {
       return( NFalse );
    }
@@ -91,69 +103,56 @@ COMMUNICATIONS_MODE SENTENCE::CommunicationsMode( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
-
-   field_data = Field( field_number );
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   if ( field_data == _T("d") )
-   {
-      return( F3E_G3E_SimplexTelephone );
-   }
-   else if ( field_data == _T("e") )
-   {
-      return( F3E_G3E_DuplexTelephone );
-   }
-   else if ( field_data == _T("m") )
-   {
-      return( J3E_Telephone );
-   }
-   else if ( field_data == _T("o") )
-   {
-      return( H3E_Telephone );
-   }
-   else if ( field_data == _T("q") )
-   {
-      return( F1B_J2B_FEC_NBDP_TelexTeleprinter );
-   }
-   else if ( field_data == _T("s") )
-   {
-      return( F1B_J2B_ARQ_NBDP_TelexTeleprinter );
-   }
-   else if ( field_data == _T("w") )
-   {
-      return( F1B_J2B_ReceiveOnlyTeleprinterDSC );
-   }
-   else if ( field_data == _T("x") )
-   {
-      return( A1A_MorseTapeRecorder );
-   }
-   else if ( field_data == _T("{") )
-   {
-      return( A1A_MorseKeyHeadset );
-   }
-   else if ( field_data == _T("|") )
-   {
-      return( F1C_F2C_F3C_FaxMachine );
-   }
-   else
+   if ( field_data.length != 1 )
    {
       return( CommunicationsModeUnknown );
    }
+
+   switch( field_data.data[ 0 ] )
+   {
+      case 'd':
+         return( F3E_G3E_SimplexTelephone );
+      case 'e':
+         return( F3E_G3E_DuplexTelephone );
+      case 'm':
+         return( J3E_Telephone );
+      case 'o':
+         return( H3E_Telephone );
+      case 'q':
+         return( F1B_J2B_FEC_NBDP_TelexTeleprinter );
+      case 's':
+         return( F1B_J2B_ARQ_NBDP_TelexTeleprinter );
+      case 'w':
+         return( F1B_J2B_ReceiveOnlyTeleprinterDSC );
+      case 'x':
+         return( A1A_MorseTapeRecorder );
+      case '{':
+         return( A1A_MorseKeyHeadset );
+      case '|':
+         return( F1C_F2C_F3C_FaxMachine );
+      default:
+         return( CommunicationsModeUnknown );
+   }
 }
 
 unsigned char SENTENCE::ComputeChecksum( void ) const
 {
    unsigned char checksum_value = 0;
 
-   int string_length = Sentence.Length();
-   int index = 1; // Skip over the $ at the begining of the sentence
+   Tokenise();
+
+   const char *sentence_data = narrow_sentence.c_str();
+   size_t string_length = narrow_sentence.length();
+   size_t index = 1; // Skip over the $ at the begining of the sentence
 
    while( index < string_length    &&
-       Sentence[ index ] != '*' &&
-       Sentence[ index ] != CARRIAGE_RETURN &&
-       Sentence[ index ] != LINE_FEED )
+       sentence_data[ index ] != '*' &&
+       sentence_data[ index ] != CARRIAGE_RETURN &&
+       sentence_data[ index ] != LINE_FEED )
    {
-       checksum_value ^= (char)Sentence[ index ];
+       checksum_value ^= sentence_data[ index ];
          index++;
    }
 
@@ -161,21 +160,19 @@ unsigned char SENTENCE::ComputeChecksum( void ) const
 }
 
 // Rejigged for position parsing
+// Fields are parsed in place, strtod stops at the delimiter that follows the field
 double SENTENCE::DecimalDegrees( int field_number ) const
 {
  //  ASSERT_VALID( this );
-      if(Field( field_number ).Len() == 0)
+      SENTENCE_FIELD field_data = FieldView( field_number );
+      if( field_data.length == 0 )
             return (NAN);
 
-      wxCharBuffer abuf = Field( field_number).ToUTF8();
-      if( !abuf.data() )                            // badly formed sentence?
-        return (NAN);
-      
       // Convert a NMEA 183 position string like 13549.345 
       // which actually means 135 degrees 49.345 minutes
       // to the correct double value 135.8224 (decimal degrees)
 
-      double someValue = ::atof( abuf.data())/100 ;// 135.49345
+      double someValue = ::strtod( field_data.data, NULL )/100 ;// 135.49345
       int degrees = trunc(someValue); // 135
       double minutes = ((someValue - degrees) * 100)/60;
       return degrees + minutes;
@@ -185,14 +182,11 @@ double SENTENCE::DecimalDegrees( int field_number ) const
 double SENTENCE::Double( int field_number ) const
 {
  //  ASSERT_VALID( this );
-      if(Field( field_number ).Len() == 0)
+      SENTENCE_FIELD field_data = FieldView( field_number );
+      if( field_data.length == 0 )
             return (NAN);
 
-      wxCharBuffer abuf = Field( field_number).ToUTF8();
-      if( !abuf.data() )                            // badly formed sentence?
-        return (NAN);
-      
-      return( ::atof( abuf.data() ));
+      return( ::strtod( field_data.data, NULL ));
       
 }
 
@@ -201,15 +195,13 @@ EASTWEST SENTENCE::EastOrWest( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
-
-   field_data = Field( field_number );
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   if ( field_data == _T("E") )
+   if ( FieldEquals( field_data, 'E' ) )
    {
       return( East );
    }
-   else if ( field_data == _T("W") )
+   else if ( FieldEquals( field_data, 'W' ) )
    {
       return( West );
    }
@@ -219,73 +211,113 @@ EASTWEST SENTENCE::EastOrWest( int field_number ) const
    }
 }
 
-const wxString& SENTENCE::Field( int desired_field_number ) const
+/*
+** Split the sentence into fields in a single pass. Field 0 follows the $ (or !), fields are delimited by ',' and '*'.
+** As before, the checksum field retains its leading '*' and CR LF, and a field beyond the end of
+** a sentence that has a checksum is "*".
+*/
+
+void SENTENCE::Tokenise( void ) const
 {
-//   ASSERT_VALID( this );
+   if ( is_tokenised && tokenised_length == Sentence.Len() )
+   {
+      return;
+   }
 
-   static wxString return_string;
-   return_string.Empty();
+   wxCharBuffer abuf = Sentence.ToUTF8();
+   if ( abuf.data() )
+   {
+      narrow_sentence.assign( abuf.data() );
+   }
+   else
+   {
+      narrow_sentence.clear();                      // badly formed sentence?
+   }
 
-   int index                = 1; // Skip over the $ at the begining of the sentence
-   int current_field_number = 0;
-   int string_length        = 0;
+   field_offsets.clear();
+   number_of_data_fields = 0;
+   checksum_present = false;
 
-   string_length = Sentence.Len();
+   const char *sentence_data = narrow_sentence.c_str();
+   int string_length = (int) narrow_sentence.length();
+   int start = 1; // Skip over the $ at the begining of the sentence
+   FIELD_OFFSET offset;
 
-   while( current_field_number < desired_field_number && index < string_length )
+   for ( int index = 1; index < string_length; index++ )
    {
-      if ( Sentence[ index ] == ',' || Sentence[ index ] == '*' )
+      if ( sentence_data[ index ] == ',' || sentence_data[ index ] == '*' )
       {
-         current_field_number++;
+         offset.start = start;
+         offset.length = index - start;
+         field_offsets.push_back( offset );
+
+         if ( sentence_data[ index ] == '*' )
+         {
+            if ( !checksum_present )
+            {
+               number_of_data_fields = (int) field_offsets.size() - 1;
+            }
+            checksum_present = true;
+            start = index;
+         }
+         else
+         {
+            start = index + 1;
+         }
       }
-
-      if( Sentence[ index ] == '*')
-          return_string += Sentence[ index ];
-      index++;
    }
 
-   if ( current_field_number == desired_field_number )
+   offset.start = start;
+   offset.length = ( string_length > start ) ? string_length - start : 0;
+   field_offsets.push_back( offset );
+
+   if ( !checksum_present )
    {
-      while( index < string_length    &&
-             Sentence[ index ] != ',' &&
-             Sentence[ index ] != '*' &&
-             Sentence[ index ] != 0x00 )
-      {
-         return_string += Sentence[ index ];
-         index++;
-      }
+      number_of_data_fields = (int) field_offsets.size() - 1;
    }
 
-
-   return( return_string );
+   tokenised_length = Sentence.Len();
+   is_tokenised = true;
 }
 
-int SENTENCE::GetNumberOfDataFields( void ) const
+SENTENCE_FIELD SENTENCE::FieldView( int desired_field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   int index                = 1; // Skip over the $ at the begining of the sentence
-   int current_field_number = 0;
-   int string_length        = 0;
+   SENTENCE_FIELD field;
 
-   string_length = Sentence.Len();
+   Tokenise();
 
-   while( index < string_length )
+   if ( desired_field_number >= 0 && desired_field_number < (int) field_offsets.size() )
    {
-      if ( Sentence[ index ] == '*' )
-      {
-         return( (int) current_field_number );
-      }
+      field.data = narrow_sentence.c_str() + field_offsets[ desired_field_number ].start;
+      field.length = field_offsets[ desired_field_number ].length;
+   }
+   else
+   {
+      field.data = checksum_present ? "*" : "";
+      field.length = checksum_present ? 1 : 0;
+   }
 
-      if ( Sentence[ index ] == ',' )
-      {
-         current_field_number++;
-      }
+   return( field );
+}
 
-      index++;
-   }
+wxString SENTENCE::Field( int desired_field_number ) const
+{
+//   ASSERT_VALID( this );
+
+   SENTENCE_FIELD field = FieldView( desired_field_number );
+
+   return( wxString::FromUTF8( field.data, field.length ) );
+}
+
+int SENTENCE::GetNumberOfDataFields( void ) const
+{
+//   ASSERT_VALID( this );
 
-   return( (int) current_field_number );
+   Tokenise();
+
+   return( number_of_data_fields );
 }
 
 void SENTENCE::Finish( void )
@@ -298,26 +330,23 @@ void SENTENCE::Finish( void )
 
    temp_string.Printf(_T("*%02X%c%c"), (int) checksum, CARRIAGE_RETURN, LINE_FEED );
    Sentence += temp_string;
+   Invalidate();
 }
 
 int SENTENCE::Integer( int field_number ) const
 {
 //   ASSERT_VALID( this );
-    wxCharBuffer abuf = Field( field_number).ToUTF8();
-    if( !abuf.data() )                            // badly formed sentence?
-        return 0;
+    SENTENCE_FIELD field_data = FieldView( field_number );
 
-    return( ::atoi( abuf.data() ));
+    return( (int) ::strtol( field_data.data, NULL, 10 ));
 }
 
 unsigned long long SENTENCE::ULongLong(int field_number) const
 {
 	//   ASSERT_VALID( this );
-	wxCharBuffer abuf = Field(field_number).ToUTF8();
-	if (!abuf.data())                            // badly formed sentence?
-		return 0;
+	SENTENCE_FIELD field_data = FieldView(field_number);
 
-	return(::atoll(abuf.data()));
+	return(::strtoll(field_data.data, NULL, 10));
 }
 
 
@@ -329,15 +358,15 @@ NMEA0183_BOOLEAN SENTENCE::IsChecksumBad( int checksum_field_number ) const
    ** Checksums are optional, return TRUE if an existing checksum is known to be bad
    */
 
-   wxString checksum_in_sentence = Field( checksum_field_number );
+   SENTENCE_FIELD checksum_in_sentence = FieldView( checksum_field_number );
 
-   if ( checksum_in_sentence == _T("") )
+   if ( checksum_in_sentence.length == 0 )
    {
       return( Unknown0183 );
    }
 
-   wxString check = checksum_in_sentence.Mid( 1 );
-   if ( ComputeChecksum() != HexValue( check ) )
+   // Skip the leading '*', strtoul stops at the CR LF
+   if ( ComputeChecksum() != (unsigned char) ::strtoul( checksum_in_sentence.data + 1, NULL, 16 ) )
    {
       return( NTrue );
    }
@@ -349,15 +378,13 @@ LEFTRIGHT SENTENCE::LeftOrRight( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
-
-   field_data = Field( field_number );
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   if ( field_data == _T("L") )
+   if ( FieldEquals( field_data, 'L' ) )
    {
       return( Left );
    }
-   else if ( field_data == _T("R") )
+   else if ( FieldEquals( field_data, 'R' ) )
    {
       return( Right );
    }
@@ -371,15 +398,13 @@ NORTHSOUTH SENTENCE::NorthOrSouth( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   field_data = Field( field_number );
-
-   if ( field_data == _T("N") )
+   if ( FieldEquals( field_data, 'N' ) )
    {
       return( North );
    }
-   else if ( field_data == _T("S") )
+   else if ( FieldEquals( field_data, 'S' ) )
    {
       return( South );
    }
@@ -393,33 +418,27 @@ REFERENCE SENTENCE::Reference( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
-
-   field_data = Field( field_number );
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   if ( field_data == _T("B") )
-   {
-      return( BottomTrackingLog );
-   }
-   else if ( field_data == _T("M") )
+   if ( field_data.length != 1 )
    {
-      return( ManuallyEntered );
-   }
-   else if ( field_data == _T("W") )
-   {
-      return( WaterReferenced );
-   }
-   else if ( field_data == _T("R") )
-   {
-      return( RadarTrackingOfFixedTarget );
-   }
-   else if ( field_data == _T("P") )
-   {
-      return( PositioningSystemGroundReference );
+      return( ReferenceUnknown );
    }
-   else
+
+   switch( field_data.data[ 0 ] )
    {
-      return( ReferenceUnknown );
+      case 'B':
+         return( BottomTrackingLog );
+      case 'M':
+         return( ManuallyEntered );
+      case 'W':
+         return( WaterReferenced );
+      case 'R':
+         return( RadarTrackingOfFixedTarget );
+      case 'P':
+         return( PositioningSystemGroundReference );
+      default:
+         return( ReferenceUnknown );
    }
 }
 
@@ -427,54 +446,38 @@ TRANSDUCER_TYPE SENTENCE::TransducerType( int field_number ) const
 {
 //   ASSERT_VALID( this );
 
-   wxString field_data;
+   SENTENCE_FIELD field_data = FieldView( field_number );
 
-   field_data = Field( field_number );
-
-   if ( field_data == _T("A") )
-   {
-      return( AngularDisplacementTransducer );
-   }
-   else if ( field_data == _T("D") )
-   {
-      return( LinearDisplacementTransducer );
-   }
-   else if ( field_data == _T("C") )
-   {
-      return( TemperatureTransducer );
-   }
-   else if ( field_data == _T("F") )
-   {
-      return( FrequencyTransducer );
-   }
-   else if ( field_data == _T("N") )
-   {
-      return( ForceTransducer );
-   }
-   else if ( field_data == _T("P") )
-   {
-      return( PressureTransducer );
-   }
-   else if ( field_data == _T("R") )
-   {
-      return( FlowRateTransducer );
-   }
-   else if ( field_data == _T("T") )
-   {
-      return( TachometerTransducer );
-   }
-   else if ( field_data == _T("H") )
-   {
-      return( HumidityTransducer );
-   }
-   else if ( field_data == _T("V") )
-   {
-      return( VolumeTransducer );
-   }
-   else
+   if ( field_data.length != 1 )
    {
       return( TransducerUnknown );
    }
+
+   switch( field_data.data[ 0 ] )
+   {
+      case 'A':
+         return( AngularDisplacementTransducer );
+      case 'D':
+         return( LinearDisplacementTransducer );
+      case 'C':
+         return( TemperatureTransducer );
+      case 'F':
+         return( FrequencyTransducer );
+      case 'N':
+         return( ForceTransducer );
+      case 'P':
+         return( PressureTransducer );
+      case 'R':
+         return( FlowRateTransducer );
+      case 'T':
+         return( TachometerTransducer );
+      case 'H':
+         return( HumidityTransducer );
+      case 'V':
+         return( VolumeTransducer );
+      default:
+         return( TransducerUnknown );
+   }
 }
 
 /*
@@ -494,6 +497,8 @@ const SENTENCE& SENTENCE::operator = ( const SENTENCE& source )
 
    Sentence = source.Sentence;
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -503,6 +508,8 @@ const SENTENCE& SENTENCE::operator = ( const wxString& source )
 
    Sentence = source;
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -513,6 +520,8 @@ const SENTENCE& SENTENCE::operator += ( const wxString& source )
     Sentence += _T(",");
    Sentence += source;
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -527,6 +536,8 @@ const SENTENCE& SENTENCE::operator += ( double value )
    Sentence += _T(",");
    Sentence += temp_string;
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -543,6 +554,8 @@ SENTENCE& SENTENCE::Add ( double value, int precision )
     Sentence += _T(",");
     Sentence += temp_string;
 
+    Invalidate();
+
     return( *this );
 }
 const SENTENCE& SENTENCE::operator += ( COMMUNICATIONS_MODE mode )
@@ -608,6 +621,8 @@ const SENTENCE& SENTENCE::operator += ( COMMUNICATIONS_MODE mode )
            break;
    }
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -676,6 +691,8 @@ const SENTENCE& SENTENCE::operator += ( TRANSDUCER_TYPE transducer )
 
    }
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -694,6 +711,8 @@ const SENTENCE& SENTENCE::operator += ( NORTHSOUTH northing )
        Sentence += _T("S");
    }
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -708,6 +727,8 @@ const SENTENCE& SENTENCE::operator += ( int value )
    Sentence += _T(",");
    Sentence += temp_string;
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -722,6 +743,8 @@ const SENTENCE& SENTENCE::operator += (unsigned long long value)
 	Sentence += _T(",");
 	Sentence += temp_string;
 
+	Invalidate();
+
 	return(*this);
 }
 
@@ -740,6 +763,8 @@ const SENTENCE& SENTENCE::operator += ( EASTWEST easting )
        Sentence += _T("W");
    }
 
+   Invalidate();
+
    return( *this );
 }
 
@@ -758,6 +783,8 @@ const SENTENCE& SENTENCE::operator += ( NMEA0183_BOOLEAN boolean )
        Sentence += _T("V");
    }
 
+   Invalidate();
+
    return( *this );
 }
 
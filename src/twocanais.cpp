@@ -187,7 +187,7 @@ std::string TwoCanAis::GetStringV3(std::vector<bool> binaryData, int start, int
 }
 
 // AIS Message parsing routine
-bool TwoCanAis::ParseAisMessage(VDM vdmMessage, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::ParseAisMessage(VDM vdmMessage, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	std::vector<bool> decodedMessage;
 	bool result = FALSE;
@@ -340,7 +340,7 @@ bool TwoCanAis::ParseAisMessage(VDM vdmMessage, std::vector<byte> *payload, unsi
 
 // Encode PGN 129038 NMEA AIS Class A Position Report
 // AIS Message Types 1,2 or 3
-bool TwoCanAis::EncodePGN129038(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129038(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129038;
 
@@ -463,7 +463,7 @@ bool TwoCanAis::EncodePGN129038(const std::vector<bool> binaryData, std::vector<
 
 // Encode payload for PGN 129039 NMEA AIS Class B Position Report
 // AIS Message Type 18
-bool TwoCanAis::EncodePGN129039(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129039(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129039;
 
@@ -566,7 +566,7 @@ bool TwoCanAis::EncodePGN129039(const std::vector<bool> binaryData, std::vector<
 
 // Encode payload for PGN 129040 AIS Class B Extended Position Report
 // AIS Message Type 19
-bool TwoCanAis::EncodePGN129040(std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129040(std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 	*parameterGroupNumber = 129040;
 
 	if (binaryData.size() == 312) {
@@ -688,7 +688,7 @@ bool TwoCanAis::EncodePGN129040(std::vector<bool> binaryData, std::vector<byte>
 
 // Encode payload for PGN 129041 AIS Aids To Navigation (AToN) Report
 // AIS Message Type 21
-bool TwoCanAis::EncodePGN129041(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129041(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129041;
 	// Variable size message
@@ -796,7 +796,7 @@ bool TwoCanAis::EncodePGN129041(const std::vector<bool> binaryData, std::vector<
 
 // Encode payload for PGN 129793 AIS Date and Time report
 // AIS Message Type 4 and if date is present also Message Type 11
-bool TwoCanAis::EncodePGN129793(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129793(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129793;
 
@@ -900,7 +900,7 @@ bool TwoCanAis::EncodePGN129793(const std::vector<bool> binaryData, std::vector<
 
 // Encode payload for PGN 129794 NMEA AIS Class A Static and Voyage Related Data
 // AIS Message Type 5
-bool TwoCanAis::EncodePGN129794(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129794(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129794;
 
@@ -1020,7 +1020,7 @@ bool TwoCanAis::EncodePGN129794(const std::vector<bool> binaryData, std::vector<
 
 //	Encode payload for PGN 129798 AIS SAR Aircraft Position Report
 // AIS Message Type 9
-bool TwoCanAis::EncodePGN129798(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129798(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129798;
 
@@ -1124,7 +1124,7 @@ bool TwoCanAis::EncodePGN129798(const std::vector<bool> binaryData, std::vector<
 }
 //	Encode payload for PGN 129801 AIS Addressed Safety Related Message
 // AIS Message Type 12
-bool TwoCanAis::EncodePGN129801(const std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129801(const std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129801;
 
@@ -1172,7 +1172,7 @@ bool TwoCanAis::EncodePGN129801(const std::vector<bool> binaryData, std::vector<
 
 // Encode payload for PGN 129802 AIS Safety Related Broadcast Message 
 // AIS Message Type 14
-bool TwoCanAis::EncodePGN129802(std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129802(std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129802;
 
@@ -1207,7 +1207,7 @@ bool TwoCanAis::EncodePGN129802(std::vector<bool> binaryData, std::vector<byte>
 
 // Encode payload for PGN 129809 AIS Class B Static Data Report, Part A 
 // AIS Message Type 24, Part A
-bool TwoCanAis::EncodePGN129809(std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129809(std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129809;
 
@@ -1244,7 +1244,7 @@ bool TwoCanAis::EncodePGN129809(std::vector<bool> binaryData, std::vector<byte>
 
 // Encode payload for PGN 129810 AIS Class B Static Data Report, Part B 
 // AIS Message Type 24, Part B
-bool TwoCanAis::EncodePGN129810(std::vector<bool> binaryData, std::vector<byte> *payload, unsigned int *parameterGroupNumber) {
+bool TwoCanAis::EncodePGN129810(std::vector<bool> binaryData, PayloadWriter *payload, unsigned int *parameterGroupNumber) {
 
 	*parameterGroupNumber = 129810;
 
@@ -0,0 +1,113 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanBusLoad - Estimates network utilisation
+// Owner: twocanplugin@hotmail.com
+// Date: 10/08/2022
+// Version History:
+// 1.0 Initial Release
+
+#include "twocanbusload.h"
+
+TwoCanBusLoad::TwoCanBusLoad(void) {
+	memset(buckets, 0, sizeof(buckets));
+}
+
+TwoCanBusLoad::~TwoCanBusLoad(void) {
+}
+
+// An extended frame has 67 + 8n bits (including the 3 bit interframe space), of which 54 + 8n are subject to bit stuffing,
+// worst case one stuff bit for every four bits after the first
+unsigned int TwoCanBusLoad::FrameBits(const unsigned int dataLength) {
+	unsigned int length = dataLength > CONST_PAYLOAD_LENGTH ? CONST_PAYLOAD_LENGTH : dataLength;
+	return 67 + (8 * length) + ((54 + (8 * length) - 1) / 4);
+}
+
+TwoCanBusLoad::BusLoadBucket *TwoCanBusLoad::CurrentBucket(const unsigned long long now) {
+	unsigned long long index = now / CONST_BUSLOAD_BUCKET_DURATION;
+	BusLoadBucket *bucket = &buckets[index % CONST_BUSLOAD_BUCKETS];
+	if (bucket->index != index) {
+		memset(bucket, 0, sizeof(BusLoadBucket));
+		bucket->index = index;
+	}
+	return bucket;
+}
+
+void TwoCanBusLoad::Record(const unsigned int id, const unsigned int dataLength) {
+	byte priority = (id >> 26) & 0x07;
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+
+	const std::lock_guard<std::mutex> lock(bucketMutex);
+	BusLoadBucket *bucket = CurrentBucket(now);
+	bucket->bits += FrameBits(dataLength);
+	bucket->frames[priority] += 1;
+	bucket->bytes[priority] += dataLength;
+}
+
+// TwoCan frame, 4 byte header (LSB first) followed by 8 data bytes
+void TwoCanBusLoad::Record(const byte *frame) {
+	Record(frame[0] | (frame[1] << 8) | (frame[2] << 16) | (frame[3] << 24), CONST_PAYLOAD_LENGTH);
+}
+
+double TwoCanBusLoad::GetLoad(const int window) {
+	BusLoadStatistics statistics;
+	GetStatistics(&statistics, window);
+	return statistics.loadPercent;
+}
+
+// The current bucket is only partially complete, so the window's duration is the completed buckets plus the elapsed part of the current one
+void TwoCanBusLoad::GetStatistics(BusLoadStatistics *statistics, const int window) {
+	int bucketCount = (window < 1) ? 1 : (window > CONST_BUSLOAD_BUCKETS) ? CONST_BUSLOAD_BUCKETS : window;
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+	unsigned long long currentIndex = now / CONST_BUSLOAD_BUCKET_DURATION;
+	unsigned long long totalBits = 0;
+	unsigned long long totalFrames[8] = { 0 };
+	unsigned long long totalBytes[8] = { 0 };
+
+	{
+		const std::lock_guard<std::mutex> lock(bucketMutex);
+		for (int i = 0; i < bucketCount; i++) {
+			const BusLoadBucket *bucket = &buckets[(currentIndex - i) % CONST_BUSLOAD_BUCKETS];
+			if (bucket->index == currentIndex - i) {
+				totalBits += bucket->bits;
+				for (int priority = 0; priority < 8; priority++) {
+					totalFrames[priority] += bucket->frames[priority];
+					totalBytes[priority] += bucket->bytes[priority];
+				}
+			}
+		}
+	}
+
+	double duration = ((bucketCount - 1) * CONST_BUSLOAD_BUCKET_DURATION + (now % CONST_BUSLOAD_BUCKET_DURATION)) / 1e6;
+	if (duration <= 0) {
+		duration = CONST_BUSLOAD_BUCKET_DURATION / 1e6;
+	}
+
+	statistics->loadPercent = (totalBits * 100.0) / (CONST_BUSLOAD_BIT_RATE * duration);
+	statistics->framesPerSecond = 0;
+	statistics->bytesPerSecond = 0;
+	for (int priority = 0; priority < 8; priority++) {
+		statistics->priorityFramesPerSecond[priority] = totalFrames[priority] / duration;
+		statistics->priorityBytesPerSecond[priority] = totalBytes[priority] / duration;
+		statistics->framesPerSecond += statistics->priorityFramesPerSecond[priority];
+		statistics->bytesPerSecond += statistics->priorityBytesPerSecond[priority];
+	}
+}
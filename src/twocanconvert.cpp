@@ -0,0 +1,433 @@
+// Copyright(C) 2018-2021 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanConvert - Headless command line converter for NMEA 2000 log files
+// Owner: twocanplugin@hotmail.com
+// Date: 15/01/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 - 26/09/2022 NMEA 0183 output, using the decoders shared with TwoCanDevice
+// 1.2 - 28/09/2022 Depends upon the wxWidgets base library only
+//
+// Usage: twocanconvert [-j threads] [-p | -n] inputFile outputFile
+//   -j   Number of threads used to parse text log files (defaults to the number of cores)
+//   -p   Write a separate CSV file for each PGN, named outputFile_<pgn>.csv
+//   -n   Write the NMEA 0183 sentences that the plugin would send to OpenCPN, rather than CSV
+//
+// Reads any of the log file formats supported by the log file & pcap (and pcapng) readers and writes a CSV file
+// of complete NMEA 2000 messages, with multi-frame Fast Messages reassembled.
+// Alternatively, complete messages are converted to NMEA 0183 sentences by TwoCanDecoder. As the decoder is
+// stateful (eg. RMC sentences are constructed from several PGN's), messages are decoded in file order.
+// Text log files are split into segments which are parsed concurrently. Fast Message reassembly is
+// performed in file order once each round of segments completes, so reassembly state is carried
+// across segment boundaries.
+
+#include "twocanutils.h"
+#include "twocandecoder.h"
+#include "twocanlogparser.h"
+#include "twocanlogreader.h"
+#include "twocanpcap.h"
+#include "twocanmappedfile.h"
+
+#include <thread>
+#include <map>
+#include <vector>
+#include <stdio.h>
+
+// The converter decodes every PGN that the plugin is able to convert
+int supportedPGN = FLAGS_HDG | FLAGS_VHW | FLAGS_DPT | FLAGS_GLL | FLAGS_VTG | FLAGS_GGA | FLAGS_ZDA | FLAGS_MWV | FLAGS_MTW | FLAGS_DSC | FLAGS_AIS | \
+	FLAGS_RTE | FLAGS_ROT | FLAGS_XTE | FLAGS_XDR | FLAGS_ENG | FLAGS_TNK | FLAGS_RSA | FLAGS_BAT | FLAGS_NAV | FLAGS_LOG | FLAGS_MET | FLAGS_MOB;
+
+// Size of the segment of a text log file that each thread parses per round
+#define CONST_CONVERT_SEGMENT_SIZE (16 * 1024 * 1024)
+
+// A frame as parsed from the log file
+typedef struct ConvertFrame {
+	byte frame[CONST_FRAME_LENGTH];
+} ConvertFrame;
+
+// A Fast Message being reassembled
+typedef struct ConvertFastMessage {
+	byte sid;
+	unsigned int expectedLength;
+	unsigned int cursor;
+	std::vector<byte> data;
+} ConvertFastMessage;
+
+// Reassembles Fast Messages and writes complete messages as CSV or NMEA 0183 sentences
+class TwoCanConverter {
+
+public:
+	TwoCanConverter(const wxString& outputName, const bool splitByPgn, const bool decodeNmea);
+	~TwoCanConverter(void);
+
+	bool IsOpen(void) const { return (splitPgn) || (outputFile != NULL); }
+
+	// Process a frame in file order
+	void ProcessFrame(const byte *frame);
+
+	unsigned long long frameCount;
+	unsigned long long messageCount;
+	unsigned long long droppedCount;
+	unsigned long long sentenceCount;
+
+private:
+	wxString outputFileName;
+	bool splitPgn;
+	bool nmeaOutput;
+	// Converts complete messages to NMEA 0183 sentences
+	TwoCanDecoder decoder;
+	FILE *outputFile;
+	std::map<unsigned int, FILE *> pgnFiles;
+	// Keyed by PGN, source, destination and the 3 bit sequence id
+	std::map<unsigned long long, ConvertFastMessage> fastMessages;
+
+	void WriteMessage(const CanHeader& header, const byte *payload, const unsigned int length);
+	void WriteSentences(const CanHeader& header, const byte *payload);
+	FILE *GetOutputFile(const unsigned int pgn);
+};
+
+TwoCanConverter::TwoCanConverter(const wxString& outputName, const bool splitByPgn, const bool decodeNmea) {
+	outputFileName = outputName;
+	splitPgn = splitByPgn;
+	nmeaOutput = decodeNmea;
+	outputFile = NULL;
+	frameCount = 0;
+	messageCount = 0;
+	droppedCount = 0;
+	sentenceCount = 0;
+	if (!splitPgn) {
+		outputFile = fopen(outputFileName.mb_str(), "w");
+		if ((outputFile != NULL) && (!nmeaOutput)) {
+			fprintf(outputFile, "PGN,Priority,Source,Destination,Length,Data\n");
+		}
+	}
+}
+
+TwoCanConverter::~TwoCanConverter(void) {
+	if (outputFile != NULL) {
+		fclose(outputFile);
+	}
+	for (auto it : pgnFiles) {
+		fclose(it.second);
+	}
+}
+
+FILE *TwoCanConverter::GetOutputFile(const unsigned int pgn) {
+	if (!splitPgn) {
+		return outputFile;
+	}
+	auto it = pgnFiles.find(pgn);
+	if (it != pgnFiles.end()) {
+		return it->second;
+	}
+	FILE *pgnFile = fopen(wxString::Format(_T("%s_%u.csv"), outputFileName, pgn).mb_str(), "w");
+	if (pgnFile != NULL) {
+		fprintf(pgnFile, "PGN,Priority,Source,Destination,Length,Data\n");
+	}
+	pgnFiles[pgn] = pgnFile;
+	return pgnFile;
+}
+
+void TwoCanConverter::WriteMessage(const CanHeader& header, const byte *payload, const unsigned int length) {
+	static const char hexDigits[] = "0123456789ABCDEF";
+	if (nmeaOutput) {
+		WriteSentences(header, payload);
+		return;
+	}
+	FILE *file = GetOutputFile(header.pgn);
+	if (file == NULL) {
+		return;
+	}
+	char line[64 + (CONST_MAX_FAST_PACKET_LENGTH * 3)];
+	int position = snprintf(line, sizeof(line), "%u,%u,%u,%u,%u,", header.pgn, header.priority, header.source, header.destination, length);
+	for (unsigned int i = 0; (i < length) && (i < CONST_MAX_FAST_PACKET_LENGTH); i++) {
+		line[position++] = hexDigits[payload[i] >> 4];
+		line[position++] = hexDigits[payload[i] & 0x0F];
+		line[position++] = ' ';
+	}
+	line[position > 0 ? position - 1 : 0] = '\n';
+	fwrite(line, 1, position, file);
+	messageCount++;
+}
+
+// Mirrors TwoCanDevice::SendNMEASentence, appending the checksum to each sentence
+void TwoCanConverter::WriteSentences(const CanHeader& header, const byte *payload) {
+	std::vector<wxString> nmeaSentences;
+	messageCount++;
+	if (decoder.DecodeMessage(header, payload, &nmeaSentences) == FALSE) {
+		return;
+	}
+	for (auto sentence : nmeaSentences) {
+		sentence.Trim();
+		wxString checksum = decoder.ComputeChecksum(sentence);
+		sentence.Append(wxT("*"));
+		sentence.Append(checksum);
+		sentence.Append(wxT("\r\n"));
+		fputs(sentence.mb_str(), outputFile);
+		sentenceCount++;
+	}
+}
+
+// Mirrors the Fast Message assembly performed by TwoCanDevice
+void TwoCanConverter::ProcessFrame(const byte *frame) {
+	CanHeader header;
+	const byte *data = &frame[CONST_HEADER_LENGTH];
+	TwoCanUtils::DecodeCanHeader(frame, &header);
+	frameCount++;
+
+	if (!TwoCanUtils::IsFastMessage(header.pgn)) {
+		WriteMessage(header, data, CONST_PAYLOAD_LENGTH);
+		return;
+	}
+
+	unsigned long long key = ((unsigned long long)header.pgn << 24) | (header.source << 16) | (header.destination << 8) | (data[0] & 0xE0);
+	auto it = fastMessages.find(key);
+
+	if ((data[0] & 0x1F) == 0) {
+		// First frame, data[1] is the total length, followed by 6 data bytes
+		if (it != fastMessages.end()) {
+			// Missed the end of the previous message with the same sequence id
+			droppedCount++;
+		}
+		if (data[1] <= 6) {
+			WriteMessage(header, &data[2], data[1]);
+			if (it != fastMessages.end()) {
+				fastMessages.erase(it);
+			}
+			return;
+		}
+		ConvertFastMessage& message = fastMessages[key];
+		message.sid = data[0];
+		message.expectedLength = data[1];
+		message.data.assign(&data[2], &data[8]);
+		message.cursor = 6;
+		return;
+	}
+
+	if (it == fastMessages.end()) {
+		// Subsequent frame without a start frame
+		droppedCount++;
+		return;
+	}
+
+	ConvertFastMessage& message = it->second;
+	if ((byte)(message.sid + 1) != data[0]) {
+		// Dropped an intermediate frame
+		droppedCount++;
+		fastMessages.erase(it);
+		return;
+	}
+
+	message.data.insert(message.data.end(), &data[1], &data[8]);
+	message.sid = data[0];
+	message.cursor += 7;
+	if (message.cursor >= message.expectedLength) {
+		WriteMessage(header, message.data.data(), message.expectedLength);
+		fastMessages.erase(it);
+	}
+}
+
+// Parse the lines that start within the segment [start, end) of a text log file.
+// A line that straddles the end of the segment belongs to this segment, and the partial line at the
+// start of the segment belongs to the previous segment
+void ParseTextSegment(TwoCanMappedFile *logFile, const int format, const unsigned long long start, const unsigned long long end, std::vector<ConvertFrame> *frames) {
+	unsigned long long offset = start;
+	const byte *buffer;
+	size_t available;
+	ConvertFrame convertFrame;
+
+	frames->clear();
+
+	if (offset > 0) {
+		available = 1;
+		buffer = logFile->Map(offset - 1, &available);
+		if ((buffer == NULL) || (buffer[0] != '\n')) {
+			available = CONST_LOGFILE_MAX_LINE;
+			buffer = logFile->Map(offset, &available);
+			const byte *lineEnd = (buffer != NULL) ? (const byte *)memchr(buffer, '\n', available) : NULL;
+			if (lineEnd == NULL) {
+				return;
+			}
+			offset += (lineEnd - buffer) + 1;
+		}
+	}
+
+	while (offset < end) {
+		available = CONST_LOGFILE_MAX_LINE;
+		buffer = logFile->Map(offset, &available);
+		if ((buffer == NULL) || (available == 0)) {
+			break;
+		}
+		const byte *lineEnd = (const byte *)memchr(buffer, '\n', available);
+		size_t lineLength = (lineEnd != NULL) ? (size_t)(lineEnd - buffer) : available;
+		offset += lineLength + ((lineEnd != NULL) ? 1 : 0);
+		if ((lineLength > 0) && (buffer[lineLength - 1] == '\r')) {
+			lineLength--;
+		}
+		if (TwoCanLogParser::ParseLine(format, (const char *)buffer, lineLength, convertFrame.frame)) {
+			frames->push_back(convertFrame);
+		}
+	}
+}
+
+int ConvertTextFile(const wxString& inputName, const int format, const unsigned int threadCount, TwoCanConverter *converter) {
+	std::vector<TwoCanMappedFile> logFiles(threadCount);
+	std::vector<std::vector<ConvertFrame>> segments(threadCount);
+	unsigned long long fileSize = 0;
+
+	for (unsigned int i = 0; i < threadCount; i++) {
+		if (logFiles[i].Open(inputName) != TWOCAN_RESULT_SUCCESS) {
+			return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_FILE_NOT_FOUND);
+		}
+		fileSize = logFiles[i].Size();
+	}
+
+	for (unsigned long long roundStart = 0; roundStart < fileSize; roundStart += (unsigned long long)threadCount * CONST_CONVERT_SEGMENT_SIZE) {
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < threadCount; i++) {
+			unsigned long long start = roundStart + ((unsigned long long)i * CONST_CONVERT_SEGMENT_SIZE);
+			unsigned long long end = start + CONST_CONVERT_SEGMENT_SIZE;
+			if (start >= fileSize) {
+				segments[i].clear();
+				continue;
+			}
+			if (end > fileSize) {
+				end = fileSize;
+			}
+			workers.push_back(std::thread(ParseTextSegment, &logFiles[i], format, start, end, &segments[i]));
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		// Reassemble in file order
+		for (unsigned int i = 0; i < threadCount; i++) {
+			for (auto& convertFrame : segments[i]) {
+				converter->ProcessFrame(convertFrame.frame);
+			}
+		}
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Pcap records have no synchronisation markers, so they are read sequentially
+int ConvertPcapFile(TwoCanPcapFile *pcapFile, TwoCanConverter *converter) {
+	byte frame[CONST_FRAME_LENGTH];
+	unsigned long long timestamp;
+	int result;
+
+	pcapFile->Rewind();
+	while ((result = pcapFile->NextPacket(frame, &timestamp)) != PcapPacketEnd) {
+		if (result == PcapPacketFrame) {
+			converter->ProcessFrame(frame);
+		}
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	bool splitPgn = false;
+	bool nmeaOutput = false;
+	int argIndex = 1;
+
+	while ((argIndex < argc) && (argv[argIndex][0] == '-')) {
+		if ((strcmp(argv[argIndex], "-j") == 0) && (argIndex + 1 < argc)) {
+			threadCount = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "-p") == 0) {
+			splitPgn = true;
+		}
+		else if (strcmp(argv[argIndex], "-n") == 0) {
+			nmeaOutput = true;
+		}
+		else {
+			break;
+		}
+		argIndex++;
+	}
+
+	// NMEA 0183 sentences are written to a single file
+	if ((argc - argIndex != 2) || (splitPgn && nmeaOutput)) {
+		fprintf(stderr, "Usage: twocanconvert [-j threads] [-p | -n] inputFile outputFile\n");
+		return 1;
+	}
+
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+
+	wxString inputName = argv[argIndex];
+	wxString outputName = argv[argIndex + 1];
+
+	// Pcap & pcapng files are identified by their magic number
+	TwoCanPcapFile pcapFile;
+	bool isPcap = (pcapFile.Open(inputName) == TWOCAN_RESULT_SUCCESS);
+
+	TwoCanMappedFile logFile;
+	if ((!isPcap) && (logFile.Open(inputName) != TWOCAN_RESULT_SUCCESS)) {
+		fprintf(stderr, "Unable to open %s\n", argv[argIndex]);
+		return 1;
+	}
+
+	// Otherwise sample the first few lines to detect the text log file format
+	int format = Undefined;
+	if (!isPcap) {
+		unsigned long long offset = 0;
+		for (int i = 0; (i < CONST_LOGFILE_SAMPLE_LINES) && (format == Undefined); i++) {
+			size_t available = CONST_LOGFILE_MAX_LINE;
+			const byte *buffer = logFile.Map(offset, &available);
+			if ((buffer == NULL) || (available == 0)) {
+				break;
+			}
+			const byte *lineEnd = (const byte *)memchr(buffer, '\n', available);
+			size_t lineLength = (lineEnd != NULL) ? (size_t)(lineEnd - buffer) : available;
+			offset += lineLength + 1;
+			format = TwoCanLogParser::DetectFormat((const char *)buffer, lineLength);
+		}
+		if (format == Undefined) {
+			fprintf(stderr, "Unrecognised log file format: %s\n", argv[argIndex]);
+			return 1;
+		}
+	}
+
+	TwoCanConverter converter(outputName, splitPgn, nmeaOutput);
+	if (!converter.IsOpen()) {
+		fprintf(stderr, "Unable to create %s\n", argv[argIndex + 1]);
+		return 1;
+	}
+
+	int returnCode;
+	if (isPcap) {
+		returnCode = ConvertPcapFile(&pcapFile, &converter);
+	}
+	else {
+		logFile.Close();
+		returnCode = ConvertTextFile(inputName, format, threadCount, &converter);
+	}
+
+	fprintf(stderr, "Frames: %llu Messages: %llu Dropped: %llu\n", converter.frameCount, converter.messageCount, converter.droppedCount);
+	if (nmeaOutput) {
+		fprintf(stderr, "Sentences: %llu\n", converter.sentenceCount);
+	}
+
+	return (returnCode == TWOCAN_RESULT_SUCCESS) ? 0 : 1;
+}
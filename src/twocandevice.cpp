@@ -45,6 +45,12 @@
 // wxWidgets 3.15 support for MacOSX, Fusion Media control, OCPN Messaging for NMEA 2000 Transmit, Extend PGN 130312 for Engine Exhaust
 // 2.11 - 30/06/2022 - Change Attitude XDR sentence from HEEL to ROLL, Support DPT instead of DBT for depth,
 // to mate with dashboard plugin. Prioritise GPS if multiple sources, Fix to PGN 129284 (distance)
+// 2.12 - 20/07/2022 - Flight recorder, triggered by MOB, DSC distress calls & excessive dropped frames
+// SLCAN serial adapters on Linux without slcand, Asynchronous prioritised transmit scheduler, Bus load estimation
+// Multiple SocketCAN interfaces with cross bus de-duplication, Event driven SocketCAN reads, Traffic generator
+// Network gateways (Yacht Devices RAW over UDP/TCP, Actisense N2K ASCII over TCP), Fast message sequence identifiers per PGN
+// Batched transmission of raw messages from other plugins
+// 2.13 - 26/09/2022 - NMEA 0183 conversions moved to TwoCanDecoder, shared with the headless log file converter
 // Outstanding Features: 
 // 1. Rewrite/Port Adapter drivers to C++
 //
@@ -59,6 +65,8 @@ TwoCanDevice::TwoCanDevice(wxEvtHandler *handler) : wxThread(wxTHREAD_JOINABLE)
 	// Initialise Message Queue to receive frames from either the Linux SocketCAN interface, Mac serial interface or Linux/Mac Log Reader
 	// Note for Windows version we use a different mechanism, using Windows Events.
 	canQueue = new wxMessageQueue<std::vector<byte>>();
+	adapterInterface = nullptr;
+	memset(interfaceFrames, 0, sizeof(interfaceFrames));
 #endif
 	
 	// FastMessage buffer is used to assemble the multiple frames of a fast message
@@ -69,28 +77,32 @@ TwoCanDevice::TwoCanDevice(wxEvtHandler *handler) : wxThread(wxTHREAD_JOINABLE)
 	transmittedFrames = 0;
 	droppedFrames = 0;
 	
-	// Initialise persisted values for constructed sentences such as RMC and GLL
-	gpsTimeOffset = 0;
-	magneticVariation = SHRT_MAX;
-	vesselCOG = USHRT_MAX;
-	vesselSOG = USHRT_MAX;
-
 	// Timer to send PGN126993 heartbeats and a monotonically incrementing counter
 	heartbeatTimer = nullptr;
 	heartbeatCounter = 0;
 
-	// Each AIS multi sentence message has a sequential Message ID
-	AISsequentialMessageId = 0;
+	// Flight recorder retains recent traffic, written to disk upon an incident
+	flightRecorder = nullptr;
+	if (enableRecorder == TRUE) {
+		flightRecorder = new TwoCanRecorder(recorderSeconds, recorderFormat);
+		if (flightRecorder->Run() != wxTHREAD_NO_ERROR) {
+			wxLogError(_T("TwoCan Device, Unable to start flight recorder"));
+			delete flightRecorder;
+			flightRecorder = nullptr;
+		}
+	}
 
-	// Until engineInstance > 0 then assume a single engined vessel
-	IsMultiEngineVessel = FALSE;
+	// Transmit scheduler, frames are queued by the callers and written to the adapter by the scheduler's thread
+	transmitScheduler = nullptr;
+	if (deviceMode == TRUE) {
+		transmitScheduler = new TwoCanScheduler([this](const CanFrame *frames, const size_t frameCount, size_t *framesWritten) { return WriteAdapterFrames(frames, frameCount, framesWritten); }, CONST_SCHEDULER_TARGET_LOAD, &busLoad);
+		if (transmitScheduler->Run() != wxTHREAD_NO_ERROR) {
+			wxLogError(_T("TwoCan Device, Unable to start transmit scheduler"));
+			delete transmitScheduler;
+			transmitScheduler = nullptr;
+		}
+	}
 
-	// Initialize Preferred GPS Sources
-	preferredGPS.sourceAddress = CONST_GLOBAL_ADDRESS;
-	preferredGPS.hdop = USHRT_MAX;
-	preferredGPS.hdopRetry = 0;
-	preferredGPS.lastUpdate = wxDateTime::Now();
-	
 	// Any raw logging ?
 	if (logLevel > FLAGS_LOG_NONE) {
 		wxDateTime tm = wxDateTime::Now();
@@ -123,7 +135,18 @@ void TwoCanDevice::OnHeartbeat(wxEvent &event) {
 	else {
 		wxLogMessage(_T("TwoCan Device, Error sending heartbeat: %d"), returnCode);
 	}
-	wxThread::Sleep(CONST_TEN_MILLIS);
+
+	wxLogMessage(_T("TwoCan Device, Bus load: %.1f%% (1 second), %.1f%% (10 seconds)"), GetBusLoad(CONST_BUSLOAD_WINDOW_SHORT), GetBusLoad(CONST_BUSLOAD_WINDOW_LONG));
+
+	// Report the transmit queue depths, the scheduler's queue and that of the adapter
+	if (transmitScheduler != nullptr) {
+#if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
+		wxLogMessage(_T("TwoCan Device, Transmit queue depth: %d, Adapter queue depth: %d"), (int)transmitScheduler->GetQueueDepth(), adapterInterface->GetTransmitQueueDepth());
+#else
+		wxLogMessage(_T("TwoCan Device, Transmit queue depth: %d"), (int)transmitScheduler->GetQueueDepth());
+#endif
+	}
+
 	// Iterate through the network map
 	int numberOfDevices = 0;
 	for (int i = 0; i < CONST_MAX_DEVICES; i++) {
@@ -138,7 +161,6 @@ void TwoCanDevice::OnHeartbeat(wxEvent &event) {
 				else {
 					wxLogMessage(_T("TwoCan Device, Error sending ISO Request for 126996 to %d: %d"), i, returnCode);
 				}
-				wxThread::Sleep(CONST_TEN_MILLIS);
 			}
 			if (wxDateTime::Now() > (networkMap[i].timestamp + wxTimeSpan::Seconds(60))) {
 			// If an entry is stale, send an address claim request.
@@ -150,7 +172,6 @@ void TwoCanDevice::OnHeartbeat(wxEvent &event) {
 				else {
 					wxLogMessage(_T("TwoCan Device, Error sending ISO Request  for 60928 to %d: %d"), i, returnCode);
 				}
-				wxThread::Sleep(CONST_TEN_MILLIS);
 			}
 			numberOfDevices += 1;
 		}
@@ -164,7 +185,6 @@ void TwoCanDevice::OnHeartbeat(wxEvent &event) {
 				else {
 					wxLogMessage(_T("TwoCan Device, Error sending ISO Request  for 60928 to %d: %d"), i, returnCode);
 				}
-				wxThread::Sleep(CONST_TEN_MILLIS);
 				numberOfDevices += 1;
 			}
 		}
@@ -273,6 +293,11 @@ int TwoCanDevice::Init(wxString driverPath) {
 		adapterInterface = new TwoCanPcap(canQueue);
 		returnCode = adapterInterface->Open(CONST_PCAPFILE_NAME);
 	}
+	else if (driverName.CmpNoCase("Traffic Generator") == 0) {
+		// Load the synthetic traffic generator, for testing without a CAN bus
+		adapterInterface = new TwoCanGenerator(canQueue, generatorRate, generatorTargets, generatorLoss, generatorReorder);
+		returnCode = adapterInterface->Open(driverName);
+	}
 #if defined (__APPLE__) && defined (__MACH__)
 	else if (driverName.CmpNoCase("Cantact") == 0) {
 		// Load the MAC Serial USB interface for the Canable Cantact
@@ -292,6 +317,21 @@ int TwoCanDevice::Init(wxString driverPath) {
 #endif
 
 #if defined (__LINUX__)
+	else if (TwoCanSerial::IsSerialInterface(driverName)) {
+		// Load the SLCAN serial interface (eg. Canable Cantact /dev/ttyACM0 or a pseudo terminal /dev/pts/3), accessed directly rather than via slcand
+		adapterInterface = new TwoCanSerial(canQueue);
+		returnCode = adapterInterface->Open(canAdapter);
+	}
+	else if (TwoCanNetwork::IsNetworkAdapter(driverName)) {
+		// Load the network gateway interface, eg. "udp://192.168.4.1:1457" or "actisense://192.168.4.1:60002"
+		adapterInterface = new TwoCanNetwork(canQueue);
+		returnCode = adapterInterface->Open(canAdapter);
+	}
+	else if (driverName.Contains(_T(","))) {
+		// Load the SocketCAN interface for several buses, eg. "can0,can1"
+		adapterInterface = new TwoCanMultiSocket(canQueue);
+		returnCode = adapterInterface->Open(canAdapter);
+	}
 	else if (driverName.MakeUpper().Matches(_T("CAN?")) || driverName.MakeUpper().Matches(_T("SLCAN?")) || driverName.MakeUpper().Matches(_T("VCAN?")) ) {
 		// Load the SocketCAN interface (eg. Native Interface CAN0, Serial Interface SLCAN0, Virtual Interface VCAN0)
 		adapterInterface = new TwoCanSocket(canQueue);
@@ -374,11 +414,22 @@ wxThread::ExitCode TwoCanDevice::Entry() {
 void TwoCanDevice::OnExit() {
 	int returnCode;
 
+	// Terminate the transmit scheduler before the adapter is closed
+	if (transmitScheduler != nullptr) {
+		wxThread::ExitCode schedulerExitCode;
+		transmitScheduler->Delete(&schedulerExitCode, wxTHREAD_WAIT_BLOCK);
+		transmitScheduler->Wait(wxTHREAD_WAIT_BLOCK);
+		delete transmitScheduler;
+		transmitScheduler = nullptr;
+	}
+
 #if (defined (__APPLE__) && defined (__MACH__)) || defined  (__LINUX__)
 	wxThread::ExitCode threadExitCode;
 	wxThreadError threadError;
 
 	wxLogMessage(_T("TwoCan Device, Terminating driver thread id: (0x%x)\n"), adapterInterface->GetId());
+	// Wake the driver thread should it be blocked waiting for frames
+	adapterInterface->Interrupt();
 	threadError = adapterInterface->Delete(&threadExitCode, wxTHREAD_WAIT_BLOCK);
 	if (threadError == wxTHREAD_NO_ERROR) {
 		wxLogMessage(_T("TwoCan Device, Terminated driver thread: %d"), threadExitCode);
@@ -389,6 +440,9 @@ void TwoCanDevice::OnExit() {
 	// Wait for the interface thread to exit
 	adapterInterface->Wait(wxTHREAD_WAIT_BLOCK);
 
+	// Retain the number of interfaces for the statistics below, as Close discards them
+	int interfaceCount = adapterInterface->GetInterfaceCount();
+
 	// Can only invoke close if it is a joinable thread as detached threads would have already deleted themselves
 	returnCode = adapterInterface->Close();
 	if (returnCode != TWOCAN_RESULT_SUCCESS) {
@@ -398,6 +452,14 @@ void TwoCanDevice::OnExit() {
 	// Can only delete the interface class if it is a joinable thread.
 	delete adapterInterface;
 
+	// Per interface statistics, only of interest if the adapter serves more than one interface,
+	// every interface is reported as one that received nothing probably has a fault
+	if (interfaceCount > 1) {
+		for (int i = 0; (i < interfaceCount) && (i < CONST_MAX_INTERFACES); i++) {
+			wxLogMessage(_T("TwoCan Device, Interface %d received %llu frames"), i, interfaceFrames[i]);
+		}
+	}
+
 #endif
 
 #if defined (__WXMSW__) 
@@ -416,6 +478,15 @@ void TwoCanDevice::OnExit() {
 		heartbeatTimer->Unbind(wxEVT_TIMER, &TwoCanDevice::OnHeartbeat, this);
 	}
 
+	// Terminate the flight recorder
+	if (flightRecorder != nullptr) {
+		wxThread::ExitCode recorderExitCode;
+		flightRecorder->Delete(&recorderExitCode, wxTHREAD_WAIT_BLOCK);
+		flightRecorder->Wait(wxTHREAD_WAIT_BLOCK);
+		delete flightRecorder;
+		flightRecorder = nullptr;
+	}
+
 	// If logging, close log file
 	if (logLevel > FLAGS_LOG_NONE) {
 		if (rawLogFile.IsOpened()) {
@@ -430,6 +501,11 @@ void TwoCanDevice::OnExit() {
 
 #if (defined (__APPLE__) && defined (__MACH__) ) || defined (__LINUX__)
 
+// Wake the read thread, which blocks on the message queue, so that it may be terminated. Invoked prior to Delete
+void TwoCanDevice::Interrupt(void) {
+	canQueue->Post(std::vector<byte>());
+}
+
 int TwoCanDevice::ReadLinuxOrMacDriver(void) {
 	CanHeader header;
 	byte payload[CONST_PAYLOAD_LENGTH];
@@ -441,21 +517,40 @@ int TwoCanDevice::ReadLinuxOrMacDriver(void) {
 	
 	while (!TestDestroy())	{
 		
-		// Wait for a CAN Frame. timeout if on an idle network
-		queueError = canQueue->ReceiveTimeout(CONST_TEN_MILLIS, receivedFrame);
+		// Block waiting for CAN Frames, Interrupt posts an empty message to wake us when the device is being terminated
+		queueError = canQueue->Receive(receivedFrame);
+
+		if ((queueError == wxMSGQUEUE_NO_ERROR) && (receivedFrame.size() == 0)) {
+			break;
+		}
 		
 		if (queueError == wxMSGQUEUE_NO_ERROR) {
+
+			// Adapters may post several frames in a single message
+			for (size_t offset = 0; offset + CONST_FRAME_LENGTH <= receivedFrame.size(); offset += CONST_FRAME_LENGTH) {
+
+				// Multi interface adapters tag each frame with the interface on which it was received, using the unused header bits
+				byte interfaceIndex = (receivedFrame[offset + 3] & CONST_INTERFACE_TAG_MASK) >> CONST_INTERFACE_TAG_SHIFT;
+				receivedFrame[offset + 3] &= ~CONST_INTERFACE_TAG_MASK;
+				interfaceFrames[interfaceIndex] += 1;
 					
-			TwoCanUtils::DecodeCanHeader(&receivedFrame[0], &header);
+				TwoCanUtils::DecodeCanHeader(&receivedFrame[offset], &header);
 
-			memcpy(payload, &receivedFrame[CONST_HEADER_LENGTH], CONST_PAYLOAD_LENGTH);
+				memcpy(payload, &receivedFrame[offset + CONST_HEADER_LENGTH], CONST_PAYLOAD_LENGTH);
 			
-			// Log received frames
-			if (logLevel > FLAGS_LOG_NONE) {
-				LogReceivedFrames(&header, &receivedFrame[0]);
-			}
+				// Log received frames
+				if (logLevel > FLAGS_LOG_NONE) {
+					LogReceivedFrames(&header, &receivedFrame[offset]);
+				}
+
+				if (flightRecorder != nullptr) {
+					flightRecorder->Record(&receivedFrame[offset]);
+				}
+
+				busLoad.Record(&receivedFrame[offset]);
 			
-			AssembleFastMessage(header, payload);
+				AssembleFastMessage(header, payload);
+			}
 		
 		}
 
@@ -657,6 +752,12 @@ int TwoCanDevice::ReadWindowsDriver() {
 					if (logLevel > FLAGS_LOG_NONE) {
 						LogReceivedFrames(&header, canFrame);
 					}
+
+					if (flightRecorder != nullptr) {
+						flightRecorder->Record(canFrame);
+					}
+
+					busLoad.Record(canFrame);
 					
 					AssembleFastMessage(header, payload);
 					
@@ -803,15 +904,7 @@ void TwoCanDevice::RaiseEvent(wxString sentence) {
 
 // Checks whether a frame is a single frame message or multiframe Fast Packet message
 bool TwoCanDevice::IsFastMessage(const CanHeader header) {
-	static const unsigned int nmeafastMessages[] = { 65240, 126208, 126464, 126996, 126998, 127233, 127237, 127489, 127496, 127506, 128275, 129029, 129038, \
-	129039, 129040, 129041, 129284, 129285, 129540, 129793, 129794, 129795, 129797, 129798, 129801, 129802, 129808, 129809, 129810, 130065, 130074, 130323, \
-	130577, 130820, 130822, 130824 };
-	for (size_t i = 0; i < sizeof(nmeafastMessages)/sizeof(unsigned int); i++) {
-		if (nmeafastMessages[i] == header.pgn) {
-			return TRUE;
-		}
-	}
-	return FALSE;
+	return TwoCanUtils::IsFastMessage(header.pgn);
 }
 
 // Determine if message is a single frame message (if so parse it) otherwise
@@ -977,6 +1070,7 @@ int TwoCanDevice::MapAppendEntry(const CanHeader header, const byte *data, const
 		if ((droppedFrames > CONST_DROPPEDFRAME_THRESHOLD) && (wxDateTime::Now() < (droppedFrameTime + wxTimeSpan::Seconds(CONST_DROPPEDFRAME_PERIOD) ) ) ) {
 			wxLogError(_T("TwoCan Device, Dropped Frames rate exceeded"));
 			wxLogError(wxString::Format(_T("Frame: Source: %d Destination: %d Priority: %d PGN: %d"),header.source, header.destination, header.priority, header.pgn));
+			TriggerRecorder(_T("Dropped Frames rate exceeded"));
 			droppedFrames = 0;
 		}
 		return FALSE;
@@ -1298,12 +1392,6 @@ void TwoCanDevice::ParseMessage(const CanHeader header, const byte *payload) {
 		result = FALSE;
 		break;
 		
-	case 126992: // System Time
-		if (supportedPGN & FLAGS_ZDA) {
-			result = DecodePGN126992(payload, &nmeaSentences);
-		}
-		break;
-		
 	case 126993: // Heartbeat
 		DecodePGN126993(header.source, payload);
 		// Update the matching entry in the network map
@@ -1344,271 +1432,16 @@ void TwoCanDevice::ParseMessage(const CanHeader header, const byte *payload) {
 		break;
 
 	case 127233: // Man Overboard
-		if (supportedPGN & FLAGS_MOB) {
-			result = DecodePGN127233(payload, &nmeaSentences);
-		}
-		break;
-
-	case 127237: // Heading/Track control
-		if (supportedPGN & FLAGS_NAV) {
-			result = DecodePGN127237(payload, &nmeaSentences);
-		}
-		break;
-
-	case 127245: // Rudder
-		if (supportedPGN & FLAGS_RSA) {
-			result = DecodePGN127245(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 127250: // Heading
-		if (supportedPGN & FLAGS_HDG) {
-			result = DecodePGN127250(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 127251: // Rate of Turn
-		if (supportedPGN & FLAGS_ROT) {
-			result = DecodePGN127251(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 127257: // Attitude
-		if (supportedPGN & FLAGS_XDR) {
-			result = DecodePGN127257(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 127258: // Magnetic Variation
-		// BUG BUG needs flags 
-		// BUG BUG Not actually used anywhere
-		result = DecodePGN127258(payload, &nmeaSentences);
-		break;
-
-	case 127488: // Engine Parameters, Rapid Update
-		if (supportedPGN & FLAGS_ENG) {
-			result = DecodePGN127488(payload, &nmeaSentences);
-		}
-		break;
-
-	case 127489: // Engine Parameters, Dynamic
-		if (supportedPGN & FLAGS_ENG) {
-			result = DecodePGN127489(payload, &nmeaSentences);
-		}
-		break;
-
-	case 127505: // Fluid Levels
-		if (supportedPGN & FLAGS_TNK) {
-			result = DecodePGN127505(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 127508: // Battery Status
-		if (supportedPGN & FLAGS_BAT) {
-			result = DecodePGN127508(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 128259: // Boat Speed
-		if (supportedPGN & FLAGS_VHW) {
-			result = DecodePGN128259(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 128267: // Water Depth
-		if (supportedPGN & FLAGS_DPT) {
-			result = DecodePGN128267(payload, &nmeaSentences);
-		}
-		break;
-		
-		case 128275: // Distance Log
-		if (supportedPGN & FLAGS_LOG) {
-			result = DecodePGN128275(payload, &nmeaSentences);
-		}
-		break;
-
-	case 129025: // Position - Rapid Update
-		if (supportedPGN & FLAGS_GLL) {
-			result = DecodePGN129025(payload, &nmeaSentences, header.source);
-		}
-		break;
-	
-	case 129026: // COG, SOG - Rapid Update
-		if (supportedPGN & FLAGS_VTG) {
-			result = DecodePGN129026(payload, &nmeaSentences, header.source);
-		}
-		break;
-	
-	case 129029: // GNSS Position
-		if (supportedPGN & FLAGS_GGA) {
-			result = DecodePGN129029(payload, &nmeaSentences, header.source);
-		}
-		break;
-	
-	case 129033: // Time & Date
-		if (supportedPGN & FLAGS_ZDA) {
-			result = DecodePGN129033(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 129038: // AIS Class A Position Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129038(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129039: // AIS Class B Position Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129039(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129040: // AIS Class B Extended Position Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129040(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129041: // AIS Aids To Navigation (AToN) Position Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129041(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129283: // Cross Track Error
-		if (supportedPGN & FLAGS_XTE) {
-			result = DecodePGN129283(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 129284: // Navigation Information
-		if (supportedPGN & FLAGS_NAV) {
-			result = DecodePGN129284(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 129285: // Route & Waypoint Information
-		if (supportedPGN & FLAGS_RTE) {
-			result = DecodePGN129285(payload, &nmeaSentences);
-		}
-		break;
-
-	case 129539: // GNSS DOP's
-		if (supportedPGN & FLAGS_GGA) {
-			result = DecodePGN129539(payload, &nmeaSentences);
-		}
-		break;
-
-	case 129540: // GNSS Satellites in view
-		if (supportedPGN & FLAGS_GGA) {
-			result = DecodePGN129540(payload, &nmeaSentences);
-		}
-		break;
-
-	case 129793: // AIS Position and Date Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129793(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129794: // AIS Class A Static & Voyage Related Data
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129794(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129795: // AIS Addressed Binary Message
-		// BUG BUG to implement
-		//if (supportedPGN & FLAGS_AIS) {
-		//	result = DecodePGN129795(payload, &nmeaSentences);
-		//}
-		result = FALSE;
-		break;
-
-	case 129797: // AIS Binary Broadcast Message
-		// BUG BUG To implement
-		//if (supportedPGN & FLAGS_AIS) {
-		//	result = DecodePGN129795(payload, &nmeaSentences);
-		//}
-		result = FALSE;
+		TriggerRecorder(_T("Man Overboard (PGN 127233)"));
+		result = DecodeMessage(header, payload, &nmeaSentences);
 		break;
 
-	case 129798: // AIS Search and Rescue (SAR) Position Report
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129798(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 129801: // Addressed Safety Related Message
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129801(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129802: // AIS Broadcast Safety Related Message
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129802(payload, &nmeaSentences);
-		}
-		break;
-	
 	case 129808: // Digital Selective Calling (DSC)
-		if (supportedPGN & FLAGS_DSC) {
-			result = DecodePGN129808(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129809: // AIS Class B Static Data, Part A
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129809(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 129810: // Class B Static Data, Part B
-		if (supportedPGN & FLAGS_AIS) {
-			result = DecodePGN129810(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 130065: // Route & Waypoint Service - Route List
-		if (supportedPGN & FLAGS_RTE) {
-			result = DecodePGN130065(payload, &nmeaSentences);
-		}
-		break;
-
-	case 130074: // Route & Waypoint service - Waypoint List
-		if (supportedPGN & FLAGS_RTE) {
-			result = DecodePGN130074(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 130306: // Wind data
-		if (supportedPGN & FLAGS_MWV) {
-			result = DecodePGN130306(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 130310: // Environmental Parameters
-		if (supportedPGN & FLAGS_MTW) {
-			result = DecodePGN130310(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 130311: // Environmental Parameters (supercedes 130310)
-		if (supportedPGN & FLAGS_MTW) {
-			result = DecodePGN130311(payload, &nmeaSentences);
-		}
-		break;
-	
-	case 130312: // Temperature
-		if ((supportedPGN & FLAGS_MTW) || (supportedPGN & FLAGS_ENG)) {
-			result = DecodePGN130312(payload, &nmeaSentences);
-		}
-		break;
-		
-	case 130316: // Temperature Extended Range
-		if (supportedPGN & FLAGS_MTW) {
-			result = DecodePGN130316(payload, &nmeaSentences);
+		// Format Specifier 112 is a Distress call
+		if (payload[0] == 112) {
+			TriggerRecorder(_T("DSC Distress (PGN 129808)"));
 		}
+		result = DecodeMessage(header, payload, &nmeaSentences);
 		break;
 
 	case 130820: // Manufacturer Proprietary Fast Frame - only interested for Fusion Media Player integration
@@ -1617,16 +1450,10 @@ void TwoCanDevice::ParseMessage(const CanHeader header, const byte *payload) {
 		}
 		break;
 
-	case 130832: // Meteorological Data
-		if (supportedPGN & FLAGS_MET) {
-			DecodePGN130323(payload, &nmeaSentences);
-		}
-		break;
-
 	default:
+		// Conversion to NMEA 0183 sentences is performed by the decoder
 		// BUG BUG Should we log an unsupported PGN error ??
-		// No NMEA 0183 sentences to pass onto OpenCPN
-		result = FALSE;
+		result = DecodeMessage(header, payload, &nmeaSentences);
 		break;
 	}
 	// Send each NMEA 0183 Sentence to OpenCPN
@@ -1798,54 +1625,6 @@ bool TwoCanDevice::DecodePGN126720(const byte *payload) {
 	}
 }
 
-// Decode PGN 126992 NMEA System Time
-// $--ZDA, hhmmss.ss, xx, xx, xxxx, xx, xx*hh<CR><LF>
-bool TwoCanDevice::DecodePGN126992(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte timeSource;
-		timeSource = (payload[1] & 0xF) >> 4;
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[2] | (payload[3] << 8);
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[4] | (payload[5] << 8) | (payload[6] << 16) | (payload[7] << 24);
-		
-		if ((TwoCanUtils::IsDataValid(daysSinceEpoch)) && (TwoCanUtils::IsDataValid(secondsSinceMidnight))) {
-			
-			wxDateTime epoch((time_t)0);
-			epoch += wxDateSpan::Days(daysSinceEpoch);
-			epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-			
-			// Calculate the local timezone offfset in hours & minutes
-			wxDateTime::TimeZone tz(wxDateTime::Local);
-    		long seconds = tz.GetOffset();
-			int hours = seconds / (3600);
-			seconds %= 3600;
-			int minutes = seconds / 60;
-
-			if (hours > 0) {
-				nmeaSentences->push_back(wxString::Format("$IIZDA,%s,%02d,%02d", epoch.Format("%H%M%S.00,%d,%m,%Y"), hours, minutes));
-			}
-			else {
-				nmeaSentences->push_back(wxString::Format("$IIZDA,%s,%03d,%03d", epoch.Format("%H%M%S.00,%d,%m,%Y"), hours, minutes));
-			}
-			
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
 // Decode PGN 126993 NMEA Heartbeat
 bool TwoCanDevice::DecodePGN126993(const int source, const byte *payload) {
 	if (payload != NULL) {
@@ -1992,3625 +1771,67 @@ int TwoCanDevice::DecodePGN126998(const byte *payload) {
 	return FALSE;
 }
 
-// Decode PGN 127233 NMEA Man Overboard
-//$--MOB, hhhhh, a, hhmmss.ss, x, xxxxxx, hhmmss.ss, llll.ll, a, yyyyy.yy, a, x.x, x.x, xxxxxxxxx, x*hh	
-bool TwoCanDevice::DecodePGN127233(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned int emitterId;
-		emitterId = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		byte mobStatus;
-		mobStatus = payload[5] & 0x03;
-
-		byte reservedA;
-		reservedA = (payload[5] & 0xF8) >> 3;
+// Decode PGN 130820 Manufacturer Proprietary Message
+// At present return FALSE, because there are no NMEA 183 sentences to generate/send
+// Initially implemented to support TwoCan Media, A Remote Control for Fusion Media Players
+bool TwoCanDevice::DecodePGN130820(const byte *payload, std::vector<wxString> *nmeaSentences) {
+	if (payload != nullptr) {
 
-		unsigned int timeOfDay;
-		timeOfDay = payload[6] | (payload[7] << 8) | (payload[8] << 16) | (payload[9] << 24);
+		unsigned int manufacturerId;
+		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
 
-		wxDateTime epoch((time_t)0);
-		epoch += wxTimeSpan::Seconds((wxLongLong)timeOfDay / 10000);
-		wxString activationTime = epoch.Format("%H%M%S");
+		byte industryCode;
+		industryCode = (payload[1] & 0xE0) >> 5;
 
-		byte positionSource;
-		positionSource = payload[10] & 0x03;
+		switch (manufacturerId) {
+			case 229: // Garmin
+				break;
+			case 275: // Navico
+				break;
+			case  382: //B & G
+				break;
+			case 419: {// Fusion
+				if (enableMusic) {
+						wxString jsonResponse;
+						if (twoCanMedia->DecodeMediaResponse(payload, &jsonResponse)) {
+							if (jsonResponse.Length() > 0) {
+								SendPluginMessage(_T("TWOCAN_MEDIA_RESPONSE"), jsonResponse);
+							}
+						}
+					}
+				}
+				break;
+			case 1875: // Simrad
+				break;
+		}
+	}
+	return FALSE;
+}
 
-		byte reservedB;
-		reservedB = (payload[10] & 0xF8) >> 3;
+bool TwoCanDevice::DecodePGN130822(const byte *payload) {
+	if (payload != nullptr) {
 
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[11] | (payload[12] << 8);
+		unsigned int manufacturerId;
+		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
 
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[13] | (payload[14] << 8) | (payload[15] << 16) | (payload[16] << 24);
+		byte industryCode;
+		industryCode = (payload[1] & 0xE0) >> 5;
 
-		epoch = (time_t)0;
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
+		return FALSE;
+	}
+	else {
+		return FALSE;
+	}
+}
 
-		int latitude;
-		latitude = (int)payload[17] | ((int)payload[18] << 8) | ((int)payload[19] << 16) | ((int)payload[20] << 24);
+bool TwoCanDevice::DecodePGN130824(const byte *payload) {
+	if (payload != nullptr) {
 
-		double latitudeDouble = ((double)latitude * 1e-7);
-		int latitudeDegrees = trunc(latitudeDouble);
-		double latitudeMinutes = (latitudeDouble - latitudeDegrees) * 60;
+		unsigned int manufacturerId;
+		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
 
-		int longitude;
-		longitude = (int)payload[21] | ((int)payload[22] << 8) | ((int)payload[23] << 16) | ((int)payload[24] << 24);
-
-		double longitudeDouble = ((double)longitude * 1e-7);
-		int longitudeDegrees = trunc(longitudeDouble);
-		double longitudeMinutes = (longitudeDouble - longitudeDegrees) * 60;
-
-		byte cogReference;
-		cogReference = payload[25] & 0x02;
-
-		unsigned short courseOverGround;
-		courseOverGround = payload[26] | (payload[27] << 8);
-
-		unsigned short speedOverGround;
-		speedOverGround = payload[28] | (payload[29] << 8);
-
-		unsigned int mmsiNumber;
-		mmsiNumber = payload[30] | (payload[31] << 8) | (payload[32] << 16) | (payload[33] << 24);
-
-		byte batteryStatus;
-		batteryStatus = payload[34] & 0x03;
-
-		nmeaSentences->push_back(wxString::Format("$IIMOB,%05X,%c,%s,%d,%s,%s,%02d%07.4f,%c,%03d%07.4f,%c,%.0f,%.0f,%d,%d",
-			emitterId, // 5 hex digits
-			mobStatus == 0 ? 'A' : mobStatus == 1 ? 'M' : mobStatus == 2 ? 'T' : 'V',
-			activationTime.ToAscii().data(), positionSource,
-			epoch.Format("%d%m%y").ToAscii().data(), epoch.Format("%H%M%S").ToAscii().data(),
-			abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S',
-			abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W',
-			speedOverGround * CONVERT_MS_KNOTS / 100, RADIANS_TO_DEGREES((float)courseOverGround / 10000),
-			mmsiNumber, batteryStatus));
-
-		// As OpenCPN does not support this sentence, just drop a waypoint
-		// When it does, remove this code
-		PlugIn_Waypoint waypoint;
-		waypoint.m_IsVisible = true;
-		waypoint.m_MarkName = wxString::Format("Man Overboard at: %s", activationTime);
-		waypoint.m_IconName = _T("Mob");
-		waypoint.m_GUID = GetNewGUID();
-		waypoint.m_lat = latitudeDouble;
-		waypoint.m_lon = longitudeDouble;
-		AddSingleWaypoint(&waypoint, true);
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-
-// Decode PGN 127237 NMEA Heading/Track Control
-// $--APB,A,A,x.x,a,N,A,A,x.x,a,c--c,x.x,a,x.x,a*hh<CR><LF>
-// 
-
-//Status A OK, V reliable fix is not available
-
-//Status V = Loran-C Cycle Lock warning flag A = OK or not used
-
-//Cross Track Error Magnitude
-
-//Direction to steer, L or R
-
-//Cross Track Units, N = Nautical Miles
-
-//Status A = Arrival Circle Entered
-
-//Status A = Perpendicular passed at waypoint
-
-//Bearing origin to destination
-
-//M = Magnetic, T = True
-
-//Destination Waypoint ID
-
-//Bearing, present position to Destination
-
-//M = Magnetic, T = True
-
-//Heading to steer to destination waypoint
-
-//M = Magnetic, T = True
-
-
-bool TwoCanDevice::DecodePGN127237(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte rudderLimitExceeded; // 0 - No, 1 - Yes, 2 - Error, 3 - Unavailable
-		rudderLimitExceeded = (payload[0] & 0xC0) >> 6;
-
-		byte offHeadingLimitExceeded; // 0 - No, 1 - Yes, 2 - Error, 3 - Unavailable
-		offHeadingLimitExceeded = (payload[0] & 0x30) >> 4; 
-        
-		byte offTrackLimitExceeded;
-		offTrackLimitExceeded = (payload[0] & 0x0C) >> 2;
-        
-		byte overRide;
-		overRide = payload[0] & 0x03;
-		
-		byte steeringMode;
-		steeringMode = (payload[1] & 0xE0) >> 5;
-		// 0 - Main Steering
-		// 1 - Non-Follow-up Device
-		// 2 - Follow-up Device
-		// 3 - Heading Control Standalone
-		// 4 - Heading Control
-		// 5 - Track Control
-		
-		byte turnMode;
-		turnMode = (payload[1] & 0x1C) >> 2;
-        // 0 - Rudder Limit controlled
-        // 1 - turn rate controlled
-        // 2 - radius controlled
-		
-		byte headingReference;
-		headingReference = payload[1] & 0x03;
-		// 0 - True
-		// 1 - Magnetic
-		// 2 - Error
-		// 3 - Null
-		
-		byte reserved;
-		reserved = (payload[2] & 0xF8) >> 3;
-          
-		byte commandedRudderDirection;
-		commandedRudderDirection = payload[2] & 0x03;
-        // 0 - No Order
-		// 1 - Move to starboard
-		// 2 - Move to port
-		short commandedRudderAngle; //0.0001 radians
-		commandedRudderAngle = payload[3] | (payload[4] << 8);
-		
-		unsigned short headingToSteer; //0.0001 radians
-		headingToSteer = payload[5] | (payload[6] << 8);
-        
-		unsigned short track; //0.0001 radians
-		track = payload[7] | (payload[8] << 8);
-
-		unsigned short rudderLimit; //0.0001 radians
-		rudderLimit = payload[9] | (payload[10] << 8);
-
-		unsigned short offHeadingLimit; // 0.0001 radians
-		offHeadingLimit = payload[11] | (payload[12] << 8);
-		  
-		short radiusOfTurn; // 0.0001 radians
-		radiusOfTurn = payload[13] | (payload[14] << 8);
-		  
-		short rateOfTurn; // 3.125e-05
-		rateOfTurn = payload[15] | (payload[16] << 8); 
-
-        short offTrackLimit; //in metres (or is it 0.01 m)??
-		offTrackLimit = payload[17] | (payload[18] << 8); 
-		
-		unsigned short vesselHeading; // 0.0001 radians
-		vesselHeading = payload[19] | (payload[20] << 8); 
-
-		nmeaSentences->push_back(wxString::Format("$IIAPB,A,A,%0.2f,%c,N,,,%02f,%c ", \
-		 fabs(CONVERT_METRES_NAUTICAL_MILES * offTrackLimit),offTrackLimit < 0? 'L':'R', \
-		 RADIANS_TO_DEGREES((float)headingToSteer / 10000), \
-		 headingReference == 0 ? 'T' : headingReference == 1 ? 'M' : char(0) ));
-	}
-	return TRUE;
-}
-
-// Decode PGN 127245 NMEA Rudder
-// $--RSA, x.x, A, x.x, A*hh<CR><LF>
-bool TwoCanDevice::DecodePGN127245(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte instance;
-		instance = payload[0];
-
-		byte directionOrder;
-		directionOrder = payload[1] & 0x03;
-
-		short angleOrder; // 0.0001 radians
-		angleOrder = payload[2] | (payload[3] << 8);
-
-		short position; // 0.0001 radians
-		position = payload[4] | (payload[5] << 8);
-
-		if (TwoCanUtils::IsDataValid(position)) {
-			// Main (or Starboard Rudder
-			if (instance == 0) { 
-				nmeaSentences->push_back(wxString::Format("$IIRSA,%.2f,A,0.0,V", RADIANS_TO_DEGREES((float)position / 10000)));
-				return TRUE;
-			}
-			// Port Rudder
-			else if (instance == 1) {
-				nmeaSentences->push_back(wxString::Format("$IIRSA,0.0,V,%.2f,A", RADIANS_TO_DEGREES((float)position / 10000)));
-				return TRUE;
-			}
-			return FALSE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127250 NMEA Vessel Heading
-// $--HDG, x.x, x.x, a, x.x, a*hh<CR><LF>
-// $--HDT,x.x,T*hh<CR><LF>
-bool TwoCanDevice::DecodePGN127250(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned short heading;
-		heading = payload[1] | (payload[2] << 8);
-
-		short deviation;
-		deviation = payload[3] | (payload[4] << 8);
-
-		short variation;
-		variation = payload[5] | (payload[6] << 8);
-
-		byte headingReference;
-		headingReference = (payload[7] & 0x03);
-		
-		// Sign of variation and deviation corresponds to East (E) or West (W)
-		
-		if (headingReference == HEADING_MAGNETIC) {
-		
-			if (TwoCanUtils::IsDataValid(heading)) {
-				
-				nmeaSentences->push_back(wxString::Format("$IIHDM,%.2f,M", RADIANS_TO_DEGREES((float)heading / 10000)));
-			
-				if (TwoCanUtils::IsDataValid(deviation)) {
-				
-					if (TwoCanUtils::IsDataValid(variation)) {
-						// heading, deviation and variation all valid
-						nmeaSentences->push_back(wxString::Format("$IIHDG,%.2f,%.2f,%c,%.2f,%c", RADIANS_TO_DEGREES((float)heading / 10000), \
-							RADIANS_TO_DEGREES((float)deviation / 10000), deviation >= 0 ? 'E' : 'W', \
-							RADIANS_TO_DEGREES((float)variation / 10000), variation >= 0 ? 'E' : 'W'));
-						return TRUE;
-					}
-				
-					else {
-						// heading, deviation are valid, variation invalid
-						nmeaSentences->push_back(wxString::Format("$IIHDG,%.2f,%.2f,%c,,", RADIANS_TO_DEGREES((float)heading / 10000), \
-							RADIANS_TO_DEGREES((float)deviation / 10000), deviation >= 0 ? 'E' : 'W'));
-						return TRUE;
-					}
-				}
-				
-				else {
-					if (TwoCanUtils::IsDataValid(variation)) {
-						// heading and variation valid, deviation invalid
-						nmeaSentences->push_back(wxString::Format("$IIHDG,%.2f,,,%.2f,%c", RADIANS_TO_DEGREES((float)heading / 10000), \
-							RADIANS_TO_DEGREES((float)variation / 10000), variation >= 0 ? 'E' : 'W'));
-						return TRUE;
-					}
-					else {
-						// heading valid, deviation and variation both invalid
-						nmeaSentences->push_back(wxString::Format("$IIHDG,%.2f,,,,", RADIANS_TO_DEGREES((float)heading / 10000)));
-						return TRUE;
-		
-					}	
-					
-				}
-			
-			}
-			else {
-				return FALSE;
-			}
-		}
-		else if (headingReference == HEADING_TRUE) {
-			if (TwoCanUtils::IsDataValid(heading)) {
-				nmeaSentences->push_back(wxString::Format("$IIHDT,%.2f", RADIANS_TO_DEGREES((float)heading / 10000)));
-				return TRUE;
-			}
-			else {
-				return FALSE;
-			}
-			
-		}
-		else {
-			return FALSE;
-		}
-		
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127251 NMEA Rate of Turn (ROT)
-// $--ROT,x.x,A*hh<CR><LF>
-bool TwoCanDevice::DecodePGN127251(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		int rateOfTurn;
-		rateOfTurn = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		// convert radians per second to degress per minute
-		// -ve sign means turning to port
-		
-		if (TwoCanUtils::IsDataValid(rateOfTurn)) {
-			nmeaSentences->push_back(wxString::Format("$IIROT,%.2f,A", RADIANS_TO_DEGREES((float)rateOfTurn * 3.125e-8)));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127257 NMEA Attitude
-// $--XDR,a,x.x,a,c--c,...…………...a,x.x,a,c--c*hh<CR><LF>
-//        |  |  |   |      |        |
-//        |  |  |   |      |      Transducer 'n'1
-//        |  |  |   |   Data for variable # of transducers
-//        |  |  | Transducer #1 ID
-//        |  | Units of measure, Transducer #12
-//        | Measurement data, Transducer #1
-//     Transducer type, Transducer #1
-// Yaw, Pitch & Roll - Transducer type is A (Angular displacement), Units of measure is D (degrees)
-
-bool TwoCanDevice::DecodePGN127257(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		short yaw;
-		yaw = payload[1] | (payload[2] << 8);
-
-		short pitch;
-		pitch = payload[3] | (payload[4] << 8);
-
-		short roll;
-		roll = payload[5] | (payload[6] << 8);
-
-		wxString xdrString;
-
-		// BUG BUG Not sure if Dashboard supports yaw and whether roll should be ROLL or HEEL
-		// BUG BUG NMEA 183 v4.11 standard defines Pitch, Yaw & Roll, however don't want to break the existing dashboard
-		if (TwoCanUtils::IsDataValid(yaw)) {
-			xdrString.Append(wxString::Format("A,%0.2f,D,YAW,", RADIANS_TO_DEGREES((float)yaw / 10000)));
-		}
-
-		if (TwoCanUtils::IsDataValid(pitch)) {
-			xdrString.Append(wxString::Format("A,%0.2f,D,PITCH,", RADIANS_TO_DEGREES((float)pitch / 10000)));
-		}
-
-		if (TwoCanUtils::IsDataValid(roll)) {
-			xdrString.Append(wxString::Format("A,%0.2f,D,ROLL,", RADIANS_TO_DEGREES((float)roll / 10000)));
-		}
-
-		if (xdrString.length() > 0) {
-			xdrString.Prepend("$IIXDR,");
-			nmeaSentences->push_back(xdrString);
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-
-// Decode PGN 127258 NMEA Magnetic Variation
-bool TwoCanDevice::DecodePGN127258(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte variationSource; //4 bits
-		variationSource = payload[1] & 0x0F;
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[2] | (payload[3] << 8);
-
-		short variation;
-		variation = payload[4] | (payload[5] << 8);
-
-		// Persist variation for use by other constructed sentences such as RMC
-		magneticVariation = variation;
-
-		variation = RADIANS_TO_DEGREES((float)variation / 10000);
-
-		// BUG BUG Needs to be added to other sentences such as HDG and RMC conversions
-		// As there is no direct NMEA 0183 sentence just for variation
-		return FALSE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127488 NMEA Engine Parameters, Rapid Update
-bool TwoCanDevice::DecodePGN127488(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte engineInstance;
-		engineInstance = payload[0];
-
-		unsigned short engineSpeed;
-		engineSpeed = payload[1] | (payload[2] << 8);
-
-		unsigned short engineBoostPressure;
-		engineBoostPressure = payload[3] | (payload[4] << 8);
-
-		// BUG BUG Need to clarify units & resolution, although unlikely to use this anywhere
-		short engineTrim;
-		engineTrim = payload[5];
-
-		// Note that until we receive data from engine instance 1, we will always assume it is a single engine vessel
-		if (engineInstance > 0) {
-			IsMultiEngineVessel = TRUE;
-		}
-
-		if (TwoCanUtils::IsDataValid(engineSpeed)) {
-			// BUGB BUG Note, Now using NMEA 183 v4.11 standard XDR names
-			nmeaSentences->push_back(wxString::Format("$IIXDR,T,%.2f,R,Engine#%1d", engineSpeed * 0.25f, engineInstance));
-			/*
-			switch (engineInstance) {
-				// Note use of flag to identify whether single engine or dual engine as
-				// engineInstance 0 in a dual engine configuration is the port engine
-				// BUG BUG Should I use XDR or RPM sentence ?? Depends on how I code the Engine Dashboard !!
-				case 0:
-					if (IsMultiEngineVessel) {
-						nmeaSentences->push_back(wxString::Format("$IIXDR,T,%.2f,R,PORT", engineSpeed * 0.25f));
-						// nmeaSentences->push_back(wxString::Format("$IIRPM,E,2,%.2f,,A", engineSpeed * 0.25f));
-					}
-					else {
-						nmeaSentences->push_back(wxString::Format("$IIXDR,T,%.2f,R,MAIN", engineSpeed * 0.25f));
-						// nmeaSentences->push_back(wxString::Format("$IIRPM,E,0,%.2f,,A", engineSpeed * 0.25f));
-					}
-					break;
-				case 1:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,T,%.2f,R,STBD", engineSpeed * 0.25f));
-					// nmeaSentences->push_back(wxString::Format("$IIRPM,E,1,%.2f,,A", engineSpeed * 0.25f));
-					break;
-				default:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,T,%.2f,R,MAIN", engineSpeed * 0.25f));
-					// nmeaSentences->push_back(wxString::Format("$IIRPM,E,0,%.2f,,A", engineSpeed * 0.25f));
-					break;
-			}
-			*/
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127489 NMEA Engine Parameters, Dynamic
-bool TwoCanDevice::DecodePGN127489(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte engineInstance;
-		engineInstance = payload[0];
-
-		unsigned short oilPressure; // hPa (1hPa = 100Pa)
-		oilPressure = payload[1] | (payload[2] << 8);
-
-		unsigned short oilTemperature; // 0.01 degree resolution, in Kelvin
-		oilTemperature = payload[3] | (payload[4] << 8);
-
-		unsigned short engineTemperature; // 0.01 degree resolution, in Kelvin
-		engineTemperature = payload[5] | (payload[6] << 8);
-
-		unsigned short alternatorPotential; // 0.01 Volts
-		alternatorPotential = payload[7] | (payload[8] << 8);
-
-		unsigned short fuelRate; // 0.1 Litres/hour
-		fuelRate = payload[9] | (payload[10] << 8);
-
-		unsigned short totalEngineHours;  // seconds
-		totalEngineHours = payload[11] | (payload[12] << 8) | (payload[13] << 16) | (payload[14] << 24);
-
-		unsigned short coolantPressure; // hPA
-		coolantPressure = payload[15] | (payload[16] << 8);
-
-		unsigned short fuelPressure; // hPa
-		fuelPressure = payload[17] | (payload[18] << 8);
-
-		unsigned short reserved;
-		reserved = payload[19];
-
-		short statusOne;
-		statusOne = payload[20] | (payload[21] << 8);
-		// BUG BUG Think of using XDR switch status with meaningful naming
-		// XDR parameters, "S", No units, "1" = On, "0" = Off
-		// Eg. "$IIXDR,S,1,,S100,S,1,,S203" to indicate Status One - Check Engine, Status 2 - Maintenance Needed
-		// BUG BUG Would need either icons or text messages to display the status in the dashboard
-		// {"0": "Check Engine"},
-		// { "1": "Over Temperature" },
-		// { "2": "Low Oil Pressure" },
-		// { "3": "Low Oil Level" },
-		// { "4": "Low Fuel Pressure" },
-		// { "5": "Low System Voltage" },
-		// { "6": "Low Coolant Level" },
-		// { "7": "Water Flow" },
-		// { "8": "Water In Fuel" },
-		// { "9": "Charge Indicator" },
-		// { "10": "Preheat Indicator" },
-		// { "11": "High Boost Pressure" },
-		// { "12": "Rev Limit Exceeded" },
-		// { "13": "EGR System" },
-		// { "14": "Throttle Position Sensor" },
-		// { "15": "Emergency Stop" }]
-
-		short statusTwo;
-		statusTwo = payload[22] | (payload[23] << 8);
-
-		// {"0": "Warning Level 1"},
-		// { "1": "Warning Level 2" },
-		// { "2": "Power Reduction" },
-		// { "3": "Maintenance Needed" },
-		// { "4": "Engine Comm Error" },
-		// { "5": "Sub or Secondary Throttle" },
-		// { "6": "Neutral Start Protect" },
-		// { "7": "Engine Shutting Down" }]
-
-		byte engineLoad;  // percentage
-		engineLoad = payload[24];
-
-		byte engineTorque; // percentage
-		engineTorque = payload[25];
-
-		// As above, until data is received from engine instance 1 we always assume a single engine vessel
-		if (engineInstance > 0) {
-			IsMultiEngineVessel = TRUE;
-		}
-
-		// BUG BUG Instead of using logical and, separate into separate sentences so if invalid value for one or two sensors, we still send something
-		if ((TwoCanUtils::IsDataValid(oilPressure)) && (TwoCanUtils::IsDataValid(engineTemperature)) && (TwoCanUtils::IsDataValid(alternatorPotential))) {
-			// BUG BUG Note, Now using NMEA 183 v4.11 standard XDR names
-			nmeaSentences->push_back(wxString::Format("$IIXDR,P,%.2f,P,EngineOil#%1d,C,%.2f,C,Engine#%1d,U,%.2f,V,Alternator#%1d", 
-				(float)(oilPressure * 100.0f), engineInstance,
-				(float)(engineTemperature * 0.01f) - CONST_KELVIN, engineInstance,
-				(float)(alternatorPotential * 0.01f), engineInstance));
-			// Type G = Generic, For deprecated TwoCan naming I defined units as H to indicate hours
-			// NMEA 183 v4.11 does not stipulate a field for the units. Until identified otherwise, leave blank
-			nmeaSentences->push_back(wxString::Format("$IIXDR,G,%.2f,,Engine#%1d", (float)totalEngineHours / 3600, engineInstance));
-			
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127505 NMEA Fluid Levels
-bool TwoCanDevice::DecodePGN127505(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte instance;
-		instance = payload[0] & 0x0F;
-
-		byte tankType;
-		tankType = (payload[0] & 0xF0) >> 4;
-
-		unsigned short tankLevel; // percentage in 0.025 increments
-		tankLevel = payload[1] | (payload[2] << 8);
-
-		unsigned int tankCapacity; // 0.1 L
-		tankCapacity = payload[3] | (payload[4] << 8) | (payload[5] << 16) | (payload[6] << 24);
-		// BUG BUG Note, Now using NMEA 4.11 standard XDR names
-		if (TwoCanUtils::IsDataValid(tankLevel)) {
-			switch (tankType) {
-				case TANK_FUEL:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,V,%.2f,P,Fuel#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-				case TANK_FRESHWATER:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,V,%.2f,P,FreshWater#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-				case TANK_WASTEWATER:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,v,%.2f,P,WasteWater#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-				case TANK_LIVEWELL:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,V,%.2f,P,LiveWellWater#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-				case TANK_OIL:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,V,%.2f,P,Oil#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-				case TANK_BLACKWATER:
-					nmeaSentences->push_back(wxString::Format("$IIXDR,V,%.2f,P,BlackWater#%1d", (float)tankLevel / QUARTER_PERCENT, instance));
-					break;
-			}
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 127508 NMEA Battery Status
-bool TwoCanDevice::DecodePGN127508(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte batteryInstance;
-		batteryInstance = payload[0] & 0xF;
-
-		unsigned short batteryVoltage; // 0.01 volts
-		batteryVoltage = payload[1] | (payload[2] << 8);
-
-		short batteryCurrent; // 0.1 amps	
-		batteryCurrent = payload[3] | (payload[4] << 8);
-		
-		unsigned short batteryTemperature; // 0.01 degree resolution, in Kelvin
-		batteryTemperature = payload[5] | (payload[6] << 8);
-		
-		byte sid;
-		sid = payload[7];
-		
-		// BUG BUG Note, Now using NMEA 183 v4.11 standard XDR names
-		if ((TwoCanUtils::IsDataValid(batteryVoltage)) && (TwoCanUtils::IsDataValid(batteryCurrent))) {
-			nmeaSentences->push_back(wxString::Format("$IIXDR,U,%.2f,V,Battery#%1d,I,%.2f,A,Battery#%1d,C,%.2f,C,Battery#%1d", 
-				(float)(batteryVoltage * 0.01f), batteryInstance, 
-				(float)(batteryCurrent * 0.1f), batteryInstance, 
-				(float)(batteryTemperature * 0.01f) - CONST_KELVIN, batteryInstance));			
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-			return FALSE;
-	}
-}
-
-
-
-// Decode PGN 128259 NMEA Speed & Heading
-// $--VHW, x.x, T, x.x, M, x.x, N, x.x, K*hh<CR><LF>
-bool TwoCanDevice::DecodePGN128259(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned short speedWaterReferenced;
-		speedWaterReferenced = payload[1] | (payload[2] << 8);
-
-		unsigned short speedGroundReferenced;
-		speedGroundReferenced = payload[3] | (payload[4] << 8);
-		
-		byte referenceType;
-		referenceType = payload[5] & 0x07;
-
-		unsigned short direction;
-		direction = payload[6] | (payload[7] << 8);
-
-		if (TwoCanUtils::IsDataValid(speedWaterReferenced)) {
-
-			// BUG BUG Maintain heading globally from other sources to insert corresponding values into sentence	
-			nmeaSentences->push_back(wxString::Format("$IIVHW,,T,,M,%.2f,N,%.2f,K", (float)speedWaterReferenced * CONVERT_MS_KNOTS / 100, \
-				(float)speedWaterReferenced * CONVERT_MS_KMH / 100));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 128267 NMEA Depth
-// $--DPT,x.x,x.x,x.x*hh<CR><LF>
-// $--DBT,x.x,f,x.x,M,x.x,F*hh<CR><LF>
-bool TwoCanDevice::DecodePGN128267(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned int depth; // /100
-		depth = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		short offset; // /1000
-		offset = payload[5] | (payload[6] << 8);
-
-		byte maxRange; // * 10
-		maxRange = payload[7];
-
-		if (TwoCanUtils::IsDataValid(depth)) {
-			
-			// OpenCPN Dashboard now accepts NMEA 183 DPT sentences. (at least noticed in 5.6.x) 
-			wxString depthSentence;
-
-			depthSentence = wxString::Format("$IIDPT,%.2f,%.2f", (float)depth / 100, (float)offset / 1000);
-			if (maxRange != 0xFF) {
-				depthSentence.Append(wxString::Format(",%d", maxRange * 10));
-			}
-			else {
-				depthSentence.Append(",");
-			}
-			
-			nmeaSentences->push_back(depthSentence);
-			
-			// Deprecated
-			// OpenCPN Dashboard only accepts DBT sentence
-			//nmeaSentences->push_back(wxString::Format("$IIDBT,%.2f,f,%.2f,M,%.2f,F", CONVERT_METRES_FEET * (double)depth / 100, \
-			//	(double)depth / 100, CONVERT_METRES_FATHOMS * (double)depth / 100));
-			
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 128275 NMEA Distance Log
-// $--VLW, x.x, N, x.x, N, x.x, N, x.x, N*hh<CR><LF>
-//          |       |       |       Total cumulative water distance, Nm
-//          |       |       Water distance since reset, Nm
-//          |      Total cumulative ground distance, Nm
-//          Ground distance since reset, Nm
-
-bool TwoCanDevice::DecodePGN128275(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[0] | (payload[1] << 8);
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[2] | (payload[3] << 8) | (payload[4] << 16) | (payload[5] << 24);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		unsigned int cumulativeDistance;
-		cumulativeDistance = payload[6] | (payload[7] << 8) | (payload[8] << 16) | (payload[9] << 24);
-
-		unsigned int tripDistance;
-		tripDistance = payload[10] | (payload[11] << 8) | (payload[12] << 16) | (payload[13] << 24);
-
-		if (TwoCanUtils::IsDataValid(cumulativeDistance)) {
-			if (TwoCanUtils::IsDataValid(tripDistance)) {
-				nmeaSentences->push_back(wxString::Format("$IIVLW,,,,,%.2f,N,%.2f,N", CONVERT_METRES_NAUTICAL_MILES * tripDistance, CONVERT_METRES_NAUTICAL_MILES * cumulativeDistance));
-				return TRUE;
-			}
-			else {
-				nmeaSentences->push_back(wxString::Format("$IIVLW,,,,,,N,%.2f,N", CONVERT_METRES_NAUTICAL_MILES * cumulativeDistance));
-				return TRUE;
-			}
-		}
-		else {
-			if (TwoCanUtils::IsDataValid(tripDistance)) {
-				nmeaSentences->push_back(wxString::Format("$IIVLW,,,,,%.2f,N,,N", CONVERT_METRES_NAUTICAL_MILES * tripDistance));
-				return TRUE;
-			}
-			else {
-				return FALSE;
-			}
-			
-		}
-					
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129025 NMEA Position Rapid Update
-// $--GLL, llll.ll, a, yyyyy.yy, a, hhmmss.ss, A, a*hh<CR><LF>
-//                                           Status A valid, V invalid
-//                                               mode - note Status = A if Mode is A (autonomous) or D (differential)
-bool TwoCanDevice::DecodePGN129025(const byte *payload, std::vector<wxString> *nmeaSentences, byte address) {
-	if ((payload != NULL) && (address == preferredGPS.sourceAddress)) {
-
-		int latitude;
-		latitude = (int)payload[0] | ((int)payload[1] << 8) | ((int)payload[2] << 16) | ((int)payload[3] << 24);
-
-		int longitude;
-		longitude = (int)payload[4] | ((int)payload[5] << 8) | ((int)payload[6] << 16) | ((int)payload[7] << 24);
-
-		if (TwoCanUtils::IsDataValid(latitude) && TwoCanUtils::IsDataValid(longitude)) {
-
-			double latitudeDouble = ((double)latitude * 1e-7);
-			int latitudeDegrees = trunc(latitudeDouble);
-			double latitudeMinutes = (latitudeDouble - latitudeDegrees) * 60;
-
-			double longitudeDouble = ((double)longitude * 1e-7);
-			int longitudeDegrees = trunc(longitudeDouble);
-			double longitudeMinutes = (longitudeDouble - longitudeDegrees) * 60;
-
-			char gpsMode;
-			gpsMode = 'A';
-
-			// BUG BUG Verify S & W values are indeed negative
-			// BUG BUG Mode & Status are not available in PGN 129025
-			// BUG BUG UTC Time is not available in PGN 129025
-
-			wxDateTime now = wxDateTime::Now();
-			wxDateTime tm = now - gpsTimeOffset;
-
-			nmeaSentences->push_back(wxString::Format("$IIGLL,%02d%07.4f,%c,%03d%07.4f,%c,%s,%c,%c", abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S', \
-				abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W', tm.Format("%H%M%S.00", wxDateTime::UTC).ToAscii(), gpsMode, ((gpsMode == 'A') || (gpsMode == 'D')) ? 'A' : 'V'));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129026 NMEA COG SOG Rapid Update
-// $--VTG,x.x,T,x.x,M,x.x,N,x.x,K,a*hh<CR><LF>
-bool TwoCanDevice::DecodePGN129026(const byte *payload, std::vector<wxString> *nmeaSentences, byte address) {
-	if ((payload != NULL) && (address == preferredGPS.sourceAddress)) {
-
-		byte sid;
-		sid = payload[0];
-
-		// True = 0, Magnetic = 1
-		byte headingReference;
-		headingReference = (payload[1] & 0x03);
-
-		unsigned short courseOverGround;
-		courseOverGround = (payload[2] | (payload[3] << 8));
-
-		unsigned short speedOverGround;
-		speedOverGround = (payload[4] | (payload[5] << 8));
-
-		// Persist SOG & COG for other constructed sentences
-		vesselCOG = courseOverGround;
-		vesselSOG = speedOverGround;
-
-		// BUG BUG if Heading Ref = True (0), then ignore %.2f,M and vice versa if Heading Ref = Magnetic (1), ignore %.2f,T
-		// BUG BUG GPS Mode should be obtained rather than assumed
-		
-		if (headingReference == HEADING_TRUE) {
-			if (TwoCanUtils::IsDataValid(courseOverGround)) {
-				if (TwoCanUtils::IsDataValid(speedOverGround)) {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,%.2f,T,,M,%.2f,N,%.2f,K,%c", RADIANS_TO_DEGREES((float)courseOverGround / 10000), \
-					(float)speedOverGround * CONVERT_MS_KNOTS / 100, (float)speedOverGround * CONVERT_MS_KMH / 100, GPS_MODE_AUTONOMOUS));
-					return TRUE;								
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,%.2f,T,,M,,N,,K,%c", RADIANS_TO_DEGREES((float)courseOverGround / 10000), GPS_MODE_AUTONOMOUS));
-					return TRUE;								
-				}
-			}
-			else {
-				if (TwoCanUtils::IsDataValid(speedOverGround)) {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,,T,,M,%.2f,N,%.2f,K,%c", \
-					(float)speedOverGround * CONVERT_MS_KNOTS / 100, (float)speedOverGround * CONVERT_MS_KMH / 100, GPS_MODE_AUTONOMOUS));
-					return TRUE;
-				}
-				else {
-					return FALSE;
-				}
-				
-			}
-			
-		}
-		
-		else if (headingReference == HEADING_MAGNETIC) {
-			if (TwoCanUtils::IsDataValid(courseOverGround)) {
-				if (TwoCanUtils::IsDataValid(speedOverGround)) {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,,T,%.2f,M,%.2f,N,%.2f,K,%c", RADIANS_TO_DEGREES((float)courseOverGround / 10000), \
-					(float)speedOverGround * CONVERT_MS_KNOTS / 100, (float)speedOverGround * CONVERT_MS_KMH / 100, GPS_MODE_AUTONOMOUS));
-					return TRUE;								
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,,T,%.2f,M,,N,,K,%c", RADIANS_TO_DEGREES((float)courseOverGround / 10000), GPS_MODE_AUTONOMOUS));
-					return TRUE;								
-				}
-			}
-			else {
-				if (TwoCanUtils::IsDataValid(speedOverGround)) {
-					nmeaSentences->push_back(wxString::Format("$IIVTG,,T,,M,%.2f,N,%.2f,K,%c", \
-					(float)speedOverGround * CONVERT_MS_KNOTS / 100, (float)speedOverGround * CONVERT_MS_KMH / 100, GPS_MODE_AUTONOMOUS));
-					return TRUE;
-				}
-				else {
-					return FALSE;
-				}
-				
-			}
-			
-			
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}	
-}
-
-// Decode PGN 129029 NMEA GNSS Position
-// $--GGA, hhmmss.ss, llll.ll, a, yyyyy.yy, a, x, xx, x.x, x.x, M, x.x, M, x.x, xxxx*hh<CR><LF>
-//                                             |  |   hdop         geoidal  age refID 
-//                                             |  |        Alt
-//                                             | sats
-//                                           fix Qualty
-
-// $--RMC,hhmmss.ss,A,ddmm.mm,a,dddmm.mm,a,x.x,x.x,xxxx,x.x,a,m,s*hh<CR><LF>
-//                  |                       |   |        |  | status
-//                Validity                 SOG COG Variation FAA Mode
-
-bool TwoCanDevice::DecodePGN129029(const byte *payload, std::vector<wxString> *nmeaSentences, byte address) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[1] | (payload[2] << 8);
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[3] | (payload[4] << 8) | (payload[5] << 16) | (payload[6] << 24);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		long long latitude;
-		latitude = (((long long)payload[7] | ((long long)payload[8] << 8) | ((long long)payload[9] << 16) | ((long long)payload[10] << 24) \
-			| ((long long)payload[11] << 32) | ((long long)payload[12] << 40) | ((long long)payload[13] << 48) | ((long long)payload[14] << 56)));
-
-
-		long long longitude;
-		longitude = (((long long)payload[15] | ((long long)payload[16] << 8) | ((long long)payload[17] << 16) | ((long long)payload[18] << 24) \
-			| ((long long)payload[19] << 32) | ((long long)payload[20] << 40) | ((long long)payload[21] << 48) | ((long long)payload[22] << 56)));
-
-		if (TwoCanUtils::IsDataValid(latitude) && TwoCanUtils::IsDataValid(longitude)) {
-
-			double latitudeDouble = ((double)latitude * 1e-16);
-			double latitudeDegrees = trunc(latitudeDouble);
-			double latitudeMinutes = (latitudeDouble - latitudeDegrees) * 60;
-
-			double longitudeDouble = ((double)longitude * 1e-16);
-			double longitudeDegrees = trunc(longitudeDouble);
-			double longitudeMinutes = (longitudeDouble - longitudeDegrees) * 60;
-
-			double altitude;
-			altitude = 1e-6 * (((long long)payload[23] | ((long long)payload[24] << 8) | ((long long)payload[25] << 16) | ((long long)payload[26] << 24) \
-				| ((long long)payload[27] << 32) | ((long long)payload[28] << 40) | ((long long)payload[29] << 48) | ((long long)payload[30] << 56)));
-
-
-			byte fixType;
-			byte fixMethod;
-
-			fixMethod = payload[31] & 0x0F;
-			fixType = (payload[31] & 0xF0) >> 4;
-
-			byte fixIntegrity;
-			fixIntegrity = payload[32] & 0x03;
-
-			byte numberOfSatellites;
-			numberOfSatellites = payload[33];
-
-			unsigned short hDOP;
-			hDOP = payload[34] | (payload[35] << 8);
-
-			unsigned short pDOP;
-			pDOP = payload[36] | (payload[37] << 8);
-
-			unsigned long geoidalSeparation; //0.01
-			geoidalSeparation = payload[38] | (payload[39] << 8);
-
-			byte referenceStations;
-			referenceStations = payload[40];
-
-			unsigned short referenceStationType;
-			unsigned short referenceStationID;
-			unsigned short referenceStationAge;
-
-			// We only need one reference station for the GGA sentence
-			if (referenceStations != 0xFF && referenceStations > 0) {
-				// BUG BUG Check this, may have bit orders wrong
-				referenceStationType = payload[43] & 0xF0 >> 4;
-				referenceStationID = (payload[43] & 0xF) << 4 | payload[44];
-				referenceStationAge = (payload[45] | (payload[46] << 8));
-			}
-
-			// Automagic preference if multiple GPS sources present
-			// Initial reception
-			if (preferredGPS.sourceAddress == CONST_GLOBAL_ADDRESS) {
-				preferredGPS.sourceAddress = address;
-				preferredGPS.lastUpdate = wxDateTime::Now();
-				preferredGPS.hdop = hDOP;
-				preferredGPS.hdopRetry = 0;
-			}
-			else {
-				// Current GPS source
-				if (address == preferredGPS.sourceAddress) {
-					preferredGPS.lastUpdate = wxDateTime::Now();
-					preferredGPS.hdop = hDOP;
-				}
-				// An alternative GPS source
-				else {
-					// Current source has not been updated in the last 30 seconds, failover
-					if (wxDateTime::Now() > preferredGPS.lastUpdate + wxTimeSpan::Seconds(30)) {
-						preferredGPS.sourceAddress = address;
-						preferredGPS.lastUpdate = wxDateTime::Now();
-						preferredGPS.hdop = hDOP;
-						preferredGPS.hdopRetry = 0;
-					}
-					// The current source has a greater HDOP than the alternative
-					else if (preferredGPS.hdop > hDOP) {
-						// And has more than ten successive better hdop values, failover
-						if (preferredGPS.hdopRetry > 10) {
-							preferredGPS.hdopRetry = 0;
-							preferredGPS.sourceAddress = address;
-							preferredGPS.lastUpdate = wxDateTime::Now();
-							preferredGPS.hdop = hDOP;
-						}
-						else {
-							preferredGPS.hdopRetry++;
-							// The current source is to be kept until the alternative has more than ten successive better hdop values
-							return FALSE;
-						}
-					}
-					else {
-						// The current source is to be kept
-						return FALSE;
-					}
-
-				}
-				
-			}
-
-			nmeaSentences->push_back(wxString::Format("$IIGGA,%s,%02.0f%07.4f,%c,%03.0f%07.4f,%c,%d,%d,%.2f,%.1f,M,%.1f,M,,", \
-				epoch.Format("%H%M%S").ToAscii(), fabs(latitudeDegrees), fabs(latitudeMinutes), latitudeDegrees >= 0 ? 'N' : 'S', \
-				fabs(longitudeDegrees), fabs(longitudeMinutes), longitudeDegrees >= 0 ? 'E' : 'W', \
-				fixType, numberOfSatellites, (double)hDOP * 0.01f, (double)altitude * 1e-6, \
-				(double)geoidalSeparation * 0.01f));
-
-			// Construct a NMEA 183 RMC sentence
-			/*
-			if ((TwoCanUtils::IsDataValid(vesselCOG)) && (TwoCanUtils::IsDataValid(vesselSOG)) && (TwoCanUtils::IsDataValid(magneticVariation))) {
-				nmeaSentences->push_back(wxString::Format("$IIRMC,%s,%c,%02.0f%07.4f,%c,%03.0f%07.4f,%c,%.2f,%.2f,%s,%.2f,%c,%c,", \
-					tm.Format("%H%M%S").ToAscii(), GPS_STATUS_VALID, fabs(latitudeDegrees), fabs(latitudeMinutes), latitudeDegrees >= 0 ? 'N' : 'S', \
-					fabs(longitudeDegrees), fabs(longitudeMinutes), longitudeDegrees >= 0 ? 'E' : 'W', \
-					(float)vesselSOG * CONVERT_MS_KNOTS / 100, RADIANS_TO_DEGREES((float)vesselCOG) * 0.0001f, tm.Format("%d%m%y").ToAscii(), \
-					RADIANS_TO_DEGREES((float)magneticVariation) * 0.0001f, FAA_MODE_AUTONOMOUS, GPS_MODE_AUTONOMOUS));
-
-			}
-			*/
-
-			return TRUE;
-
-			// BUG BUG for the time being ignore reference stations, too lazy to code this
-			//, \
-			//	((referenceStations != 0xFF) && (referenceStations > 0)) ? referenceStationAge : "", \
-			//	((referenceStations != 0xFF) && (referenceStations > 0)) ? referenceStationID : "");
-			//
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129033 NMEA Date & Time
-// $--ZDA, hhmmss.ss, xx, xx, xxxx, xx, xx*hh<CR><LF>
-bool TwoCanDevice::DecodePGN129033(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[0] | (payload[1] << 8);
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[2] | (payload[3] << 8) | (payload[4] << 16) | (payload[5] << 24);
-
-		short localOffset;
-		localOffset = payload[6] | (payload[7] << 8);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		// save the time offset between the computer time & the received gps time for use in constructed sentences such as RMC
-		gpsTimeOffset = wxDateTime::Now() - epoch; 
-
-		if ((TwoCanUtils::IsDataValid(daysSinceEpoch))  && (TwoCanUtils::IsDataValid(secondsSinceMidnight))) {
-			nmeaSentences->push_back(wxString::Format("$IIZDA,%s,%d,%d", epoch.Format("%H%M%S,%d,%m,%Y"), (int)localOffset / 60, localOffset % 60));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Template for NMEA183 AIS VDM messages
-// !--VDM,x,x,x,a,s--s,x*hh
-//       | | | |   |  Number of fill bits
-//       | | | |   Encoded Message
-//       | | | AIS Channel
-//       | | Sequential Message ID
-//       | Sentence Number
-//      Total Number of sentences
-
-
-// Decode PGN 129038 NMEA AIS Class A Position Report
-// AIS Message Types 1,2 or 3
-bool TwoCanDevice::DecodePGN129038(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(168);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-		
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte timeStamp;
-		timeStamp = (payload[13] & 0xFC) >> 2;
-
-		unsigned short courseOverGround;
-		courseOverGround = payload[14] | (payload[15] << 8);
-
-		unsigned short speedOverGround;
-		speedOverGround = payload[16] | (payload[17] << 8);
-
-		unsigned int communicationState;
-		communicationState = payload[18] | (payload[19] << 8) | ((payload[20] & 0x07) << 16);
-
-		byte transceiverInformation; 
-		transceiverInformation = (payload[20] & 0xF8) >> 3;
-
-		char aisChannel; 
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		unsigned short trueHeading;
-		trueHeading = payload[21] | (payload[22] << 8);
-
-		short rateOfTurn;
-		rateOfTurn = payload[23] | (payload[24] << 8);
-
-		byte navigationalStatus;
-		navigationalStatus = payload[25] & 0x0F;
-
-		byte manoeuverIndicator;
-		manoeuverIndicator = payload[25] & 0x30 >> 4;
-
-		byte reserved;
-		reserved = (payload[25] & 0xC0) >> 6;
-
-		byte spare;
-		spare = (payload[26] & 0x07);
-
-		byte reservedForRegionalApplications;
-		reservedForRegionalApplications = (payload[26] & 0xF8) >> 3;
-
-		byte sequenceID;
-		sequenceID = payload[27];
-
-		// Encode correct AIS rate of turn from sensor data as per ITU M.1371 standard
-		// BUG BUG fix this up to remove multiple calculations. 
-		int AISRateOfTurn;
-
-		// Undefined/not available
-		if (!TwoCanUtils::IsDataValid(rateOfTurn)) {
-			AISRateOfTurn = -128;
-		}
-		else {
-			// Greater or less than 708 degrees/min
-			if ((RADIANS_TO_DEGREES((float)rateOfTurn * 3.125e-8) * 60) > 708) {
-				AISRateOfTurn = 127;
-			}
-
-			else if ((RADIANS_TO_DEGREES((float)rateOfTurn * 3.125e-8) * 60) < -708) {
-				AISRateOfTurn = -127;
-			}
-
-			else {
-				AISRateOfTurn = 4.733 * sqrt(RADIANS_TO_DEGREES((float)rateOfTurn * 3.125e-8) * 60);
-			}
-		}
-			
-		// Encode VDM message using 6 bit ASCII 
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 4, navigationalStatus);
-		AISInsertInteger(binaryData, 42, 8, AISRateOfTurn);
-		AISInsertInteger(binaryData, 50, 10, TwoCanUtils::IsDataValid(speedOverGround) ? CONVERT_MS_KNOTS * speedOverGround * 0.1f : 1023);
-		AISInsertInteger(binaryData, 60, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 61, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 89, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 116, 12, TwoCanUtils::IsDataValid(courseOverGround) ? RADIANS_TO_DEGREES((float)courseOverGround) * 0.001f : 3600);
-		AISInsertInteger(binaryData, 128, 9, TwoCanUtils::IsDataValid(trueHeading) ? RADIANS_TO_DEGREES((float)trueHeading) * 0.0001f : 511);
-		AISInsertInteger(binaryData, 137, 6, timeStamp);
-		AISInsertInteger(binaryData, 143, 2, manoeuverIndicator);
-		AISInsertInteger(binaryData, 145, 3, spare);
-		AISInsertInteger(binaryData, 148, 1, raimFlag);
-		AISInsertInteger(binaryData, 149, 19, communicationState);
-
-		// Send a single VDM sentence, note no fillbits nor a sequential message Id
-		
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		} 
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-
-		return TRUE;
-	}
-
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129039 NMEA AIS Class B Position Report
-// AIS Message Type 18
-bool TwoCanDevice::DecodePGN129039(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(168);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-		
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte timeStamp;
-		timeStamp = (payload[13] & 0xFC) >> 2;
-
-		unsigned short courseOverGround;
-		courseOverGround = payload[14] | (payload[15] << 8);
-
-		unsigned short  speedOverGround;
-		speedOverGround = payload[16] | (payload[17] << 8);
-
-		unsigned int communicationState;
-		communicationState = (payload[18] | (payload[19] << 8) | (payload[20] << 16)) & 0x7FFFF;
-
-		byte transceiverInformation;
-		transceiverInformation = (payload[20] & 0xF8) >> 3;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		unsigned short trueHeading;
-		trueHeading = payload[21] | (payload[22] << 8);
-
-		byte regionalReservedA;
-		regionalReservedA = payload[23];
-
-		byte regionalReservedB;
-		regionalReservedB = payload[24] & 0x03;
-
-		byte unitFlag;
-		unitFlag = (payload[24] & 0x04) >> 2;
-
-		byte displayFlag;
-		displayFlag = (payload[24] & 0x08) >> 3;
-
-		byte dscFlag;
-		dscFlag = (payload[24] & 0x10) >> 4;
-
-		byte bandFlag;
-		bandFlag = (payload[24] & 0x20) >> 5;
-
-		byte msg22Flag;
-		msg22Flag = (payload[24] & 0x40) >> 6;
-
-		byte assignedModeFlag;
-		assignedModeFlag = (payload[24] & 0x80) >> 7;
-		
-		byte sotdmaFlag;
-		sotdmaFlag = payload[25] & 0x01;
-		
-		// Encode VDM Message using 6bit ASCII
-				
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 8, 0xFF); // spare
-		AISInsertInteger(binaryData, 46, 10, TwoCanUtils::IsDataValid(speedOverGround) ? CONVERT_MS_KNOTS * speedOverGround * 0.1f : 1023);
-		AISInsertInteger(binaryData, 56, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 57, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 85, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 112, 12, TwoCanUtils::IsDataValid(courseOverGround) ? RADIANS_TO_DEGREES((float)courseOverGround) * 0.001f : 3600);
-		AISInsertInteger(binaryData, 124, 9, TwoCanUtils::IsDataValid(trueHeading) ? RADIANS_TO_DEGREES((float)trueHeading) * 0.0001f : 511);
-		AISInsertInteger(binaryData, 133, 6, timeStamp);
-		AISInsertInteger(binaryData, 139, 2, regionalReservedB);
-		AISInsertInteger(binaryData, 141, 1, unitFlag);
-		AISInsertInteger(binaryData, 142, 1, displayFlag);
-		AISInsertInteger(binaryData, 143, 1, dscFlag);
-		AISInsertInteger(binaryData, 144, 1, bandFlag);
-		AISInsertInteger(binaryData, 145, 1, msg22Flag);
-		AISInsertInteger(binaryData, 146, 1, assignedModeFlag); 
-		AISInsertInteger(binaryData, 147, 1, raimFlag); 
-		AISInsertInteger(binaryData, 148, 1, sotdmaFlag); 
-		AISInsertInteger(binaryData, 149, 19, communicationState);
-		
-		// Send a single VDM sentence, note no fillbits nor a sequential message Id
-		
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		
-		return TRUE;
-	}
-
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129040 AIS Class B Extended Position Report
-// AIS Message Type 19
-bool TwoCanDevice::DecodePGN129040(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(312);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte timeStamp;
-		timeStamp = (payload[13] & 0xFC) >> 2;
-
-		unsigned short courseOverGround;
-		courseOverGround = payload[14] | (payload[15] << 8);
-
-		unsigned short speedOverGround;
-		speedOverGround = payload[16] | (payload[17] << 8);
-
-		byte regionalReservedA;
-		regionalReservedA = payload[18];
-
-		byte regionalReservedB;
-		regionalReservedB = payload[19] & 0x0F;
-
-		byte reservedA;
-		reservedA = (payload[19] & 0xF0) >> 4;
-
-		byte shipType;
-		shipType = payload[20];
-
-		unsigned short trueHeading;
-		trueHeading = payload[21] | (payload[22] << 8);
-
-		byte reservedB;
-		reservedB = payload[23] & 0x0F;
-
-		byte gnssType;
-		gnssType = (payload[23] & 0xF0) >> 4;
-
-		unsigned short shipLength;
-		shipLength = payload[24] | (payload[25] << 8);
-		
-		unsigned short shipBeam;
-		shipBeam = payload[26] | (payload[27] << 8);
-
-		unsigned short refStarboard;
-		refStarboard = payload[28] | (payload[29] << 8);
-
-		unsigned short refBow;
-		refBow = payload[30] | (payload[31] << 8);
-		
-		std::string shipName;
-		for (int i = 0; i < 20; i++) {
-			shipName.append(1, (char)payload[32 + i]);
-		}
-		
-		byte dteFlag;
-		dteFlag = payload[52] & 0x01;
-
-		byte assignedModeFlag;
-		assignedModeFlag = (payload[52] & 0x02) >> 1;
-
-		byte spare;
-		spare = (payload[52] & 0x3C) >> 2;
-
-		byte transceiverInformation;
-		transceiverInformation = ((payload[52] & 0xC0) >> 6) | ((payload[53] & 0x07) << 2);
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		// Encode VDM Message using 6bit ASCII
-			
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 8, regionalReservedA);
-		AISInsertInteger(binaryData, 46, 10, TwoCanUtils::IsDataValid(speedOverGround) ? CONVERT_MS_KNOTS * speedOverGround * 0.1f : 1023);
-		AISInsertInteger(binaryData, 56, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 57, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 85, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 112, 12, TwoCanUtils::IsDataValid(courseOverGround) ? RADIANS_TO_DEGREES((float)courseOverGround) * 0.001f : 3600);
-		AISInsertInteger(binaryData, 124, 9, TwoCanUtils::IsDataValid(trueHeading) ? RADIANS_TO_DEGREES((float)trueHeading) * 0.0001f : 511);
-		AISInsertInteger(binaryData, 133, 6, timeStamp);
-		AISInsertInteger(binaryData, 139, 4, regionalReservedB);
-		AISInsertString(binaryData, 143, 120, shipName);
-		AISInsertInteger(binaryData, 263, 8, shipType);
-		AISInsertInteger(binaryData, 271, 9, refBow / 10);
-		AISInsertInteger(binaryData, 280, 9, (shipLength / 10) - (refBow / 10));
-		AISInsertInteger(binaryData, 289, 6, refStarboard / 10);
-		AISInsertInteger(binaryData, 295, 6, (shipBeam / 10) - (refStarboard / 10));
-		AISInsertInteger(binaryData, 301, 4, gnssType);
-		AISInsertInteger(binaryData, 305, 1, raimFlag);
-		AISInsertInteger(binaryData, 306, 1, dteFlag);
-		AISInsertInteger(binaryData, 307, 1, assignedModeFlag);
-		AISInsertInteger(binaryData, 308, 4, spare);
-
-		wxString encodedVDMMessage = AISEncodePayload(binaryData);
-		
-		// Send the VDM message, Note no fillbits
-		// One day I'll remember why I chose 28 as the length of a multisentence VDM message
-		// BUG BUG Or just send two messages, 26 bytes long
-		int numberOfVDMMessages = ((int)encodedVDMMessage.Length() / 28) + ((encodedVDMMessage.Length() % 28) >  0 ? 1 : 0);
-
-		for (int i = 0; i < numberOfVDMMessages; i++) {
-			if (i == numberOfVDMMessages -1) { // This is the last message
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28))));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28))));
-				}
-			}
-			else {
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}
-			}
-		}
-		
-		AISsequentialMessageId += 1;
-		if (AISsequentialMessageId == 10) {
-			AISsequentialMessageId = 0;
-		}
-
-		return TRUE;
-	}
-
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129041 AIS Aids To Navigation (AToN) Report
-// AIS Message Type 21
-bool TwoCanDevice::DecodePGN129041(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(358);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-		
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-		
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte timeStamp;
-		timeStamp = (payload[13] & 0xFC) >> 2;
-
-		unsigned short shipLength;
-		shipLength = payload[14] | (payload[15] << 8);
-
-		unsigned short shipBeam;
-		shipBeam = payload[16] | (payload[17] << 8);
-
-		unsigned short refStarboard;
-		refStarboard = payload[18] | (payload[19] << 8);
-
-		unsigned short refBow;
-		refBow = payload[20] | (payload[21] << 8);
-		
-		byte AToNType;
-		AToNType = payload[22] & 0x1F;
-
-		byte offPositionFlag;
-		offPositionFlag = (payload[22] & 0x20) >> 5;
-
-		byte virtualAToN;
-		virtualAToN = (payload[22] & 0x40) >> 6;;
-
-		byte assignedModeFlag;
-		assignedModeFlag = (payload[22] & 0x80) >> 7;
-
-		byte spare;
-		spare = payload[23] & 0x01;
-
-		byte gnssType;
-		gnssType = (payload[23] & 0x1E) >> 1;
-
-		byte reserved;
-		reserved = payload[23] & 0xE0 >> 5;
-
-		byte AToNStatus;
-		AToNStatus = payload[24];
-
-		byte transceiverInformation;
-		transceiverInformation = payload[25] & 0x1F;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		byte reservedB;
-		reservedB = (payload[25] & 0xE0) >> 5;
-
-		// BUG BUG This is variable up to 20 + 14 (34) characters
-		std::string AToNName;
-		size_t AToNNameLength = payload[26];
-		if (payload[27] == 1) { // First byte indicates encoding, 0 for Unicode, 1 for ASCII
-			for (size_t i = 0; i < AToNNameLength - 2; i++) {
-				AToNName.append(1, (char)payload[28 + i]);
-			}
-		} 
-
-		// Encode VDM Message using 6bit ASCII
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 5, AToNType);
-		AISInsertString(binaryData, 43, 120, AToNNameLength <= 20 ? AToNName : AToNName.substr(0,20));
-		AISInsertInteger(binaryData, 163, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 164, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 192, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 219, 9, refBow / 10);
-		AISInsertInteger(binaryData, 228, 9, (shipLength / 10) - (refBow / 10));
-		AISInsertInteger(binaryData, 237, 6, refStarboard / 10);
-		AISInsertInteger(binaryData, 243, 6, (shipBeam / 10) - (refStarboard / 10));
-		AISInsertInteger(binaryData, 249, 4, gnssType);
-		AISInsertInteger(binaryData, 253, 6, timeStamp);
-		AISInsertInteger(binaryData, 259, 1, offPositionFlag);
-		AISInsertInteger(binaryData, 260, 8, AToNStatus);
-		AISInsertInteger(binaryData, 268, 1, raimFlag);
-		AISInsertInteger(binaryData, 269, 1, virtualAToN);
-		AISInsertInteger(binaryData, 270, 1, assignedModeFlag);
-		AISInsertInteger(binaryData, 271, 1, spare);
-		// Why is this called a spare (not padding) when in actual fact 
-		// it functions as padding, Refer to the ITU Standard ITU-R M.1371-4 for clarification
-		int fillBits = 0;
-		if (AToNName.length() > 20) {
-			// Add the AToN's name extension characters if necessary
-			// BUG BUG Should check that shipName.length is not greater than 34
-			AISInsertString(binaryData, 272, (AToNName.length() - 20) * 6,AToNName.substr(20,AToNName.length() - 20));
-			fillBits = 6 - ((272 + ((AToNName.length() - 20) * 6)) % 6);
-			// Add padding to align on 6 bit boundary
-			if (fillBits > 0) {
-				AISInsertInteger(binaryData, 272 + (AToNName.length() - 20) * 6, fillBits, 0);
-			}
-		}
-		else {
-			// Add padding to align on 6 bit boundary
-			fillBits = 6 - (272 % 6);
-			binaryData.resize(272 + fillBits);
-			if (fillBits > 0) {
-				AISInsertInteger(binaryData, 272, fillBits, 0);
-			}
-		}
-		
-		wxString encodedVDMMessage = AISEncodePayload(binaryData);
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,,%c,%s,%d", 1, 1, aisChannel, encodedVDMMessage, fillBits));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,,%c,%s,%d", 1, 1, aisChannel, encodedVDMMessage, fillBits));
-		}
-
-		// Send the VDM message
-		/*
-		int numberOfVDMMessages = ((int)encodedVDMMessage.Length() / 28) + ((encodedVDMMessage.Length() % 28) >  0 ? 1 : 0);
-
-		for (int i = 0; i < numberOfVDMMessages; i++) {
-			if (i == numberOfVDMMessages -1) { // This is the last message
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28))));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28))));
-				}
-			}
-			else {
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}
-			}
-		}
-		
-		AISsequentialMessageId += 1;
-		if (AISsequentialMessageId == 10) {
-			AISsequentialMessageId = 0;
-		}
-		*/
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129283 NMEA Cross Track Error
-// $--XTE, A, A, x.x, a, N, a*hh<CR><LF>
-bool TwoCanDevice::DecodePGN129283(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte xteMode;
-		xteMode = payload[1] & 0x0F;
-
-		byte navigationTerminated;
-		navigationTerminated = (payload[1] & 0xC0) >> 6;
-
-		int crossTrackError;
-		crossTrackError = payload[2] | (payload[3] << 8) | (payload[4] << 16) | (payload[5] << 24);
-		
-		if (TwoCanUtils::IsDataValid(crossTrackError)) {
-
-			nmeaSentences->push_back(wxString::Format("$IIXTE,A,A,%.2f,%c,N", fabs(CONVERT_METRES_NAUTICAL_MILES * crossTrackError * 0.01f), crossTrackError < 0 ? 'L' : 'R'));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129284 Navigation Data
-//$--BWC, hhmmss.ss, llll.ll, a, yyyyy.yy, a, x.x, T, x.x, M, x.x, N, c--c, a*hh<CR><LF>
-//$--BWR, hhmmss.ss, llll.ll, a, yyyyy.yy, a, x.x, T, x.x, M, x.x, N, c--c, a*hh<CR><LF>
-//$--BOD, x.x, T, x.x, M, c--c, c--c*hh<CR><LF>
-//$--WCV, x.x, N, c--c, a*hh<CR><LF>
-
-// Not sure of this use case, as it implies there is already a chartplotter on board
-bool TwoCanDevice::DecodePGN129284(const byte * payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned int distance;
-		distance = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		byte bearingRef; // 0 = Magnetic, 1 = True
-		bearingRef = payload[5] & 0x03;
-
-		byte perpendicularCrossed; // 0 = No, 1 = Yes
-		perpendicularCrossed = (payload[5] & 0x0C) >> 2;
-
-		byte circleEntered; // 0 = No, 1 = Yes
-		circleEntered = (payload[5] & 0x30) >> 4;
-
-		byte calculationType; // 0 = Great Circle, 1 = Rhumb Line
-		calculationType = (payload[5] & 0xC0) >> 6;
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[6] | (payload[7] << 8) | (payload[8] << 16) | (payload[9] << 24);
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[10] | (payload[11] << 8);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		unsigned short bearingOrigin;
-		bearingOrigin = (payload[12] | (payload[13] << 8)) * 0.001;
-
-		unsigned short bearingPosition;
-		bearingPosition = (payload[14] | (payload[15] << 8)) * 0.001;
-
-		int originWaypointId;
-		originWaypointId = payload[16] | (payload[17] << 8) | (payload[18] << 16) | (payload[19] << 24);
-
-		int destinationWaypointId;
-		destinationWaypointId = payload[20] | (payload[21] << 8) | (payload[22] << 16) | (payload[23] << 24);
-
-		double latitude;
-		latitude = ((payload[24] | (payload[25] << 8) | (payload[26] << 16) | (payload[27] << 24))) * 1e-7;
-
-		int latitudeDegrees = trunc(latitude);
-		double latitudeMinutes = (fabs(latitude) - abs(latitudeDegrees)) * 60;
-
-		double longitude;
-		longitude = ((payload[28] | (payload[29] << 8) | (payload[30] << 16) | (payload[31] << 24))) * 1e-7;
-
-		int longitudeDegrees = trunc(longitude);
-		double longitudeMinutes = (fabs(longitude) - abs(longitudeDegrees)) * 60;
-
-		int waypointClosingVelocity;
-		waypointClosingVelocity = (payload[32] | (payload[33] << 8)) * 0.01;
-
-		wxDateTime timeNow;
-		timeNow = wxDateTime::Now();
-
-		if (calculationType == GREAT_CIRCLE) { 
-			if (bearingRef == HEADING_TRUE) {
-				nmeaSentences->push_back(wxString::Format("$IIBWC,%s,%02d%05.2f,%c,%03d%05.2f,%c,%.2f,T,,M,%.2f,N,%d,A", 
-					timeNow.Format("%H%M%S.00"), 
-					abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S', 
-					abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W', 
-					RADIANS_TO_DEGREES((float)bearingPosition / 10000), 
-					CONVERT_METRES_NAUTICAL_MILES * distance, destinationWaypointId));
-			}
-			else {
-				nmeaSentences->push_back(wxString::Format("$IIBWC,%s,%02d%05.2f,%c,%03d%05.2f,%c,,T,%.2f,M,%.2f,N,%d,A", 
-					timeNow.Format("%H%M%S.00"), 
-					abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S', 
-					abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W', 
-					RADIANS_TO_DEGREES((float)bearingPosition / 10000), \
-					CONVERT_METRES_NAUTICAL_MILES * distance, destinationWaypointId));
-			}
-
-		}
-		else { 
-			if (bearingRef == HEADING_TRUE) {
-				nmeaSentences->push_back(wxString::Format("$IIBWR,%s,%02d%05.2f,%c,%03d%05.2f,%c,%.2f,T,,M,%.2f,N,%d,A", 
-					timeNow.Format("%H%M%S.00"),
-					abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S',
-					abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W',
-					RADIANS_TO_DEGREES((float)bearingPosition / 10000), \
-					CONVERT_METRES_NAUTICAL_MILES * distance, destinationWaypointId));
-			}
-			else {
-				nmeaSentences->push_back(wxString::Format("$IIBWR,%s,%02d%05.2f,%c,%03d%05.2f,%c,,T,%.2f,M,%.2f,N,%d,A", 
-					timeNow.Format("%H%M%S.00"),
-					abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S',
-					abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W',
-					RADIANS_TO_DEGREES((float)bearingPosition / 10000), \
-					CONVERT_METRES_NAUTICAL_MILES * distance, destinationWaypointId));
-			}
-		}
-
-	
-		if (bearingRef == HEADING_TRUE) {
-			nmeaSentences->push_back(wxString::Format("$IIBOD,%.2f,T,,M,%d,%d", 
-				RADIANS_TO_DEGREES((float)bearingOrigin),destinationWaypointId, originWaypointId));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("$IIBOD,,T,%.2f,M,%d,%d", 
-				RADIANS_TO_DEGREES((float)bearingOrigin),  destinationWaypointId, originWaypointId));
-		}
-
-		nmeaSentences->push_back(wxString::Format("$IIWCV,%.2f,N,%d,A",CONVERT_MS_KNOTS * waypointClosingVelocity, destinationWaypointId));
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129285 Route and Waypoint Information
-// $--RTE,x.x,x.x,a,c--c,c--c, ..……... c--c*hh<CR><LF>
-// and 
-// $--WPL,llll.ll,a,yyyyy.yy,a,c--c
-bool TwoCanDevice::DecodePGN129285(const byte * payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-		// Prepend the NMEA 183 Route sentence
-		wxString routeSentence = "$IIRTE,1,1,c";
-
-		unsigned short rps;
-		rps = payload[0] | (payload[1] << 8);
-
-		unsigned short nItems;
-		nItems = payload[2] | (payload[3] << 8);
-
-		unsigned short databaseVersion;
-		databaseVersion = payload[4] | (payload[5] << 8);
-
-		unsigned short routeID;
-		routeID = payload[6] | (payload[7] << 8);
-
-		// I presume forward/reverse
-		byte direction; 
-		direction = (payload[8] & 0xE0) >> 5; 
-
-		byte supplementaryInfo;
-		supplementaryInfo = (payload[8] & 0x18) >> 3;
-
-		// NMEA reserved
-		byte reservedA = payload[8] & 0x07;
-
-		// As we need to iterate repeated fields with variable length strings
-		// can't use hardcoded indexes into the payload
-		int index = 9;
-
-		std::string routeName;
-		int routeNameLength = payload[index];
-		index++;
-		if (payload[index] == 1) {
-			index++;
-			// first byte of Route name indicates encoding; 0 for Unicode, 1 for ASCII
-			for (int i = 0; i < routeNameLength - 2; i++) {
-				routeName += static_cast<char>(payload[index]);
-				index++;
-			}
-		}
-
-		// NMEA reserved 
-		byte reservedB = payload[index];
-		index++;
-
-		// repeated fields
-		for (unsigned int i = 0; i < nItems; i++) {
-			unsigned short waypointID;
-			waypointID = payload[index] | (payload[index + 1] << 8);
-
-			routeSentence.append(wxString::Format(",%d", waypointID));
-
-			index += 2;
-
-			std::string waypointName;
-			int waypointNameLength = payload[index];
-			index++;
-			if (payload[index] == 1) {
-				// first byte of Waypoint Name indicates encoding; 0 for Unicode, 1 for ASCII
-				index++;
-				for (int i = 0; i < waypointNameLength - 2; i++) {
-					waypointName += (static_cast<char>(payload[index]));
-					index++;
-				}
-			}
-					
-			double latitude = (payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24)) * 1e-7;
-			int latitudeDegrees = trunc(latitude);
-			double latitudeMinutes = fabs(latitude - latitudeDegrees);
-
-			double longitude = (payload[index + 4] | (payload[index + 5] << 8) | (payload[index + 6] << 16) | (payload[index + 7] << 24)) * 1e-7;
-			int longitudeDegrees = trunc(longitude);
-			double longitudeMinutes = fabs(longitude - longitudeDegrees);
-
-			index += 8;
-
-			// BUG BUG Do we use WaypointID or Waypoint Name ?? 
-			// Use the same (WaypointID) as used in the Route Sentence
-			nmeaSentences->push_back(wxString::Format("$IIWPL,%02d%05.2f,%c,%03d%05.2f,%c,%d",
-				abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S',
-				abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W',
-				waypointID));
-
-		}
-
-		nmeaSentences->push_back(routeSentence);
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129539 GNSS DOP's
-//        1 2 3                        14 15  16  17  18
-//        | | |                         |  |   |   |   |
-//$--GSA,a,a,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x.x,x.x,x.x*hh<CR><LF>
-// 1. Selection mode: M=Manual, forced to operate in 2D or 3D, A=Automatic, 2D/3D
-// 2. Mode (1 = no fix, 2 = 2D fix, 3 = 3D fix)
-// 3..14 Satellite ID's
-// 15, 16, 17 PDOP, HDOP, VDOP
-bool TwoCanDevice::DecodePGN129539(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte desiredMode;
-		desiredMode = payload[1] & 0x07;
-
-		byte actualMode;
-		actualMode = (payload[1] & 0x38) >> 3;
-		// 0 = 1D, 1 =2D, 2 = 3D, 3 =Auto
-
-		byte reserved;
-		reserved = (payload[1] & 0xC0) >> 6;
-
-		short hDOP; // * 0.01
-		hDOP = payload[2] | (payload[3] << 8);
-
-		short vDOP;
-		vDOP = payload[4] | (payload[5] << 8);
-
-		short tDOP;
-		tDOP = payload[6] | (payload[7] << 8);
-
-		//nmeaSentences->push_back(wxString::Format("$IIGSA,GSA,A,,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x.x,x.x,x.x));
-		// Looks like we'll need to construct this sentence
-
-		return FALSE;
-	}
-	else {
-		return FALSE;
-	}
-
-}
-
-// Decode PGN 129540 NMEA Satellites in View
-// $--GSV,x,x,x,x,x,x,x,...*hh<CR><LF>
-//        | | | | | | snr
-//        | | | | | azimuth
-//        | | | | elevation
-//        | | | satellite id
-//    total | satellites in view
-//          sentence number
-bool TwoCanDevice::DecodePGN129540(const byte * payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte mode;
-		mode = payload[1] & 0x03;
-
-		byte reserved;
-		reserved = (payload[1] & 0xFC) >> 2;
-
-		byte satsInView;
-		satsInView = payload[2];
-
-		unsigned int index;
-		index = 3;
-
-		wxString gsvSentence;
-		int totalSentences;
-		totalSentences = trunc(satsInView / 4) + ((satsInView % 4) == 0 ? 0 : 1);
-		int sentenceNumber;
-		sentenceNumber = 1;
-
-		for (size_t i = 0;i < satsInView; i++) {
-			
-			byte prn;
-			prn = payload[index];
-			index += 1;
-
-			unsigned short elevation; // radians * 0.0001
-			elevation = payload[index] | (payload[index+1] << 8);
-			index += 2;
-
-			unsigned short azimuth; // radians * 0.0001
-			azimuth = payload[index] | (payload[index+1] << 8);
-			index += 2;
-
-			unsigned short snr; //db * 0.01
-			snr = payload[index] | (payload[index+1] << 8);
-			index += 2;
-
-			int rangeResiduals;
-			rangeResiduals = payload[index] | (payload[index+1] << 8) | (payload[index+2] << 16) | (payload[index+3] << 24);
-			index += 4;
-
-			// From canboat,
-			// 0 Not tracked
-			// 1 Tracked
-			// 2 Used
-			// 3 Not tracked+Diff
-			// 4 Tracked+Diff
-			// 5 Used+Diff
-			byte status; 
-			status = payload[index] & 0x0F;
-			index += 1;
-
-			// BUG BUG Leading zeroes ??
-			// BUG BUG Only generate GSV sentence for satellites used for the position fix
-			if ((status == 2) || (status == 5)) {
-				gsvSentence += wxString::Format(",%02d,%02d,%03d,%02d", prn, 
-				(unsigned int)RADIANS_TO_DEGREES((float)elevation / 10000),
-				(unsigned int)RADIANS_TO_DEGREES((float)azimuth/10000),(unsigned int)snr/100);
-			}
-
-			// Send one NMEA sentence for each quadruple (4) of satellites
-			// and another for the remainder (if the number of satellites is not a multipe of 4)
-			if ((((i+1)%4) == 0) || (((((i+1)%4) != 0)) && ( i == (satsInView - 1)))) {
-				gsvSentence.Prepend(wxString::Format("$GPGSV,%d,%d,%d", totalSentences, sentenceNumber, satsInView));
-				nmeaSentences->push_back(gsvSentence);
-				gsvSentence.Empty();
-				sentenceNumber++;
-			}
-		}
-	return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-              
-}
-
-// Decode PGN 129793 AIS Date and Time report
-// AIS Message Type 4 and if date is present also Message Type 11
-bool TwoCanDevice::DecodePGN129793(const byte * payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(168);
-
-		// Should really check whether this is 4 (Base Station) or 
-		// 11 (mobile station, but only in response to a request using message 10)
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-		
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte reservedA;
-		reservedA = (payload[13] & 0xFC) >> 2;
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[14] | (payload[15] << 8) | (payload[16] << 16) | (payload[17] << 24);
-
-		unsigned int communicationState;
-		communicationState = payload[18] | (payload[19] << 8) | ((payload[20] & 0x07) << 16);
-
-		byte transceiverInformation;
-		transceiverInformation = (payload[20] & 0xF8) >> 3;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[21] | (payload[22] << 8);
-
-		byte reservedB;
-		reservedB = payload[23] & 0x0F;
-
-		byte gnssType;
-		gnssType = (payload[23] & 0xF0) >> 4;
-
-		byte spare;
-		spare = payload[24];
-
-		byte longRangeFlag = 0;
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		// Encode VDM message using 6bit ASCII
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 14, epoch.GetYear());
-		AISInsertInteger(binaryData, 52, 4, epoch.GetMonth() + 1);
-		AISInsertInteger(binaryData, 56, 5, epoch.GetDay());
-		AISInsertInteger(binaryData, 61, 5, epoch.GetHour());
-		AISInsertInteger(binaryData, 66, 6, epoch.GetMinute());
-		AISInsertInteger(binaryData, 72, 6, epoch.GetSecond());
-		AISInsertInteger(binaryData, 78, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 79, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 107, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 134, 4, gnssType);
-		AISInsertInteger(binaryData, 138, 1, longRangeFlag); // Long Range flag doesn't appear to be set anywhere
-		AISInsertInteger(binaryData, 139, 9, spare);
-		AISInsertInteger(binaryData, 148, 1, raimFlag);
-		AISInsertInteger(binaryData, 149, 19, communicationState);
-		
-		// Send a single VDM sentence, note no fillbits nor a sequential message Id
-		
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-
-// Decode PGN 129794 NMEA AIS Class A Static and Voyage Related Data
-// AIS Message Type 5
-bool TwoCanDevice::DecodePGN129794(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(426,0);
-	
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		unsigned int imoNumber;
-		imoNumber = payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24);
-
-		std::string callSign;
-		for (int i = 0; i < 7; i++) {
-			callSign.append(1, (char)payload[9 + i]);
-		}
-
-		std::string shipName;
-		for (int i = 0; i < 20; i++) {
-			shipName.append(1, (char)payload[16 + i]);
-		}
-
-		byte shipType;
-		shipType = payload[36];
-
-		unsigned short shipLength;
-		shipLength = payload[37] | (payload[38] << 8);
-
-		unsigned short shipBeam;
-		shipBeam = payload[39] | (payload[40] << 8);
-
-		unsigned short refStarboard;
-		refStarboard = payload[41] | (payload[42] << 8);
-
-		unsigned short refBow;
-		refBow = payload[43] | (payload[44] << 8);
-
-		unsigned short daysSinceEpoch;
-		daysSinceEpoch = payload[45] | (payload[46] << 8);
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = payload[47] | (payload[48] << 8) | (payload[49] << 16) | (payload[50] << 24);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-
-		unsigned short draft;
-		draft = payload[51] | (payload[52] << 8);
-
-		std::string destination;
-		for (int i = 0; i < 20; i++) {
-			destination.append(1, (char)payload[53 + i]);
-		}
-		
-		byte aisVersion;
-		aisVersion = (payload[73] & 0x03);
-
-		byte gnssType;
-		gnssType = (payload[73] & 0x3C) >> 2;
-
-		byte dteFlag;
-		dteFlag = (payload[73] & 0x40) >> 6;
-
-		byte transceiverInformation;
-		transceiverInformation = payload[74] & 0x1F;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		// Encode VDM Message using 6bit ASCII
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 2, aisVersion );
-		AISInsertInteger(binaryData, 40, 30, imoNumber);
-		AISInsertString(binaryData, 70, 42, callSign);
-		AISInsertString(binaryData, 112, 120, shipName);
-		AISInsertInteger(binaryData, 232, 8, shipType);
-		AISInsertInteger(binaryData, 240, 9, refBow / 10);
-		AISInsertInteger(binaryData, 249, 9, (shipLength / 10) - (refBow / 10));
-		AISInsertInteger(binaryData, 258, 6, (shipBeam / 10) - (refStarboard / 10));
-		AISInsertInteger(binaryData, 264, 6, refStarboard / 10);
-		AISInsertInteger(binaryData, 270, 4, gnssType);
-		AISInsertInteger(binaryData, 274, 4, epoch.GetMonth() + 1);
-		AISInsertInteger(binaryData, 278, 5, epoch.GetDay());
-		AISInsertInteger(binaryData, 283, 5, epoch.GetHour());
-		AISInsertInteger(binaryData, 288, 6, epoch.GetMinute());
-		AISInsertInteger(binaryData, 294, 8, draft / 10);
-		AISInsertString(binaryData, 302, 120, destination);
-		AISInsertInteger(binaryData, 422, 1, dteFlag);
-		AISInsertInteger(binaryData, 423, 1, 0xFF); //spare
-		
-		wxString encodedVDMMessage = AISEncodePayload(binaryData);
-		
-		// Send VDM message in two NMEA183 sentences
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,2,1,%d,%c,%s,0", AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(0,35).c_str()));
-			nmeaSentences->push_back(wxString::Format("!AIVDO,2,2,%d,%c,%s,2", AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(35,36).c_str()));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,2,1,%d,%c,%s,0", AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(0,35).c_str()));
-			nmeaSentences->push_back(wxString::Format("!AIVDM,2,2,%d,%c,%s,2", AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(35,36).c_str()));
-		}
-
-		AISsequentialMessageId += 1;
-		if (AISsequentialMessageId == 10) {
-			AISsequentialMessageId = 0;
-		}
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-//	Decode PGN 129798 AIS SAR Aircraft Position Report
-// AIS Message Type 9
-bool TwoCanDevice::DecodePGN129798(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(168);
-		
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		double longitude;
-		longitude = (payload[5] | (payload[6] << 8) | (payload[7] << 16) | (payload[8] << 24)) * 1e-7;
-		
-		double latitude;
-		latitude = (payload[9] | (payload[10] << 8) | (payload[11] << 16) | (payload[12] << 24)) * 1e-7;
-		
-		byte positionAccuracy;
-		positionAccuracy = payload[13] & 0x01;
-
-		byte raimFlag;
-		raimFlag = (payload[13] & 0x02) >> 1;
-
-		byte timeStamp;
-		timeStamp = (payload[13] & 0xFC) >> 2;
-
-		unsigned short courseOverGround;
-		courseOverGround = payload[14] | (payload[15] << 8);
-
-		unsigned short speedOverGround;
-		speedOverGround = payload[16] | (payload[17] << 8);
-
-		unsigned int communicationState;
-		communicationState = (payload[18] | (payload[19] << 8) | (payload[20] << 16)) & 0x7FFFF;
-
-		byte transceiverInformation; 
-		transceiverInformation = (payload[20] & 0xF8) >> 3;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		double altitude;
-		altitude = 1e-6 * (((long long)payload[21] | ((long long)payload[22] << 8) | ((long long)payload[23] << 16) | ((long long)payload[24] << 24) \
-			| ((long long)payload[25] << 32) | ((long long)payload[26] << 40) | ((long long)payload[27] << 48) | ((long long)payload[28] << 56)));
-		
-		byte reservedForRegionalApplications;
-		reservedForRegionalApplications = payload[29];
-
-		byte dteFlag; 
-		dteFlag = payload[30] & 0x01;
-
-		// BUG BUG Just guessing these to match NMEA2000 payload with ITU AIS fields
-
-		byte assignedModeFlag;
-		assignedModeFlag = (payload[30] & 0x02) >> 1;
-
-		byte sotdmaFlag;
-		sotdmaFlag = (payload[30] & 0x04) >> 2;
-
-		byte altitudeSensor;
-		altitudeSensor = (payload[30] & 0x08) >> 3;
-
-		byte spare;
-		spare = (payload[30] & 0xF0) >> 4;
-
-		byte reserved;
-		reserved = payload[31];
-		
-		// Encode VDM Message using 6bit ASCII
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 12, altitude);
-		AISInsertInteger(binaryData, 50, 10, TwoCanUtils::IsDataValid(speedOverGround) ? CONVERT_MS_KNOTS * speedOverGround * 0.1f : 1023);
-		AISInsertInteger(binaryData, 60, 1, positionAccuracy);
-		AISInsertInteger(binaryData, 61, 28, (int)(longitude * 600000));
-		AISInsertInteger(binaryData, 89, 27, (int)(latitude * 600000));
-		AISInsertInteger(binaryData, 116, 12, TwoCanUtils::IsDataValid(courseOverGround) ? RADIANS_TO_DEGREES((float)courseOverGround) * 0.001f : 3600);
-		AISInsertInteger(binaryData, 128, 6, timeStamp);
-		AISInsertInteger(binaryData, 134, 1, altitudeSensor);
-		AISInsertInteger(binaryData, 135, 7, reservedForRegionalApplications);
-		AISInsertInteger(binaryData, 142, 1, dteFlag);
-		AISInsertInteger(binaryData, 143, 3, spare);
-		AISInsertInteger(binaryData, 146, 1, assignedModeFlag);
-		AISInsertInteger(binaryData, 147, 1, raimFlag);
-		AISInsertInteger(binaryData, 148, 1, sotdmaFlag);
-		AISInsertInteger(binaryData, 149, 19, communicationState);
-		
-		// Send a single VDM sentence, note no fillbits nor a sequential message Id
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-	
-//	Decode PGN 129801 AIS Addressed Safety Related Message
-// AIS Message Type 12
-bool TwoCanDevice::DecodePGN129801(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(1008);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int sourceID;
-		sourceID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		byte reservedA;
-		reservedA = payload[4] & 0x01;
-
-		byte transceiverInformation;
-		transceiverInformation = (payload[5] & 0x3E) >> 1;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		byte sequenceNumber;
-		sequenceNumber = (payload[5] & 0xC0) >> 6;
-
-		unsigned int destinationId;
-		destinationId = payload[6] | (payload[7] << 8) | (payload[8] << 16) | (payload[9] << 24);
-
-		byte reservedB;
-		reservedB = payload[10] & 0x3F;
-
-		byte retransmitFlag;
-		retransmitFlag = (payload[10] & 0x40) >> 6;
-
-		byte reservedC;
-		reservedC = (payload[10] & 0x80) >> 7;
-
-		std::string safetyMessage;
-		int safetyMessageLength = payload[11];
-		if (payload[12] == 1) {
-			// first byte of safety message indicates encoding; 0 for Unicode, 1 for ASCII
-			for (int i = 0; i < safetyMessageLength - 2; i++) {
-				safetyMessage += (static_cast<char>(payload[13 + i]));
-			}
-		}
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, sourceID);
-		AISInsertInteger(binaryData, 38, 2, sequenceNumber);
-		AISInsertInteger(binaryData, 40, 30, destinationId);
-		AISInsertInteger(binaryData, 70, 1, retransmitFlag);
-		AISInsertInteger(binaryData, 71, 1, 0); // unused spare
-		AISInsertString(binaryData, 72, 936, safetyMessage);
-
-		// BUG BUG Calculate fill bits correcty as safetyMessage is variable in length
-
-		int fillBits = 0;
-		fillBits = 1008 % 6;
-		if (fillBits > 0) {
-			AISInsertInteger(binaryData, 968, fillBits, 0);
-		}
-
-		wxString encodedVDMMessage = AISEncodePayload(binaryData);
-
-		// Send the VDM message
-		int numberOfVDMMessages = ((int)encodedVDMMessage.Length() / 28) + ((encodedVDMMessage.Length() % 28) >  0 ? 1 : 0);
-
-		for (int i = 0; i < numberOfVDMMessages; i++) {
-			if (i == numberOfVDMMessages -1) { // This is the last message
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,%d", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28)),fillBits));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,%d", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, encodedVDMMessage.size() - (i * 28)),fillBits));
-				}
-			}
-			else {
-				if (transceiverInformation & 0x04) {
-					nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}
-				else {
-					nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-				}	
-			}
-		}
-
-		AISsequentialMessageId += 1;
-		if (AISsequentialMessageId == 10) {
-			AISsequentialMessageId = 0;
-		}
-
-		return TRUE;
-		
-	}
-
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129802 AIS Safety Related Broadcast Message 
-// AIS Message Type 14
-bool TwoCanDevice::DecodePGN129802(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(1008);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int sourceID;
-		sourceID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | ((payload[4] & 0x3F) << 24);
-
-		byte reservedA;
-		reservedA = (payload[4] & 0xC0) >> 6;
-
-		byte transceiverInformation;
-		transceiverInformation = payload[5] & 0x1F;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		byte reservedB;
-		reservedB = (payload[5] & 0xE0) >> 5;
-
-		std::string safetyMessage;
-		int safetyMessageLength = payload[6];
-		if (payload[7] == 1) { 
-			// first byte of safety message indicates encoding; 0 for Unicode, 1 for ASCII
-			for (int i = 0; i < safetyMessageLength - 2; i++) {
-				safetyMessage += (static_cast<char>(payload[8 + i]));
-			}
-		}
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, sourceID);
-		AISInsertInteger(binaryData, 38, 2, 0); //spare
-		int l = safetyMessage.size();
-		// Remember 6 bits per character
-		AISInsertString(binaryData, 40, l * 6, safetyMessage);
-
-		// Calculate fill bits as safetyMessage is variable in length
-		// According to ITU, maximum length of safetyMessage is 966 6bit characters
-		int fillBits = (40 + (l * 6)) % 6;
-		if (fillBits > 0) {
-			AISInsertInteger(binaryData, 40 + (l * 6), fillBits, 0);
-		}
-
-		// BUG BUG Should check whether the binary message is smaller than 1008 bytes otherwise
-		// we just need a substring from the binaryData
-		std::vector<bool>::const_iterator first = binaryData.begin();
-		std::vector<bool>::const_iterator last = binaryData.begin() + 40 + (l * 6) + fillBits;
-		std::vector<bool> newVec(first, last);
-
-		// Encode the VDM Message using 6bit ASCII
-		wxString encodedVDMMessage = AISEncodePayload(newVec);
-
-		// Send the VDM message, use 28 characters as an arbitary number for multiple NMEA 183 sentences
-		int numberOfVDMMessages = ((int)encodedVDMMessage.Length() / 28) + ((encodedVDMMessage.Length() % 28) >  0 ? 1 : 0);
-		if (numberOfVDMMessages == 1) {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,A,%s,%d", encodedVDMMessage, fillBits));
-		}
-		else {
-			for (int i = 0; i < numberOfVDMMessages; i++) {
-				if (i == numberOfVDMMessages - 1) { // Is this the last message, if so append number of fillbits as appropriate
-					if (transceiverInformation & 0x04) {
-						nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,%d", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28), fillBits));
-					}
-					else {
-						nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,%d", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28), fillBits));
-					}
-				}
-				else {
-					if (transceiverInformation & 0x04) {
-						nmeaSentences->push_back(wxString::Format("!AIVDO,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-					}
-					else {
-						nmeaSentences->push_back(wxString::Format("!AIVDM,%d,%d,%d,%c,%s,0", numberOfVDMMessages, i, AISsequentialMessageId, aisChannel, encodedVDMMessage.Mid(i * 28, 28)));
-					}
-					
-				}
-			}
-		}
-
-		AISsequentialMessageId += 1;
-		if (AISsequentialMessageId == 10) {
-			AISsequentialMessageId = 0;
-		}
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-
-// Decode PGN 129808 NMEA DSC Call
-// $--DSC, xx,xxxxxxxxxx,xx,xx,xx,x.x,x.x,xxxxxxxxxx,xx,a,a
-//          |     |       |  |  |  |   |  MMSI        | | Expansion Specifier
-//          |   MMSI     Category  Position           | Acknowledgement        
-//          Format Specifer  |  |      |Time          Nature of Distress
-//                           |  Type of Communication or Second telecommand
-//                           Nature of Distress or First Telecommand
-
-// and
-// $--DSE
-bool TwoCanDevice::DecodePGN129808(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte formatSpecifier;
-		formatSpecifier = payload[0];
-
-		byte dscCategory;
-		dscCategory = payload[1];
-
-		wxString mmsiAddress = wxEmptyString;
-		// BUG BUG Note MMSI addresses are 9 digits but the spec for both NMEA 183 & 2000 append zero as the field could
-		// also be encoded as a geographic location, encoded using 10 digits.
-		if (payload[6] != 0xFF) {
-			mmsiAddress = wxString::Format("%02x%02x%02x%02x%02x", payload[2], payload[3], payload[4], payload[5], payload[6]);
-		}
-
-		byte firstTelecommand; // or Nature of Distress
-		firstTelecommand = payload[7];
-
-		byte secondTelecommand; // or Communication Mode
-		secondTelecommand = payload[8];
-
-		wxString receiveFrequency = wxEmptyString;
-		if (payload[9] != 0xFF) {
-			receiveFrequency = wxString::Format("%02d%02d%02d%02d%02d%02d", payload[9], payload[10], payload[11], payload[12], payload[13], payload[14]);
-		}
-
-		wxString transmitFrequency = wxEmptyString;
-		if (payload[20] != 0xFF) {
-			transmitFrequency = wxString::Format("%02d%02d%02d%02d%02d%02d", payload[15], payload[16], payload[17], payload[18], payload[19], payload[20]);
-		}
-
-		wxString telephoneNumber;
-		size_t telephoneNumberLength = payload[21];
-		if (payload[22] == 1) { // First byte indicates encoding, 0 for Unicode, 1 for ASCII
-			for (size_t i = 0; i < telephoneNumberLength - 2; i++) {
-				telephoneNumber.append(1, (char)payload[23 + i]);
-			}
-		}
-
-		size_t index = 21 + telephoneNumberLength;
-
-		double latitude;
-		latitude = 1e-7 * (payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24));
-
-		index += 4;
-
-		double longitude;
-		longitude = 1e-7 * (payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24));
-
-		index += 4;
-
-		int latitudeDegrees = trunc(latitude);
-		double latitudeMinutes = fabs((latitude - latitudeDegrees) * 60);
-
-		int longitudeDegrees = trunc(longitude);
-		double longitudeMinutes = fabs((longitude - longitudeDegrees) * 60);
-
-		wxString position;
-		position = wxString::Format("%02d%02d%03d%02d", abs(latitudeDegrees), (int)trunc(latitudeMinutes),
-			abs(longitudeDegrees), (int)trunc(longitudeMinutes));
-
-		// quadrant 0 = North East, 1 North West, 2 South East, 3 South West,
-		if (latitude >= 0) {
-			if (longitude >= 0) {
-				position.insert(0, "0");
-			}
-			else {
-				position.insert(0, "1");
-			}
-		}
-		else {
-			if (longitude >= 0) {
-				position.insert(0, "2");
-			}
-			else {
-				position.insert(0, "3");
-			}
-		}
-
-		unsigned int secondsSinceMidnight;
-		secondsSinceMidnight = (unsigned int)payload[index] | ((unsigned int)payload[index + 1] << 8) | ((unsigned int)payload[index + 2] << 16) | ((unsigned int)payload[index + 3] << 24);
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		wxString timeOfPosition = epoch.Format("%H%M");
-
-		index += 4;
-
-		wxString vesselInDistress = wxEmptyString;
-
-		if (payload[index + 4] != 0xFF) { // If there is no MMSI address, the value should be all 0xFF
-			vesselInDistress = wxString::Format("%02d%02d%02d%02d%02d", payload[index], payload[index + 1], payload[index + 2], payload[index + 3], payload[index + 4]);
-		}
-
-		index += 5;
-
-		byte endOfSequence;
-		endOfSequence = payload[index]; // 1 byte
-
-		index += 1;
-
-		byte dscExpansionEnabled; // Encoded over two bits
-		dscExpansionEnabled = payload[index] & 0x03;
-
-		index += 1;
-
-		wxString callingRx = wxEmptyString;
-		if (payload[index + 5] != 0xFF) {
-			callingRx = wxString::Format("%02d%02d%02d%02d%02d%02d", payload[index], payload[index + 1], payload[index + 2], payload[index + 3], payload[index + 4], payload[index + 5]);
-		}
-
-		index += 6;
-
-		wxString callingTx = wxEmptyString;
-		if (payload[index + 5] != 0xFF) {
-			callingTx = wxString::Format("%02d%02d%02d%02d%02d%02d", payload[index], payload[index + 1], payload[index + 2], payload[index + 3], payload[index + 4], payload[index + 5]);
-		}
-
-		index += 6;
-
-		unsigned int timeOfTransmission; // Not used in DSC sentence
-		timeOfTransmission = payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24);
-
-		index += 4;
-
-		unsigned short dayOfTransmission; // Not used in DSC Sentence
-		dayOfTransmission = payload[index] | (payload[index + 1] << 8);
-
-		index += 2;
-
-		unsigned short messageId; // Not used in DSC Sentence
-		messageId = payload[index] | (payload[index + 1] << 8);
-
-		index += 2;
-
-		wxString dscSentence;
-
-		dscSentence = wxString::Format("$CDDSC,%02d,%s", formatSpecifier - 100, mmsiAddress);
-
-		if (formatSpecifier == 112) { // If Format Specifier is Distress, DSC Category is NULL
-			dscSentence += wxString::Format(",,%02d,%02d,%s,%s,,,%c", firstTelecommand - 100, secondTelecommand - 100, position,
-				timeOfPosition, endOfSequence == 117 ? 'R' : endOfSequence == 122 ? 'B' : 'S');
-		}
-		else { // Format Specifier is All Ships, Group or Individual
-			//"$CDDSC,16,0112345670,12,12,09,1474712219,1234,9991212120,00,S,,", _
-			//"$CDDSC,16,0112345670,08,09,26,041250,,,,S,,*C9",
-			if (dscCategory == 112) { // Either a Distress Ack, Distres Relay or Distress Relay Ack
-				dscSentence += wxString::Format(",%02d,%02d,%02d,%s,%s,%s,%02d,%c", dscCategory - 100, firstTelecommand - 100, secondTelecommand - 100,
-					position, timeOfPosition, vesselInDistress, secondTelecommand - 100,
-					endOfSequence == 117 ? 'R' : endOfSequence == 122 ? 'B' : 'S');
-			}
-			else { // Urgency of Safety.Eg, A position update
-				dscSentence += wxString::Format(",%02d,%02d, %02d,%s,%s,,,%c", dscCategory - 100, firstTelecommand - 100, secondTelecommand - 100,
-					position, timeOfPosition, endOfSequence == 117 ? 'R' : endOfSequence == 122 ? 'B' : 'S');
-			}
-		}
-
-		if ((dscExpansionEnabled & 0x01)== 0x01) {
-			dscSentence += ",E";
-		}
-		else {
-			dscSentence += ",";
-		}
-
-		nmeaSentences->push_back(dscSentence);
-
-		// If there is DSE Expansion Data, the following pairs are repeated
-
-		if ((dscExpansionEnabled & 0x01) == 0x01) {
-
-			byte dscExpansionSymbol;
-			std::vector<byte> dseExpansionData;
-			wxString dseSentence;
-
-			dseSentence = wxString::Format("$CDDSE,1,1,A,%s", mmsiAddress);
-			
-			for (size_t j = 0; j < 2; j++) {
-
-				dscExpansionSymbol = payload[index];
-				if (dscExpansionSymbol != 0xFF) {
-					dseSentence += wxString::Format(",%02d,", dscExpansionSymbol - 100);
-					index += 1;
-
-					size_t  dseExpansionDataLength = payload[index];
-					index += 1;
-
-					byte dscEncoding = payload[index]; // Should really check it is 0x01  to denote ASCII
-					index += 1;
-
-					if (dseExpansionDataLength > 2) {
-
-						for (size_t k = 0; k < dseExpansionDataLength - 2; k++) {
-							dseSentence += std::to_string(payload[index]);
-							index += 1;
-						}
-					} 
-				}
-				else {
-					// Assuming they have correctly encoded a blank value with the correct length & encoding byte
-					index += 2;
-				}
-			}
-
-			wxLogMessage(wxString::Format("&&&& DSE: %s", dseSentence));
-			nmeaSentences->push_back(dseSentence);
-		} 
-
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode table from ITU-R M.825 // Not actually used here, but.....
-wxString TwoCanDevice::DecodeDSEExpansionCharacters(std::vector<byte> dseData) {
-	wxString result;
-	char lookupTable[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '\'',
-		'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L',
-		'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-		'Y', 'Z', '.', ',', '-', '/', ' ' };
-
-	for (size_t i = 0; i < dseData.size(); i += 2) {
-		result.append(1, lookupTable[dseData[i]]);
-	}
-	return result;
-}
-
-// Decode PGN 129809 AIS Class B Static Data Report, Part A 
-// AIS Message Type 24, Part A
-bool TwoCanDevice::DecodePGN129809(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-		
-		std::vector<bool> binaryData(164);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		std::string shipName;
-		for (int i = 0; i < 20; i++) {
-			shipName.append(1, (char)payload[5 + i]);
-		}
-
-		byte transceiverInformation;
-		transceiverInformation = payload[25] & 0x1F;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		// Encode VDM Message using 6 bit ASCII
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 2, 0x0); // Part A = 0
-		AISInsertString(binaryData, 40, 120, shipName);
-		
-		// Add padding to align on 6 bit boundary
-		int fillBits = 0;
-		fillBits = 160 % 6;
-		if (fillBits > 0) {
-			AISInsertInteger(binaryData, 160, fillBits, 0);
-		}
-		
-		// Send a single VDM sentence, note no sequential message Id		
-		if (transceiverInformation & 0x04) {		
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,%d", aisChannel, AISEncodePayload(binaryData), fillBits));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,%d", aisChannel, AISEncodePayload(binaryData), fillBits));
-		}
-		
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 129810 AIS Class B Static Data Report, Part B 
-// AIS Message Type 24, Part B
-bool TwoCanDevice::DecodePGN129810(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		std::vector<bool> binaryData(168);
-
-		byte messageID;
-		messageID = payload[0] & 0x3F;
-
-		byte repeatIndicator;
-		repeatIndicator = (payload[0] & 0xC0) >> 6;
-
-		unsigned int userID; // aka sender's MMSI
-		userID = payload[1] | (payload[2] << 8) | (payload[3] << 16) | (payload[4] << 24);
-
-		byte shipType;
-		shipType = payload[5];
-
-		std::string vendorId;
-		for (int i = 0; i < 7; i++) {
-			vendorId.append(1, (char)payload[6 + i]);
-		}
-
-		std::string callSign;
-		for (int i = 0; i < 7; i++) {
-			callSign.append(1, (char)payload[13 + i]);
-		}
-		
-		unsigned short shipLength;
-		shipLength = payload[20] | (payload[21] << 8);
-
-		unsigned short shipBeam;
-		shipBeam = payload[22] | (payload[23] << 8);
-
-		unsigned short refStarboard;
-		refStarboard = payload[24] | (payload[25] << 8);
-
-		unsigned short refBow;
-		refBow = payload[26] | (payload[27] << 8);
-
-		unsigned int motherShipID; // aka mother ship MMSI
-		motherShipID = payload[28] | (payload[29] << 8) | (payload[30] << 16) | (payload[31] << 24);
-
-		byte reserved;
-		reserved = (payload[32] & 0x03);
-
-		byte spare;
-		spare = (payload[32] & 0xFC) >> 2;
-
-		byte transceiverInformation;
-		transceiverInformation = payload[33] & 0x1F;
-
-		char aisChannel;
-		aisChannel = (transceiverInformation & 0x01) ? 'B' : 'A';
-
-		AISInsertInteger(binaryData, 0, 6, messageID);
-		AISInsertInteger(binaryData, 6, 2, repeatIndicator);
-		AISInsertInteger(binaryData, 8, 30, userID);
-		AISInsertInteger(binaryData, 38, 2, 0x01); // Part B = 1
-		AISInsertInteger(binaryData, 40, 8, shipType);
-		AISInsertString(binaryData, 48, 42, vendorId);
-		AISInsertString(binaryData, 90, 42, callSign);
-		AISInsertInteger(binaryData, 132, 9, refBow / 10);
-		AISInsertInteger(binaryData, 141, 9, (shipLength / 10) - (refBow / 10));
-		AISInsertInteger(binaryData, 150, 6, (shipBeam / 10) - (refStarboard / 10));
-		AISInsertInteger(binaryData, 156, 6, refStarboard / 10);
-		AISInsertInteger(binaryData, 162 ,6 , 0); //spare
-		
-		// Send a single VDM sentence, note no fillbits nor a sequential message Id
-		if (transceiverInformation & 0x04) {
-			nmeaSentences->push_back(wxString::Format("!AIVDO,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		else {
-			nmeaSentences->push_back(wxString::Format("!AIVDM,1,1,,%c,%s,0", aisChannel, AISEncodePayload(binaryData)));
-		}
-		
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// decode PGN 130065 NMEA Route & Waypoint Service - Route List
-bool TwoCanDevice::DecodePGN130065(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-		
-		byte startRouteId;
-		startRouteId = payload[0];
-		
-		byte nItems;
-		nItems = payload[1];
-
-        byte nRoutes;
-		nRoutes = payload[2];
-
-        byte databaseId;
-		databaseId = payload[3];
-		
-		unsigned int index;
-		index = 4;
-
-		for (unsigned int i = 0; i < nItems; i++) {
-			
-			byte routeId;
-			routeId = payload[index];
-			index += 1;
-
-			// BUG BUG Are these null terminated ??
-			char routeName[8];
-			memcpy(routeName, &payload[index], 8);
-			index += 8;
-
-			byte wpIdMethod;
-			wpIdMethod = (payload[index] & 0x30) >> 4;
-
-			byte routeStatus;
-			routeStatus = (payload[index] & 0xC0 ) >> 6;
-			index += 1;
-
-			if (enableWaypoint == TRUE) {
-				PlugIn_Route route;
-				route.m_NameString = routeName;
-				route.m_GUID = GetNewGUID();
-				// What to do with
-				// route.m_StartString;
-    			// route.m_EndString;
-				AddPlugInRoute(&route, true);
-			}
-
-		}
-          
-        
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-
-}
-
-// Decode PGN 130074 NMEA Route & Waypoint Service - Waypoint List
-bool TwoCanDevice::DecodePGN130074(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		unsigned short startingWaypointId;
-		startingWaypointId = payload[0] | (payload[1] << 8);
-
-		unsigned short items;
-		items = payload[2] | (payload[3] << 8);
-
-		unsigned short validItems;
-		validItems = payload[4] | (payload[5] << 8);
-
-		unsigned short databaseId;
-		databaseId = payload[6] | (payload[7] << 8);
-
-		unsigned short reserved;
-		reserved = payload[8] | (payload[9] << 8);
-
-		unsigned int index;
-		index = 10;
-
-		// BUG BUG This is potentially broken, however I have never seen more than
-		// one waypoint sent, and I have never seen Unicode characters used.
-		for (size_t i = 0; i < validItems; i++) {
-			unsigned short waypointId;
-			waypointId = payload[index] | (payload[index + 1] << 8);
-			index += 2;
-
-			// Text with length & control byte
-			unsigned int wptNameLength;
-			wxString waypointName;
-
-			wptNameLength = payload[index];
-			index += 1;
-			if (payload[index] == 0x01) { // first byte of Waypoint Name indicates encoding; 0 for Unicode, 1 for ASCII
-				index += 1;
-				waypointName.clear();
-				for (size_t i = 0; i < wptNameLength - 2; i++) {
-					waypointName.append(1, (char)payload[index]);
-					index++;
-				}
-
-			}
-
-			double latitude;
-			latitude = (payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24)) * 1e-7;
-			int latitudeDegrees = trunc(latitude);
-			double latitudeMinutes = fabs(latitude - latitudeDegrees);
-			index += 4;
-
-			double longitude;
-			longitude = (payload[index] | (payload[index + 1] << 8) | (payload[index + 2] << 16) | (payload[index + 3] << 24)) * 1e-7;
-			int longitudeDegrees = trunc(longitude);
-			double longitudeMinutes = fabs(longitude - longitudeDegrees);
-			index += 4;
-
-			// Generate the NMEA 183 WPL sentence, even though it is not used by OpenCPN.
-			nmeaSentences->push_back(wxString::Format("$IIWPL,%02d%05.2f,%c,%03d%05.2f,%c,%s",
-				abs(latitudeDegrees), fabs(latitudeMinutes), latitude >= 0 ? 'N' : 'S',
-				abs(longitudeDegrees), fabs(longitudeMinutes), longitude >= 0 ? 'E' : 'W',
-				waypointName.ToAscii()));
-
-			// Insert the waypoint directly into OpenCPN as it does not parse WPL sentences.
-			// we don't retrieve waypoints to compare, so no way to avoid duplication......
-			if (enableWaypoint) {
-				PlugIn_Waypoint waypoint;
-				waypoint.m_IsVisible = true;
-				waypoint.m_MarkName = waypointName;
-				// BUG BUG Should have a UI thingy to specify the default symbol
-				waypoint.m_IconName = "Symbol_Triangle";
-				waypoint.m_GUID = GetNewGUID();
-				waypoint.m_lat = latitude;
-				waypoint.m_lon = longitude;
-				AddSingleWaypoint(&waypoint, true);
-			}
-		}
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130306 NMEA Wind
-// $--MWV,x.x,a,x.x,a,A*hh<CR><LF>
-bool TwoCanDevice::DecodePGN130306(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned short windSpeed;
-		windSpeed = payload[1] | (payload[2] << 8);
-
-		unsigned short windAngle;
-		windAngle = payload[3] | (payload[4] << 8);
-
-		byte windReference;
-		windReference = (payload[5] & 0x07);
-
-		if (TwoCanUtils::IsDataValid(windSpeed)) {
-			if (TwoCanUtils::IsDataValid(windAngle)) {
-				nmeaSentences->push_back(wxString::Format("$IIMWV,%.2f,%c,%.2f,N,A", RADIANS_TO_DEGREES((float)windAngle/10000), \
-				(windReference == WIND_REFERENCE_APPARENT) ? 'R' : 'T', (double)windSpeed * CONVERT_MS_KNOTS / 100));
-				return TRUE;
-
-			}
-			else {
-				nmeaSentences->push_back(wxString::Format("$IIMWV,,%c,%.2f,N,A", \
-				(windReference == WIND_REFERENCE_APPARENT) ? 'R' : 'T', (double)windSpeed * CONVERT_MS_KNOTS / 100));
-				return TRUE;	
-			}
-		}
-		else {
-			if (TwoCanUtils::IsDataValid(windAngle)) {
-				nmeaSentences->push_back(wxString::Format("$IIMWV,%.2f,%c,,N,A", RADIANS_TO_DEGREES((float)windAngle/10000), \
-				(windReference == WIND_REFERENCE_APPARENT) ? 'R' : 'T'));
-				return TRUE;
-			}
-			else {
-				return FALSE;
-			}
-		} 
-		
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130310 NMEA Water & Air Temperature and Pressure
-// $--MTW,x.x,C*hh<CR><LF>
-bool TwoCanDevice::DecodePGN130310(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		unsigned short waterTemperature;
-		waterTemperature = payload[1] | (payload[2] << 8);
-
-		unsigned short airTemperature;
-		airTemperature = payload[3] | (payload[4] << 8);
-
-		unsigned short airPressure;
-		airPressure = payload[5] | (payload[6] << 8);
-		
-		if (TwoCanUtils::IsDataValid(waterTemperature)) {
-			nmeaSentences->push_back(wxString::Format("$IIMTW,%.2f,C", ((float)waterTemperature * 0.01f) - CONST_KELVIN));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130311 NMEA Environment  (supercedes 130311)
-// $--MTW,x.x,C*hh<CR><LF>
-bool TwoCanDevice::DecodePGN130311(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte temperatureSource;
-		temperatureSource = payload[1] & 0x3F;
-		
-		byte humiditySource;
-		humiditySource = (payload[1] & 0xC0) >> 6;
-		
-		unsigned short temperature;
-		temperature = payload[2] | (payload[3] << 8);
-			
-		unsigned short humidity;
-		humidity = payload[4] | (payload[5] << 8);
-		//	Resolution 0.004
-			
-		unsigned short pressure;
-		pressure = payload[6] | (payload[7] << 8);
-		
-		if ((temperatureSource == TEMPERATURE_SEA) && (TwoCanUtils::IsDataValid(temperature))) {
-			nmeaSentences->push_back(wxString::Format("$IIMTW,%.2f,C", ((float)temperature * 0.01f) - CONST_KELVIN));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-
-// Decode PGN 130312 NMEA Temperature
-// $--MTW,x.x,C*hh<CR><LF>
-// $--XDR,C,x.x,C,c-c*hh<<CR?<:F>
-bool TwoCanDevice::DecodePGN130312(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte instance;
-		instance = payload[1];
-
-		byte source;
-		source = payload[2];
-
-		unsigned short actualTemperature;
-		actualTemperature = payload[3] | (payload[4] << 8);
-
-		unsigned short setTemperature;
-		setTemperature = payload[5] | (payload[6] << 8);
-
-		// BUG BUG Perhaps switch statement ??
-		if ((source == TEMPERATURE_SEA) && (TwoCanUtils::IsDataValid(actualTemperature))) {
-			nmeaSentences->push_back(wxString::Format("$IIMTW,%.2f,C", ((float)actualTemperature * 0.01f) - CONST_KELVIN));
-			return TRUE;
-		}
-		else if ((source == TEMPERATURE_EXHAUST) && (TwoCanUtils::IsDataValid(actualTemperature))) {
-			nmeaSentences->push_back(wxString::Format("$ERXDR,C,%.1f,C,ENGINEEXHAUST#%1d", 
-				((float)actualTemperature * 0.01f) - CONST_KELVIN, instance));
-			return TRUE;
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130316 NMEA Temperature Extended Range
-// $--MTW,x.x,C*hh<CR><LF>
-bool TwoCanDevice::DecodePGN130316(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte sid;
-		sid = payload[0];
-
-		byte instance;
-		instance = payload[1];
-
-		byte source;
-		source = payload[2];
-
-		unsigned int actualTemperature; // A three byte value, guess I need to special case the validity check. Bloody NMEA!!
-		actualTemperature = payload[3] | (payload[4] << 8) | (payload[5] << 16);
-
-		unsigned short setTemperature;
-		setTemperature = payload[6] | (payload[7] << 8);
-
-		if ((source == TEMPERATURE_SEA) && (actualTemperature < 0xFFFFFD)) {
-			nmeaSentences->push_back(wxString::Format("$IIMTW,%.2f,C", ((float)actualTemperature * 0.001f) - CONST_KELVIN));
-			return TRUE; 
-		}
-		else {
-			return FALSE;
-		}
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130323 Meteorological Station Data
-//         1   2  3    4  5  6 7 8  9 10 11 12 13 14 15 16 17 18 19 20 21
-//         |   |  |    |  |  | | |  |  |  |  |  |  |  |  |  |  |  |  |  |
-// $--MDA,n.nn,I,n.nnn,B,n.n,C,n.C,n.n,n,n.n,C,n.n,T,n.n,M,n.n,N,n.n,M*hh<CR><LF>
-
-// Field Number:
-// 1. Barometric pressure, inches of mercury, to the nearest 0.01 inch
-// 2. I = inches of mercury
-// 3.. Barometric pressure, bars, to the nearest .001 bar
-// 4. B = bars
-// 5. Air temperature, degrees C, to the nearest 0.1 degree C
-// 6. C = degrees C
-// 7. Water temperature, degrees C (this field left blank by WeatherStation)
-// 8. C = degrees C
-// 9. Relative humidity, percent, to the nearest 0.1 percent
-// 10. Absolute humidity, percent
-// 11. Dew point, degrees C, to the nearest 0.1 degree C
-// 12. C = degrees C
-// 13. Wind direction, degrees True, to the nearest 0.1 degree
-// 14. T = true
-// 15. Wind direction, degrees Magnetic, to the nearest 0.1 degree
-// 16. M = magnetic
-// 17. Wind speed, knots, to the nearest 0.1 knot
-// 18. N = knots
-// 19. Wind speed, meters per second, to the nearest 0.1 m/s
-// 20. M = meters per second
-// 21. Checksum
-
-bool TwoCanDevice::DecodePGN130323(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		byte dataMode;
-		dataMode = payload[0] & 0x0F;
-
-		int daysSinceEpoch;
-		daysSinceEpoch = payload[1] | (payload[2] << 8);
-
-		int secondsSinceMidnight;
-		secondsSinceMidnight = payload[3] | (payload[4] << 8) | (payload[5] << 16) | (payload[6] << 24);
-
-		double latitude;
-		latitude = (payload[7] | (payload[8] << 8) | (payload[9] << 16) | (payload[10] << 24)) * 1e-7;
-
-		int latitudeDegrees;
-		latitudeDegrees = trunc(latitude);
-
-		double latitudeMinutes;
-		latitudeMinutes = fabs(latitude - latitudeDegrees);
-
-		double longitude;
-		longitude = (payload[11] | (payload[12] << 8) | (payload[13] << 16) | (payload[14] << 24)) * 1e-7;
-
-		int longitudeDegrees;
-		longitudeDegrees = trunc(longitude);
-
-		double longitudeMinutes;
-		longitudeMinutes = fabs(longitude - longitudeDegrees);
-
-		int windSpeed;
-		windSpeed = payload[15] | (payload[16] << 8);
-
-		int windAngle;
-		windAngle = payload[17] | (payload[18] << 8);
-
-		byte windReference;
-		windReference = payload[19] & 0x07;
-
-		int windGusts;
-		windGusts = payload[20] | (payload[21] << 8);
-
-		int atmosphericPressure;
-		atmosphericPressure = payload[22] | (payload[23] << 8);
-
-		float ambientTemperature;
-		ambientTemperature = ((payload[24] | (payload[25] << 8)) * 0.01f) - 273.15;
-
-		std::string stationId;;
-		int index = 26;
-		int stringLength = payload[index];
-		index++;
-		if (payload[index] == 1) {
-			index++;
-			// first byte of Station ID indicates encoding; 0 for Unicode, 1 for ASCII
-			for (int i = 0; i < stringLength - 2; i++) {
-				stationId += (static_cast<char>(payload[index]));
-				index++;
-			}
-		}
-
-		std::string stationName;
-		stringLength = payload[index];
-		index++;
-		if (payload[index] == 1) {
-			index++;
-			// first byte of Station Name indicates encoding; 0 for Unicode, 1 for ASCII
-			for (int i = 0; i < stringLength - 2; i++) {
-				stationName += (static_cast<char>(payload[index]));
-				index++;
-			}
-		}
-
-
-		wxDateTime epoch((time_t)0);
-		epoch += wxDateSpan::Days(daysSinceEpoch);
-		epoch += wxTimeSpan::Seconds((wxLongLong)secondsSinceMidnight / 10000);
-
-		nmeaSentences->push_back(wxString::Format("$IIMDA,,I,%.2f,B,%.1f,C,,C,,,,C,%.2f,T,,M,%.2f,N,%.2f,M", atmosphericPressure, \
-		((float)ambientTemperature * 0.01f) - CONST_KELVIN, RADIANS_TO_DEGREES((float)windAngle / 10000 ), \
-		(double)windSpeed * CONVERT_MS_KNOTS / 100, (double)windSpeed / 100));
-		
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130577 NMEA Direction Data
-bool TwoCanDevice::DecodePGN130577(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != NULL) {
-
-		// 0 - Autonomous, 1 - Differential enhanced, 2 - Estimated, 3 - Simulated, 4 - Manual
-		byte dataMode;
-		dataMode = payload[0] & 0x0F;
-
-		// True = 0, Magnetic = 1
-		byte cogReference;
-		cogReference = (payload[0] & 0x30);
-
-		byte sid;
-		sid = payload[1];
-
-		unsigned short courseOverGround;
-		courseOverGround = (payload[2] | (payload[3] << 8));
-
-		unsigned short speedOverGround;
-		speedOverGround = (payload[4] | (payload[5] << 8));
-
-		unsigned short heading;
-		heading = (payload[6] | (payload[7] << 8));
-
-		unsigned short speedThroughWater;
-		speedThroughWater = (payload[8] | (payload[9] << 8));
-
-		unsigned short set;
-		set = (payload[10] | (payload[11] << 8));
-
-		unsigned short drift;
-		drift = (payload[12] | (payload[13] << 8));
-
-
-		nmeaSentences->push_back(wxString::Format("$IIVTG,%.2f,T,%.2f,M,%.2f,N,%.2f,K,%c", RADIANS_TO_DEGREES((float)courseOverGround / 10000), \
-			RADIANS_TO_DEGREES((float)courseOverGround / 10000), (float)speedOverGround * CONVERT_MS_KNOTS / 100, \
-			(float)speedOverGround * CONVERT_MS_KMH / 100, GPS_MODE_AUTONOMOUS));
-		return TRUE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-// Decode PGN 130820 Manufacturer Proprietary Message
-// At present return FALSE, because there are no NMEA 183 sentences to generate/send
-// Initially implemented to support TwoCan Media, A Remote Control for Fusion Media Players
-bool TwoCanDevice::DecodePGN130820(const byte *payload, std::vector<wxString> *nmeaSentences) {
-	if (payload != nullptr) {
-
-		unsigned int manufacturerId;
-		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
-
-		byte industryCode;
-		industryCode = (payload[1] & 0xE0) >> 5;
-
-		switch (manufacturerId) {
-			case 229: // Garmin
-				break;
-			case 275: // Navico
-				break;
-			case  382: //B & G
-				break;
-			case 419: {// Fusion
-				if (enableMusic) {
-						wxString jsonResponse;
-						if (twoCanMedia->DecodeMediaResponse(payload, &jsonResponse)) {
-							if (jsonResponse.Length() > 0) {
-								SendPluginMessage(_T("TWOCAN_MEDIA_RESPONSE"), jsonResponse);
-							}
-						}
-					}
-				}
-				break;
-			case 1875: // Simrad
-				break;
-		}
-	}
-	return FALSE;
-}
-
-bool TwoCanDevice::DecodePGN130822(const byte *payload) {
-	if (payload != nullptr) {
-
-		unsigned int manufacturerId;
-		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
-
-		byte industryCode;
-		industryCode = (payload[1] & 0xE0) >> 5;
-
-		return FALSE;
-	}
-	else {
-		return FALSE;
-	}
-}
-
-bool TwoCanDevice::DecodePGN130824(const byte *payload) {
-	if (payload != nullptr) {
-
-		unsigned int manufacturerId;
-		manufacturerId = payload[0] | ((payload[1] & 0x07) << 8);
-
-		byte industryCode;
-		industryCode = (payload[1] & 0xE0) >> 5;
+		byte industryCode;
+		industryCode = (payload[1] & 0xE0) >> 5;
 
 		return FALSE;
 	}
@@ -5902,31 +2123,19 @@ void TwoCanDevice::SendNMEASentence(wxString sentence) {
 	RaiseEvent(sentence);
 }
 
-// Shamelessly copied from somewhere, another plugin ?
-wxString TwoCanDevice::ComputeChecksum(wxString sentence) {
-	unsigned char calculatedChecksum = 0;
-	for (wxString::const_iterator it = sentence.begin() + 1; it != sentence.end(); ++it) {
-		calculatedChecksum ^= static_cast<unsigned char> (*it);
-	}
-	return(wxString::Format(wxT("%02X"), calculatedChecksum));
-}
-
 // Fragment a Fast Packet Message into 8 byte payload chunks
+// The frames are queued together so that they are transmitted consecutively
 int TwoCanDevice::FragmentFastMessage(CanHeader *header, unsigned int payloadLength, byte *payload) {
-	unsigned int id;
+	CanFrame frames[CONST_MAX_FAST_PACKET_FRAMES];
 	int returnCode;
-	byte data[8];
-	
-	TwoCanUtils::EncodeCanHeader(&id,header);
-		
-	// Send the first frame
-	// BUG BUG should maintain a map of sequential ID's for each PGN
-	byte sid = 0;
-	data[0] = sid;
-	data[1] = payloadLength;
-	memcpy(&data[2], &payload[0], 6);
-	
-	returnCode = TransmitFrame(id, &data[0]);
+
+	size_t frameCount = TwoCanUtils::FragmentFastMessage(header, payloadLength, payload, frames);
+	if (frameCount == 0) {
+		wxLogError(_T("TwoCan Device, Fast message too long: %d"), payloadLength);
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_TRANSMIT_FAILURE);
+	}
+
+	returnCode = TransmitFrames(frames, frameCount);
 
 	if (returnCode != TWOCAN_RESULT_SUCCESS) {
 		wxLogError(_T("TwoCan Device, Error sending fast message frame"));
@@ -5934,58 +2143,135 @@ int TwoCanDevice::FragmentFastMessage(CanHeader *header, unsigned int payloadLen
 		return returnCode;
 	}
 	
-	sid += 1;
-	wxThread::Sleep(CONST_TEN_MILLIS);
-	
-	// Now the intermediate frames
-	int iterations;
-	iterations = (int)((payloadLength - 6) / 7);
-		
-	for (int i = 0; i < iterations; i++) {
-		data[0] = sid;
-		memcpy(&data[1],&payload[6 + (i * 7)],7);
-		
-		returnCode = TransmitFrame(id, &data[0]);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Transmit a NMEA 2000 message
+// Called by the plugin for the gateway & autopilot functions.
+// In active mode the frames are queued for the transmit scheduler and this returns immediately
+int TwoCanDevice::TransmitFrame(unsigned int id, byte *data, const size_t frameCount) {
+	int returnCode = TWOCAN_RESULT_SUCCESS;
 
+	if (transmitScheduler != nullptr) {
+		returnCode = transmitScheduler->Enqueue(id, data, frameCount);
 		if (returnCode != TWOCAN_RESULT_SUCCESS) {
-			wxLogError(_T("TwoCan Device, Error sending fast message frame"));
-			// BUG BUG Should we log the frame ??
-			return returnCode;
+			wxLogError(_T("TwoCan Device, Transmit queue full, discarded %d frame(s)"), (int)frameCount);
 		}
-		
-		sid += 1;
-		wxThread::Sleep(CONST_TEN_MILLIS);
+		return returnCode;
 	}
-	
-	// Is there a remaining frame ?
-	int remainingBytes;
-	remainingBytes = (payloadLength - 6) % 7;
-	if (remainingBytes > 0) {
-		data[0] = sid;
-		memset(&data[1],0xFF,7);
-		memcpy(&data[1], &payload[payloadLength - remainingBytes], remainingBytes );
-			
-		returnCode = TransmitFrame(id, &data[0]);
-		
+
+	// Passive mode, write directly to the adapter
+	CanFrame frame;
+	size_t framesWritten;
+	frame.id = id;
+	for (size_t i = 0; (i < frameCount) && (returnCode == TWOCAN_RESULT_SUCCESS); i++) {
+		memcpy(frame.data, &data[i * CONST_PAYLOAD_LENGTH], CONST_PAYLOAD_LENGTH);
+		returnCode = WriteAdapterFrames(&frame, 1, &framesWritten);
+	}
+	return returnCode;
+}
+
+// Transmit frames that have already been encoded, eg. by the NMEA 183 encoder
+// In active mode the span is queued in its entirety for the transmit scheduler, otherwise written to the adapter as a single batch
+int TwoCanDevice::TransmitFrames(const CanFrame *frames, const size_t frameCount) {
+	if (frameCount == 0) {
+		return TWOCAN_RESULT_SUCCESS;
+	}
+
+	if (transmitScheduler != nullptr) {
+		int returnCode = transmitScheduler->Enqueue(frames, frameCount);
 		if (returnCode != TWOCAN_RESULT_SUCCESS) {
-			wxLogError(_T("TwoCan Device, Error sending fast message frame"));
-			// BUG BUG Should we log the frame ??
-			return returnCode;
+			wxLogError(_T("TwoCan Device, Transmit queue full, discarded %d frame(s)"), (int)frameCount);
 		}
+		return returnCode;
 	}
-	
-	return TWOCAN_RESULT_SUCCESS;
+
+	size_t framesWritten;
+	return WriteAdapterFrames(frames, frameCount, &framesWritten);
 }
 
-// Transmit a NMEA 2000 message
-// Called by the plugin for the gateway & autopilot functions.
-int TwoCanDevice::TransmitFrame(unsigned int id, byte *data) {
+// Transmit messages generated by the autopilot & media player
+int TwoCanDevice::TransmitMessages(std::vector<CanMessage> *messages) {
+	std::vector<CanFrame> frames(messages->size());
+
+	for (size_t i = 0; i < messages->size(); i++) {
+		TwoCanUtils::EncodeCanHeader(&frames[i].id, &messages->at(i).header);
+		memset(frames[i].data, 0xFF, CONST_PAYLOAD_LENGTH);
+		memcpy(frames[i].data, messages->at(i).payload.data(), std::min(messages->at(i).payload.size(), (size_t)CONST_PAYLOAD_LENGTH));
+	}
+
+	return TransmitFrames(frames.data(), frames.size());
+}
+
+// Transmit raw messages from other plugins. The messages are validated first, then converted into frames
+// and queued a batch at a time, so that a large export neither builds one enormous span nor overfills the transmit queue.
+int TwoCanDevice::TransmitRawMessages(const TwoCanRawMessage *messages, const size_t messageCount, size_t *messagesQueued) {
+	std::vector<CanFrame> frames;
+	CanHeader header;
+	size_t frameCount = 0;
 	int returnCode;
+
+	*messagesQueued = 0;
+
+	for (size_t i = 0; i < messageCount; i++) {
+		if ((messages[i].data == nullptr) || (messages[i].length == 0) || (messages[i].length > CONST_MAX_FAST_PACKET_LENGTH)) {
+			wxLogError(_T("TwoCan Device, Invalid raw message, PGN: %d, Length: %d"), messages[i].pgn, messages[i].length);
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_TRANSMIT_FAILURE);
+		}
+		// Out of range values would spill into the flag bits of the CAN id (eg. SocketCAN's error & RTR flags)
+		if ((messages[i].priority > 7) || (messages[i].pgn > 0x1FFFF)) {
+			wxLogError(_T("TwoCan Device, Invalid raw message, PGN: %d, Priority: %d"), messages[i].pgn, messages[i].priority);
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_TRANSMIT_FAILURE);
+		}
+	}
+
+	frames.resize(CONST_TRANSMIT_BATCH_FRAMES + CONST_MAX_FAST_PACKET_FRAMES);
+	header.source = networkAddress;
+
+	for (size_t i = 0; i < messageCount; i++) {
+		header.pgn = messages[i].pgn;
+		header.priority = messages[i].priority;
+		header.destination = messages[i].destination;
+
+		if ((messages[i].length > CONST_PAYLOAD_LENGTH) || (TwoCanUtils::IsFastMessage(messages[i].pgn))) {
+			frameCount += TwoCanUtils::FragmentFastMessage(&header, messages[i].length, messages[i].data, &frames[frameCount]);
+		}
+		else {
+			TwoCanUtils::EncodeCanHeader(&frames[frameCount].id, &header);
+			memset(frames[frameCount].data, 0xFF, CONST_PAYLOAD_LENGTH);
+			memcpy(frames[frameCount].data, messages[i].data, messages[i].length);
+			frameCount++;
+		}
+
+		// Queue the batch once full, or at the end. If the queue is full the caller may retry the remaining messages later
+		if ((frameCount >= CONST_TRANSMIT_BATCH_FRAMES) || (i == messageCount - 1)) {
+			returnCode = TransmitFrames(frames.data(), frameCount);
+			if (returnCode != TWOCAN_RESULT_SUCCESS) {
+				return returnCode;
+			}
+			*messagesQueued = i + 1;
+			frameCount = 0;
+		}
+	}
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Write frames to the CAN adapter
+int TwoCanDevice::WriteAdapterFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten) {
+	int returnCode = TWOCAN_RESULT_SUCCESS;
 	const std::lock_guard<std::mutex> lock(writeMutex);
+	*framesWritten = 0;
 
 #if defined (__WXMSW__)
 	if (writeFrame != NULL) {
-		returnCode = writeFrame(id, CONST_PAYLOAD_LENGTH, &data[0]);
+		for (size_t i = 0; i < frameCount; i++) {
+			returnCode = writeFrame(frames[i].id, CONST_PAYLOAD_LENGTH, frames[i].data);
+			if (returnCode != TWOCAN_RESULT_SUCCESS) {
+				break;
+			}
+			*framesWritten += 1;
+		}
 	}
 	else {
 		returnCode = SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_INVALID_WRITE_FUNCTION);
@@ -5993,106 +2279,76 @@ int TwoCanDevice::TransmitFrame(unsigned int id, byte *data) {
 #endif
 	
 #if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
-	returnCode = adapterInterface->Write(id,CONST_PAYLOAD_LENGTH,&data[0]);
+	if (adapterInterface != nullptr) {
+		returnCode = adapterInterface->WriteFrames(frames, frameCount, framesWritten);
+	}
+	else {
+		returnCode = SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_INVALID_WRITE_FUNCTION);
+	}
 #endif
 
+	transmittedFrames += *framesWritten;
+	for (size_t i = 0; i < *framesWritten; i++) {
+		busLoad.Record(frames[i].id, CONST_PAYLOAD_LENGTH);
+	}
+
 	return returnCode;
 
 }
 
 
-// Encode an 8 bit ASCII character using NMEA 0183 6 bit encoding
-char TwoCanDevice::AISEncodeCharacter(char value)  {
-		char result = value < 40 ? value + 48 : value + 56;
-		return result;
+// Estimated network utilisation
+double TwoCanDevice::GetBusLoad(const int window) {
+	return busLoad.GetLoad(window);
 }
 
-// Decode a NMEA 0183 6 bit encoded character to an 8 bit ASCII character
-char TwoCanDevice::AISDecodeCharacter(char value) {
-	char result = value - 48;
-	result = result > 40 ? result - 8 : result;
-	return result;
+void TwoCanDevice::GetBusLoadStatistics(BusLoadStatistics *statistics, const int window) {
+	busLoad.GetStatistics(statistics, window);
 }
 
-// Create the NMEA 0183 AIS VDM/VDO payload from the 6 bit encoded binary data
-wxString TwoCanDevice::AISEncodePayload(std::vector<bool>& binaryData) {
-	wxString result;
-	int j = 6;
-	char temp = 0;
-	// BUG BUG should probably use std::vector<bool>::size_type
-	for (std::vector<bool>::size_type i = 0; i < binaryData.size(); i++) {
-		temp += (binaryData[i] << (j - 1));
-		j--;
-		if (j == 0) { // "gnaw" through each 6 bits
-			result.append(AISEncodeCharacter(temp));
-			temp = 0;
-			j = 6;
-		}
-	}
-	return result;
-}
-
-// Decode the NMEA 0183 ASCII values, derived from 6 bit encoded data to an array of bits
-// so that we can gnaw through the bits to retrieve each AIS data field 
-std::vector<bool> TwoCanDevice::AISDecodePayload(wxString SixBitData) {
-	std::vector<bool> decodedData(168);
-	for (wxString::size_type i = 0; i < SixBitData.length(); i++) {
-		char testByte = AISDecodeCharacter((char)SixBitData[i]);
-		// Perform in reverse order so that we store in LSB order
-		for (int j = 5; j >= 0; j--) {
-			// BUG BUG generates compiler warning, could use ....!=0 but could be confusing ??
-			decodedData.push_back((testByte & (1 << j))); // sets each bit value in the array
-		}
+// Write the flight recorder's recent traffic to disk
+void TwoCanDevice::TriggerRecorder(const wxString& reason) {
+	if (flightRecorder != nullptr) {
+		flightRecorder->Trigger(reason);
 	}
-	return decodedData;
 }
 
-// Assemble AIS VDM message, fragmenting if necessary
-	std::vector<wxString> TwoCanDevice::AssembleAISMessage(std::vector<bool> binaryData, const int messageType) {
-	std::vector<wxString> result;
-	result.push_back(wxString::Format("!AIVDM,1,1,,B,%s,0", AISEncodePayload(binaryData)));
-	return result;
+// As OpenCPN does not support the MOB sentence, just drop a waypoint
+void TwoCanDevice::OnManOverboard(const wxString& markName, const double latitude, const double longitude) {
+	PlugIn_Waypoint waypoint;
+	waypoint.m_IsVisible = true;
+	waypoint.m_MarkName = markName;
+	waypoint.m_IconName = _T("Mob");
+	waypoint.m_GUID = GetNewGUID();
+	waypoint.m_lat = latitude;
+	waypoint.m_lon = longitude;
+	AddSingleWaypoint(&waypoint, true);
 }
 
-// Insert an integer value into AIS binary data, prior to AIS encoding
-void TwoCanDevice::AISInsertInteger(std::vector<bool>& binaryData, int start, int length, int value) {
-	for (int i = 0; i < length; i++) {
-		// set the bit values, storing as MSB
-		binaryData[start + length - i - 1] = (value & (1 << i));
+// Insert the waypoint directly into OpenCPN as it does not parse WPL sentences.
+// we don't retrieve waypoints to compare, so no way to avoid duplication......
+void TwoCanDevice::OnWaypointReceived(const wxString& waypointName, const double latitude, const double longitude) {
+	if (enableWaypoint) {
+		PlugIn_Waypoint waypoint;
+		waypoint.m_IsVisible = true;
+		waypoint.m_MarkName = waypointName;
+		// BUG BUG Should have a UI thingy to specify the default symbol
+		waypoint.m_IconName = "Symbol_Triangle";
+		waypoint.m_GUID = GetNewGUID();
+		waypoint.m_lat = latitude;
+		waypoint.m_lon = longitude;
+		AddSingleWaypoint(&waypoint, true);
 	}
-	return;
-}
-
-// Insert a date value, DDMMhhmm into AIS binary data, prior to AIS encoding
-void TwoCanDevice::AISInsertDate(std::vector<bool>& binaryData, int start, int length, int day, int month, int hour, int minute) {
-	AISInsertInteger(binaryData, start, 4, day);
-	AISInsertInteger(binaryData, start + 4, 5, month);
-	AISInsertInteger(binaryData, start + 9, 5, hour);
-	AISInsertInteger(binaryData, start + 14, 6, minute);
-	return;
 }
 
-// Insert a string value into AIS binary data, prior to AIS encoding
-void TwoCanDevice::AISInsertString(std::vector<bool> &binaryData, int start, int length, std::string value) {
-
-	// Should check that value.length is a multiple of 6 (6 bit ASCII encoded characters) and
-	// that value.length * 6 is less than length.
-
-	// convert to uppercase;
-	std::transform(value.begin(), value.end(), value.begin(), ::toupper);
-
-	// pad string with @ 
-	// BUG BUG Not sure if this is correct. 
-	value.append((length / 6) - value.length(), '@');
-
-	// Encode each ASCII character to 6 bit ASCII according to ITU-R M.1371-4
-	// BUG BUG Is this faster or slower than using a lookup table ??
-	std::bitset<6> bitValue;
-	for (int i = 0; i < static_cast<int>(value.length()); i++) {
-		bitValue = value[i] >= 64 ? value[i] - 64 : value[i];
-		for (int j = 0, k = 5; j < 6; j++, k--) {
-			// set the bit values, storing as MSB
-			binaryData.at((i * 6) + start + k) = bitValue.test(j);
-		}
+void TwoCanDevice::OnRouteReceived(const wxString& routeName) {
+	if (enableWaypoint == TRUE) {
+		PlugIn_Route route;
+		route.m_NameString = routeName;
+		route.m_GUID = GetNewGUID();
+		// What to do with
+		// route.m_StartString;
+		// route.m_EndString;
+		AddPlugInRoute(&route, true);
 	}
 }
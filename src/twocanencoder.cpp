@@ -28,6 +28,16 @@
 // 1.1 - 04/07/2021 Add AIS conversion
 // 1.2 - 20/05/2022 Add DSC & MOB conversion, Fix incorrect GGA PGN (caused random depth values), Fix APB flags
 //       Use NMEA 0183 v4.11 XDR standard transducer names
+// 1.3 - 02/09/2022 Fast message sequence identifiers shared with the device, per PGN & destination
+// 1.4 - 05/09/2022 Messages are encoded directly into a frame arena supplied by the caller
+// 1.5 - 08/09/2022 Sentences dispatched by a packed integer key
+// 1.6 - 10/09/2022 Encoded by the gateway's thread, DSE timeout is a deadline checked by that thread rather than a wxTimer
+// 1.7 - 14/09/2022 Coalesce PGN's that are generated by several sentences (eg. GGA, GLL & RMC), latest value sent once per window
+// 1.8 - 16/09/2022 Payloads built in a fixed capacity buffer rather than a vector, typed little endian writers
+// 1.9 - 18/09/2022 Routes & waypoints exported directly to PGN 129285 & 130074, many waypoints per message
+// 1.10 - 20/09/2022 DSC messages awaiting DSE sentences held per MMSI number, expired by a timing wheel
+// 1.11 - 22/09/2022 Table of encodable sentences for the gateway's front end
+// 1.12 - 24/09/2022 Sentences dispatched to a handler per sentence through a table shared with the front end
 
 #include "twocanencoder.h"
 
@@ -35,21 +45,31 @@
 TwoCanEncoder::TwoCanEncoder(wxEvtHandler *handler) {
 	eventHandlerAddress = handler;
 	aisDecoder = new TwoCanAis();
-	dseTimer = new wxTimer();
-	dseTimer->Bind(wxEVT_TIMER, &TwoCanEncoder::OnDseTimerExpired, this);
+
+	// No DSC messages are awaiting DSE sentences
+	for (int i = 0; i < CONST_DSC_PENDING_ENTRIES; i++) {
+		pendingDscMessages[i].mmsiNumber = 0;
+		pendingDscMessages[i].deadline = 0;
+		pendingDscMessages[i].nextEntry = -1;
+	}
+	for (int i = 0; i < CONST_DSC_WHEEL_SLOTS; i++) {
+		dscWheel[i] = -1;
+	}
+	dscWheelTick = TwoCanUtils::GetTimeInMicroseconds() / CONST_DSC_WHEEL_TICK;
+
+	// PGN's that more than one sentence converts to, GGA, GLL & RMC (129025), RMC & VTG (129026), ZDA, RMC & BWC (129033, 126992)
+	coalesceWindow = (unsigned long long)gatewayCoalesceWindow * 1000;
+	coalescedMessagesCount = 0;
+	for (auto pgn : { 126992, 129025, 129026, 129033 }) {
+		coalescedMessages[pgn].deadline = 0;
+		coalescedMessages[pgn].isPending = FALSE;
+	}
 }
 
 TwoCanEncoder::~TwoCanEncoder(void) {
 	delete aisDecoder;
 }
 
-void TwoCanEncoder::RaiseEvent(int pgn, std::vector<byte> *data) {
-	wxCommandEvent *event = new wxCommandEvent(wxEVT_SENTENCE_RECEIVED_EVENT, DSE_EXPIRED_EVENT);
-	event->SetString(std::to_string(pgn));
-	event->SetClientData(data);
-	wxQueueEvent(eventHandlerAddress, event);
-}
-
 // Used to validate XDR Transducer Names and retrieve the instance number (as per NMEA 0183 v4.11 XDR standard)
 // Eg. BATTERY#n, ENGINE#n, FUEL#n etc. where n is a digit from 0-9
 int TwoCanEncoder::GetInstanceNumber(wxString transducerName) {
@@ -68,109 +88,256 @@ int TwoCanEncoder::GetInstanceNumber(wxString transducerName) {
     return -1;
 }
 
-// Timer for processing DSE sentences
-void TwoCanEncoder::OnDseTimerExpired(wxEvent &event) {
-	if (dseMMSINumber != 0) {
-		// we have not received the corresponding sentence within the timeout period, so send an incomplete PGN 129808 message
-		dseMMSINumber = 0;
-		
-		// Fill out the remaining bytes for PGN 129808 
-		dscPayload.push_back(0xFF);
-
-		// Field 22
-		dscPayload.push_back(0x02); // Length of data includes length byte & encoding byte
-		dscPayload.push_back(0x01); // 01 = ASCII
+// Deadlines for processing DSE sentences and sending coalesced messages, checked periodically by the gateway's thread
+bool TwoCanEncoder::EncodeExpiredMessages(std::vector<CanFrame> *canFrames) {
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+	bool isExpired = FALSE;
 
-		// Field 23
-		dscPayload.push_back(0xFF);
+	// Send the latest value of each held message whose window has closed, this opens the next window
+	for (auto& it : coalescedMessages) {
+		if ((it.second.isPending) && (now >= it.second.deadline)) {
+			it.second.isPending = FALSE;
+			it.second.deadline = now + coalesceWindow;
+			AppendFrames(&it.second.header, &it.second.payload, canFrames);
+			isExpired = TRUE;
+		}
+	}
 
-		// Field 24
-		dscPayload.push_back(0x02); // Length of data includes length byte & encoding byte
-		dscPayload.push_back(0x01); // 01 = ASCII
-
-		RaiseEvent(129808, &dscPayload);
+	// Walk the timing wheel from the last tick processed up to the current tick. For any DSC message whose
+	// corresponding DSE sentence has not been received within the timeout period, send an incomplete PGN 129808 message
+	unsigned long long currentTick = now / CONST_DSC_WHEEL_TICK;
+	if (currentTick - dscWheelTick >= CONST_DSC_WHEEL_SLOTS) {
+		// Every slot is visited once, no matter how long since the wheel was last turned
+		dscWheelTick = currentTick - (CONST_DSC_WHEEL_SLOTS - 1);
 	}
-	else {
-		// If MMSI Number equals zero, then we have already received the corresponding DSE sentence,
-		// constructed the remainder of PGN 129808 and transmitted it. The timer should have been stopped in anycase.
+	for (; dscWheelTick <= currentTick; dscWheelTick++) {
+		int entry = dscWheel[dscWheelTick % CONST_DSC_WHEEL_SLOTS];
+		while (entry != -1) {
+			int nextEntry = pendingDscMessages[entry].nextEntry;
+			if (pendingDscMessages[entry].deadline <= now) {
+				// Fill out the remaining bytes for PGN 129808 
+				PutEmptyDseFields(&pendingDscMessages[entry].payload);
+
+				CanHeader header;
+				header.source = networkAddress;
+				header.destination = CONST_GLOBAL_ADDRESS;
+				header.priority = CONST_PRIORITY_MEDIUM;
+				header.pgn = 129808;
+				AppendFrames(&header, &pendingDscMessages[entry].payload, canFrames);
+				ReleasePendingDsc(entry);
+				isExpired = TRUE;
+			}
+			entry = nextEntry;
+		}
 	}
+	// The current slot may still hold messages that are not yet due
+	dscWheelTick = currentTick;
 
+	// Otherwise either no DSE sentences are awaited, or we have already received them,
+	// constructed the remainder of PGN 129808 and transmitted it.
+	return isExpired;
 }
 
-// BUG BUG Duplicated code from twocandevice.cpp. Should refactor & deduplicate
-void TwoCanEncoder::FragmentFastMessage(CanHeader *header, std::vector<byte> *payload, std::vector<CanMessage> *canMessages) {
-	size_t payloadLength = payload->size();
-	std::vector<byte> data;
-	CanMessage message;
-	message.header = *header;
-
-	// Fragment a fast message into a sequence of singleframe messages
-	if (payloadLength > 8) {
-	
-		// The first frame
-		// BUG BUG should maintain a map of sequential ID's for each PGN
-		byte sid = 0;
-		data.push_back(sid);
-		data.push_back(payloadLength);
-		for (std::vector<byte>::iterator it = payload->begin(); it != payload->begin() +6; ++it) {
-    		data.push_back(*it);
+// Index of the DSC message awaiting a DSE sentence from the given MMSI number, -1 if none
+int TwoCanEncoder::FindPendingDsc(const unsigned long long mmsiNumber) {
+	for (int i = 0; i < CONST_DSC_PENDING_ENTRIES; i++) {
+		if ((pendingDscMessages[i].deadline != 0) && (pendingDscMessages[i].mmsiNumber == mmsiNumber)) {
+			return i;
 		}
-	
-		message.payload = data;
-		canMessages->push_back(message);
+	}
+	return -1;
+}
 
-		sid += 1;
-	
-		// Intermediate frames
-		int iterations;
-		iterations = (int)((payloadLength - 6) / 7);	
-		for (int i = 0; i < iterations; i++) {
-			data.clear();
+// Insert a DSC message into the slot of the timing wheel for its deadline
+void TwoCanEncoder::ArmPendingDsc(const int entry, const unsigned long long deadline) {
+	int slot = (deadline / CONST_DSC_WHEEL_TICK) % CONST_DSC_WHEEL_SLOTS;
+	pendingDscMessages[entry].deadline = deadline;
+	pendingDscMessages[entry].nextEntry = dscWheel[slot];
+	dscWheel[slot] = entry;
+}
 
-			data.push_back(sid);
+// Remove a DSC message from the timing wheel and return its entry to the pool
+void TwoCanEncoder::ReleasePendingDsc(const int entry) {
+	int *link = &dscWheel[(pendingDscMessages[entry].deadline / CONST_DSC_WHEEL_TICK) % CONST_DSC_WHEEL_SLOTS];
+	while (*link != entry) {
+		link = &pendingDscMessages[*link].nextEntry;
+	}
+	*link = pendingDscMessages[entry].nextEntry;
+	pendingDscMessages[entry].mmsiNumber = 0;
+	pendingDscMessages[entry].deadline = 0;
+	pendingDscMessages[entry].nextEntry = -1;
+}
 
-			for (std::vector<unsigned char>::iterator it = payload->begin() + 6 + (i *7); it != payload->begin() + 13 + (i *7); ++it) {
-        		data.push_back(*it);
-    		}
+// Fields 21 - 24 of PGN 129808, the two DSE expansion pairs with "no data"
+void TwoCanEncoder::PutEmptyDseFields(PayloadWriter *payload) {
+	// Field 21, DSE Expansion Field Symbol
+	payload->push_back(0xFF);
 
-			message.payload = data;
-			canMessages->push_back(message);
-		
-			sid += 1;
+	// Field 22
+	payload->push_back(0x02); // Length of data includes length byte & encoding byte
+	payload->push_back(0x01); // 01 = ASCII
+
+	// Field 23
+	payload->push_back(0xFF);
+
+	// Field 24
+	payload->push_back(0x02); // Length of data includes length byte & encoding byte
+	payload->push_back(0x01); // 01 = ASCII
+}
+
+// Earliest time at which EncodeExpiredMessages has something to send, zero if nothing is pending
+unsigned long long TwoCanEncoder::GetNextDeadline(void) {
+	unsigned long long nextDeadline = 0;
+
+	// The first occupied slot of the timing wheel holds the earliest DSC deadline
+	for (unsigned long long tick = dscWheelTick; (tick < dscWheelTick + CONST_DSC_WHEEL_SLOTS) && (nextDeadline == 0); tick++) {
+		for (int entry = dscWheel[tick % CONST_DSC_WHEEL_SLOTS]; entry != -1; entry = pendingDscMessages[entry].nextEntry) {
+			if ((nextDeadline == 0) || (pendingDscMessages[entry].deadline < nextDeadline)) {
+				nextDeadline = pendingDscMessages[entry].deadline;
+			}
 		}
-	
-		// Any remaining frames ?
-		int remainingBytes;
-		remainingBytes = (payloadLength - 6) % 7;
-		if (remainingBytes > 0) {
-			data.clear();
-
-			data.push_back(sid);
-				
-    		for (std::vector<unsigned char>::iterator it = payload->end() - remainingBytes; it != payload->end(); ++it) {
-        		data.push_back(*it);
-    		}
-
-			// fill any unused bytes with 0xFF
-	    	for (int i = 0; i < (7-remainingBytes); i++) {
-        		data.push_back(0xFF);
-    		}
-	
-			message.payload = data;
-			canMessages->push_back(message);
+	}
+
+	for (auto& it : coalescedMessages) {
+		if ((it.second.isPending) && ((nextDeadline == 0) || (it.second.deadline < nextDeadline))) {
+			nextDeadline = it.second.deadline;
 		}
 	}
+	return nextDeadline;
+}
+
+// Hold messages that several sentences convert to, only the latest is sent when the window closes
+bool TwoCanEncoder::CoalesceMessage(const CanHeader *header, const PayloadWriter *payload) {
+	if (coalesceWindow == 0) {
+		return FALSE;
+	}
+
+	auto it = coalescedMessages.find(header->pgn);
+	if (it == coalescedMessages.end()) {
+		return FALSE;
+	}
+
+	// Leading edge, when no window is open the message is sent immediately and opens one.
+	// A source that sends a single sentence is therefore never delayed
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+	if ((!it->second.isPending) && ((it->second.deadline == 0) || (now >= it->second.deadline))) {
+		it->second.deadline = now + coalesceWindow;
+		return FALSE;
+	}
+
+	// Messages within the window replace any held message with fresher values, the latest is sent when the window closes
+	it->second.header = *header;
+	it->second.payload = *payload;
+	it->second.isPending = TRUE;
+	coalescedMessagesCount++;
+	return TRUE;
+}
+
+// Coalesce or append the frames to the caller's frame arena
+void TwoCanEncoder::FragmentFastMessage(CanHeader *header, PayloadWriter *payload, std::vector<CanFrame> *canFrames) {
+	if (!CoalesceMessage(header, payload)) {
+		AppendFrames(header, payload, canFrames);
+	}
+}
+
+// Append the frames directly to the caller's frame arena, fragmenting fast messages
+void TwoCanEncoder::AppendFrames(CanHeader *header, PayloadWriter *payload, std::vector<CanFrame> *canFrames) {
+	size_t frameCount = canFrames->size();
+
+	if (payload->IsOverflowed()) {
+		wxLogMessage(_T("TwoCan Encoder, PGN %d payload exceeds the maximum fast message length"), header->pgn);
+		return;
+	}
+
+	// Fragment a fast message into a sequence of single frames
+	if (payload->size() > 8) {
+		canFrames->resize(frameCount + CONST_MAX_FAST_PACKET_FRAMES);
+		frameCount += TwoCanUtils::FragmentFastMessage(header, payload->size(), payload->data(), &canFrames->at(frameCount));
+		canFrames->resize(frameCount);
+	}
 	// Not a fast message, just a single frame message
 	else {
-		message.payload = *payload;
-		canMessages->push_back(message);
+		CanFrame frame;
+		TwoCanUtils::EncodeCanHeader(&frame.id, header);
+		memset(frame.data, 0xFF, CONST_PAYLOAD_LENGTH);
+		memcpy(frame.data, payload->data(), payload->size());
+		canFrames->push_back(frame);
 	}
 	
 }
 
-bool TwoCanEncoder::EncodeMessage(wxString sentence, std::vector<CanMessage> *canMessages) {
+// The sentences that EncodeMessage dispatches and that IsEncodable accepts, a sentence without a handler is recognised but
+// not converted. Proprietary and unknown sentences are absent. Adding a sentence here is all that is required for both.
+const SentenceDispatch TwoCanEncoder::sentenceDispatch[] = {
+	{ NMEA0183_KEY('A', 'P', 'B'), &TwoCanEncoder::EncodeSentenceAPB },
+	{ NMEA0183_KEY('B', 'O', 'D'), nullptr }, // BOD Bearing - Origin to Destination, ignored
+	{ NMEA0183_KEY('B', 'W', 'C'), &TwoCanEncoder::EncodeSentenceBWC },
+	{ NMEA0183_KEY('B', 'W', 'R'), &TwoCanEncoder::EncodeSentenceBWR },
+	{ NMEA0183_KEY('B', 'W', 'W'), nullptr }, // BWW Bearing Waypoint to Waypoint, ignored
+	{ NMEA0183_KEY('D', 'B', 'T'), &TwoCanEncoder::EncodeSentenceDBT },
+	{ NMEA0183_KEY('D', 'P', 'T'), &TwoCanEncoder::EncodeSentenceDPT },
+	{ NMEA0183_KEY('D', 'S', 'C'), &TwoCanEncoder::EncodeSentenceDSC },
+	{ NMEA0183_KEY('D', 'S', 'E'), &TwoCanEncoder::EncodeSentenceDSE },
+	{ NMEA0183_KEY('D', 'T', 'M'), nullptr }, // DTM Datum Reference, ignored
+	{ NMEA0183_KEY('G', 'G', 'A'), &TwoCanEncoder::EncodeSentenceGGA },
+	{ NMEA0183_KEY('G', 'L', 'L'), &TwoCanEncoder::EncodeSentenceGLL },
+	{ NMEA0183_KEY('G', 'N', 'S'), &TwoCanEncoder::EncodeSentenceGNS },
+	{ NMEA0183_KEY('G', 'S', 'A'), &TwoCanEncoder::EncodeSentenceGSA },
+	{ NMEA0183_KEY('G', 'S', 'V'), &TwoCanEncoder::EncodeSentenceGSV },
+	{ NMEA0183_KEY('H', 'D', 'G'), &TwoCanEncoder::EncodeSentenceHDG },
+	{ NMEA0183_KEY('H', 'D', 'M'), &TwoCanEncoder::EncodeSentenceHDM },
+	{ NMEA0183_KEY('H', 'D', 'T'), &TwoCanEncoder::EncodeSentenceHDT },
+	{ NMEA0183_KEY('M', 'O', 'B'), &TwoCanEncoder::EncodeSentenceMOB },
+	{ NMEA0183_KEY('M', 'T', 'W'), &TwoCanEncoder::EncodeSentenceMTW },
+	{ NMEA0183_KEY('M', 'W', 'D'), &TwoCanEncoder::EncodeSentenceMWD },
+	{ NMEA0183_KEY('M', 'W', 'V'), &TwoCanEncoder::EncodeSentenceMWV },
+	{ NMEA0183_KEY('R', 'M', 'B'), &TwoCanEncoder::EncodeSentenceRMB },
+	{ NMEA0183_KEY('R', 'M', 'C'), &TwoCanEncoder::EncodeSentenceRMC },
+	{ NMEA0183_KEY('R', 'O', 'T'), &TwoCanEncoder::EncodeSentenceROT },
+	{ NMEA0183_KEY('R', 'P', 'M'), &TwoCanEncoder::EncodeSentenceRPM },
+	{ NMEA0183_KEY('R', 'S', 'A'), &TwoCanEncoder::EncodeSentenceRSA },
+	{ NMEA0183_KEY('R', 'T', 'E'), nullptr }, // RTE Routes, ignored
+	{ NMEA0183_KEY('V', 'B', 'W'), nullptr }, // VBW Dual Ground / Water Speed, ignored
+	{ NMEA0183_KEY('V', 'D', 'M'), &TwoCanEncoder::EncodeSentenceVDM },
+	{ NMEA0183_KEY('V', 'D', 'O'), nullptr }, // VDO AIS VHF Data Link Own Vessel Report, ignored
+	{ NMEA0183_KEY('V', 'D', 'R'), &TwoCanEncoder::EncodeSentenceVDR },
+	{ NMEA0183_KEY('V', 'H', 'W'), &TwoCanEncoder::EncodeSentenceVHW },
+	{ NMEA0183_KEY('V', 'L', 'W'), &TwoCanEncoder::EncodeSentenceVLW },
+	{ NMEA0183_KEY('V', 'T', 'G'), &TwoCanEncoder::EncodeSentenceVTG },
+	{ NMEA0183_KEY('W', 'C', 'V'), nullptr }, // WCV Waypoint Closure Velocity, ignored
+	{ NMEA0183_KEY('W', 'N', 'C'), nullptr }, // WNC Distance Waypoint to Waypoint, ignored
+	{ NMEA0183_KEY('W', 'P', 'L'), &TwoCanEncoder::EncodeSentenceWPL },
+	{ NMEA0183_KEY('X', 'D', 'R'), &TwoCanEncoder::EncodeSentenceXDR },
+	{ NMEA0183_KEY('X', 'T', 'E'), &TwoCanEncoder::EncodeSentenceXTE },
+	{ NMEA0183_KEY('Z', 'D', 'A'), &TwoCanEncoder::EncodeSentenceZDA },
+	{ NMEA0183_KEY('Z', 'T', 'G'), nullptr }, // ZTG UTC & Time to Destination Waypoint, ignored
+};
+
+// Entry in the dispatch table for a sentence key, nullptr if none. Indexed by key (as for the NMEA0183 parser's response index)
+const SentenceDispatch *TwoCanEncoder::FindSentenceDispatch(const int sentenceKey) {
+	static const std::vector<unsigned char> dispatchIndex = []() {
+		std::vector<unsigned char> index(NMEA0183_NUMBER_OF_KEYS, 0);
+		for (size_t i = 0; i < sizeof(sentenceDispatch) / sizeof(sentenceDispatch[0]); i++) {
+			index[sentenceDispatch[i].sentenceKey] = i + 1;
+		}
+		return index;
+	}();
+
+	if ((sentenceKey < 0) || (sentenceKey >= NMEA0183_NUMBER_OF_KEYS) || (dispatchIndex[sentenceKey] == 0)) {
+		return nullptr;
+	}
+	return &sentenceDispatch[dispatchIndex[sentenceKey] - 1];
+}
+
+// Sentences that have a handler in the dispatch table
+bool TwoCanEncoder::IsEncodable(const int sentenceKey) {
+	const SentenceDispatch *dispatch = FindSentenceDispatch(sentenceKey);
+	return ((dispatch != nullptr) && (dispatch->handler != nullptr));
+}
+
+bool TwoCanEncoder::EncodeMessage(wxString sentence, std::vector<CanFrame> *canFrames) {
 	CanHeader header;
-	std::vector<byte> payload;
+	PayloadWriter payload;
 	
 	// Parse the NMEA 183 sentence
 	nmeaParser << sentence;
@@ -178,7 +345,7 @@ bool TwoCanEncoder::EncodeMessage(wxString sentence, std::vector<CanMessage> *ca
 	if (nmeaParser.PreParse()) {
 
 		// BUG BUG Should use a different priority based on the PGN
-		// The actual PGN is initialized later in the switch statement
+		// The actual PGN is initialized later by the sentence handler
 		header.source = networkAddress;
 		header.destination = CONST_GLOBAL_ADDRESS;
 		header.priority = CONST_PRIORITY_MEDIUM;
@@ -192,1333 +359,1229 @@ bool TwoCanEncoder::EncodeMessage(wxString sentence, std::vector<CanMessage> *ca
 			sequenceId = 0;
 		}
 
-		// APB Heading Track Controller(Autopilot) Sentence "B"
-		if (nmeaParser.LastSentenceIDReceived == _T("APB")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_NAV)) {
-					// if (EncodePGN127237(&nmeaParser, &payload)) { // Heading/Track Control
-					//	header.pgn = 127237;
-					//	FragmentFastMessage(&header, &payload, canMessages);
-					// }
-					if (EncodePGN129283(&nmeaParser, &payload)) {
-						header.pgn = 129283;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN129284(&nmeaParser, &payload)) {
-						header.pgn = 129284;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				return TRUE;
-				}
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
-		}
-
-		// BOD Bearing - Origin to Destination
-		else if (nmeaParser.LastSentenceIDReceived == _T("BOD")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_RTE)) {
-				// BUG BUG Not implemented
-				}
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
+		// Dispatch on the sentence key (the three letter mnemonic packed into an integer) through the table shared with IsEncodable
+		const SentenceDispatch *dispatch = FindSentenceDispatch(nmeaParser.LastSentenceKeyReceived);
+		if ((dispatch != nullptr) && (dispatch->handler != nullptr)) {
+			return (this->*(dispatch->handler))(header, payload, canFrames, sentence);
 		}
+	} 
+	else {
+		wxLogMessage(_T("TwoCan Encoder, Error pre-parsing %s"), sentence);
+	}
 
-		// BWC Bearing & Distance to Waypoint Great Circle
-		else if (nmeaParser.LastSentenceIDReceived == _T("BWC")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+	return FALSE;
+}
 
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				if (!(supportedPGN & FLAGS_XTE)) {
-					if (EncodePGN129283(&nmeaParser, &payload)) {
-						header.pgn = 129283;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
+// The following routines convert each type of sentence, they are dispatched through sentenceDispatch
 
-				if (!(supportedPGN & FLAGS_NAV)) {
-					if (EncodePGN129284(&nmeaParser, &payload)) {
-						header.pgn = 129284;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				
-				return TRUE;
+// APB Heading Track Controller(Autopilot) Sentence "B"
+bool TwoCanEncoder::EncodeSentenceAPB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_NAV)) {
+			// if (EncodePGN127237(&nmeaParser, &payload)) { // Heading/Track Control
+			//	header.pgn = 127237;
+			//	FragmentFastMessage(&header, &payload, canFrames);
+			// }
+			if (EncodePGN129283(&nmeaParser, &payload)) {
+				header.pgn = 129283;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
-		}
 
-		// BWR Bearing & Distance to Waypoint Rhumb Line
-		else if (nmeaParser.LastSentenceIDReceived == _T("BWR")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-	
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-	
-				if (!(supportedPGN & FLAGS_XTE)) {
-					if (EncodePGN129283(&nmeaParser, &payload)) {
-						header.pgn = 129283;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-	
-				if (!(supportedPGN & FLAGS_NAV)) {
-					if (EncodePGN129284(&nmeaParser, &payload)) {
-						header.pgn = 129284;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-	
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+			if (EncodePGN129284(&nmeaParser, &payload)) {
+				header.pgn = 129284;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
+		return TRUE;
 		}
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// BWW Bearing Waypoint to Waypoint
-		else if (nmeaParser.LastSentenceIDReceived == _T("BWW")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
+// BWC Bearing & Distance to Waypoint Great Circle
+bool TwoCanEncoder::EncodeSentenceBWC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
 
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+		}
+		if (!(supportedPGN & FLAGS_XTE)) {
+			if (EncodePGN129283(&nmeaParser, &payload)) {
+				header.pgn = 129283;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// DBT Depth below transducer
-		else if (nmeaParser.LastSentenceIDReceived == _T("DBT")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_DPT)) {
-					if (EncodePGN128267(&nmeaParser, &payload)) {
-						header.pgn = 128267;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+		if (!(supportedPGN & FLAGS_NAV)) {
+			if (EncodePGN129284(&nmeaParser, &payload)) {
+				header.pgn = 129284;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+		
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// DPT Depth
-		else if (nmeaParser.LastSentenceIDReceived == _T("DPT")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_DPT)) {
-					if (EncodePGN128267(&nmeaParser, &payload)) {
-						header.pgn = 128267;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// BWR Bearing & Distance to Waypoint Rhumb Line
+bool TwoCanEncoder::EncodeSentenceBWR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// DSC Digital Selective Calling Information
-		else if (nmeaParser.LastSentenceIDReceived == _T("DSC")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_DSC)) {
-					if (EncodePGN129808(&nmeaParser, &payload)) {
-						header.pgn = 129808;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
-		}
-
-		// DSE Expanded Digital Selective Calling
-		else if (nmeaParser.LastSentenceIDReceived == _T("DSE")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_DSC)) {
-					if ((dseTimer->IsRunning()) && (dseMMSINumber == nmeaParser.Dse.mmsiNumber) && (nmeaParser.Dse.sentenceNumber == nmeaParser.Dse.totalSentences)) {
-						// We've received a DSE sentence that matches a preceding DSC sentence and within the time limit
-						// Add the DSE data pairs to the PGN 129808 payload
-						// Not sure if the DSE is limted to two items for NMEA 2000 ?
-						for (size_t i = 0; i < nmeaParser.Dse.codeFields.size(), i < 2; i++) {
-							dscPayload.push_back(nmeaParser.Dse.codeFields.at(i) + 100); // Code byte 
-							dscPayload.push_back(nmeaParser.Dse.dataFields.at(i).size() + 2); // Length byte includes length & control byte
-							dscPayload.push_back(0x01); // Control Byte, 0x01 = ASCII
-							for (auto it : nmeaParser.Dse.dataFields.at(i)) {
-								dscPayload.push_back(it);
-							}
-						}
-						// Reset the MMSI number to indicate that we have processed the accompanying DSE sentence
-						dseMMSINumber = 0;
-						dseTimer->Stop();
-						// Transmit the completed PGN 129808 message
-						header.pgn = 129808;
-						FragmentFastMessage(&header, &dscPayload, canMessages);
-						return TRUE;
-					}
-				}
+		if (!(supportedPGN & FLAGS_XTE)) {
+			if (EncodePGN129283(&nmeaParser, &payload)) {
+				header.pgn = 129283;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
 
-		// DTM Datum Reference
-		else if (nmeaParser.LastSentenceIDReceived == _T("DTM")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
-
+		if (!(supportedPGN & FLAGS_NAV)) {
+			if (EncodePGN129284(&nmeaParser, &payload)) {
+				header.pgn = 129284;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
 
-		// GGA Global Positioning System Fix Data
-		else if (nmeaParser.LastSentenceIDReceived == _T("GGA")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-
-				if (!(supportedPGN & FLAGS_GGA)) {
-					if (EncodePGN129025(&nmeaParser, &payload)) {
-						header.pgn = 129025;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN129029(&nmeaParser, &payload)) {
-						header.pgn = 129029;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-				// EncodePGN129539(&nmeaParser, &payload); GNS DOP
-					
-				return TRUE;
+// DBT Depth below transducer
+bool TwoCanEncoder::EncodeSentenceDBT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_DPT)) {
+			if (EncodePGN128267(&nmeaParser, &payload)) {
+				header.pgn = 128267;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// GLL Geographic Position Latitude / Longitude
-		else if (nmeaParser.LastSentenceIDReceived == _T("GLL")) {
-			if (nmeaParser.Parse()) {
-				// Date & Time
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				// Position
-				if (!(supportedPGN & FLAGS_GLL)) {
-					if (EncodePGN129025(&nmeaParser, &payload)) {
-						header.pgn = 129025;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN129029(&nmeaParser, &payload)) {
-						header.pgn = 129029;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// DPT Depth
+bool TwoCanEncoder::EncodeSentenceDPT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_DPT)) {
+			if (EncodePGN128267(&nmeaParser, &payload)) {
+				header.pgn = 128267;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// GNS GNSS Fix Data
-		else if (nmeaParser.LastSentenceIDReceived == _T("GNS")) {
-			if (nmeaParser.Parse()) {
-				// Date and Time
-				if (!(supportedPGN & FLAGS_ZDA)) {
-				
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-
-				// Position
-				if (!(supportedPGN & FLAGS_GGA)) {
-					
-					if (EncodePGN129025(&nmeaParser, &payload)) {
-						header.pgn = 129025;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+// DSC Digital Selective Calling Information
+bool TwoCanEncoder::EncodeSentenceDSC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_DSC)) {
+			if (EncodePGN129808(&nmeaParser, &payload)) {
+				header.pgn = 129808;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-					if (EncodePGN129029(&nmeaParser, &payload)) {
-						header.pgn = 129029;
-						FragmentFastMessage(&header, &payload, canMessages);
+// DSE Expanded Digital Selective Calling
+bool TwoCanEncoder::EncodeSentenceDSE(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_DSC)) {
+			int entry = FindPendingDsc(nmeaParser.Dse.mmsiNumber);
+			if ((entry != -1) && (nmeaParser.Dse.sentenceNumber == nmeaParser.Dse.totalSentences)) {
+				// We've received a DSE sentence that matches a preceding DSC sentence and within the time limit
+				// Add the DSE data pairs to the PGN 129808 payload
+				// Not sure if the DSE is limted to two items for NMEA 2000 ?
+				PayloadWriter *dscPayload = &pendingDscMessages[entry].payload;
+				for (size_t i = 0; (i < nmeaParser.Dse.codeFields.size()) && (i < 2); i++) {
+					dscPayload->push_back(nmeaParser.Dse.codeFields.at(i) + 100); // Code byte 
+					dscPayload->push_back(nmeaParser.Dse.dataFields.at(i).size() + 2); // Length byte includes length & control byte
+					dscPayload->push_back(0x01); // Control Byte, 0x01 = ASCII
+					for (auto it : nmeaParser.Dse.dataFields.at(i)) {
+						dscPayload->push_back(it);
 					}
 				}
-
+				// Transmit the completed PGN 129808 message
+				header.pgn = 129808;
+				FragmentFastMessage(&header, dscPayload, canFrames);
+				// Release the entry to indicate that we have processed the accompanying DSE sentence
+				ReleasePendingDsc(entry);
 				return TRUE;
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// GSA GNSS DOP and Active Satellites
-		else if (nmeaParser.LastSentenceIDReceived == _T("GSA")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_GGA)) {
-					if (EncodePGN129029(&nmeaParser, &payload)) {
-						header.pgn = 129029;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-					
-					//if (EncodePGN129539(&nmeaParser, &payload)) {
-					//	header.pgn = 129539;
-					//	FragmentFastMessage(&header, &payload, canMessages);
-					//}
-				}
-				return TRUE;
+// GGA Global Positioning System Fix Data
+bool TwoCanEncoder::EncodeSentenceGGA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// GSV GNSS Satellites In View
-		else if (nmeaParser.LastSentenceIDReceived == _T("GSV")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_GGA)) {
-					if (EncodePGN129540(&nmeaParser, &payload)) {
-						header.pgn = 129540;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+		if (!(supportedPGN & FLAGS_GGA)) {
+			if (EncodePGN129025(&nmeaParser, &payload)) {
+				header.pgn = 129025;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129029(&nmeaParser, &payload)) {
+				header.pgn = 129029;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// HDG Heading, Deviation & Variation
-		else if (nmeaParser.LastSentenceIDReceived == _T("HDG")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_HDG)) {
-					if (EncodePGN127250(&nmeaParser, &payload)) {
-						header.pgn = 127250;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				
-					if (EncodePGN127258(&nmeaParser, &payload)) {
-						header.pgn = 127258;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+		// EncodePGN129539(&nmeaParser, &payload); GNS DOP
+			
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-					if (EncodePGN130577(&nmeaParser, &payload)) {
-						header.pgn = 130577;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-					
-				return TRUE;
+// GLL Geographic Position Latitude / Longitude
+bool TwoCanEncoder::EncodeSentenceGLL(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		// Date & Time
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		// Position
+		if (!(supportedPGN & FLAGS_GLL)) {
+			if (EncodePGN129025(&nmeaParser, &payload)) {
+				header.pgn = 129025;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
 
-		// HDM Heading, Magnetic
-		else if (nmeaParser.LastSentenceIDReceived == _T("HDM")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_HDG)) {
-				
-					if (EncodePGN127250(&nmeaParser, &payload)) {
-						header.pgn = 127250;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+			if (EncodePGN129029(&nmeaParser, &payload)) {
+				header.pgn = 129029;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-					if (EncodePGN130577(&nmeaParser, &payload)) {
-						header.pgn = 130577;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// GNS GNSS Fix Data
+bool TwoCanEncoder::EncodeSentenceGNS(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		// Date and Time
+		if (!(supportedPGN & FLAGS_ZDA)) {
+		
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// HDT Heading, True
-		else if (nmeaParser.LastSentenceIDReceived == _T("HDT")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_HDG)) {
+		// Position
+		if (!(supportedPGN & FLAGS_GGA)) {
 			
-					if (EncodePGN127250(&nmeaParser, &payload)) {
-						header.pgn = 127250;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				
-					if (EncodePGN130577(&nmeaParser, &payload)) {
-						header.pgn = 130577;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+			if (EncodePGN129025(&nmeaParser, &payload)) {
+				header.pgn = 129025;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129029(&nmeaParser, &payload)) {
+				header.pgn = 129029;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// MOB Man Overboard
-		else if (nmeaParser.LastSentenceIDReceived == _T("MOB")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_MOB)) {
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-					if (EncodePGN127233(&nmeaParser, &payload)) {
-						header.pgn = 127233;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// GSA GNSS DOP and Active Satellites
+bool TwoCanEncoder::EncodeSentenceGSA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_GGA)) {
+			if (EncodePGN129029(&nmeaParser, &payload)) {
+				header.pgn = 129029;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
+			
+			//if (EncodePGN129539(&nmeaParser, &payload)) {
+			//	header.pgn = 129539;
+			//	FragmentFastMessage(&header, &payload, canFrames);
+			//}
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// MTW Water Temperature
-		else if (nmeaParser.LastSentenceIDReceived == _T("MTW")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_MTW)) {
-	
-					if (EncodePGN130310(&nmeaParser, &payload)) {
-						header.pgn = 130310;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN130311(&nmeaParser, &payload)) {
-						header.pgn = 130311;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+// GSV GNSS Satellites In View
+bool TwoCanEncoder::EncodeSentenceGSV(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_GGA)) {
+			if (EncodePGN129540(&nmeaParser, &payload)) {
+				header.pgn = 129540;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// MWD Wind Direction & Speed
-		else if (nmeaParser.LastSentenceIDReceived == _T("MWD")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_MWV)) {
-				
-					if (EncodePGN130306(&nmeaParser, &payload)) {
-						header.pgn = 130306;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// HDG Heading, Deviation & Variation
+bool TwoCanEncoder::EncodeSentenceHDG(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_HDG)) {
+			if (EncodePGN127250(&nmeaParser, &payload)) {
+				header.pgn = 127250;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+		
+			if (EncodePGN127258(&nmeaParser, &payload)) {
+				header.pgn = 127258;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+
+			if (EncodePGN130577(&nmeaParser, &payload)) {
+				header.pgn = 130577;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+			
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// MWV Wind Speed & Angle
-		else if (nmeaParser.LastSentenceIDReceived == _T("MWV")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_MWV)) {
+// HDM Heading, Magnetic
+bool TwoCanEncoder::EncodeSentenceHDM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_HDG)) {
 		
-					if (EncodePGN130306(&nmeaParser, &payload)) {
-						header.pgn = 130306;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+			if (EncodePGN127250(&nmeaParser, &payload)) {
+				header.pgn = 127250;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN130577(&nmeaParser, &payload)) {
+				header.pgn = 130577;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// RMB Recommended Minimum Navigation Information
-		else if (nmeaParser.LastSentenceIDReceived == _T("RMB")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_XTE)) {
-					if (EncodePGN129283(&nmeaParser, &payload)) {
-						header.pgn = 129283;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-
-				if (!(supportedPGN & FLAGS_NAV)) {
-					if (EncodePGN129284(&nmeaParser, &payload)) {
-						header.pgn = 129284;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// HDT Heading, True
+bool TwoCanEncoder::EncodeSentenceHDT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_HDG)) {
+	
+			if (EncodePGN127250(&nmeaParser, &payload)) {
+				header.pgn = 127250;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+		
+			if (EncodePGN130577(&nmeaParser, &payload)) {
+				header.pgn = 130577;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// RMC Recommended Minimum Specific GNSS Data
-		else if (nmeaParser.LastSentenceIDReceived == _T("RMC")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+// MOB Man Overboard
+bool TwoCanEncoder::EncodeSentenceMOB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_MOB)) {
 
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
+			if (EncodePGN127233(&nmeaParser, &payload)) {
+				header.pgn = 127233;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-				//if (EncodePGN127250(&nmeaParser, &payload)) {
-				//	header.pgn = 127250;
-				//	FragmentFastMessage(&header, &payload, canMessages);
-				//}
+// MTW Water Temperature
+bool TwoCanEncoder::EncodeSentenceMTW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_MTW)) {
 
-				//if (EncodePGN127258(&nmeaParser, &payload)) {
-				//	header.pgn = 127258;
-				//	FragmentFastMessage(&header, &payload, canMessages);
-				//}
+			if (EncodePGN130310(&nmeaParser, &payload)) {
+				header.pgn = 130310;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
 
-				if (!(supportedPGN & FLAGS_GGA)) {
-					if (EncodePGN129025(&nmeaParser, &payload)) {
-						header.pgn = 129025;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				
-				if (!(supportedPGN & FLAGS_VTG)) {
-					if (EncodePGN129026(&nmeaParser, &payload)) {
-						header.pgn = 129026;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
+			if (EncodePGN130311(&nmeaParser, &payload)) {
+				header.pgn = 130311;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-				//if (EncodePGN129029(&nmeaParser, &payload)) {
-				//	header.pgn = 129029;
-				//	FragmentFastMessage(&header, &payload, canMessages);
-				//}
+// MWD Wind Direction & Speed
+bool TwoCanEncoder::EncodeSentenceMWD(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_MWV)) {
+		
+			if (EncodePGN130306(&nmeaParser, &payload)) {
+				header.pgn = 130306;
+				FragmentFastMessage(&header, &payload, canFrames);
+			}
+		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
+// MWV Wind Speed & Angle
+bool TwoCanEncoder::EncodeSentenceMWV(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_MWV)) {
 
-				//if (EncodePGN130577(&nmeaParser, &payload)) {
-				//	header.pgn = 130577;
-				//	FragmentFastMessage(&header, &payload, canMessages);
-				//}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+			if (EncodePGN130306(&nmeaParser, &payload)) {
+				header.pgn = 130306;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// ROT Rate Of Turn
-		else if (nmeaParser.LastSentenceIDReceived == _T("ROT")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ROT)) {
-					if (EncodePGN127251(&nmeaParser, &payload)) {
-						header.pgn = 127251;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// RMB Recommended Minimum Navigation Information
+bool TwoCanEncoder::EncodeSentenceRMB(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_XTE)) {
+			if (EncodePGN129283(&nmeaParser, &payload)) {
+				header.pgn = 129283;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
 
-		// RPM Revolutions
-		else if (nmeaParser.LastSentenceIDReceived == _T("RPM")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ENG)) {
-					if (EncodePGN127488(&nmeaParser, &payload)) {
-						header.pgn = 127488;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+		if (!(supportedPGN & FLAGS_NAV)) {
+			if (EncodePGN129284(&nmeaParser, &payload)) {
+				header.pgn = 129284;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// RSA Rudder Sensor Angle
-		else if (nmeaParser.LastSentenceIDReceived == _T("RSA")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_RSA)) {
-			
-					if (EncodePGN127245(&nmeaParser, &payload)) {
-						header.pgn = 127245;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// RMC Recommended Minimum Specific GNSS Data
+bool TwoCanEncoder::EncodeSentenceRMC(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// RTE Routes RTE Routes
-		else if (nmeaParser.LastSentenceIDReceived == _T("RTE")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_RTE)) {
-				// IGNORE
+		//if (EncodePGN127250(&nmeaParser, &payload)) {
+		//	header.pgn = 127250;
+		//	FragmentFastMessage(&header, &payload, canFrames);
+		//}
 
-				}
+		//if (EncodePGN127258(&nmeaParser, &payload)) {
+		//	header.pgn = 127258;
+		//	FragmentFastMessage(&header, &payload, canFrames);
+		//}
+
+		if (!(supportedPGN & FLAGS_GGA)) {
+			if (EncodePGN129025(&nmeaParser, &payload)) {
+				header.pgn = 129025;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+		}
+		
+		if (!(supportedPGN & FLAGS_VTG)) {
+			if (EncodePGN129026(&nmeaParser, &payload)) {
+				header.pgn = 129026;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
 
-		// VBW Dual Ground / Water Speed
-		else if (nmeaParser.LastSentenceIDReceived == _T("VBW")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
+		//if (EncodePGN129029(&nmeaParser, &payload)) {
+		//	header.pgn = 129029;
+		//	FragmentFastMessage(&header, &payload, canFrames);
+		//}
 
+
+		//if (EncodePGN130577(&nmeaParser, &payload)) {
+		//	header.pgn = 130577;
+		//	FragmentFastMessage(&header, &payload, canFrames);
+		//}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
+
+// ROT Rate Of Turn
+bool TwoCanEncoder::EncodeSentenceROT(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ROT)) {
+			if (EncodePGN127251(&nmeaParser, &payload)) {
+				header.pgn = 127251;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// VDM AIS VHF Data Link Message
-		else if (nmeaParser.LastSentenceIDReceived == _T("VDM")) {
-			if (!(supportedPGN & FLAGS_AIS)) {
-				if (nmeaParser.Parse()) {
-					if (aisDecoder->ParseAisMessage(nmeaParser.Vdm, &payload, &header.pgn)) {
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-					return TRUE;
-				}
-				else {
-					wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-				}
+// RPM Revolutions
+bool TwoCanEncoder::EncodeSentenceRPM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ENG)) {
+			if (EncodePGN127488(&nmeaParser, &payload)) {
+				header.pgn = 127488;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// VDO AIS VHF Data Link Own Vessel Report
-		else if (nmeaParser.LastSentenceIDReceived == _T("VDO")) {
-			if (!(supportedPGN & FLAGS_AIS)) {
-				if (nmeaParser.Parse()) {
-					// IGNORE
-
-				}
-				else {
-					wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-				}
+// RSA Rudder Sensor Angle
+bool TwoCanEncoder::EncodeSentenceRSA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_RSA)) {
+	
+			if (EncodePGN127245(&nmeaParser, &payload)) {
+				header.pgn = 127245;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// VDR Set & Drift
-		else if (nmeaParser.LastSentenceIDReceived == _T("VDR")) {
-			if (nmeaParser.Parse()) {
-				// BUG BUG What Flags ??
-				if (EncodePGN130577(&nmeaParser, &payload)) {
-					header.pgn = 130577;
-					FragmentFastMessage(&header, &payload, canMessages);
-				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+// VDM AIS VHF Data Link Message
+bool TwoCanEncoder::EncodeSentenceVDM(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (!(supportedPGN & FLAGS_AIS)) {
+		if (nmeaParser.Parse()) {
+			if (aisDecoder->ParseAisMessage(nmeaParser.Vdm, &payload, &header.pgn)) {
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
+			return TRUE;
+		}
+		else {
+			wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
 		}
+	}
+	return FALSE;
+}
 
-		// VHW Water Speed and Heading
-		else if (nmeaParser.LastSentenceIDReceived == _T("VHW")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_VHW)) {
-					if (EncodePGN128259(&nmeaParser, &payload) == TRUE) {
-						header.pgn = 128259;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				if (!(supportedPGN & FLAGS_HDG)) {
-					if (EncodePGN127250(&nmeaParser, &payload) == TRUE) {
-						header.pgn = 127250;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
+// VDR Set & Drift
+bool TwoCanEncoder::EncodeSentenceVDR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		// BUG BUG What Flags ??
+		if (EncodePGN130577(&nmeaParser, &payload)) {
+			header.pgn = 130577;
+			FragmentFastMessage(&header, &payload, canFrames);
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// VLW Dual Ground / Water Distance
-		else if (nmeaParser.LastSentenceIDReceived == _T("VLW")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_VHW)) {
-					if (EncodePGN128275(&nmeaParser, &payload)) {
-						header.pgn = 128275;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;
+// VHW Water Speed and Heading
+bool TwoCanEncoder::EncodeSentenceVHW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_VHW)) {
+			if (EncodePGN128259(&nmeaParser, &payload) == TRUE) {
+				header.pgn = 128259;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+		}
+		if (!(supportedPGN & FLAGS_HDG)) {
+			if (EncodePGN127250(&nmeaParser, &payload) == TRUE) {
+				header.pgn = 127250;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// VTG Course Over Ground & Ground Speed
-		else if (nmeaParser.LastSentenceIDReceived == _T("VTG")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_VTG)) {
-					if (EncodePGN129026(&nmeaParser, &payload)) {
-						header.pgn = 129026;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-
-					if (EncodePGN130577(&nmeaParser, &payload)) {
-						header.pgn = 130577;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-				}
-				return TRUE;				
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+// VLW Dual Ground / Water Distance
+bool TwoCanEncoder::EncodeSentenceVLW(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_VHW)) {
+			if (EncodePGN128275(&nmeaParser, &payload)) {
+				header.pgn = 128275;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// WCV Waypoint Closure Velocity
-		else if (nmeaParser.LastSentenceIDReceived == _T("WCV")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
-
+// VTG Course Over Ground & Ground Speed
+bool TwoCanEncoder::EncodeSentenceVTG(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_VTG)) {
+			if (EncodePGN129026(&nmeaParser, &payload)) {
+				header.pgn = 129026;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN130577(&nmeaParser, &payload)) {
+				header.pgn = 130577;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;				
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// WNC Distance Waypoint to Waypoint
-		else if (nmeaParser.LastSentenceIDReceived == _T("WNC")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
-
+// WPL Waypoint Location
+bool TwoCanEncoder::EncodeSentenceWPL(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if ((!(supportedPGN & FLAGS_RTE)) || (enableWaypoint == TRUE)) {
+			if (EncodePGN130074(&nmeaParser, &payload)) {
+				header.pgn = 130074;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
+
 		}
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// WPL Waypoint Location
-		else if (nmeaParser.LastSentenceIDReceived == _T("WPL")) {
-			if (nmeaParser.Parse()) {
-				if ((!(supportedPGN & FLAGS_RTE)) || (enableWaypoint == TRUE)) {
-					if (EncodePGN130074(&nmeaParser, &payload)) {
-						header.pgn = 130074;
-						FragmentFastMessage(&header, &payload, canMessages);
+// XDR Transducer Measurements
+// A big ugly mess
+bool TwoCanEncoder::EncodeSentenceXDR(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		// Each XDR sentence may have up to four measurement values
+		for (int i = 0; i < nmeaParser.Xdr.TransducerCnt; i++) {
+			payload.clear();
+			// "A" Angular Displacement in "D" Degrees
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("A")) {
+				if (!(supportedPGN & FLAGS_XDR)) {
+					short yaw = SHRT_MAX;
+					short pitch = SHRT_MAX;
+					short roll = SHRT_MAX;
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("D")) {
+						if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("PITCH"))  {
+							pitch = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);
+						}
+						else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("YAW")) {
+							yaw = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);
+						}
+						else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("ROLL")) {
+							roll = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);	
+						}
+						else {
+							// Not a transducer measurement we are interested in
+							break;
+						}
+						if (EncodePGN127257(yaw, pitch, roll, &payload)) {
+							header.pgn = 127257;
+							FragmentFastMessage(&header, &payload, canFrames);
+						}
+					
 					}
-
 				}
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
-		}
-
-		// XDR Transducer Measurements
-		// A big ugly mess
-		else if (nmeaParser.LastSentenceIDReceived == _T("XDR")) {
-			if (nmeaParser.Parse()) {
-				// Each XDR sentence may have up to four measurement values
-				for (int i = 0; i < nmeaParser.Xdr.TransducerCnt; i++) {
-					payload.clear();
-					// "A" Angular Displacement in "D" Degrees
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("A")) {
-						if (!(supportedPGN & FLAGS_XDR)) {
-							short yaw = SHRT_MAX;
-							short pitch = SHRT_MAX;
-							short roll = SHRT_MAX;
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("D")) {
-								if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("PITCH"))  {
-									pitch = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);
-								}
-								else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("YAW")) {
-									yaw = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);
-								}
-								else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName == _T("ROLL")) {
-									roll = 10000 * DEGREES_TO_RADIANS(nmeaParser.Xdr.TransducerInfo[i].MeasurementData);	
-								}
-								else {
-									// Not a transducer measurement we are interested in
-									break;
-								}
-								if (EncodePGN127257(yaw, pitch, roll, &payload)) {
-									header.pgn = 127257;
-									FragmentFastMessage(&header, &payload, canMessages);
-								}
-							
-							}
-						}
-					}
 
 
-					// "C" Temperature in "C" degrees Celsius
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("C")) {
-						if (!(supportedPGN & FLAGS_ENG)) {
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("C")) {
+			// "C" Temperature in "C" degrees Celsius
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("C")) {
+				if (!(supportedPGN & FLAGS_ENG)) {
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("C")) {
 
-								int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-								wxString remainingString;
+						int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+						wxString remainingString;
 
-								if (engineInstance != -1) {
+						if (engineInstance != -1) {
 
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
 
-										payload.push_back(engineInstance);
+								payload.push_back(engineInstance);
 
-										unsigned short oilPressure = USHRT_MAX;
-										payload.push_back(oilPressure & 0xFF);
-										payload.push_back((oilPressure >> 8) & 0xFF);
+								unsigned short oilPressure = USHRT_MAX;
+								payload.push_back(oilPressure & 0xFF);
+								payload.push_back((oilPressure >> 8) & 0xFF);
 
-										unsigned short oilTemperature = USHRT_MAX;
-										payload.push_back(oilTemperature & 0xFF);
-										payload.push_back((oilTemperature >> 8) & 0xFF);
+								unsigned short oilTemperature = USHRT_MAX;
+								payload.push_back(oilTemperature & 0xFF);
+								payload.push_back((oilTemperature >> 8) & 0xFF);
 
-										unsigned short engineTemperature = static_cast<unsigned short>(((nmeaParser.Xdr.TransducerInfo[i].MeasurementData + CONST_KELVIN) * 100));
-										payload.push_back(engineTemperature & 0xFF);
-										payload.push_back((engineTemperature >> 8) & 0xFF);
+								unsigned short engineTemperature = static_cast<unsigned short>(((nmeaParser.Xdr.TransducerInfo[i].MeasurementData + CONST_KELVIN) * 100));
+								payload.push_back(engineTemperature & 0xFF);
+								payload.push_back((engineTemperature >> 8) & 0xFF);
 
-										unsigned short alternatorPotential = USHRT_MAX;
-										payload.push_back(alternatorPotential & 0xFF);
-										payload.push_back((alternatorPotential >> 8) & 0xFF);
+								unsigned short alternatorPotential = USHRT_MAX;
+								payload.push_back(alternatorPotential & 0xFF);
+								payload.push_back((alternatorPotential >> 8) & 0xFF);
 
-										unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
-										payload.push_back(fuelRate & 0xFF);
-										payload.push_back((fuelRate >> 8) &0xFF);
+								unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
+								payload.push_back(fuelRate & 0xFF);
+								payload.push_back((fuelRate >> 8) &0xFF);
 
-										unsigned int totalEngineHours = UINT_MAX;  // seconds
-										payload.push_back(totalEngineHours & 0xFF);
-										payload.push_back((totalEngineHours >> 8) & 0xFF);
-										payload.push_back((totalEngineHours >> 16) & 0xFF);
-										payload.push_back((totalEngineHours >> 24) & 0xFF);
+								unsigned int totalEngineHours = UINT_MAX;  // seconds
+								payload.push_back(totalEngineHours & 0xFF);
+								payload.push_back((totalEngineHours >> 8) & 0xFF);
+								payload.push_back((totalEngineHours >> 16) & 0xFF);
+								payload.push_back((totalEngineHours >> 24) & 0xFF);
 
-										unsigned short coolantPressure = USHRT_MAX; // hPA
-										payload.push_back(coolantPressure & 0xFF);
-										payload.push_back((coolantPressure >> 8) & 0xFF);
+								unsigned short coolantPressure = USHRT_MAX; // hPA
+								payload.push_back(coolantPressure & 0xFF);
+								payload.push_back((coolantPressure >> 8) & 0xFF);
 
-										unsigned short fuelPressure = USHRT_MAX; // hPa
-										payload.push_back(fuelPressure & 0xFF);
-										payload.push_back((fuelPressure >> 8) & 0xFF);
+								unsigned short fuelPressure = USHRT_MAX; // hPa
+								payload.push_back(fuelPressure & 0xFF);
+								payload.push_back((fuelPressure >> 8) & 0xFF);
 
-										byte reserved = UCHAR_MAX;
-										payload.push_back(reserved & 0xFF);
+								byte reserved = UCHAR_MAX;
+								payload.push_back(reserved & 0xFF);
 
-										unsigned short statusOne = USHRT_MAX;
-										payload.push_back(statusOne & 0xFF);
-										payload.push_back((statusOne >> 8) & 0xFF);
-			
-										unsigned short statusTwo = USHRT_MAX;
-										payload.push_back(statusTwo & 0xFF);
-										payload.push_back((statusTwo >>8) & 0xFF);
+								unsigned short statusOne = USHRT_MAX;
+								payload.push_back(statusOne & 0xFF);
+								payload.push_back((statusOne >> 8) & 0xFF);
+	
+								unsigned short statusTwo = USHRT_MAX;
+								payload.push_back(statusTwo & 0xFF);
+								payload.push_back((statusTwo >>8) & 0xFF);
 
-										byte engineLoad = UCHAR_MAX;  // percentage
-										payload.push_back(engineLoad & 0xFF);
+								byte engineLoad = UCHAR_MAX;  // percentage
+								payload.push_back(engineLoad & 0xFF);
 
-										byte engineTorque = UCHAR_MAX; // percentage
-										payload.push_back(engineTorque & 0xFF);
+								byte engineTorque = UCHAR_MAX; // percentage
+								payload.push_back(engineTorque & 0xFF);
 
-										header.pgn = 127489;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}
-							
+								header.pgn = 127489;
+								FragmentFastMessage(&header, &payload, canFrames);
 							}
-													
 						}
+					
 					}
-					// "T" Tachometer in "R" RPM
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("T")) {
-						if (!(supportedPGN & FLAGS_ENG)) {
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("R")) {
+											
+				}
+			}
+			// "T" Tachometer in "R" RPM
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("T")) {
+				if (!(supportedPGN & FLAGS_ENG)) {
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("R")) {
 
-								int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-								wxString remainingString;
+						int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+						wxString remainingString;
 
-								if (engineInstance != -1) {
+						if (engineInstance != -1) {
+						
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
 								
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
-										
-										// BUG BUG duplicating code for PGN 127488
-										payload.push_back(engineInstance);
-
-										unsigned short engineSpeed = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 4.0f);
-										payload.push_back(engineSpeed & 0xFF);
-										payload.push_back((engineSpeed >> 8) & 0xFF);
-			
-										unsigned short engineBoostPressure = USHRT_MAX;
-										payload.push_back(engineBoostPressure & 0xFF);
-										payload.push_back((engineBoostPressure >> 8) & 0xFF);
-
-										short engineTrim = SHRT_MAX;
-										payload.push_back(engineTrim & 0xFF);
-										payload.push_back((engineTrim >> 8) & 0xFF);
-
-										header.pgn = 127488;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}						
+								// BUG BUG duplicating code for PGN 127488
+								payload.push_back(engineInstance);
+
+								unsigned short engineSpeed = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 4.0f);
+								payload.push_back(engineSpeed & 0xFF);
+								payload.push_back((engineSpeed >> 8) & 0xFF);
+	
+								unsigned short engineBoostPressure = USHRT_MAX;
+								payload.push_back(engineBoostPressure & 0xFF);
+								payload.push_back((engineBoostPressure >> 8) & 0xFF);
+
+								short engineTrim = SHRT_MAX;
+								payload.push_back(engineTrim & 0xFF);
+								payload.push_back((engineTrim >> 8) & 0xFF);
+
+								header.pgn = 127488;
+								FragmentFastMessage(&header, &payload, canFrames);
 							}
-						}
+						}						
 					}
-					
-		    
-					// "P" Pressure in "P" pascal
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("P")) {
-						if (!(supportedPGN & FLAGS_ENG)) {
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("P")) {
-
-								int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-								wxString remainingString;
+				}
+			}
+			
+    
+			// "P" Pressure in "P" pascal
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("P")) {
+				if (!(supportedPGN & FLAGS_ENG)) {
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("P")) {
 
-								if (engineInstance != -1) {
+						int engineInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+						wxString remainingString;
 
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
-										
-										// BUG BUG duplicating code for PGN 127488
-										payload.push_back(engineInstance);
+						if (engineInstance != -1) {
 
-										unsigned short engineSpeed = USHRT_MAX ;
-										payload.push_back(engineSpeed & 0xFF);
-										payload.push_back((engineSpeed >> 8) & 0xFF);
-			
-										// BUG BUG Unsure of units & range
-										unsigned short engineBoostPressure = nmeaParser.Xdr.TransducerInfo[i].MeasurementData / 100;
-										payload.push_back(engineBoostPressure & 0xFF);
-										payload.push_back((engineBoostPressure >> 8) & 0xFF);
-
-										short engineTrim = SHRT_MAX;
-										payload.push_back(engineTrim & 0xFF);
-										payload.push_back((engineTrim >> 8) & 0xFF);
-
-										header.pgn = 127488;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINE#"), &remainingString)) {
 								
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINEOIL#"), &remainingString)) {
+								// BUG BUG duplicating code for PGN 127488
+								payload.push_back(engineInstance);
 
-										payload.push_back(engineInstance);
+								unsigned short engineSpeed = USHRT_MAX ;
+								payload.push_back(engineSpeed & 0xFF);
+								payload.push_back((engineSpeed >> 8) & 0xFF);
+	
+								// BUG BUG Unsure of units & range
+								unsigned short engineBoostPressure = nmeaParser.Xdr.TransducerInfo[i].MeasurementData / 100;
+								payload.push_back(engineBoostPressure & 0xFF);
+								payload.push_back((engineBoostPressure >> 8) & 0xFF);
 
-										unsigned short oilPressure = nmeaParser.Xdr.TransducerInfo[i].MeasurementData / 100; // hPa (1hPa = 100Pa)
-										payload.push_back(oilPressure & 0xFF);
-										payload.push_back((oilPressure >> 8) & 0xFF);
+								short engineTrim = SHRT_MAX;
+								payload.push_back(engineTrim & 0xFF);
+								payload.push_back((engineTrim >> 8) & 0xFF);
 
-										unsigned short oilTemperature = USHRT_MAX;
-										payload.push_back(oilTemperature & 0xFF);
-										payload.push_back((oilTemperature >> 8) & 0xFF);
+								header.pgn = 127488;
+								FragmentFastMessage(&header, &payload, canFrames);
+							}
+						
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ENGINEOIL#"), &remainingString)) {
 
-										unsigned short engineTemperature = USHRT_MAX;
-										payload.push_back(engineTemperature & 0xFF);
-										payload.push_back((engineTemperature >> 8) & 0xFF);
+								payload.push_back(engineInstance);
 
-										unsigned short alternatorPotential = USHRT_MAX; // 0.01 Volts
-										payload.push_back(alternatorPotential & 0xFF);
-										payload.push_back((alternatorPotential >> 8) & 0xFF);
+								unsigned short oilPressure = nmeaParser.Xdr.TransducerInfo[i].MeasurementData / 100; // hPa (1hPa = 100Pa)
+								payload.push_back(oilPressure & 0xFF);
+								payload.push_back((oilPressure >> 8) & 0xFF);
 
-										unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
-										payload.push_back(fuelRate & 0xFF);
-										payload.push_back((fuelRate >> 8) &0xFF);
+								unsigned short oilTemperature = USHRT_MAX;
+								payload.push_back(oilTemperature & 0xFF);
+								payload.push_back((oilTemperature >> 8) & 0xFF);
 
-										unsigned int totalEngineHours = UINT_MAX;  // seconds
-										payload.push_back(totalEngineHours & 0xFF);
-										payload.push_back((totalEngineHours >> 8) & 0xFF);
-										payload.push_back((totalEngineHours >> 16) & 0xFF);
-										payload.push_back((totalEngineHours >> 24) & 0xFF);
+								unsigned short engineTemperature = USHRT_MAX;
+								payload.push_back(engineTemperature & 0xFF);
+								payload.push_back((engineTemperature >> 8) & 0xFF);
 
-										unsigned short coolantPressure = USHRT_MAX; // hPA
-										payload.push_back(coolantPressure & 0xFF);
-										payload.push_back((coolantPressure >> 8) & 0xFF);
+								unsigned short alternatorPotential = USHRT_MAX; // 0.01 Volts
+								payload.push_back(alternatorPotential & 0xFF);
+								payload.push_back((alternatorPotential >> 8) & 0xFF);
 
-										unsigned short fuelPressure = USHRT_MAX; // hPa
-										payload.push_back(fuelPressure & 0xFF);
-										payload.push_back((fuelPressure >> 8) & 0xFF);
+								unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
+								payload.push_back(fuelRate & 0xFF);
+								payload.push_back((fuelRate >> 8) &0xFF);
 
-										byte reserved = UCHAR_MAX;
-										payload.push_back(reserved & 0xFF);
+								unsigned int totalEngineHours = UINT_MAX;  // seconds
+								payload.push_back(totalEngineHours & 0xFF);
+								payload.push_back((totalEngineHours >> 8) & 0xFF);
+								payload.push_back((totalEngineHours >> 16) & 0xFF);
+								payload.push_back((totalEngineHours >> 24) & 0xFF);
 
-										unsigned short statusOne = USHRT_MAX;
-										payload.push_back(statusOne & 0xFF);
-										payload.push_back((statusOne >> 8) & 0xFF);
-			
-										unsigned short statusTwo = USHRT_MAX;
-										payload.push_back(statusTwo & 0xFF);
-										payload.push_back((statusTwo >> 8) & 0xFF);
+								unsigned short coolantPressure = USHRT_MAX; // hPA
+								payload.push_back(coolantPressure & 0xFF);
+								payload.push_back((coolantPressure >> 8) & 0xFF);
 
-										byte engineLoad = UCHAR_MAX;  // percentage
-										payload.push_back(engineLoad & 0xFF);
+								unsigned short fuelPressure = USHRT_MAX; // hPa
+								payload.push_back(fuelPressure & 0xFF);
+								payload.push_back((fuelPressure >> 8) & 0xFF);
 
-										byte engineTorque = UCHAR_MAX; // percentage
-										payload.push_back(engineTorque & 0xFF);
+								byte reserved = UCHAR_MAX;
+								payload.push_back(reserved & 0xFF);
 
-										header.pgn = 127489;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}						
-							}
-						}
+								unsigned short statusOne = USHRT_MAX;
+								payload.push_back(statusOne & 0xFF);
+								payload.push_back((statusOne >> 8) & 0xFF);
+	
+								unsigned short statusTwo = USHRT_MAX;
+								payload.push_back(statusTwo & 0xFF);
+								payload.push_back((statusTwo >> 8) & 0xFF);
 
+								byte engineLoad = UCHAR_MAX;  // percentage
+								payload.push_back(engineLoad & 0xFF);
+
+								byte engineTorque = UCHAR_MAX; // percentage
+								payload.push_back(engineTorque & 0xFF);
+
+								header.pgn = 127489;
+								FragmentFastMessage(&header, &payload, canFrames);
+							}
+						}						
 					}
+				}
 
-					// "I" Current in "A" amperes
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("I")) {
-						if (!(supportedPGN & FLAGS_BAT)) {
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("A")) {
-								
-								int batteryInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-								wxString remainingString;
+			}
+
+			// "I" Current in "A" amperes
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("I")) {
+				if (!(supportedPGN & FLAGS_BAT)) {
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("A")) {
+						
+						int batteryInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+						wxString remainingString;
 
-								if (batteryInstance != -1) {
+						if (batteryInstance != -1) {
 
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BATTERY#"), &remainingString)) {
-										
-										payload.push_back(batteryInstance & 0xF);
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BATTERY#"), &remainingString)) {
+								
+								payload.push_back(batteryInstance & 0xF);
 
-										unsigned short batteryVoltage = USHRT_MAX;
-										payload.push_back(batteryVoltage & 0xFF);
-										payload.push_back((batteryVoltage >> 8) & 0xFF);
+								unsigned short batteryVoltage = USHRT_MAX;
+								payload.push_back(batteryVoltage & 0xFF);
+								payload.push_back((batteryVoltage >> 8) & 0xFF);
 
-										short batteryCurrent  = nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 10;
-										payload.push_back(batteryCurrent & 0xFF);
-										payload.push_back((batteryCurrent >> 8) & 0xFF);
-			
-										unsigned short batteryTemperature = USHRT_MAX; 
-										payload.push_back(batteryTemperature & 0xFF);
-										payload.push_back((batteryTemperature >> 8) & 0xFF);
-			
-										payload.push_back(sequenceId);
+								short batteryCurrent  = nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 10;
+								payload.push_back(batteryCurrent & 0xFF);
+								payload.push_back((batteryCurrent >> 8) & 0xFF);
+	
+								unsigned short batteryTemperature = USHRT_MAX; 
+								payload.push_back(batteryTemperature & 0xFF);
+								payload.push_back((batteryTemperature >> 8) & 0xFF);
+	
+								payload.push_back(sequenceId);
 
-										header.pgn = 127508;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}
+								header.pgn = 127508;
+								FragmentFastMessage(&header, &payload, canFrames);
 							}
 						}
 					}
+				}
+			}
 
-					// "U" Voltage in "V" volts
-					if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("U")) {
-						if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("V")) {
-								
-							int batteryInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-							wxString remainingString;
+			// "U" Voltage in "V" volts
+			if (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("U")) {
+				if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("V")) {
+						
+					int batteryInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+					wxString remainingString;
 
-							if (batteryInstance != -1) {
-															
-								if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BATTERY#"), &remainingString)) {
-									if (!(supportedPGN & FLAGS_BAT)) {
-										payload.push_back(batteryInstance & 0xF);
+					if (batteryInstance != -1) {
+													
+						if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BATTERY#"), &remainingString)) {
+							if (!(supportedPGN & FLAGS_BAT)) {
+								payload.push_back(batteryInstance & 0xF);
 
-										unsigned short batteryVoltage = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 100.0f);
-										payload.push_back(batteryVoltage & 0xFF);
-										payload.push_back((batteryVoltage >> 8) & 0xFF);
+								unsigned short batteryVoltage = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 100.0f);
+								payload.push_back(batteryVoltage & 0xFF);
+								payload.push_back((batteryVoltage >> 8) & 0xFF);
 
-										short batteryCurrent = SHRT_MAX;
-										payload.push_back(batteryCurrent & 0xFF);
-										payload.push_back((batteryCurrent >> 8) & 0xFF);
+								short batteryCurrent = SHRT_MAX;
+								payload.push_back(batteryCurrent & 0xFF);
+								payload.push_back((batteryCurrent >> 8) & 0xFF);
 
-										unsigned short batteryTemperature = USHRT_MAX;
-										payload.push_back(batteryTemperature & 0xFF);
-										payload.push_back((batteryTemperature >> 8) & 0xFF);
+								unsigned short batteryTemperature = USHRT_MAX;
+								payload.push_back(batteryTemperature & 0xFF);
+								payload.push_back((batteryTemperature >> 8) & 0xFF);
 
-										payload.push_back(sequenceId);
+								payload.push_back(sequenceId);
 
-										header.pgn = 127508;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}
-								
-								if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ALTERNATOR#"), &remainingString)) {
-									if (!(supportedPGN & FLAGS_ENG)) {
-										payload.push_back(batteryInstance);
+								header.pgn = 127508;
+								FragmentFastMessage(&header, &payload, canFrames);
+							}
+						}
+						
+						if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("ALTERNATOR#"), &remainingString)) {
+							if (!(supportedPGN & FLAGS_ENG)) {
+								payload.push_back(batteryInstance);
 
-										unsigned short oilPressure = USHRT_MAX;
-										payload.push_back(oilPressure & 0xFF);
-										payload.push_back((oilPressure >> 8) & 0xFF);
+								unsigned short oilPressure = USHRT_MAX;
+								payload.push_back(oilPressure & 0xFF);
+								payload.push_back((oilPressure >> 8) & 0xFF);
 
-										unsigned short oilTemperature = USHRT_MAX;
-										payload.push_back(oilTemperature & 0xFF);
-										payload.push_back((oilTemperature >> 8) & 0xFF);
+								unsigned short oilTemperature = USHRT_MAX;
+								payload.push_back(oilTemperature & 0xFF);
+								payload.push_back((oilTemperature >> 8) & 0xFF);
 
-										unsigned short engineTemperature = USHRT_MAX;
-										payload.push_back(engineTemperature & 0xFF);
-										payload.push_back((engineTemperature >> 8) & 0xFF);
+								unsigned short engineTemperature = USHRT_MAX;
+								payload.push_back(engineTemperature & 0xFF);
+								payload.push_back((engineTemperature >> 8) & 0xFF);
 
-										unsigned short alternatorPotential = nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 100;
-										payload.push_back(alternatorPotential & 0xFF);
-										payload.push_back((alternatorPotential >> 8) & 0xFF);
+								unsigned short alternatorPotential = nmeaParser.Xdr.TransducerInfo[i].MeasurementData * 100;
+								payload.push_back(alternatorPotential & 0xFF);
+								payload.push_back((alternatorPotential >> 8) & 0xFF);
 
-										unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
-										payload.push_back(fuelRate & 0xFF);
-										payload.push_back((fuelRate >> 8) & 0xFF);
+								unsigned short fuelRate = USHRT_MAX; // 0.1 Litres/hour
+								payload.push_back(fuelRate & 0xFF);
+								payload.push_back((fuelRate >> 8) & 0xFF);
 
-										unsigned int totalEngineHours = UINT_MAX;  // seconds
-										payload.push_back(totalEngineHours & 0xFF);
-										payload.push_back((totalEngineHours >> 8) & 0xFF);
-										payload.push_back((totalEngineHours >> 16) & 0xFF);
-										payload.push_back((totalEngineHours >> 24) & 0xFF);
+								unsigned int totalEngineHours = UINT_MAX;  // seconds
+								payload.push_back(totalEngineHours & 0xFF);
+								payload.push_back((totalEngineHours >> 8) & 0xFF);
+								payload.push_back((totalEngineHours >> 16) & 0xFF);
+								payload.push_back((totalEngineHours >> 24) & 0xFF);
 
-										unsigned short coolantPressure = USHRT_MAX; // hPA
-										payload.push_back(coolantPressure & 0xFF);
-										payload.push_back((coolantPressure >> 8) & 0xFF);
+								unsigned short coolantPressure = USHRT_MAX; // hPA
+								payload.push_back(coolantPressure & 0xFF);
+								payload.push_back((coolantPressure >> 8) & 0xFF);
 
-										unsigned short fuelPressure = USHRT_MAX; // hPa
-										payload.push_back(fuelPressure & 0xFF);
-										payload.push_back((fuelPressure >> 8) & 0xFF);
+								unsigned short fuelPressure = USHRT_MAX; // hPa
+								payload.push_back(fuelPressure & 0xFF);
+								payload.push_back((fuelPressure >> 8) & 0xFF);
 
-										byte reserved = UCHAR_MAX;
-										payload.push_back(reserved & 0xFF);
+								byte reserved = UCHAR_MAX;
+								payload.push_back(reserved & 0xFF);
 
-										unsigned short statusOne = USHRT_MAX;
-										payload.push_back(statusOne & 0xFF);
-										payload.push_back((statusOne >> 8) & 0xFF);
+								unsigned short statusOne = USHRT_MAX;
+								payload.push_back(statusOne & 0xFF);
+								payload.push_back((statusOne >> 8) & 0xFF);
 
-										unsigned short statusTwo = USHRT_MAX;
-										payload.push_back(statusTwo & 0xFF);
-										payload.push_back((statusTwo >> 8) & 0xFF);
+								unsigned short statusTwo = USHRT_MAX;
+								payload.push_back(statusTwo & 0xFF);
+								payload.push_back((statusTwo >> 8) & 0xFF);
 
-										byte engineLoad = UCHAR_MAX;  // percentage
-										payload.push_back(engineLoad & 0xFF);
+								byte engineLoad = UCHAR_MAX;  // percentage
+								payload.push_back(engineLoad & 0xFF);
 
-										byte engineTorque = UCHAR_MAX; // percentage
-										payload.push_back(engineTorque & 0xFF);
+								byte engineTorque = UCHAR_MAX; // percentage
+								payload.push_back(engineTorque & 0xFF);
 
-										header.pgn = 127489;
-										FragmentFastMessage(&header, &payload, canMessages);
-									}
-								}
+								header.pgn = 127489;
+								FragmentFastMessage(&header, &payload, canFrames);
 							}
 						}
-					}	
+					}
+				}
+			}	
 
-					// "V" Volume or "E" Volume - "P" as percent capacity
-					if ((nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("V")) || (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("E"))) {
-						if (!(supportedPGN & FLAGS_TNK)) {
-							if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("P")) {
+			// "V" Volume or "E" Volume - "P" as percent capacity
+			if ((nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("V")) || (nmeaParser.Xdr.TransducerInfo[i].TransducerType == _T("E"))) {
+				if (!(supportedPGN & FLAGS_TNK)) {
+					if (nmeaParser.Xdr.TransducerInfo[i].UnitOfMeasurement == _T("P")) {
 
-								int tankInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
-								byte tankType;
-								wxString remainingString;
+						int tankInstance = GetInstanceNumber(nmeaParser.Xdr.TransducerInfo[i].TransducerName);
+						byte tankType;
+						wxString remainingString;
 
-								if (tankInstance != -1) {
+						if (tankInstance != -1) {
 
-									if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("FUEL#"), &remainingString)) {
-										tankType = TANK_FUEL;
-									}
+							if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("FUEL#"), &remainingString)) {
+								tankType = TANK_FUEL;
+							}
 
-									else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith( _T("FRESHWATER#"), &remainingString)) {
-										tankType = TANK_FRESHWATER;
-									}
+							else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith( _T("FRESHWATER#"), &remainingString)) {
+								tankType = TANK_FRESHWATER;
+							}
 
-									else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("WASTEWATER#"), &remainingString)) {
-										tankType = TANK_WASTEWATER;
-									}
+							else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("WASTEWATER#"), &remainingString)) {
+								tankType = TANK_WASTEWATER;
+							}
 
-									else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("LIVEWELL#"), &remainingString)) {
-										tankType = TANK_LIVEWELL;
-									}
+							else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("LIVEWELL#"), &remainingString)) {
+								tankType = TANK_LIVEWELL;
+							}
 
-									else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("OIL#"), &remainingString)) {
-										tankType = TANK_OIL;
-									}
+							else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("OIL#"), &remainingString)) {
+								tankType = TANK_OIL;
+							}
 
-									else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BLACKWATER#"), &remainingString)) {
-										tankType = TANK_BLACKWATER;
-									}
+							else if (nmeaParser.Xdr.TransducerInfo[i].TransducerName.StartsWith(_T("BLACKWATER#"), &remainingString)) {
+								tankType = TANK_BLACKWATER;
+							}
 
-									else {
-										// Not a transducer measurement we are interested in
-										return FALSE;
-									}
-		
-									payload.push_back((tankInstance & 0x0F) | ((tankType << 4) & 0xF0));
+							else {
+								// Not a transducer measurement we are interested in
+								return FALSE;
+							}
 
-									unsigned short tankLevel = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * QUARTER_PERCENT); // percentage in 0.25 % increments
-									payload.push_back(tankLevel & 0xFF);
-									payload.push_back((tankLevel >> 8) & 0xFF);
+							payload.push_back((tankInstance & 0x0F) | ((tankType << 4) & 0xF0));
 
-									unsigned int tankCapacity = UINT_MAX;  // Capacity in tenths of litres
-									payload.push_back(tankCapacity & 0xFF);
-									payload.push_back((tankCapacity >> 8) & 0xFF); 
-									payload.push_back((tankCapacity >> 16) & 0xFF);
-									payload.push_back((tankCapacity >> 24) & 0xFF);
+							unsigned short tankLevel = static_cast<unsigned short>(nmeaParser.Xdr.TransducerInfo[i].MeasurementData * QUARTER_PERCENT); // percentage in 0.25 % increments
+							payload.push_back(tankLevel & 0xFF);
+							payload.push_back((tankLevel >> 8) & 0xFF);
 
-									header.pgn = 127505;
-									FragmentFastMessage(&header, &payload, canMessages);
+							unsigned int tankCapacity = UINT_MAX;  // Capacity in tenths of litres
+							payload.push_back(tankCapacity & 0xFF);
+							payload.push_back((tankCapacity >> 8) & 0xFF); 
+							payload.push_back((tankCapacity >> 16) & 0xFF);
+							payload.push_back((tankCapacity >> 24) & 0xFF);
 
-								}
-							}
-						}
-					}
-				}
-				return TRUE;
-			}	
-		
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
-			}
-			return FALSE;
-		}
+							header.pgn = 127505;
+							FragmentFastMessage(&header, &payload, canFrames);
 
-		// XTE Cross - Track Error, Measured
-		else if (nmeaParser.LastSentenceIDReceived == _T("XTE")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_XTE)) {
-					if (EncodePGN129283(&nmeaParser, &payload)) {
-						header.pgn = 129283;
-						FragmentFastMessage(&header, &payload, canMessages);
+						}
 					}
 				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}	
 
-		// ZDA Time & Date
-		// PGN 126992, 129029, 129033
-		else if (nmeaParser.LastSentenceIDReceived == _T("ZDA")) {
-			if (nmeaParser.Parse()) {
-				if (!(supportedPGN & FLAGS_ZDA)) {
-					if (EncodePGN126992(&nmeaParser, &payload)) {
-						header.pgn = 126992;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-					if (EncodePGN129033(&nmeaParser, &payload)) {
-						header.pgn = 129033;
-						FragmentFastMessage(&header, &payload, canMessages);
-					}
-	
-				}
-				return TRUE;
-			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+// XTE Cross - Track Error, Measured
+bool TwoCanEncoder::EncodeSentenceXTE(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_XTE)) {
+			if (EncodePGN129283(&nmeaParser, &payload)) {
+				header.pgn = 129283;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
 		}
+		return TRUE;
+	}
+	else {
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+	}
+	return FALSE;
+}
 
-		// ZTG UTC & Time to Destination Waypoint
-		else if (nmeaParser.LastSentenceIDReceived == _T("ZTG")) {
-			if (nmeaParser.Parse()) {
-				// IGNORE
-
+// ZDA Time & Date
+// PGN 126992, 129029, 129033
+bool TwoCanEncoder::EncodeSentenceZDA(CanHeader& header, PayloadWriter& payload, std::vector<CanFrame> *canFrames, const wxString& sentence) {
+	if (nmeaParser.Parse()) {
+		if (!(supportedPGN & FLAGS_ZDA)) {
+			if (EncodePGN126992(&nmeaParser, &payload)) {
+				header.pgn = 126992;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			else {
-				wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
+
+			if (EncodePGN129033(&nmeaParser, &payload)) {
+				header.pgn = 129033;
+				FragmentFastMessage(&header, &payload, canFrames);
 			}
-			return FALSE;
+
 		}
-	} 
+		return TRUE;
+	}
 	else {
-		wxLogMessage(_T("TwoCan Encoder, Error pre-parsing %s"), sentence);
+		wxLogMessage(_T("TwoCan Encoder Parse Error, %s: %s"), sentence, nmeaParser.ErrorMessage);
 	}
-
 	return FALSE;
 }
 
@@ -1527,7 +1590,7 @@ bool TwoCanEncoder::EncodeMessage(wxString sentence, std::vector<CanMessage> *ca
 // hence the parser->LastSentenceIDParsed palaver.
 
 // Encode PGN 126992 NMEA System Time
-bool TwoCanEncoder::EncodePGN126992(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN126992(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("RMC")) {
@@ -1654,7 +1717,7 @@ bool TwoCanEncoder::EncodePGN126992(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 127233 NMEA Man Overboard (MOB)
-bool TwoCanEncoder::EncodePGN127233(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127233(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	if (parser->LastSentenceIDParsed == _T("MOB")) {
 		n2kMessage->clear();
 
@@ -1744,7 +1807,7 @@ bool TwoCanEncoder::EncodePGN127233(const NMEA0183 *parser, std::vector<byte> *n
 
 
 // Encode payload for PGN 127245 NMEA Rudder Position
-bool TwoCanEncoder::EncodePGN127245(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127245(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	if (parser->LastSentenceIDParsed == _T("RSA")) {
 		n2kMessage->clear();
 		// BUG BUG How to deal with multi rudder configurations
@@ -1778,7 +1841,7 @@ bool TwoCanEncoder::EncodePGN127245(const NMEA0183 *parser, std::vector<byte> *n
 }	
 
 // Encode payload for PGN 127250 NMEA Vessel Heading
-bool TwoCanEncoder::EncodePGN127250(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127250(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 	if (parser->LastSentenceIDParsed == _T("HDG")) {
 		n2kMessage->push_back(sequenceId);			
@@ -1851,7 +1914,7 @@ bool TwoCanEncoder::EncodePGN127250(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 127251 NMEA Rate of Turn (ROT)
-bool TwoCanEncoder::EncodePGN127251(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127251(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("ROT")) {
@@ -1871,7 +1934,7 @@ bool TwoCanEncoder::EncodePGN127251(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 127257 NMEA Attitude
-bool TwoCanEncoder::EncodePGN127257(const short yaw, const short pitch, const short roll, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127257(const short yaw, const short pitch, const short roll, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	n2kMessage->push_back(sequenceId);
@@ -1890,7 +1953,7 @@ bool TwoCanEncoder::EncodePGN127257(const short yaw, const short pitch, const sh
 }
 
 // Encode payload for PGN 127258 NMEA Magnetic Variation
-bool TwoCanEncoder::EncodePGN127258(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127258(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("HDG")) {
@@ -1923,7 +1986,7 @@ bool TwoCanEncoder::EncodePGN127258(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 127488 Engine Rapid Update
-bool TwoCanEncoder::EncodePGN127488(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127488(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("RPM")) {
@@ -1955,7 +2018,7 @@ bool TwoCanEncoder::EncodePGN127488(const NMEA0183 *parser, std::vector<byte> *n
 
 // Encode payload for PGN 127489 Engine Static Parameters
 // BUG BUG Not all parameters are configured, assumes values are enumerated from NMEA 183 XDR sentence
-bool TwoCanEncoder::EncodePGN127250(const byte engineInstance, const unsigned short oilPressure, const unsigned short engineTemperature, const unsigned short alternatorPotential, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN127250(const byte engineInstance, const unsigned short oilPressure, const unsigned short engineTemperature, const unsigned short alternatorPotential, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	n2kMessage->push_back(engineInstance);
@@ -2013,7 +2076,7 @@ bool TwoCanEncoder::EncodePGN127250(const byte engineInstance, const unsigned sh
 }
 
 // Encode payload for PGN 128259 NMEA Speed & Heading
-bool TwoCanEncoder::EncodePGN128259(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN128259(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("VHW")) {
@@ -2040,22 +2103,16 @@ bool TwoCanEncoder::EncodePGN128259(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 128267 NMEA Depth
-bool TwoCanEncoder::EncodePGN128267(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN128267(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("DPT")) {
 
 		n2kMessage->push_back(sequenceId);
 
-		unsigned int depth = (unsigned int)(100 * parser->Dpt.DepthMeters);
-		n2kMessage->push_back(depth & 0xFF);
-		n2kMessage->push_back((depth >> 8) & 0xFF);
-		n2kMessage->push_back((depth >> 16) & 0xFF);
-		n2kMessage->push_back((depth >> 24) & 0xFF);
+		n2kMessage->PutScaledUInt32(parser->Dpt.DepthMeters, 100);
 		
-		short offset = (short)(1000 * nmeaParser.Dpt.OffsetFromTransducerMeters);
-		n2kMessage->push_back(offset & 0xFF);
-		n2kMessage->push_back((offset >> 8) & 0xFF);
+		n2kMessage->PutScaledInt16(nmeaParser.Dpt.OffsetFromTransducerMeters, 1000);
 
 		byte maxRange = (byte)(0.1 * nmeaParser.Dpt.MaximumRangeMeters);
 		n2kMessage->push_back(maxRange & 0xFF);
@@ -2066,15 +2123,9 @@ bool TwoCanEncoder::EncodePGN128267(const NMEA0183 *parser, std::vector<byte> *n
 
 		n2kMessage->push_back(sequenceId);
 			
-		unsigned int depth = (unsigned int)(100 * parser->Dbt.DepthMeters);
-		n2kMessage->push_back(depth & 0xFF);
-		n2kMessage->push_back((depth >> 8) & 0xFF);
-		n2kMessage->push_back((depth >> 16) & 0xFF);
-		n2kMessage->push_back((depth >> 24) & 0xFF);
+		n2kMessage->PutScaledUInt32(parser->Dbt.DepthMeters, 100);
 		
-		short offset = SHRT_MAX;
-		n2kMessage->push_back(offset & 0xFF);
-		n2kMessage->push_back((offset >> 8) & 0xFF);
+		n2kMessage->PutInt16(SHRT_MAX);
 
 		byte maxRange = UCHAR_MAX;
 		n2kMessage->push_back(maxRange & 0xFF);
@@ -2085,7 +2136,7 @@ bool TwoCanEncoder::EncodePGN128267(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 128275 NMEA Distance Log
-bool TwoCanEncoder::EncodePGN128275(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN128275(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("VLW")) {
@@ -2124,31 +2175,23 @@ bool TwoCanEncoder::EncodePGN128275(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 129025 NMEA Position Rapid Update
-bool TwoCanEncoder::EncodePGN129025(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129025(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (nmeaParser.LastSentenceIDParsed == _T("RMC")) {
 		if (parser->Rmc.IsDataValid == NTrue) {
 						
-			int latitude = parser->Rmc.Position.Latitude.Latitude * 1e7;
-
+			double latitude = parser->Rmc.Position.Latitude.Latitude;
 			if (parser->Rmc.Position.Latitude.Northing == South) {
 				latitude = -latitude;
 			}
-			n2kMessage->push_back(latitude & 0xFF);
-			n2kMessage->push_back((latitude >> 8) & 0xFF);
-			n2kMessage->push_back((latitude >> 16) & 0xFF);
-			n2kMessage->push_back((latitude >> 24) & 0xFF);
-
-			int longitude = parser->Rmc.Position.Longitude.Longitude * 1e7;
+			n2kMessage->PutScaledInt32(latitude, 1e7);
 
+			double longitude = parser->Rmc.Position.Longitude.Longitude;
 			if (parser->Rmc.Position.Longitude.Easting == West) {
 				longitude = -longitude;
 			}
-			n2kMessage->push_back(longitude & 0xFF);
-			n2kMessage->push_back((longitude >> 8) & 0xFF);
-			n2kMessage->push_back((longitude >> 16) & 0xFF);
-			n2kMessage->push_back((longitude >> 24) & 0xFF);
+			n2kMessage->PutScaledInt32(longitude, 1e7);
 
 			return TRUE;
 		}
@@ -2156,23 +2199,17 @@ bool TwoCanEncoder::EncodePGN129025(const NMEA0183 *parser, std::vector<byte> *n
 	else if (nmeaParser.LastSentenceIDParsed == _T("GLL")) {
 		if (parser->Gll.IsDataValid == NTrue) {
 	
-			int latitude = (int)(parser->Gll.Position.Latitude.Latitude * 1e7);
+			double latitude = parser->Gll.Position.Latitude.Latitude;
 			if (parser->Gll.Position.Latitude.Northing == South) {
 				latitude = -latitude;
 			}
-			n2kMessage->push_back(latitude & 0xFF);
-			n2kMessage->push_back((latitude >> 8) & 0xFF);
-			n2kMessage->push_back((latitude >> 16) & 0xFF);
-			n2kMessage->push_back((latitude >> 24) & 0xFF);
+			n2kMessage->PutScaledInt32(latitude, 1e7);
 
-			int longitude = (int)(parser->Gll.Position.Longitude.Longitude * 1e7);
+			double longitude = parser->Gll.Position.Longitude.Longitude;
 			if (parser->Gll.Position.Longitude.Easting == West) {
 				longitude = -longitude;
 			}
-			n2kMessage->push_back(longitude & 0xFF);
-			n2kMessage->push_back((longitude >> 8) & 0xFF);
-			n2kMessage->push_back((longitude >> 16) & 0xFF);
-			n2kMessage->push_back((longitude >> 24) & 0xFF);
+			n2kMessage->PutScaledInt32(longitude, 1e7);
 			return TRUE;
 		}
 	}
@@ -2180,23 +2217,17 @@ bool TwoCanEncoder::EncodePGN129025(const NMEA0183 *parser, std::vector<byte> *n
 	else if (nmeaParser.LastSentenceIDParsed == _T("GGA")) {
 		if (parser->Gga.GPSQuality != 0) { // 0 indicates fix not available
 	
-			int latitude = (int)(parser->Gga.Position.Latitude.Latitude * 1e7);
+			double latitude = parser->Gga.Position.Latitude.Latitude;
 			if (parser->Gga.Position.Latitude.Northing == South) {
 				latitude = -latitude;
 			}
-			n2kMessage->push_back(latitude & 0xFF);
-			n2kMessage->push_back((latitude >> 8) & 0xFF);
-			n2kMessage->push_back((latitude >> 16) & 0xFF);
-			n2kMessage->push_back((latitude >> 24) & 0xFF);
+			n2kMessage->PutScaledInt32(latitude, 1e7);
 
-			int longitude = (int)(parser->Gga.Position.Longitude.Longitude * 1e7);
+			double longitude = parser->Gga.Position.Longitude.Longitude;
 			if (parser->Gga.Position.Longitude.Easting == West) {
 				longitude = -longitude;
 			}
-			n2kMessage->push_back(longitude & 0xFF);
-			n2kMessage->push_back((longitude >> 8) & 0xFF);
-			n2kMessage->push_back((longitude >> 16) & 0xFF);
-			n2kMessage->push_back((longitude >> 24) & 0xFF);
+			n2kMessage->PutScaledInt32(longitude, 1e7);
 			return TRUE;
 		}
 	}
@@ -2204,7 +2235,7 @@ bool TwoCanEncoder::EncodePGN129025(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 129026 NMEA COG SOG Rapid Update
-bool TwoCanEncoder::EncodePGN129026(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129026(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (nmeaParser.LastSentenceIDParsed == _T("RMC")) {
@@ -2215,13 +2246,10 @@ bool TwoCanEncoder::EncodePGN129026(const NMEA0183 *parser, std::vector<byte> *n
 			byte headingReference = HEADING_TRUE;
 			n2kMessage->push_back(headingReference & 0x03);
 
-			unsigned short courseOverGround = 10000 * DEGREES_TO_RADIANS(parser->Rmc.TrackMadeGoodDegreesTrue);
-			n2kMessage->push_back(courseOverGround & 0xFF);
-			n2kMessage->push_back((courseOverGround >> 8) & 0xFF);
+			n2kMessage->PutScaledUInt16(DEGREES_TO_RADIANS(parser->Rmc.TrackMadeGoodDegreesTrue), 10000);
 
 			unsigned short speedOverGround = 100 * parser->Rmc.SpeedOverGroundKnots / CONVERT_MS_KNOTS;
-			n2kMessage->push_back(speedOverGround & 0xFF);
-			n2kMessage->push_back((speedOverGround >> 8) & 0xFF);
+			n2kMessage->PutUInt16(speedOverGround);
 
 			return TRUE;
 		}
@@ -2229,7 +2257,7 @@ bool TwoCanEncoder::EncodePGN129026(const NMEA0183 *parser, std::vector<byte> *n
 	return FALSE;
 }
 
-bool TwoCanEncoder::EncodePGN129029(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129029(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("GGA")) {
@@ -2333,7 +2361,7 @@ bool TwoCanEncoder::EncodePGN129029(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 129033 NMEA Date & Time
-bool TwoCanEncoder::EncodePGN129033(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129033(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	if (parser->LastSentenceIDParsed == _T("ZDA")) {
 		n2kMessage->clear();
 
@@ -2368,7 +2396,7 @@ bool TwoCanEncoder::EncodePGN129033(const NMEA0183 *parser, std::vector<byte> *n
 
 // Encode payload for PGN 129283 NMEA Cross Track Error
 // Generated by APB, RMB or XTE sentences
-bool TwoCanEncoder::EncodePGN129283(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129283(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("XTE")) {
@@ -2519,7 +2547,7 @@ bool TwoCanEncoder::EncodePGN129283(const NMEA0183 *parser, std::vector<byte> *n
 //$--WCV, x.x, N, c--c, a*hh<CR><LF>
 
 // Not sure of this use case, as it implies there is already a chartplotter on board
-bool TwoCanEncoder::EncodePGN129284(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129284(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("RMB")) {
@@ -2613,7 +2641,7 @@ bool TwoCanEncoder::EncodePGN129284(const NMEA0183 *parser, std::vector<byte> *n
 // $--RTE,x.x,x.x,a,c--c,c--c, ..��... c--c*hh<CR><LF>
 // and 
 // $--WPL,llll.ll,a,yyyyy.yy,a,c--c
-bool TwoCanEncoder::EncodePGN129285(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129285(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	
 	// Need to construct a route/waypoint thingy......
 	// This is what we are sent
@@ -2691,7 +2719,7 @@ bool TwoCanEncoder::EncodePGN129285(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 129540 GNSS Satellites in View
-bool TwoCanEncoder::EncodePGN129540(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129540(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	int numberOfMessages = parser->Gsv.NumberOfMessages;
@@ -2799,7 +2827,7 @@ bool TwoCanEncoder::EncodePGN129540(const NMEA0183 *parser, std::vector<byte> *n
 // and
 // $--DSE
 
-bool TwoCanEncoder::EncodePGN129808(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN129808(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 
 	if (parser->LastSentenceIDParsed == _T("DSC")) {
 
@@ -3048,43 +3076,43 @@ bool TwoCanEncoder::EncodePGN129808(const NMEA0183 *parser, std::vector<byte> *n
 		// If there is a DSE sentence to follow, we copy this payload and wait for the DSE sentence to arrive,
 		// add the remaining bytes and send
 		if (parser->Dsc.dseExpansion == NMEA0183_BOOLEAN::NTrue) {
-			dseMMSINumber = parser->Dsc.mmsiNumber;
-			dseTimer->Start(2 * CONST_ONE_SECOND, wxTIMER_ONE_SHOT);
-			// Make a copy of the vector and wait till the corresponding DSE sentence is processed
-			dscPayload.clear();
-			dscPayload = *n2kMessage;
-			return FALSE;
-		}
-		else {
-			// Fill out the following fields with "no data"
-			// The following pairs are repeated DSE Expansion fields
-			// Field 21
-			// DSE Expansion Field Symbol
-			byte dseExpansionFieldSymbol = 0xFF;
-			n2kMessage->push_back(dseExpansionFieldSymbol);
-
-			// Field 22
-			n2kMessage->push_back(0x02); // Length of data includes length byte & encoding byte
-			n2kMessage->push_back(0x01); // 01 = ASCII
-
-
-			// Field 23
-			dseExpansionFieldSymbol = 0xFF;
-			n2kMessage->push_back(dseExpansionFieldSymbol);
+			// A repeated call from the same station replaces its pending message, otherwise use a free entry
+			int entry = FindPendingDsc(parser->Dsc.mmsiNumber);
+			if (entry != -1) {
+				ReleasePendingDsc(entry);
+			}
+			else {
+				for (int i = 0; i < CONST_DSC_PENDING_ENTRIES; i++) {
+					if (pendingDscMessages[i].deadline == 0) {
+						entry = i;
+						break;
+					}
+				}
+			}
 
-			// Field 24
-			n2kMessage->push_back(0x02);
-			n2kMessage->push_back(0x01);
+			if (entry != -1) {
+				// Make a copy of the payload and wait till the corresponding DSE sentence is processed
+				pendingDscMessages[entry].mmsiNumber = parser->Dsc.mmsiNumber;
+				pendingDscMessages[entry].payload = *n2kMessage;
+				ArmPendingDsc(entry, TwoCanUtils::GetTimeInMicroseconds() + CONST_DSE_TIMEOUT);
+				return FALSE;
+			}
 
-			return TRUE;
+			// BUG BUG Too many calls awaiting DSE sentences, rather than lose this call send it now without the DSE data
+			wxLogMessage(_T("TwoCan Encoder, DSC table full, sending DSC from %llu without DSE data"), parser->Dsc.mmsiNumber);
 		}
+
+		// Fill out the following fields with "no data"
+		// The following pairs are repeated DSE Expansion fields
+		PutEmptyDseFields(n2kMessage);
+		return TRUE;
 	}
 	return FALSE;
 
 }
 
 // Encode payload for PGN030306 NMEA Waypoint Location
-bool TwoCanEncoder::EncodePGN130074(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130074(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 
 	if (parser->LastSentenceIDParsed == _T("WPL")) {
 
@@ -3157,7 +3185,7 @@ bool TwoCanEncoder::EncodePGN130074(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 130306 NMEA Wind
-bool TwoCanEncoder::EncodePGN130306(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130306(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("MWV")) {
@@ -3181,7 +3209,7 @@ bool TwoCanEncoder::EncodePGN130306(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 130310 NMEA Water & Air Temperature and Pressure
-bool TwoCanEncoder::EncodePGN130310(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130310(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("MTW")) {
@@ -3207,7 +3235,7 @@ bool TwoCanEncoder::EncodePGN130310(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 130311 NMEA Environment
-bool TwoCanEncoder::EncodePGN130311(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130311(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 	
 	if (parser->LastSentenceIDParsed == _T("MTW")) {
@@ -3236,7 +3264,7 @@ bool TwoCanEncoder::EncodePGN130311(const NMEA0183 *parser, std::vector<byte> *n
 
 
 // Encode payload for PGN 130312 NMEA Temperature
-bool TwoCanEncoder::EncodePGN130312(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130312(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("MTW")) {
@@ -3264,7 +3292,7 @@ bool TwoCanEncoder::EncodePGN130312(const NMEA0183 *parser, std::vector<byte> *n
 }
 
 // Encode payload for PGN 130316 NMEA Temperature Extended Range
-bool TwoCanEncoder::EncodePGN130316(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130316(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("MTW")) {
@@ -3290,7 +3318,7 @@ bool TwoCanEncoder::EncodePGN130316(const NMEA0183 *parser, std::vector<byte> *n
 
 // Encode payload for PGN 130577 NMEA Direction Data
 // BUG BUG Work out what to convert this to
-bool TwoCanEncoder::EncodePGN130577(const NMEA0183 *parser, std::vector<byte> *n2kMessage) {
+bool TwoCanEncoder::EncodePGN130577(const NMEA0183 *parser, PayloadWriter *n2kMessage) {
 	n2kMessage->clear();
 
 	if (parser->LastSentenceIDParsed == _T("VDR")) {
@@ -3335,3 +3363,101 @@ bool TwoCanEncoder::EncodePGN130577(const NMEA0183 *parser, std::vector<byte> *n
 	}
 
 }
+
+// Route & waypoint export. Rather than round tripping each waypoint through a NMEA 183 WPL sentence,
+// waypoints are packed directly, as many as will fit, into PGN 130074 Waypoint List and PGN 129285 Route & Waypoint Information payloads
+
+// Route id derived from the OpenCPN GUID, FNV-1a folded to 16 bits
+unsigned short TwoCanEncoder::GetExportRouteId(const wxString& guid) {
+	unsigned int hash = 2166136261U;
+	for (size_t i = 0; i < guid.length(); i++) {
+		hash ^= (unsigned int)guid[i].GetValue();
+		hash *= 16777619U;
+	}
+	return (unsigned short)((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+// Number of bytes a name occupies, length & control byte followed by the (truncated) characters
+size_t TwoCanEncoder::GetExportNameLength(const wxString& name) {
+	return 2 + std::min<size_t>(name.length(), CONST_EXPORT_NAME_LENGTH);
+}
+
+// Text with length & control byte, characters that are not ASCII are replaced
+void TwoCanEncoder::PutExportName(const wxString& name, PayloadWriter *payload) {
+	size_t nameLength = std::min<size_t>(name.length(), CONST_EXPORT_NAME_LENGTH);
+	payload->push_back(nameLength + 2);
+	payload->push_back(0x01); // First byte of the name indicates ASCII or Unicode encoding
+	for (size_t i = 0; i < nameLength; i++) {
+		payload->push_back(name[i].IsAscii() ? (byte)name[i].GetValue() : '?');
+	}
+}
+
+// Waypoint id, name, latitude & longitude, common to both PGN's
+void TwoCanEncoder::PutExportWaypoint(const unsigned short waypointId, const PlugIn_Waypoint *waypoint, PayloadWriter *payload) {
+	payload->PutUInt16(waypointId);
+	PutExportName(waypoint->m_MarkName, payload);
+	payload->PutScaledInt32(waypoint->m_lat, 1e7);
+	payload->PutScaledInt32(waypoint->m_lon, 1e7);
+}
+
+// Number of waypoints, starting at firstWaypoint, that fit into a payload following a header of headerLength bytes.
+// As names are truncated, at least one waypoint always fits.
+size_t TwoCanEncoder::CountExportWaypoints(const std::vector<const PlugIn_Waypoint *>& waypoints, const size_t firstWaypoint, size_t headerLength) {
+	size_t waypointCount = 0;
+	for (size_t i = firstWaypoint; i < waypoints.size(); i++) {
+		headerLength += 2 + GetExportNameLength(waypoints[i]->m_MarkName) + 8;
+		if (headerLength > CONST_MAX_FAST_PACKET_LENGTH) {
+			break;
+		}
+		waypointCount++;
+	}
+	return waypointCount;
+}
+
+// Encode PGN 130074 Waypoint List payloads, waypoint id's are the (one based) position of the waypoint in the list
+size_t TwoCanEncoder::EncodeWaypointLists(const std::vector<const PlugIn_Waypoint *>& waypoints, std::vector<PayloadWriter> *payloads) {
+	size_t messageCount = 0;
+	size_t firstWaypoint = 0;
+	while (firstWaypoint < waypoints.size()) {
+		size_t waypointCount = CountExportWaypoints(waypoints, firstWaypoint, 10);
+		PayloadWriter payload;
+		payload.PutUInt16(firstWaypoint + 1); // Starting waypoint id
+		payload.PutUInt16(waypointCount); // Items
+		payload.PutUInt16(waypointCount); // Valid items
+		payload.PutUInt16(0); // Database id
+		payload.PutUInt16(0xFFFF); // Reserved
+		for (size_t i = firstWaypoint; i < firstWaypoint + waypointCount; i++) {
+			PutExportWaypoint(i + 1, waypoints[i], &payload);
+		}
+		payloads->push_back(payload);
+		firstWaypoint += waypointCount;
+		messageCount++;
+	}
+	return messageCount;
+}
+
+// Encode PGN 129285 Route & Waypoint Information payloads, the route name is repeated in each message
+// and the starting RPS (route point sequence) identifies the first waypoint in each message
+size_t TwoCanEncoder::EncodeRouteInformation(const wxString& routeName, const unsigned short routeId, const std::vector<const PlugIn_Waypoint *>& waypoints, std::vector<PayloadWriter> *payloads) {
+	size_t messageCount = 0;
+	size_t firstWaypoint = 0;
+	size_t headerLength = 9 + GetExportNameLength(routeName) + 1;
+	while (firstWaypoint < waypoints.size()) {
+		size_t waypointCount = CountExportWaypoints(waypoints, firstWaypoint, headerLength);
+		PayloadWriter payload;
+		payload.PutUInt16(firstWaypoint); // Starting RPS
+		payload.PutUInt16(waypointCount); // Items
+		payload.PutUInt16(0); // Database version
+		payload.PutUInt16(routeId);
+		payload.push_back(0x07); // Forward direction, no supplementary data, NMEA reserved
+		PutExportName(routeName, &payload);
+		payload.push_back(0xFF); // NMEA reserved
+		for (size_t i = firstWaypoint; i < firstWaypoint + waypointCount; i++) {
+			PutExportWaypoint(i + 1, waypoints[i], &payload);
+		}
+		payloads->push_back(payload);
+		firstWaypoint += waypointCount;
+		messageCount++;
+	}
+	return messageCount;
+}
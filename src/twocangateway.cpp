@@ -0,0 +1,317 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanGateway - Encodes NMEA 183 sentences off the OpenCPN main thread
+// Owner: twocanplugin@hotmail.com
+// Date: 10/09/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 - 12/09/2022 Echo cancellation of our own sentences, ignored talker id's
+// 1.2 - 14/09/2022 Wake when the next coalesced message is due
+// 1.3 - 22/09/2022 Front end rejects corrupt and unconverted sentences before they are parsed
+
+#include "twocangateway.h"
+
+TwoCanGateway::TwoCanGateway(TwoCanEncoder *encoder, GatewayTransmitFunction transmitFunction) : wxThread(wxTHREAD_JOINABLE) {
+	twoCanEncoder = encoder;
+	transmitFrameSpan = transmitFunction;
+	queueHead = 0;
+	queueTail = 0;
+	droppedSentences = 0;
+	droppedEssentialSentences = 0;
+	highWaterMark = 0;
+	suppressedEchoes = 0;
+	suppressedTalkers = 0;
+	corruptSentences = 0;
+	ignoredSentences = 0;
+	isOverflowing = FALSE;
+	encodedSentences = 0;
+	failedTransmissions = 0;
+	transmitFrames.reserve(CONST_GATEWAY_ARENA_FRAMES);
+	memset(echoFingerprints, 0, sizeof(echoFingerprints));
+	echoIndex = 0;
+	ignoredTalkerCount = 0;
+}
+
+TwoCanGateway::~TwoCanGateway(void) {
+}
+
+// MOB, DSC & DSE sentences, the sentence id follows the '$' and two character talker id
+bool TwoCanGateway::IsEssential(const wxString& sentence) {
+	wxString sentenceId = sentence.Mid(3, 3);
+	return ((sentenceId == _T("MOB")) || (sentenceId == _T("DSC")) || (sentenceId == _T("DSE")));
+}
+
+// FNV-1a, the trailing CR LF is ignored as OpenCPN may or may not have retained it
+unsigned int TwoCanGateway::HashSentence(const wxString& sentence) {
+	size_t length = sentence.length();
+	while ((length > 0) && ((sentence[length - 1] == '\r') || (sentence[length - 1] == '\n'))) {
+		length--;
+	}
+	unsigned int hash = 2166136261U;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned int)sentence[i].GetValue();
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+// A single pass copies the sentence to a narrow buffer, then the checksum and the sentence id are checked on the buffer.
+// Checksums are optional (as they are for the NMEA 0183 parser), but if present must be correct
+bool TwoCanGateway::IsAccepted(const wxString& sentence) {
+	char buffer[CONST_GATEWAY_MAX_SENTENCE];
+	size_t length = 0;
+	bool isCorrupt = FALSE;
+
+	// Copy up to the line terminator, NMEA 0183 is ASCII so anything else is corrupt
+	for (wxString::const_iterator it = sentence.begin(); it != sentence.end(); ++it) {
+		wxUniChar character = *it;
+		if ((character == '\r') || (character == '\n')) {
+			break;
+		}
+		if ((!character.IsAscii()) || (length == CONST_GATEWAY_MAX_SENTENCE)) {
+			isCorrupt = TRUE;
+			break;
+		}
+		buffer[length++] = (char)character.GetValue();
+	}
+
+	if ((!isCorrupt) && ((length < 6) || ((buffer[0] != '$') && (buffer[0] != '!')))) {
+		isCorrupt = TRUE;
+	}
+
+	// Checksum of the characters between the leading '$' or '!' and the '*'
+	size_t index = 1;
+	if (!isCorrupt) {
+		unsigned char checksum = 0;
+		while ((index < length) && (buffer[index] != '*')) {
+			checksum ^= buffer[index];
+			index++;
+		}
+		if (index < length) {
+			if ((index + 2 >= length) || (!isxdigit(buffer[index + 1])) || (!isxdigit(buffer[index + 2]))) {
+				isCorrupt = TRUE;
+			}
+			else {
+				auto hexValue = [](const char digit) { return (digit <= '9') ? digit - '0' : (toupper(digit) - 'A') + 10; };
+				isCorrupt = ((hexValue(buffer[index + 1]) << 4) | hexValue(buffer[index + 2])) != checksum;
+			}
+		}
+	}
+
+	// The sentence id is the last three characters of the address field, eg. GPGGA, proprietary sentences are never converted
+	int sentenceKey = NMEA0183_KEY_UNKNOWN;
+	if (!isCorrupt) {
+		size_t addressEnd = 1;
+		while ((addressEnd < length) && (buffer[addressEnd] != ',') && (buffer[addressEnd] != '*')) {
+			addressEnd++;
+		}
+		if (addressEnd < 4) {
+			isCorrupt = TRUE;
+		}
+		else if (buffer[1] != 'P') {
+			const char *mnemonic = &buffer[addressEnd - 3];
+			if ((isupper(mnemonic[0])) && (isupper(mnemonic[1])) && (isupper(mnemonic[2]))) {
+				sentenceKey = NMEA0183_KEY(mnemonic[0], mnemonic[1], mnemonic[2]);
+			}
+			else {
+				isCorrupt = TRUE;
+			}
+		}
+	}
+
+	if (isCorrupt) {
+		if (corruptSentences++ == 0) {
+			wxLogMessage(_T("TwoCan Gateway, Discarding malformed sentences or sentences with invalid checksums, eg. %s"), sentence);
+		}
+		return FALSE;
+	}
+
+	if (!TwoCanEncoder::IsEncodable(sentenceKey)) {
+		ignoredSentences++;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Fingerprints are written round robin, the oldest is overwritten
+void TwoCanGateway::RecordOutbound(const wxString& sentence) {
+	echoFingerprints[echoIndex].hash = HashSentence(sentence);
+	echoFingerprints[echoIndex].timestamp = TwoCanUtils::GetTimeInMicroseconds();
+	echoIndex = (echoIndex + 1) % CONST_GATEWAY_ECHO_ENTRIES;
+}
+
+// An exact match of a recently sent sentence is an echo, each fingerprint cancels a single echo
+bool TwoCanGateway::IsSuppressed(const wxString& sentence) {
+	if (sentence.length() < 6) {
+		return FALSE;
+	}
+
+	if (ignoredTalkerCount > 0) {
+		unsigned short talkerId = ((sentence[1].GetValue() & 0xFF) << 8) | (sentence[2].GetValue() & 0xFF);
+		for (unsigned int i = 0; i < ignoredTalkerCount; i++) {
+			if (ignoredTalkers[i] == talkerId) {
+				suppressedTalkers++;
+				return TRUE;
+			}
+		}
+	}
+
+	unsigned int hash = HashSentence(sentence);
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+	for (unsigned int i = 0; i < CONST_GATEWAY_ECHO_ENTRIES; i++) {
+		if ((echoFingerprints[i].timestamp != 0) && (echoFingerprints[i].hash == hash) && (now - echoFingerprints[i].timestamp <= CONST_GATEWAY_ECHO_WINDOW)) {
+			echoFingerprints[i].timestamp = 0;
+			if (suppressedEchoes++ == 0) {
+				wxLogMessage(_T("TwoCan Gateway, Discarding echoes of converted NMEA 2000 messages"));
+			}
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Talker id's are two characters, anything else is ignored
+void TwoCanGateway::SetIgnoredTalkers(const wxString& talkerIds) {
+	wxStringTokenizer tokenizer(talkerIds, _T(","));
+	ignoredTalkerCount = 0;
+	while ((tokenizer.HasMoreTokens()) && (ignoredTalkerCount < CONST_GATEWAY_MAX_TALKERS)) {
+		wxString talkerId = tokenizer.GetNextToken().Trim(TRUE).Trim(FALSE).Upper();
+		if (talkerId.length() == 2) {
+			ignoredTalkers[ignoredTalkerCount++] = ((talkerId[0].GetValue() & 0xFF) << 8) | (talkerId[1].GetValue() & 0xFF);
+			wxLogMessage(_T("TwoCan Gateway, Ignoring sentences from talker %s"), talkerId);
+		}
+	}
+}
+
+// Queue a sentence, there is a single producer, the OpenCPN main thread, so only the tail is written here
+int TwoCanGateway::Enqueue(const wxString& sentence) {
+	size_t tail = queueTail.load(std::memory_order_relaxed);
+	size_t depth = tail - queueHead.load(std::memory_order_acquire);
+	bool isEssential = IsEssential(sentence);
+
+	if (depth >= (isEssential ? CONST_GATEWAY_QUEUE_SIZE : CONST_GATEWAY_QUEUE_SIZE - CONST_GATEWAY_RESERVED_SLOTS)) {
+		if (!isOverflowing) {
+			wxLogMessage(_T("TwoCan Gateway, Queue full, discarding sentences"));
+			isOverflowing = TRUE;
+		}
+		droppedSentences++;
+		if (isEssential) {
+			droppedEssentialSentences++;
+		}
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_PLUGIN, TWOCAN_ERROR_GATEWAY_QUEUE_FULL);
+	}
+
+	if (isOverflowing) {
+		wxLogMessage(_T("TwoCan Gateway, Queue resumed, discarded %llu sentences in total"), droppedSentences.load());
+		isOverflowing = FALSE;
+	}
+
+	// The consumer has finished with this slot, publish the sentence by advancing the tail
+	// A deep copy, as wxString may share its data or conversion caches and the sentence crosses threads
+	sentenceQueue[tail & (CONST_GATEWAY_QUEUE_SIZE - 1)] = sentence.Clone();
+	queueTail.store(tail + 1, std::memory_order_release);
+
+	if (depth + 1 > highWaterMark.load(std::memory_order_relaxed)) {
+		highWaterMark.store(depth + 1, std::memory_order_relaxed);
+	}
+
+	queueSemaphore.Post();
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Number of sentences waiting to be encoded
+size_t TwoCanGateway::GetQueueDepth(void) {
+	return queueTail.load(std::memory_order_acquire) - queueHead.load(std::memory_order_acquire);
+}
+
+// Encode a sentence into the frame arena and transmit the frames as a single span
+void TwoCanGateway::EncodeSentence(const wxString& sentence) {
+	transmitFrames.clear();
+	// Nothing to send if the encoder is holding the messages for coalescing
+	if ((twoCanEncoder->EncodeMessage(sentence, &transmitFrames) == TRUE) && (!transmitFrames.empty())) {
+		int returnCode = transmitFrameSpan(transmitFrames.data(), transmitFrames.size());
+		if (returnCode != TWOCAN_RESULT_SUCCESS) {
+			wxLogMessage(_T("TwoCan Gateway, Error sending converted NMEA 183 sentence: %d"), returnCode);
+			failedTransmissions++;
+		}
+	}
+	encodedSentences++;
+}
+
+// A DSC sentence has timed out waiting for a DSE sentence, so we send PGN 129808 without the DSE data,
+// or the window for a coalesced message has closed, so we send its latest value
+void TwoCanGateway::CheckExpiredMessages(void) {
+	transmitFrames.clear();
+	if (twoCanEncoder->EncodeExpiredMessages(&transmitFrames) == TRUE) {
+		int returnCode = transmitFrameSpan(transmitFrames.data(), transmitFrames.size());
+		if (returnCode != TWOCAN_RESULT_SUCCESS) {
+			wxLogMessage(_T("TwoCan Gateway, Error sending expired DSC or coalesced message: %d"), returnCode);
+			failedTransmissions++;
+		}
+	}
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanGateway::Entry() {
+	wxString sentence;
+	size_t head;
+	unsigned long long nextDeadline;
+	unsigned long long now;
+	unsigned long waitInterval;
+
+	while (!TestDestroy()) {
+		// Wake periodically to check whether the thread is being terminated, or sooner if a DSC or coalesced message is due
+		waitInterval = CONST_GATEWAY_POLL_INTERVAL;
+		nextDeadline = twoCanEncoder->GetNextDeadline();
+		if (nextDeadline != 0) {
+			now = TwoCanUtils::GetTimeInMicroseconds();
+			waitInterval = (nextDeadline <= now) ? 0 : (unsigned long)std::min<unsigned long long>(CONST_GATEWAY_POLL_INTERVAL, ((nextDeadline - now) + 999) / 1000);
+		}
+		if (waitInterval > 0) {
+			queueSemaphore.WaitTimeout(waitInterval);
+		}
+
+		// Drain the queue, the slot is emptied and released before encoding so the producer is not held up
+		head = queueHead.load(std::memory_order_relaxed);
+		while (head != queueTail.load(std::memory_order_acquire)) {
+			sentence.clear();
+			sentence.swap(sentenceQueue[head & (CONST_GATEWAY_QUEUE_SIZE - 1)]);
+			head++;
+			queueHead.store(head, std::memory_order_release);
+			EncodeSentence(sentence);
+		}
+
+		CheckExpiredMessages();
+	}
+
+	wxLogMessage(_T("TwoCan Gateway, Encoded sentences: %llu, Failed: %llu, Discarded: %llu (Safety related: %llu), Peak queue depth: %d, Unprocessed: %d"),
+		encodedSentences, failedTransmissions, droppedSentences.load(), droppedEssentialSentences.load(), (int)highWaterMark.load(), (int)GetQueueDepth());
+	wxLogMessage(_T("TwoCan Gateway, Suppressed echoes: %llu, Suppressed talker sentences: %llu, Coalesced messages: %llu"), suppressedEchoes.load(), suppressedTalkers.load(), twoCanEncoder->coalescedMessagesCount);
+	wxLogMessage(_T("TwoCan Gateway, Rejected corrupt sentences: %llu, Rejected unconverted sentences: %llu"), corruptSentences.load(), ignoredSentences.load());
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanGateway::OnExit() {
+	// Nothing to do ??
+}
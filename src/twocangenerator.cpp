@@ -0,0 +1,439 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanGenerator - Synthesises NMEA 2000 traffic for testing without a CAN bus
+// Owner: twocanplugin@hotmail.com
+// Date: 25/08/2022
+// Version History:
+// 1.0 Initial Release
+
+#include "twocangenerator.h"
+
+TwoCanGenerator::TwoCanGenerator(wxMessageQueue<std::vector<byte>> *messageQueue, const int rate, const int targets, const double loss, const double reorder) : TwoCanInterface(messageQueue),
+	randomGenerator(CONST_GENERATOR_SEED), percentDistribution(0.0, 100.0) {
+	generatorRate = (rate > 0) ? rate : CONST_GENERATOR_RATE;
+	frameLoss = loss;
+	frameReorder = reorder;
+	aisTargets.resize((targets < 0) ? 0 : (targets > CONST_GENERATOR_MAX_TARGETS) ? CONST_GENERATOR_MAX_TARGETS : targets);
+	memset(sequenceIds, 0, sizeof(sequenceIds));
+	frameHeld = false;
+	generatedFrames = 0;
+	discardedFrames = 0;
+	reorderedFrames = 0;
+}
+
+TwoCanGenerator::~TwoCanGenerator() {
+// Nothing to do in the destructor ??
+}
+
+// Build the schedule of periodic messages, intervals are those typically observed on a network
+int TwoCanGenerator::Open(const wxString& portName) {
+	randomGenerator.seed(CONST_GENERATOR_SEED);
+	schedule.clear();
+
+	latitude = CONST_GENERATOR_LATITUDE;
+	longitude = CONST_GENERATOR_LONGITUDE;
+	heading = 45;
+	speed = 6;
+
+	AddSchedule(129029, CONST_GENERATOR_GNSS_ADDRESS, CONST_PRIORITY_HIGH, 1000);
+	AddSchedule(127250, CONST_GENERATOR_COMPASS_ADDRESS, CONST_PRIORITY_VERY_HIGH, 100);
+	AddSchedule(130306, CONST_GENERATOR_WIND_ADDRESS, CONST_PRIORITY_VERY_HIGH, 100);
+	AddSchedule(128267, CONST_GENERATOR_DEPTH_ADDRESS, CONST_PRIORITY_HIGH, 1000);
+	AddSchedule(127488, CONST_GENERATOR_ENGINE_ADDRESS, CONST_PRIORITY_VERY_HIGH, 100);
+	AddSchedule(127489, CONST_GENERATOR_ENGINE_ADDRESS, CONST_PRIORITY_VERY_HIGH, 500);
+
+	for (byte source = CONST_GENERATOR_GNSS_ADDRESS; source <= CONST_GENERATOR_AIS_ADDRESS; source++) {
+		AddSchedule(60928, source, CONST_PRIORITY_MEDIUM, 60000);
+	}
+
+	// Every fourth target is a Class B transceiver, the remainder Class A which also report static & voyage data
+	for (size_t i = 0; i < aisTargets.size(); i++) {
+		GeneratorTarget *target = &aisTargets[i];
+		target->mmsi = 503000000 + i;
+		target->isClassB = ((i % 4) == 3);
+		target->range = 0.5 + percentDistribution(randomGenerator) / 10;
+		target->bearing = percentDistribution(randomGenerator) * 3.6;
+		target->course = percentDistribution(randomGenerator) * 3.6;
+		target->speed = percentDistribution(randomGenerator) / 5;
+		if (target->isClassB) {
+			AddSchedule(129039, CONST_GENERATOR_AIS_ADDRESS, CONST_PRIORITY_LOW, 5000, i);
+		}
+		else {
+			AddSchedule(129038, CONST_GENERATOR_AIS_ADDRESS, CONST_PRIORITY_LOW, 2000, i);
+			AddSchedule(129794, CONST_GENERATOR_AIS_ADDRESS, CONST_PRIORITY_MEDIUM, 60000, i);
+		}
+	}
+
+	wxLogMessage(_T("TwoCan Generator, Rate %d%%, %u AIS targets, frame loss %.2f%%, reordering %.2f%%"),
+		generatorRate, (unsigned int)aisTargets.size(), frameLoss, frameReorder);
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+int TwoCanGenerator::Close(void) {
+	wxLogMessage(_T("TwoCan Generator, Generated %llu frames, discarded %llu, reordered %llu"), generatedFrames, discardedFrames, reorderedFrames);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// The first occurrence is staggered randomly within the interval, so that messages do not all fall due together
+void TwoCanGenerator::AddSchedule(const unsigned int pgn, const byte source, const byte priority, const unsigned int interval, const int target) {
+	GeneratorSchedule entry;
+	entry.pgn = pgn;
+	entry.source = source;
+	entry.priority = priority;
+	entry.interval = ((unsigned long long)interval * 1000 * 100) / generatorRate;
+	entry.nextDue = (unsigned long long)(percentDistribution(randomGenerator) * entry.interval / 100);
+	entry.target = target;
+	schedule.push_back(entry);
+}
+
+// Sails a gently weaving course, with targets drifting around us
+void TwoCanGenerator::UpdateVessel(const unsigned long long now) {
+	double elapsed = (now - startTime) / 1e6;
+	heading = 45 + (10 * sin(elapsed / 60));
+	speed = 6 + sin(elapsed / 300);
+	double distance = (speed / 3600) * ((now - updateTime) / 1e6);
+	updateTime = now;
+	latitude = latitude + (distance / 60) * cos(DEGREES_TO_RADIANS(heading));
+	longitude = longitude + (distance / 60) * sin(DEGREES_TO_RADIANS(heading)) / cos(DEGREES_TO_RADIANS(latitude));
+}
+
+unsigned int TwoCanGenerator::EncodePayload(const GeneratorSchedule *entry, byte *payload) {
+	unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+	double elapsed = (now - startTime) / 1e6;
+	unsigned int payloadLength = 0;
+	byte sid = (byte)(now / 100000);
+	int value;
+	long long position;
+
+	switch (entry->pgn) {
+
+	case 60928: { // ISO Address Claim
+		unsigned int uniqueNumber = 0x1F0000 + entry->source;
+		value = uniqueNumber | (CONST_MANUFACTURER_CODE << 21);
+		TwoCanUtils::ConvertIntegerToByteArray(value, &payload[0]);
+		payload[4] = 0; // Device Instance
+		payload[5] = CONST_DEVICE_FUNCTION;
+		payload[6] = CONST_DEVICE_CLASS << 1;
+		payload[7] = 0x80 | (CONST_MARINE_INDUSTRY << 4); // Arbitrary Address Capable
+		payloadLength = 8;
+		break;
+	}
+
+	case 127250: // Vessel Heading, magnetic
+		payload[0] = sid;
+		value = (int)(DEGREES_TO_RADIANS(heading) * 10000);
+		payload[1] = value & 0xFF;
+		payload[2] = (value >> 8) & 0xFF;
+		payload[3] = 0xFF; // Deviation not available
+		payload[4] = 0x7F;
+		payload[5] = 0xFF; // Variation not available
+		payload[6] = 0x7F;
+		payload[7] = 0xFD; // Magnetic
+		payloadLength = 8;
+		break;
+
+	case 130306: // Wind, apparent
+		payload[0] = sid;
+		value = (int)((12 + (3 * sin(elapsed / 10))) * 100);
+		payload[1] = value & 0xFF;
+		payload[2] = (value >> 8) & 0xFF;
+		value = (int)(DEGREES_TO_RADIANS(40 + (5 * sin(elapsed / 7))) * 10000);
+		payload[3] = value & 0xFF;
+		payload[4] = (value >> 8) & 0xFF;
+		payload[5] = 0xFA; // Apparent
+		payload[6] = 0xFF;
+		payload[7] = 0xFF;
+		payloadLength = 8;
+		break;
+
+	case 128267: // Water Depth
+		payload[0] = sid;
+		value = (int)((15 + (5 * sin(elapsed / 120))) * 100);
+		TwoCanUtils::ConvertIntegerToByteArray(value, &payload[1]);
+		payload[5] = 0xF4; // Offset -0.5 metres
+		payload[6] = 0x01;
+		payload[7] = 0xFF;
+		payloadLength = 8;
+		break;
+
+	case 127488: // Engine Parameters, Rapid
+		payload[0] = 0; // Engine Instance
+		value = (int)((2200 + (50 * sin(elapsed))) * 4);
+		payload[1] = value & 0xFF;
+		payload[2] = (value >> 8) & 0xFF;
+		payload[3] = 0xFF;
+		payload[4] = 0xFF;
+		payload[5] = 0x7F;
+		payload[6] = 0xFF;
+		payload[7] = 0xFF;
+		payloadLength = 8;
+		break;
+
+	case 127489: // Engine Parameters, Dynamic
+		memset(payload, 0xFF, 26);
+		payload[0] = 0; // Engine Instance
+		value = 3500; // Oil pressure, 350 kPa
+		payload[1] = value & 0xFF;
+		payload[2] = (value >> 8) & 0xFF;
+		value = (int)((CONST_KELVIN + 85) * 100); // Engine temperature
+		payload[5] = value & 0xFF;
+		payload[6] = (value >> 8) & 0xFF;
+		value = 1420; // Alternator, 14.2 Volts
+		payload[7] = value & 0xFF;
+		payload[8] = (value >> 8) & 0xFF;
+		TwoCanUtils::ConvertIntegerToByteArray(3600 * 1250 + (int)elapsed, &payload[11]); // Engine hours
+		payload[20] = 0; // Status
+		payload[21] = 0;
+		payload[22] = 0;
+		payload[23] = 0;
+		payload[24] = 60; // Load
+		payload[25] = 55; // Torque
+		payloadLength = 26;
+		break;
+
+	case 129029: { // GNSS Position
+		memset(payload, 0xFF, 43);
+		payload[0] = sid;
+		unsigned short daysSinceEpoch = (unsigned short)(now / 1000000 / 86400);
+		unsigned int secondsSinceMidnight = (unsigned int)(((now / 1000000) % 86400) * 10000);
+		payload[1] = daysSinceEpoch & 0xFF;
+		payload[2] = (daysSinceEpoch >> 8) & 0xFF;
+		TwoCanUtils::ConvertIntegerToByteArray(secondsSinceMidnight, &payload[3]);
+		position = (long long)(latitude * 1e16);
+		for (int i = 0; i < 8; i++) {
+			payload[7 + i] = (position >> (i * 8)) & 0xFF;
+		}
+		position = (long long)(longitude * 1e16);
+		for (int i = 0; i < 8; i++) {
+			payload[15 + i] = (position >> (i * 8)) & 0xFF;
+		}
+		memset(&payload[23], 0, 8); // Altitude
+		payload[31] = 0x11; // GNSS Fix, GPS
+		payload[32] = 0xFC; // Integrity, no checking
+		payload[33] = 9; // Satellites
+		payload[34] = 90; // HDOP 0.9
+		payload[35] = 0;
+		payload[36] = 160; // PDOP 1.6
+		payload[37] = 0;
+		payload[38] = 0; // Geoidal separation
+		payload[39] = 0;
+		payload[40] = 0; // Reference stations
+		payloadLength = 43;
+		break;
+	}
+
+	case 129038: // AIS Class A Position Report
+	case 129039: { // AIS Class B Position Report
+		GeneratorTarget *target = &aisTargets[entry->target];
+		double bearing = DEGREES_TO_RADIANS(target->bearing + (elapsed * target->speed / 60));
+		double targetLatitude = latitude + (target->range / 60) * cos(bearing);
+		double targetLongitude = longitude + (target->range / 60) * sin(bearing) / cos(DEGREES_TO_RADIANS(latitude));
+		memset(payload, 0xFF, 28);
+		payload[0] = (entry->pgn == 129038) ? 1 : 18; // Message Id
+		TwoCanUtils::ConvertIntegerToByteArray(target->mmsi, &payload[1]);
+		TwoCanUtils::ConvertIntegerToByteArray((int)(targetLongitude * 1e7), &payload[5]);
+		TwoCanUtils::ConvertIntegerToByteArray((int)(targetLatitude * 1e7), &payload[9]);
+		payload[13] = 0x01 | ((((now / 1000000) % 60) & 0x3F) << 2);
+		value = (int)(DEGREES_TO_RADIANS(target->course) * 10000);
+		payload[14] = value & 0xFF;
+		payload[15] = (value >> 8) & 0xFF;
+		value = (int)((target->speed / CONVERT_MS_KNOTS) * 100);
+		payload[16] = value & 0xFF;
+		payload[17] = (value >> 8) & 0xFF;
+		payload[18] = 0; // Communication State
+		payload[19] = 0;
+		payload[20] = 0;
+		payload[21] = payload[14]; // True Heading
+		payload[22] = payload[15];
+		if (entry->pgn == 129038) {
+			payload[23] = 0; // Rate of Turn
+			payload[24] = 0;
+			payload[25] = 0; // Under way using engine
+			payload[26] = 0;
+			payload[27] = 0;
+			payloadLength = 28;
+		}
+		else {
+			payload[23] = 0;
+			payload[24] = 0x74; // Unit, DSC, Band, Message 22 flags
+			payload[25] = 0x00;
+			payloadLength = 27;
+		}
+		break;
+	}
+
+	case 129794: { // AIS Class A Static and Voyage Related Data
+		GeneratorTarget *target = &aisTargets[entry->target];
+		memset(payload, 0x20, 75);
+		payload[0] = 5; // Message Id
+		TwoCanUtils::ConvertIntegerToByteArray(target->mmsi, &payload[1]);
+		TwoCanUtils::ConvertIntegerToByteArray(9000000 + entry->target, &payload[5]); // IMO Number
+		char text[21];
+		int textLength = snprintf(text, sizeof(text), "VK%04d", entry->target);
+		memcpy(&payload[9], text, std::min(textLength, 7));
+		textLength = snprintf(text, sizeof(text), "TARGET %d", entry->target);
+		memcpy(&payload[16], text, std::min(textLength, 20));
+		payload[36] = 70; // Cargo vessel
+		payload[37] = 0xE8; // Length 100 metres
+		payload[38] = 0x03;
+		payload[39] = 0xC8; // Beam 20 metres
+		payload[40] = 0x00;
+		payload[41] = 0x64; // 10 metres from starboard
+		payload[42] = 0x00;
+		payload[43] = 0x20; // 80 metres from bow
+		payload[44] = 0x03;
+		payload[45] = 0xFF; // ETA not available
+		payload[46] = 0xFF;
+		payload[47] = 0xFF;
+		payload[48] = 0xFF;
+		payload[49] = 0xFF;
+		payload[50] = 0xFF;
+		payload[51] = 0x58; // Draft 6 metres
+		payload[52] = 0x02;
+		memcpy(&payload[53], "SYDNEY", 6);
+		payload[73] = 0x04; // GPS
+		payload[74] = 0;
+		payloadLength = 75;
+		break;
+	}
+
+	}
+
+	return payloadLength;
+}
+
+// Fast messages are fragmented as per FragmentFastMessage, the sequence identifier is maintained per source
+void TwoCanGenerator::AppendMessage(const GeneratorSchedule *entry, const byte *payload, const unsigned int payloadLength, std::vector<byte> *postedFrames) {
+	CanHeader header;
+	unsigned int id;
+	byte frame[CONST_FRAME_LENGTH];
+
+	header.pgn = entry->pgn;
+	header.source = entry->source;
+	header.destination = CONST_GLOBAL_ADDRESS;
+	header.priority = entry->priority;
+	TwoCanUtils::EncodeCanHeader(&id, &header);
+	TwoCanUtils::ConvertIntegerToByteArray(id, &frame[0]);
+
+	if (!TwoCanUtils::IsFastMessage(entry->pgn)) {
+		memset(&frame[CONST_HEADER_LENGTH], 0xFF, CONST_PAYLOAD_LENGTH);
+		memcpy(&frame[CONST_HEADER_LENGTH], payload, std::min(payloadLength, (unsigned int)CONST_PAYLOAD_LENGTH));
+		AppendFrame(frame, postedFrames);
+		return;
+	}
+
+	sequenceIds[entry->source] = TwoCanUtils::GenerateID(sequenceIds[entry->source]);
+	byte sid = sequenceIds[entry->source];
+
+	// The first frame, 6 bytes of data
+	frame[CONST_HEADER_LENGTH] = sid;
+	frame[CONST_HEADER_LENGTH + 1] = payloadLength;
+	memcpy(&frame[CONST_HEADER_LENGTH + 2], payload, 6);
+	AppendFrame(frame, postedFrames);
+
+	// Subsequent frames, 7 bytes of data
+	for (unsigned int offset = 6; offset < payloadLength; offset += 7) {
+		sid += 1;
+		frame[CONST_HEADER_LENGTH] = sid;
+		memset(&frame[CONST_HEADER_LENGTH + 1], 0xFF, 7);
+		memcpy(&frame[CONST_HEADER_LENGTH + 1], &payload[offset], std::min(payloadLength - offset, 7U));
+		AppendFrame(frame, postedFrames);
+	}
+}
+
+// Frames may be discarded, or held back and appended after the following frame
+void TwoCanGenerator::AppendFrame(const byte *frame, std::vector<byte> *postedFrames) {
+	generatedFrames++;
+
+	if ((frameLoss > 0) && (percentDistribution(randomGenerator) < frameLoss)) {
+		discardedFrames++;
+		return;
+	}
+
+	if ((!frameHeld) && (frameReorder > 0) && (percentDistribution(randomGenerator) < frameReorder)) {
+		memcpy(heldFrame, frame, CONST_FRAME_LENGTH);
+		frameHeld = true;
+		reorderedFrames++;
+		return;
+	}
+
+	postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+
+	if (frameHeld) {
+		postedFrames->insert(postedFrames->end(), heldFrame, heldFrame + CONST_FRAME_LENGTH);
+		frameHeld = false;
+	}
+}
+
+// Every tick, encode the messages that have fallen due and post them as a single batch
+void TwoCanGenerator::Read() {
+	byte payload[CONST_MAX_FAST_PACKET_LENGTH];
+	std::vector<byte> postedFrames;
+	unsigned long long elapsed;
+
+	startTime = TwoCanUtils::GetTimeInMicroseconds();
+	updateTime = startTime;
+
+	while (!TestDestroy()) {
+
+		unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+		elapsed = now - startTime;
+
+		UpdateVessel(now);
+
+		for (auto it = schedule.begin(); it != schedule.end(); ++it) {
+			if (elapsed >= it->nextDue) {
+				unsigned int payloadLength = EncodePayload(&(*it), payload);
+				AppendMessage(&(*it), payload, payloadLength, &postedFrames);
+				it->nextDue += it->interval;
+				// If we have fallen behind, don't attempt to catch up
+				if (it->nextDue < elapsed) {
+					it->nextDue = elapsed + it->interval;
+				}
+			}
+		}
+
+		if (postedFrames.size() > 0) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+
+		// Wait for the next tick
+		unsigned long long processing = TwoCanUtils::GetTimeInMicroseconds() - now;
+		if (processing < CONST_GENERATOR_TICK * 1000) {
+			wxMicroSleep((CONST_GENERATOR_TICK * 1000) - processing);
+		}
+	}
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanGenerator::Entry() {
+	// Merely loops continuously generating frames
+	Read();
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanGenerator::OnExit() {
+	// Nothing to do ??
+}
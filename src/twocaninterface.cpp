@@ -24,6 +24,9 @@
 // Date: 10/5/2020
 // Version History: 
 // 1.8 Initial Release, Mac OSX support
+// 2.0 - 05/08/2022 Batched writes, transmit queue depth
+// 2.1 - 20/08/2022 Interrupt, to wake adapters blocked waiting for data
+// 2.2 - 28/09/2022 Number of CAN interfaces served by the adapter
 //
 
 #include <twocaninterface.h>
@@ -68,6 +71,34 @@ int TwoCanInterface::Write(const unsigned int canId, const unsigned char payload
 	return TWOCAN_RESULT_SUCCESS;
 }
 
+// Write a batch of frames, adapters that support batched transmission override this
+int TwoCanInterface::WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten) {
+	int returnCode = TWOCAN_RESULT_SUCCESS;
+	*framesWritten = 0;
+	for (size_t i = 0; i < frameCount; i++) {
+		returnCode = Write(frames[i].id, CONST_PAYLOAD_LENGTH, frames[i].data);
+		if (returnCode != TWOCAN_RESULT_SUCCESS) {
+			break;
+		}
+		*framesWritten += 1;
+	}
+	return returnCode;
+}
+
+// Data queued within the adapter awaiting transmission, zero if unknown
+int TwoCanInterface::GetTransmitQueueDepth(void) {
+	return 0;
+}
+
+// Most adapters serve a single CAN interface
+int TwoCanInterface::GetInterfaceCount(void) {
+	return 1;
+}
+
+// Wake a blocked Read, adapters that poll check TestDestroy and need do nothing
+void TwoCanInterface::Interrupt(void) {
+}
+
 // Generate a 29bit Unique number, using random numbers and a pairing function
 int TwoCanInterface::GetUniqueNumber(unsigned long *uniqueNumber) {
 	srand(CONST_PRODUCT_CODE);
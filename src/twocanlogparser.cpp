@@ -0,0 +1,351 @@
+// Copyright(C) 2018-2021 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanLogParser - Parses the different text log file formats
+// Owner: twocanplugin@hotmail.com
+// Date: 10/01/2022
+// Version History: 
+// 1.0 Initial Release, replaces the regular expressions previously used by the log file reader
+// 1.1 - 28/08/2022 Actisense N2K ASCII messages, used by the network gateway adapter
+
+#include "twocanlogparser.h"
+
+const byte TwoCanLogParser::hexTable[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// Parse an unsigned decimal number, advancing the cursor past the digits
+bool TwoCanLogParser::ScanDecimal(const char **cursor, const char *end, unsigned int *value) {
+	const char *p = *cursor;
+	unsigned int result = 0;
+	while ((p < end) && ((unsigned)(*p - '0') < 10)) {
+		result = (result * 10) + (*p - '0');
+		p++;
+	}
+	if (p == *cursor) {
+		return false;
+	}
+	*value = result;
+	*cursor = p;
+	return true;
+}
+
+// Parse an unsigned hexadecimal number, advancing the cursor past the digits
+bool TwoCanLogParser::ScanHex(const char **cursor, const char *end, unsigned int *value) {
+	const char *p = *cursor;
+	unsigned int result = 0;
+	while ((p < end) && (hexTable[(byte)*p] != 0xFF)) {
+		result = (result << 4) | hexTable[(byte)*p];
+		p++;
+	}
+	if ((p == *cursor) || (p - *cursor > 8)) {
+		return false;
+	}
+	*value = result;
+	*cursor = p;
+	return true;
+}
+
+// Skip past the next occurrence of the delimiter
+bool TwoCanLogParser::SkipPast(const char **cursor, const char *end, const char delimiter) {
+	const char *p = (const char *)memchr(*cursor, delimiter, end - *cursor);
+	if (p == NULL) {
+		return false;
+	}
+	*cursor = p + 1;
+	return true;
+}
+
+// The template uses '9' to indicate any digit, all other characters must match exactly
+bool TwoCanLogParser::MatchTemplate(const char *line, const size_t length, const char *pattern) {
+	size_t i;
+	for (i = 0; pattern[i] != '\0'; i++) {
+		if (i >= length) {
+			return false;
+		}
+		if (pattern[i] == '9') {
+			if ((unsigned)(line[i] - '0') > 9) {
+				return false;
+			}
+		}
+		else if (line[i] != pattern[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int TwoCanLogParser::DetectFormat(const char *line, const size_t length) {
+	byte frame[CONST_FRAME_LENGTH];
+	if (ParseTwoCan(line, length, frame)) {
+		return TwoCanRaw;
+	}
+	if (ParseCanDump(line, length, frame)) {
+		return CanDump;
+	}
+	if (ParseKees(line, length, frame)) {
+		return Kees;
+	}
+	if (ParseYachtDevices(line, length, frame)) {
+		return YachtDevices;
+	}
+	return Undefined;
+}
+
+bool TwoCanLogParser::ParseLine(const int format, const char *line, const size_t length, byte *frame) {
+	switch (format) {
+		case TwoCanRaw:
+			return ParseTwoCan(line, length, frame);
+		case CanDump:
+			return ParseCanDump(line, length, frame);
+		case Kees:
+			return ParseKees(line, length, frame);
+		case YachtDevices:
+			return ParseYachtDevices(line, length, frame);
+		default:
+			return false;
+	}
+}
+
+// 0x01,0x01,0xF8,0x09,0x64,0xD9,0xDF,0x19,0xC7,0xB9,0x0A,0x08
+// Fixed width, each byte occupies 5 characters (including the comma separator)
+bool TwoCanLogParser::ParseTwoCan(const char *line, const size_t length, byte *frame) {
+	if (length < (CONST_FRAME_LENGTH * 5) - 1) {
+		return false;
+	}
+	const char *p = line;
+	for (int i = 0; i < CONST_FRAME_LENGTH; i++) {
+		if ((p[0] != '0') || ((p[1] | 0x20) != 'x') || (!DecodeHexByte(&p[2], &frame[i]))) {
+			return false;
+		}
+		if ((i < CONST_FRAME_LENGTH - 1) && (p[4] != ',')) {
+			return false;
+		}
+		p += 5;
+	}
+	return true;
+}
+
+// (1542794024.886119) can0 09F50303#030000FFFF00FFFF
+// Fix included for V2.0 supports matching of slcan, vcan or can
+bool TwoCanLogParser::ParseCanDump(const char *line, const size_t length, byte *frame) {
+	const char *p = line;
+	const char *end = line + length;
+	unsigned int timestamp;
+
+	if ((length == 0) || (*p++ != '(')) {
+		return false;
+	}
+	// Timestamp, seconds.microseconds
+	if ((!ScanDecimal(&p, end, &timestamp)) || (p >= end) || (*p++ != '.')) {
+		return false;
+	}
+	if ((!ScanDecimal(&p, end, &timestamp)) || (p >= end) || (*p++ != ')')) {
+		return false;
+	}
+	if ((p >= end) || (*p++ != ' ')) {
+		return false;
+	}
+	// Interface name, eg. can0, vcan0, slcan0
+	if (!SkipPast(&p, end, ' ')) {
+		return false;
+	}
+	// 29 bit CAN Id, always 8 hex characters for extended frames
+	if ((end - p) < 9) {
+		return false;
+	}
+	byte id[4];
+	for (int i = 0; i < 4; i++) {
+		if (!DecodeHexByte(&p[i * 2], &id[3 - i])) {
+			return false;
+		}
+	}
+	p += 8;
+	if (*p++ != '#') {
+		return false;
+	}
+	memcpy(&frame[0], &id[0], CONST_HEADER_LENGTH);
+	// Payload, pad any unused bytes as per NMEA 2000 convention
+	int i;
+	for (i = 0; (i < CONST_PAYLOAD_LENGTH) && ((end - p) >= 2); i++) {
+		if (!DecodeHexByte(p, &frame[CONST_HEADER_LENGTH + i])) {
+			break;
+		}
+		p += 2;
+	}
+	if (i == 0) {
+		return false;
+	}
+	memset(&frame[CONST_HEADER_LENGTH + i], 0xFF, CONST_PAYLOAD_LENGTH - i);
+	return true;
+}
+
+// 2009-06-18Z09:46:01.129,2,127251,1,255,8,ff,ff,ff,ff,ff,ff,ff,ff
+// Parses both Kees format from Canboat and Raw format from SignalK Server
+// Only difference is the header/date time fields, the remaining fields are the same
+bool TwoCanLogParser::ParseKees(const char *line, const size_t length, byte *frame) {
+	const char *p = line;
+	const char *end = line + length;
+	
+	// SignalK prefixes the Kees format with a millisecond timestamp and an 'A'
+	if (MatchTemplate(p, end - p, "9999999999999;A;")) {
+		p += 16;
+	}
+	
+	if ((!MatchTemplate(p, end - p, "9999-99-99")) || ((end - p) < 11) || ((p[10] != 'T') && (p[10] != 'Z'))) {
+		return false;
+	}
+	
+	if (!SkipPast(&p, end, ',')) {
+		return false;
+	}
+	
+	// priority, pgn, source, destination, length
+	unsigned int fields[5];
+	for (int i = 0; i < 5; i++) {
+		if ((!ScanDecimal(&p, end, &fields[i])) || (p >= end) || (*p++ != ',')) {
+			return false;
+		}
+	}
+	
+	if ((fields[0] > 7) || (fields[1] > 0x1FFFF) || (fields[2] > 255) || (fields[3] > 255) || (fields[4] > CONST_PAYLOAD_LENGTH)) {
+		return false;
+	}
+	
+	CanHeader header;
+	header.priority = fields[0];
+	header.pgn = fields[1];
+	header.source = fields[2];
+	header.destination = fields[3];
+	
+	unsigned int id;
+	TwoCanUtils::EncodeCanHeader(&id, &header);
+	memcpy(&frame[0], &id, CONST_HEADER_LENGTH);
+	
+	// Comma separated payload
+	for (unsigned int i = 0; i < fields[4]; i++) {
+		if (((end - p) < 2) || (!DecodeHexByte(p, &frame[CONST_HEADER_LENGTH + i]))) {
+			return false;
+		}
+		p += 2;
+		if ((i < fields[4] - 1) && ((p >= end) || (*p++ != ','))) {
+			return false;
+		}
+	}
+	memset(&frame[CONST_HEADER_LENGTH + fields[4]], 0xFF, CONST_PAYLOAD_LENGTH - fields[4]);
+	return true;
+}
+
+// 09:06:35.596 R 09F80203 FF FC 43 1E 00 00 FF FF
+bool TwoCanLogParser::ParseYachtDevices(const char *line, const size_t length, byte *frame) {
+	const char *p = line;
+	const char *end = line + length;
+	
+	if (!MatchTemplate(p, length, "99:99:99.999 R ")) {
+		return false;
+	}
+	p += 15;
+	
+	// 29 bit CAN Id
+	if ((end - p) < 8) {
+		return false;
+	}
+	byte id[4];
+	for (int i = 0; i < 4; i++) {
+		if (!DecodeHexByte(&p[i * 2], &id[3 - i])) {
+			return false;
+		}
+	}
+	p += 8;
+	memcpy(&frame[0], &id[0], CONST_HEADER_LENGTH);
+	
+	// Space separated payload
+	int i;
+	for (i = 0; (i < CONST_PAYLOAD_LENGTH) && ((end - p) >= 3) && (*p == ' '); i++) {
+		if (!DecodeHexByte(&p[1], &frame[CONST_HEADER_LENGTH + i])) {
+			return false;
+		}
+		p += 3;
+	}
+	if (i == 0) {
+		return false;
+	}
+	memset(&frame[CONST_HEADER_LENGTH + i], 0xFF, CONST_PAYLOAD_LENGTH - i);
+	return true;
+}
+
+// A173321.107 23FF7 1F513 012F3070002F30709F
+// Timestamp (hhmmss.ddd), source, destination & priority (SSDDP), PGN and the data bytes without separators
+bool TwoCanLogParser::ParseActisense(const char *line, const size_t length, CanHeader *header, byte *payload, unsigned int *payloadLength) {
+	const char *p = line;
+	const char *end = line + length;
+	unsigned int value;
+
+	if (!MatchTemplate(p, length, "A999999.999 ")) {
+		return false;
+	}
+	p += 12;
+
+	// Source, Destination & Priority
+	if (((end - p) < 6) || (p[5] != ' ')) {
+		return false;
+	}
+	if ((!DecodeHexByte(&p[0], &header->source)) || (!DecodeHexByte(&p[2], &header->destination)) || (hexTable[(byte)p[4]] > 7)) {
+		return false;
+	}
+	header->priority = hexTable[(byte)p[4]];
+	p += 6;
+
+	// PGN
+	if ((!ScanHex(&p, end, &value)) || (value > 0x1FFFF) || (p >= end) || (*p++ != ' ')) {
+		return false;
+	}
+	header->pgn = value;
+
+	// Data, pairs of hex characters
+	unsigned int i;
+	for (i = 0; ((end - p) >= 2) && (i < CONST_MAX_FAST_PACKET_LENGTH); i++) {
+		if (!DecodeHexByte(p, &payload[i])) {
+			break;
+		}
+		p += 2;
+	}
+	if (i == 0) {
+		return false;
+	}
+	*payloadLength = i;
+	return true;
+}
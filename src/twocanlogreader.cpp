@@ -27,15 +27,16 @@
 // 1.8 - 10/05/2020 Derived from abstract class, support for Mac OSX
 // 2.0 - 04-07-2921 Support slcan, vcan and can socketCAN interfaces in log file
 // 2.1 - 20-12-2021 Support SignalK Server Raw Log Files
+// 2.2 - 10-01-2022 Replace regular expressions with hand written parsers, sample several lines to detect format
+// 2.3 - 12-01-2022 Memory mapped file access, supports log files larger than physical memory
+// 2.4 - 28-09-2022 Discard lines longer than the line buffer rather than parsing the fragments
 
 #include <twocanlogreader.h>
 
 TwoCanLogReader::TwoCanLogReader(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
-	// Initialize the different log file format regular expressions
-	//KeesRegex.assign(CONST_KEES_REGEX);
-	//TwoCanRegex.assign(CONST_TWOCAN_REGEX);
-	//CanDumpRegex.assign(CONST_CANDUMP_REGEX);
-	//YachtDevicesRegex.assign(CONST_YACHTDEVICES_REGEX);
+	logFileFormat = Undefined;
+	readOffset = 0;
+	malformedLines = 0;
 }
 
 TwoCanLogReader::~TwoCanLogReader() {
@@ -48,183 +49,112 @@ int TwoCanLogReader::Open(const wxString& fileName) {
 	
 	wxLogMessage(_T("TwoCan LogReader, Opening log file: %s"),logFileName);
 	
-	logFileStream.open(logFileName, std::ifstream::in);	
-
-	if (logFileStream.fail()) {
-		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_FILE_NOT_FOUND);
+	int returnCode = logFile.Open(logFileName);
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		return returnCode;
 	}
 	
 	// Test the log file format
-	std::string line;
-	getline(logFileStream, line);
-	logFileFormat = TestFormat(line);
+	logFileFormat = TestFormat();
 	if (logFileFormat == Undefined) {
 		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
 	}
 	
 	// If a valid format, rewind to the beginning and return SUCCESS
-	logFileStream.clear();
-	logFileStream.seekg(0, std::ios::beg); 
+	readOffset = 0;
 	
 	wxLogMessage(_T("TwoCan LogReader, File opened, Log File Format: %u"),logFileFormat);
 	return TWOCAN_RESULT_SUCCESS;
 }
 
 int TwoCanLogReader::Close(void) {
-	if (logFileStream.is_open()) {
-		logFileStream.close();
-		wxLogMessage(_T("TwoCan LogReader, Log File closed"));
+	if (logFile.IsOpen()) {
+		logFile.Close();
+		wxLogMessage(_T("TwoCan LogReader, Log File closed, discarded %llu overlong lines"), malformedLines);
 	}
 	return TWOCAN_RESULT_SUCCESS;
 }
 
-void TwoCanLogReader::ParseTwoCan(std::string str) {
-	if (twoCanRegEx.Matches(str,wxRE_DEFAULT)) {
-	// BUG BUG I'm sure strtok is more efficient !!
-		canFrame[0] = std::strtoul(twoCanRegEx.GetMatch(str,1), NULL, 16);
-		canFrame[1] = std::strtoul(twoCanRegEx.GetMatch(str,2), NULL, 16);
-		canFrame[2] = std::strtoul(twoCanRegEx.GetMatch(str,3), NULL, 16);
-		canFrame[3] = std::strtoul(twoCanRegEx.GetMatch(str,4), NULL, 16);
-		canFrame[4] = std::strtoul(twoCanRegEx.GetMatch(str,5), NULL, 16);
-		canFrame[5] = std::strtoul(twoCanRegEx.GetMatch(str,6), NULL, 16);
-		canFrame[6] = std::strtoul(twoCanRegEx.GetMatch(str,7), NULL, 16);
-		canFrame[7] = std::strtoul(twoCanRegEx.GetMatch(str,8), NULL, 16);
-		canFrame[8] = std::strtoul(twoCanRegEx.GetMatch(str,9), NULL, 16);
-		canFrame[9] = std::strtoul(twoCanRegEx.GetMatch(str,10), NULL, 16);
-		canFrame[10] = std::strtoul(twoCanRegEx.GetMatch(str,11), NULL, 16);
-		canFrame[11] = std::strtoul(twoCanRegEx.GetMatch(str,12), NULL, 16);
+// Sample the first few lines, as some log files may start with a header or comments
+// The first line that matches one of the known formats determines the format of the entire file
+int TwoCanLogReader::TestFormat(void) {
+	const char *line;
+	size_t length;
+	int format = Undefined;
+	readOffset = 0;
+	for (int i = 0; (i < CONST_LOGFILE_SAMPLE_LINES) && (format == Undefined) && (NextLine(&line, &length)); i++) {
+		format = TwoCanLogParser::DetectFormat(line, length);
 	}
-	return;
+	return format;
 }
 
-// Fix included for V2.0 supports matching of slcan, vcan or can
-void TwoCanLogReader::ParseCanDump(std::string str) {
-	if (twoCanRegEx.Matches(str,wxRE_DEFAULT)) {
-		unsigned long temp = std::strtoul(twoCanRegEx.GetMatch(str,2), NULL, 16);
-		memcpy(&canFrame[0],&temp, 4);
-		wxString tmpString = twoCanRegEx.GetMatch(str,3).c_str();
-		byte tmpChar[tmpString.size()];
-        memcpy(&tmpChar[0], tmpString,tmpString.size());
-       	TwoCanUtils::ConvertHexStringToByteArray(&tmpChar[0], 8, &canFrame[4]);
+// Lines are returned in place from the memory mapped file, no copying is performed
+bool TwoCanLogReader::NextLine(const char **line, size_t *length) {
+	size_t available = CONST_LOGFILE_MAX_LINE;
+	const byte *buffer = logFile.Map(readOffset, &available);
+	if ((buffer == NULL) || (available == 0)) {
+		return false;
 	}
-	return;	
-}
-
-// Parses both Kees format from Canboat and Raw format from SignalK Server
-// Only difference is the header/date time fields, the remaining fields are the same
-void TwoCanLogReader::ParseKees(std::string str) {
-	if (twoCanRegEx.Matches(str,wxRE_DEFAULT)) {
-		CanHeader header;
-		
-		header.source = atoi(twoCanRegEx.GetMatch(str,3));
-		header.destination = atoi(twoCanRegEx.GetMatch(str,4));
-		header.pgn = atoi(twoCanRegEx.GetMatch(str,2));
-		header.priority = atoi(twoCanRegEx.GetMatch(str,1));
-		
-		// BUG BUG Should create a function EncodeCanHeader
-		// Encodes a 29 bit CAN header
-		canFrame[3] = ((header.pgn >> 16) & 0x01) | (header.priority << 2);
-		canFrame[2] = ((header.pgn & 0xFF00) >> 8);
-		canFrame[1] = (canFrame[2] > 239) ? (header.pgn & 0xFF) : header.destination;
-		canFrame[0] = header.source;
-		
-		canFrame[4] = std::strtoul(twoCanRegEx.GetMatch(str,6), NULL, 16);
-		canFrame[5] = std::strtoul(twoCanRegEx.GetMatch(str,7), NULL, 16);
-		canFrame[6] = std::strtoul(twoCanRegEx.GetMatch(str,8), NULL, 16);
-		canFrame[7] = std::strtoul(twoCanRegEx.GetMatch(str,9), NULL, 16);
-		canFrame[8] = std::strtoul(twoCanRegEx.GetMatch(str,10), NULL, 16);
-		canFrame[9] = std::strtoul(twoCanRegEx.GetMatch(str,11), NULL, 16);
-		canFrame[10] = std::strtoul(twoCanRegEx.GetMatch(str,12), NULL, 16);
-		canFrame[11] = std::strtoul(twoCanRegEx.GetMatch(str,13), NULL, 16);
+	const byte *lineEnd = (const byte *)memchr(buffer, '\n', available);
+	// A line longer than the line buffer is malformed, skip to the next newline rather than returning the fragments
+	while ((lineEnd == NULL) && (readOffset + available < logFile.Size())) {
+		malformedLines++;
+		if (!SkipLine()) {
+			return false;
+		}
+		available = CONST_LOGFILE_MAX_LINE;
+		buffer = logFile.Map(readOffset, &available);
+		if ((buffer == NULL) || (available == 0)) {
+			return false;
+		}
+		lineEnd = (const byte *)memchr(buffer, '\n', available);
 	}
-	return;
-}
-
-void TwoCanLogReader::ParseYachtDevices(std::string str) {
-	if (twoCanRegEx.Matches(str,wxRE_DEFAULT)) {
-		unsigned long temp = std::strtoul(twoCanRegEx.GetMatch(str,1), NULL, 16);
-		memcpy(&canFrame[0], &temp, 4);
-		canFrame[4] = std::strtoul(twoCanRegEx.GetMatch(str,2), NULL, 16);
-		canFrame[5] = std::strtoul(twoCanRegEx.GetMatch(str,3), NULL, 16);
-		canFrame[6] = std::strtoul(twoCanRegEx.GetMatch(str,4), NULL, 16); 
-		canFrame[7] = std::strtoul(twoCanRegEx.GetMatch(str,5), NULL, 16);
-		canFrame[8] = std::strtoul(twoCanRegEx.GetMatch(str,6), NULL, 16);
-		canFrame[9] = std::strtoul(twoCanRegEx.GetMatch(str,7), NULL, 16);
-		canFrame[10] = std::strtoul(twoCanRegEx.GetMatch(str,8), NULL, 16);
-		canFrame[11] = std::strtoul(twoCanRegEx.GetMatch(str,9), NULL, 16);
+	size_t lineLength = (lineEnd != NULL) ? (size_t)(lineEnd - buffer) : available;
+	readOffset += lineLength + ((lineEnd != NULL) ? 1 : 0);
+	// Windows line endings
+	if ((lineLength > 0) && (buffer[lineLength - 1] == '\r')) {
+		lineLength--;
 	}
-	return;
+	*line = (const char *)buffer;
+	*length = lineLength;
+	return true;
 }
 
-int TwoCanLogReader::TestFormat(std::string line) {
-	// BUG BUG Should check that the Regular Expression is valid
-	// eg. twoCanRegEx.IsValid()
-	twoCanRegEx.Compile(CONST_TWOCAN_REGEX, wxRE_ADVANCED |  wxRE_NEWLINE);
-	if (twoCanRegEx.Matches(line,wxRE_DEFAULT)) {
-		return TwoCanRaw;
-	}
-	twoCanRegEx.Compile(CONST_CANDUMP_REGEX, wxRE_ADVANCED | wxRE_NEWLINE);
-	if (twoCanRegEx.Matches(line,wxRE_DEFAULT)) {
-		return CanDump;
-	}
-	twoCanRegEx.Compile(CONST_KEES_REGEX, wxRE_ADVANCED | wxRE_NEWLINE);
-	if (twoCanRegEx.Matches(line,wxRE_DEFAULT))  {
-		return Kees;
-	}
-	twoCanRegEx.Compile(CONST_SIGNALK_REGEX, wxRE_ADVANCED | wxRE_NEWLINE);
-	if (twoCanRegEx.Matches(line, wxRE_DEFAULT)) {
-		return Kees;
-	}
-	twoCanRegEx.Compile(CONST_YACHTDEVICES_REGEX, wxRE_ADVANCED |  wxRE_NEWLINE);
-	if (twoCanRegEx.Matches(line,wxRE_DEFAULT)) {
-		return YachtDevices;
-	}
-	return Undefined;
+// Advance past the next newline, returns false if the end of the file is reached first
+bool TwoCanLogReader::SkipLine(void) {
+	size_t available;
+	const byte *buffer;
+	const byte *lineEnd;
+	do {
+		available = CONST_LOGFILE_MAX_LINE;
+		buffer = logFile.Map(readOffset, &available);
+		if ((buffer == NULL) || (available == 0)) {
+			return false;
+		}
+		lineEnd = (const byte *)memchr(buffer, '\n', available);
+		readOffset += (lineEnd != NULL) ? (size_t)(lineEnd - buffer) + 1 : available;
+	} while (lineEnd == NULL);
+	return true;
 }
 
 void TwoCanLogReader::Read() {
-	std::string inputLine;
+	const char *inputLine;
+	size_t inputLength;
 	std::vector<byte> postedFrame(CONST_FRAME_LENGTH);
-	while (!logFileStream.eof()) {
-		getline(logFileStream, inputLine);
-		if (!TestDestroy()) {
-		// process the line
-			switch(logFileFormat) {
-				case TwoCanRaw:
-					ParseTwoCan(inputLine);
-					break;
-				case CanDump:
-					ParseCanDump(inputLine);
-					break;
-				case Kees:
-					ParseKees(inputLine);
-					break;
-				case YachtDevices:
-					ParseYachtDevices(inputLine);
-					break;
-				case Undefined:
-					// should log invalid log file format message here.
-					break;
-			}
-			
+	while (!TestDestroy()) {
+		// If end of file, rewind to beginning
+		if (!NextLine(&inputLine, &inputLength)) {
+			readOffset = 0;
+			continue;
+		}
+		// process the line, only posting those lines that were successfully parsed
+		if (TwoCanLogParser::ParseLine(logFileFormat, inputLine, inputLength, canFrame)) {
 			// Post frame to TwoCan device
-			// BUG BUG Do we need to protect access to the canFrame using a mutex
-			std::vector<byte>postedFrame(canFrame, canFrame + (sizeof(canFrame) / sizeof(canFrame[0])));
+			postedFrame.assign(canFrame, canFrame + CONST_FRAME_LENGTH);
 			deviceQueue->Post(postedFrame);
 			wxThread::Sleep(20);
-		} 
-		else {
-			// Thread Exiting
-			break;
-		}
-		
-		// If end of file, rewind to beginning
-		if (logFileStream.eof()) {
-			logFileStream.clear();
-			logFileStream.seekg(0, std::ios::beg); 
 		}
-	} // end while not eof
-	
+	} // end while not exiting
 }
 
 // Entry, the method that is executed upon thread start
@@ -0,0 +1,142 @@
+// Copyright(C) 2018-2021 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanMappedFile - Windowed memory mapped file access for the log file readers
+// Owner: twocanplugin@hotmail.com
+// Date: 10/01/2022
+// Version History: 
+// 1.0 Initial Release
+
+#include "twocanmappedfile.h"
+
+TwoCanMappedFile::TwoCanMappedFile(void) {
+	fileDescriptor = -1;
+	fileSize = 0;
+	windowAddress = NULL;
+	windowOffset = 0;
+	windowLength = 0;
+	prefetchOffset = 0;
+	pageSize = sysconf(_SC_PAGESIZE);
+}
+
+TwoCanMappedFile::~TwoCanMappedFile(void) {
+	Close();
+}
+
+int TwoCanMappedFile::Open(const wxString& fileName) {
+	Close();
+
+	fileDescriptor = open(fileName.mb_str(), O_RDONLY);
+	if (fileDescriptor == -1) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_FILE_NOT_FOUND);
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) == -1) {
+		Close();
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_FILE_MAP);
+	}
+	fileSize = fileStatus.st_size;
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+void TwoCanMappedFile::Close(void) {
+	UnmapWindow();
+	if (fileDescriptor != -1) {
+		close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+	fileSize = 0;
+}
+
+void TwoCanMappedFile::UnmapWindow(void) {
+	if (windowAddress != NULL) {
+		munmap(windowAddress, windowLength);
+		windowAddress = NULL;
+	}
+	windowOffset = 0;
+	windowLength = 0;
+	prefetchOffset = 0;
+}
+
+// Map a window starting at the page boundary at or below the given offset
+int TwoCanMappedFile::MapWindow(const unsigned long long offset) {
+	UnmapWindow();
+
+	unsigned long long alignedOffset = offset - (offset % pageSize);
+	unsigned long long remaining = fileSize - alignedOffset;
+	size_t length = (remaining < CONST_MMAP_WINDOW_SIZE) ? (size_t)remaining : CONST_MMAP_WINDOW_SIZE;
+
+	void *address = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileDescriptor, alignedOffset);
+	if (address == MAP_FAILED) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_FILE_MAP);
+	}
+
+	// Log files are read from beginning to end
+	madvise(address, length, MADV_SEQUENTIAL);
+
+	windowAddress = (byte *)address;
+	windowOffset = alignedOffset;
+	windowLength = length;
+	prefetchOffset = alignedOffset;
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+const byte *TwoCanMappedFile::Map(const unsigned long long offset, size_t *length) {
+	if ((fileDescriptor == -1) || (offset >= fileSize)) {
+		*length = 0;
+		return NULL;
+	}
+
+	// Truncate the request at the end of the file
+	if (*length > fileSize - offset) {
+		*length = (size_t)(fileSize - offset);
+	}
+
+	// Remap if the requested region is not entirely within the current window
+	if ((windowAddress == NULL) || (offset < windowOffset) || (offset + *length > windowOffset + windowLength)) {
+		if (MapWindow(offset) != TWOCAN_RESULT_SUCCESS) {
+			*length = 0;
+			return NULL;
+		}
+		// A record that is larger than the window cannot be returned
+		if (offset + *length > windowOffset + windowLength) {
+			*length = (size_t)(windowOffset + windowLength - offset);
+		}
+	}
+
+	// Ask the kernel to read ahead of the current position
+	if (offset + *length + (CONST_MMAP_PREFETCH_SIZE / 2) > prefetchOffset) {
+		unsigned long long prefetchStart = prefetchOffset > offset ? prefetchOffset : offset;
+		prefetchStart -= (prefetchStart % pageSize);
+		unsigned long long prefetchEnd = prefetchStart + CONST_MMAP_PREFETCH_SIZE;
+		if (prefetchEnd > windowOffset + windowLength) {
+			prefetchEnd = windowOffset + windowLength;
+		}
+		if (prefetchEnd > prefetchStart) {
+			madvise(windowAddress + (prefetchStart - windowOffset), (size_t)(prefetchEnd - prefetchStart), MADV_WILLNEED);
+		}
+		prefetchOffset = prefetchEnd;
+	}
+
+	return windowAddress + (offset - windowOffset);
+}
@@ -0,0 +1,176 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanMultiSocket - Reads several SocketCAN interfaces, merging and de-duplicating their frames
+// Owner: twocanplugin@hotmail.com
+// Date: 15/08/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 20/08/2022 Share the SocketCAN event loop, blocking until frames arrive or shutdown is signalled
+// 1.2 28/09/2022 Report the number of interfaces, so that those that received nothing are also reported
+
+#include "twocanmultisocket.h"
+
+TwoCanMultiSocket::TwoCanMultiSocket(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanSocket(messageQueue) {
+	duplicateFrames = 0;
+	memset(dedupTable, 0, sizeof(dedupTable));
+}
+
+TwoCanMultiSocket::~TwoCanMultiSocket(void) {
+}
+
+// Open each of the interfaces and register them with epoll, the epoll data is the interface index
+int TwoCanMultiSocket::Open(const wxString& portNames) {
+	int returnCode;
+
+	returnCode = OpenEventLoop();
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		Close();
+		return returnCode;
+	}
+
+	wxStringTokenizer tokenizer(portNames, _T(","));
+	while (tokenizer.HasMoreTokens()) {
+		wxString portName = tokenizer.GetNextToken().Trim().Trim(false);
+		if (portName.IsEmpty()) {
+			continue;
+		}
+
+		if (canSockets.size() == CONST_MAX_INTERFACES) {
+			wxLogMessage(_T("TwoCan Multi Socket, Ignoring %s, a maximum of %d interfaces are supported"), portName, CONST_MAX_INTERFACES);
+			continue;
+		}
+
+		int socketDescriptor;
+		returnCode = OpenSocket(portName, &socketDescriptor);
+		if (returnCode != TWOCAN_RESULT_SUCCESS) {
+			wxLogMessage(_T("TwoCan Multi Socket, Error opening %s: %d"), portName, returnCode);
+			Close();
+			return returnCode;
+		}
+
+		returnCode = WatchSocket(socketDescriptor, canSockets.size());
+		if (returnCode != TWOCAN_RESULT_SUCCESS) {
+			close(socketDescriptor);
+			Close();
+			return returnCode;
+		}
+
+		canSockets.push_back(socketDescriptor);
+		interfaceNames.push_back(portName);
+		wxLogMessage(_T("TwoCan Multi Socket, Opened %s as interface %d"), portName, (int)canSockets.size() - 1);
+	}
+
+	if (canSockets.size() == 0) {
+		Close();
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_ADAPTER_NOT_FOUND);
+	}
+
+	// Transmit on the first interface
+	canSocket = canSockets[0];
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+int TwoCanMultiSocket::Close(void) {
+	for (auto it : canSockets) {
+		close(it);
+	}
+	canSockets.clear();
+	interfaceNames.clear();
+	canSocket = -1;
+
+	CloseEventLoop();
+
+	if (duplicateFrames > 0) {
+		wxLogMessage(_T("TwoCan Multi Socket, Discarded %llu duplicate frames"), duplicateFrames);
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Each interface in the comma separated list
+int TwoCanMultiSocket::GetInterfaceCount(void) {
+	return (int)interfaceNames.size();
+}
+
+// A frame is a duplicate if an identical frame was received on a different interface within the window.
+// Uses a direct mapped table of FNV-1a hashes, a collision merely results in a duplicate being posted.
+bool TwoCanMultiSocket::IsDuplicate(const byte *frame, const int interfaceIndex, const unsigned long long now) {
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i = 0; i < CONST_FRAME_LENGTH; i++) {
+		hash = (hash ^ frame[i]) * 1099511628211ULL;
+	}
+
+	DedupEntry *entry = &dedupTable[hash & (CONST_DEDUP_TABLE_SIZE - 1)];
+
+	if ((entry->hash == hash) && (entry->interfaceIndex != interfaceIndex) && (now - entry->timestamp < CONST_DEDUP_WINDOW)) {
+		// Consume the entry, so that a later retransmission on the original interface is not discarded
+		entry->hash = 0;
+		return true;
+	}
+
+	entry->hash = hash;
+	entry->timestamp = now;
+	entry->interfaceIndex = interfaceIndex;
+	return false;
+}
+
+// Duplicates are only possible when there is more than one interface
+bool TwoCanMultiSocket::AcceptFrame(const byte *frame, const int interfaceIndex) {
+	if ((canSockets.size() > 1) && (IsDuplicate(frame, interfaceIndex, TwoCanUtils::GetTimeInMicroseconds()))) {
+		duplicateFrames++;
+		return false;
+	}
+	return true;
+}
+
+// Block until any of the interfaces are readable or the shutdown event is signalled, 
+// drain each readable interface and post all of the frames as a single batch
+void TwoCanMultiSocket::Read() {
+	struct epoll_event readyEvents[CONST_MAX_INTERFACES + 1];
+	std::vector<byte> postedFrames;
+	bool shutdownSignalled = false;
+
+	postedFrames.reserve(CONST_MAX_INTERFACES * CONST_SOCKET_RECEIVE_FRAMES * CONST_FRAME_LENGTH);
+
+	while ((!shutdownSignalled) && (!TestDestroy())) {
+
+		int readyCount = epoll_wait(epollDescriptor, readyEvents, CONST_MAX_INTERFACES + 1, -1);
+
+		for (int i = 0; i < readyCount; i++) {
+			unsigned int interfaceIndex = readyEvents[i].data.u32;
+
+			if (interfaceIndex == CONST_SOCKET_SHUTDOWN_EVENT) {
+				shutdownSignalled = true;
+			}
+			else if (ReceiveFrames(canSockets[interfaceIndex], interfaceIndex, &postedFrames) < 0) {
+				wxLogMessage(_T("TwoCan Multi Socket, Error reading %s: %s"), interfaceNames[interfaceIndex], strerror(errno));
+			}
+		}
+
+		if (postedFrames.size() > 0) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+
+	}
+
+}
@@ -0,0 +1,514 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanNetwork - Ethernet/WiFi NMEA 2000 gateways (Yacht Devices RAW, Actisense N2K ASCII) on Linux
+// Owner: twocanplugin@hotmail.com
+// Date: 28/08/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 28/09/2022 Encode and send under the socket mutex, a lost connection clears the outgoing messages from the read thread
+
+#include "twocannetwork.h"
+
+// For the unique number
+#include "twocansocket.h"
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+TwoCanNetwork::TwoCanNetwork(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
+	protocol = NetworkYachtDevicesUdp;
+	portNumber = 0;
+	gatewayAddressLength = 0;
+	networkSocket = -1;
+	shutdownEvent = -1;
+	receiveLength = 0;
+	memset(sequenceIds, 0, sizeof(sequenceIds));
+	receivedLines = 0;
+	invalidLines = 0;
+	reconnections = 0;
+}
+
+TwoCanNetwork::~TwoCanNetwork() {
+// Nothing to do in the destructor ??
+}
+
+bool TwoCanNetwork::IsNetworkAdapter(const wxString& portName) {
+	return (portName.StartsWith(_T("udp://")) || portName.StartsWith(_T("tcp://")) || portName.StartsWith(_T("actisense://")));
+}
+
+// Use the same unique number as the SocketCAN interface, derived from the MAC address
+int TwoCanNetwork::GetUniqueNumber(unsigned long *uniqueNumber) {
+	return TwoCanSocket::DeriveUniqueNumber(uniqueNumber);
+}
+
+// The adapter name is of the form protocol://host:port
+int TwoCanNetwork::Open(const wxString& portName) {
+	wxString address;
+	unsigned long port;
+
+	if (portName.StartsWith(_T("udp://"), &address)) {
+		protocol = NetworkYachtDevicesUdp;
+	}
+	else if (portName.StartsWith(_T("tcp://"), &address)) {
+		protocol = NetworkYachtDevicesTcp;
+	}
+	else if (portName.StartsWith(_T("actisense://"), &address)) {
+		protocol = NetworkActisenseTcp;
+	}
+	else {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_ADAPTER_NOT_FOUND);
+	}
+
+	hostName = address.BeforeLast(':');
+	if ((hostName.IsEmpty()) || (!address.AfterLast(':').ToULong(&port)) || (port == 0) || (port > 65535)) {
+		wxLogMessage(_T("TwoCan Network, Invalid gateway address %s"), portName);
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_ADAPTER_NOT_FOUND);
+	}
+	portNumber = (unsigned short)port;
+
+	shutdownEvent = eventfd(0, EFD_NONBLOCK);
+	if (shutdownEvent < 0) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CREATE);
+	}
+
+	return Connect();
+}
+
+int TwoCanNetwork::Close(void) {
+	Disconnect();
+	if (shutdownEvent != -1) {
+		close(shutdownEvent);
+		shutdownEvent = -1;
+	}
+	wxLogMessage(_T("TwoCan Network, Received %llu lines, %llu invalid, %u reconnections"), receivedLines, invalidLines, reconnections);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Yacht Devices gateways broadcast UDP to the configured port, so for UDP we bind to that port and send to the gateway's address.
+// For TCP, connect to the gateway, waiting no longer than the reconnect interval.
+int TwoCanNetwork::Connect(void) {
+	struct addrinfo hints;
+	struct addrinfo *addresses;
+	bool isTcp = (protocol != NetworkYachtDevicesUdp);
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = isTcp ? AF_UNSPEC : AF_INET;
+	hints.ai_socktype = isTcp ? SOCK_STREAM : SOCK_DGRAM;
+
+	if (getaddrinfo(hostName.c_str(), wxString::Format(_T("%u"), portNumber).c_str(), &hints, &addresses) != 0) {
+		wxLogMessage(_T("TwoCan Network, Unable to resolve %s"), hostName);
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_ADAPTER_NOT_FOUND);
+	}
+
+	memcpy(&gatewayAddress, addresses->ai_addr, addresses->ai_addrlen);
+	gatewayAddressLength = addresses->ai_addrlen;
+
+	int socketDescriptor = socket(addresses->ai_family, addresses->ai_socktype | SOCK_NONBLOCK, 0);
+	freeaddrinfo(addresses);
+	if (socketDescriptor < 0) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CREATE);
+	}
+
+	int option = 1;
+	if (isTcp) {
+		setsockopt(socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+
+		if ((connect(socketDescriptor, (struct sockaddr *)&gatewayAddress, gatewayAddressLength) < 0) && (errno != EINPROGRESS)) {
+			close(socketDescriptor);
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CONNECT);
+		}
+
+		struct pollfd pollDescriptor = { socketDescriptor, POLLOUT, 0 };
+		int socketError = ETIMEDOUT;
+		socklen_t errorLength = sizeof(socketError);
+		if (poll(&pollDescriptor, 1, CONST_NETWORK_RECONNECT) == 1) {
+			getsockopt(socketDescriptor, SOL_SOCKET, SO_ERROR, &socketError, &errorLength);
+		}
+		if (socketError != 0) {
+			wxLogMessage(_T("TwoCan Network, Unable to connect to %s:%u, %s"), hostName, portNumber, strerror(socketError));
+			close(socketDescriptor);
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CONNECT);
+		}
+	}
+	else {
+		setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+		setsockopt(socketDescriptor, SOL_SOCKET, SO_BROADCAST, &option, sizeof(option));
+
+		struct sockaddr_in localAddress;
+		memset(&localAddress, 0, sizeof(localAddress));
+		localAddress.sin_family = AF_INET;
+		localAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+		localAddress.sin_port = htons(portNumber);
+		if (bind(socketDescriptor, (struct sockaddr *)&localAddress, sizeof(localAddress)) < 0) {
+			close(socketDescriptor);
+			return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_BIND);
+		}
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(socketMutex);
+		networkSocket = socketDescriptor;
+		receiveLength = 0;
+	}
+
+	wxLogMessage(_T("TwoCan Network, Connected to %s:%u"), hostName, portNumber);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+void TwoCanNetwork::Disconnect(void) {
+	const std::lock_guard<std::mutex> lock(socketMutex);
+	if (networkSocket != -1) {
+		close(networkSocket);
+		networkSocket = -1;
+	}
+	outgoingMessages.clear();
+}
+
+// Signal the shutdown event, the read thread then exits without waiting for further data
+void TwoCanNetwork::Interrupt(void) {
+	if (shutdownEvent != -1) {
+		uint64_t signal = 1;
+		if (write(shutdownEvent, &signal, sizeof(signal)) != sizeof(signal)) {
+			wxLogMessage(_T("TwoCan Network, Error signalling shutdown %s"), strerror(errno));
+		}
+	}
+}
+
+// Wait for data (or if disconnected, just the timeout), returns false if the shutdown event is signalled
+bool TwoCanNetwork::WaitForData(const int timeout) {
+	struct pollfd pollDescriptors[2];
+	pollDescriptors[0].fd = shutdownEvent;
+	pollDescriptors[0].events = POLLIN;
+	pollDescriptors[1].fd = networkSocket;
+	pollDescriptors[1].events = POLLIN;
+
+	int readyCount = poll(pollDescriptors, (networkSocket != -1) ? 2 : 1, timeout);
+
+	return !((readyCount > 0) && (pollDescriptors[0].revents & POLLIN));
+}
+
+// Parse each complete line, returns the number of bytes consumed which excludes any trailing partial line
+size_t TwoCanNetwork::ParseLines(const char *buffer, const size_t length, std::vector<byte> *postedFrames) {
+	const char *line = buffer;
+	const char *end = buffer + length;
+	const char *lineEnd;
+
+	while ((lineEnd = (const char *)memchr(line, '\n', end - line)) != NULL) {
+		size_t lineLength = lineEnd - line;
+		if ((lineLength > 0) && (line[lineLength - 1] == '\r')) {
+			lineLength--;
+		}
+		if (lineLength > 0) {
+			ParseLine(line, lineLength, postedFrames);
+		}
+		line = lineEnd + 1;
+	}
+
+	return line - buffer;
+}
+
+void TwoCanNetwork::ParseLine(const char *line, const size_t length, std::vector<byte> *postedFrames) {
+	byte frame[CONST_FRAME_LENGTH];
+
+	receivedLines++;
+
+	if (protocol != NetworkActisenseTcp) {
+		if (TwoCanLogParser::ParseYachtDevices(line, length, frame)) {
+			postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+		}
+		// Gateways echo the frames we transmit, 09:06:35.596 T 09F80203 ...
+		else if ((length < 14) || (line[13] != 'T')) {
+			invalidLines++;
+		}
+		return;
+	}
+
+	// Actisense delivers complete messages, fast messages are fragmented into frames for the TwoCan device to reassemble
+	CanHeader header;
+	byte payload[CONST_MAX_FAST_PACKET_LENGTH];
+	unsigned int payloadLength;
+	unsigned int id;
+
+	if (!TwoCanLogParser::ParseActisense(line, length, &header, payload, &payloadLength)) {
+		invalidLines++;
+		return;
+	}
+
+	TwoCanUtils::EncodeCanHeader(&id, &header);
+	TwoCanUtils::ConvertIntegerToByteArray(id, &frame[0]);
+
+	if (!TwoCanUtils::IsFastMessage(header.pgn)) {
+		memset(&frame[CONST_HEADER_LENGTH], 0xFF, CONST_PAYLOAD_LENGTH);
+		memcpy(&frame[CONST_HEADER_LENGTH], payload, std::min(payloadLength, (unsigned int)CONST_PAYLOAD_LENGTH));
+		postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+		return;
+	}
+
+	sequenceIds[header.source] = TwoCanUtils::GenerateID(sequenceIds[header.source]);
+	byte sid = sequenceIds[header.source];
+
+	memset(&frame[CONST_HEADER_LENGTH], 0xFF, CONST_PAYLOAD_LENGTH);
+	frame[CONST_HEADER_LENGTH] = sid;
+	frame[CONST_HEADER_LENGTH + 1] = payloadLength;
+	memcpy(&frame[CONST_HEADER_LENGTH + 2], payload, std::min(payloadLength, 6U));
+	postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+
+	for (unsigned int offset = 6; offset < payloadLength; offset += 7) {
+		sid += 1;
+		frame[CONST_HEADER_LENGTH] = sid;
+		memset(&frame[CONST_HEADER_LENGTH + 1], 0xFF, 7);
+		memcpy(&frame[CONST_HEADER_LENGTH + 1], &payload[offset], std::min(payloadLength - offset, 7U));
+		postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+	}
+}
+
+// Drain the socket each time it becomes readable and post the frames as a single batch.
+// UDP datagrams are read in bulk using recvmmsg, each datagram contains complete lines.
+// TCP data is appended to the receive buffer, complete lines are parsed in place and any partial line retained.
+void TwoCanNetwork::Read() {
+	std::vector<byte> postedFrames;
+	struct mmsghdr messages[CONST_NETWORK_DATAGRAMS];
+	struct iovec ioVectors[CONST_NETWORK_DATAGRAMS];
+
+	postedFrames.reserve(CONST_NETWORK_BUFFER_SIZE / 2);
+
+	while (!TestDestroy()) {
+
+		// Lost the connection to a TCP gateway, wait and then attempt to reconnect
+		if (networkSocket == -1) {
+			if (!WaitForData(CONST_NETWORK_RECONNECT)) {
+				break;
+			}
+			if (Connect() == TWOCAN_RESULT_SUCCESS) {
+				reconnections++;
+			}
+			continue;
+		}
+
+		if (!WaitForData(-1)) {
+			break;
+		}
+
+		if (protocol == NetworkYachtDevicesUdp) {
+			int datagramCount;
+			do {
+				memset(messages, 0, sizeof(messages));
+				for (int i = 0; i < CONST_NETWORK_DATAGRAMS; i++) {
+					ioVectors[i].iov_base = &receiveBuffer[i * CONST_NETWORK_DATAGRAM_SIZE];
+					ioVectors[i].iov_len = CONST_NETWORK_DATAGRAM_SIZE;
+					messages[i].msg_hdr.msg_iov = &ioVectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				datagramCount = recvmmsg(networkSocket, messages, CONST_NETWORK_DATAGRAMS, MSG_DONTWAIT, NULL);
+
+				for (int i = 0; i < datagramCount; i++) {
+					const char *datagram = &receiveBuffer[i * CONST_NETWORK_DATAGRAM_SIZE];
+					size_t datagramLength = messages[i].msg_len;
+					size_t consumed = ParseLines(datagram, datagramLength, &postedFrames);
+					// Tolerate a final line without a line terminator
+					if (consumed < datagramLength) {
+						ParseLine(datagram + consumed, datagramLength - consumed, &postedFrames);
+					}
+				}
+			} while (datagramCount == CONST_NETWORK_DATAGRAMS);
+		}
+		else {
+			ssize_t bytesReceived;
+			while ((bytesReceived = recv(networkSocket, &receiveBuffer[receiveLength], CONST_NETWORK_BUFFER_SIZE - receiveLength, MSG_DONTWAIT)) > 0) {
+				receiveLength += bytesReceived;
+				size_t consumed = ParseLines(receiveBuffer, receiveLength, &postedFrames);
+				receiveLength -= consumed;
+				if (receiveLength == CONST_NETWORK_BUFFER_SIZE) {
+					// No line terminator in an entire buffer, discard it
+					invalidLines++;
+					receiveLength = 0;
+				}
+				else if ((receiveLength > 0) && (consumed > 0)) {
+					memmove(receiveBuffer, &receiveBuffer[consumed], receiveLength);
+				}
+			}
+
+			if ((bytesReceived == 0) || ((bytesReceived < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+				wxLogMessage(_T("TwoCan Network, Connection to %s:%u lost"), hostName, portNumber);
+				Disconnect();
+			}
+		}
+
+		if (postedFrames.size() > 0) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+	}
+}
+
+// Yacht Devices RAW, 09F80203 FF FC 43 1E 00 00 FF FF
+// Actisense N2K ASCII, A000000.000 23FF7 1F513 012F3070002F30709F, only once all of the frames of a fast message have been written
+size_t TwoCanNetwork::EncodeFrame(const CanFrame *frame, char *line) {
+	char *p = line;
+	const byte *data = frame->data;
+	unsigned int dataLength = CONST_PAYLOAD_LENGTH;
+
+	if (protocol != NetworkActisenseTcp) {
+		for (int i = 28; i >= 0; i -= 4) {
+			*p++ = hexDigits[(frame->id >> i) & 0x0F];
+		}
+		for (int i = 0; i < CONST_PAYLOAD_LENGTH; i++) {
+			*p++ = ' ';
+			*p++ = hexDigits[data[i] >> 4];
+			*p++ = hexDigits[data[i] & 0x0F];
+		}
+		*p++ = '\r';
+		*p++ = '\n';
+		return p - line;
+	}
+
+	byte header[CONST_HEADER_LENGTH];
+	CanHeader canHeader;
+	TwoCanUtils::ConvertIntegerToByteArray(frame->id, header);
+	TwoCanUtils::DecodeCanHeader(header, &canHeader);
+
+	if (TwoCanUtils::IsFastMessage(canHeader.pgn)) {
+		NetworkMessage *message = &outgoingMessages[frame->id];
+		if ((frame->data[0] & 0x1F) == 0) {
+			message->length = std::min((unsigned int)frame->data[1], (unsigned int)CONST_MAX_FAST_PACKET_LENGTH);
+			message->cursor = std::min(message->length, 6U);
+			memcpy(message->data, &frame->data[2], message->cursor);
+		}
+		else if (message->length > 0) {
+			unsigned int count = std::min(message->length - message->cursor, 7U);
+			memcpy(&message->data[message->cursor], &frame->data[1], count);
+			message->cursor += count;
+		}
+		if ((message->length == 0) || (message->cursor < message->length)) {
+			return 0;
+		}
+		data = message->data;
+		dataLength = message->length;
+		message->length = 0;
+	}
+
+	p += snprintf(p, CONST_NETWORK_MAX_LINE, "A000000.000 %02X%02X%1X %05X ", canHeader.source, canHeader.destination, canHeader.priority, canHeader.pgn);
+	for (unsigned int i = 0; i < dataLength; i++) {
+		*p++ = hexDigits[data[i] >> 4];
+		*p++ = hexDigits[data[i] & 0x0F];
+	}
+	*p++ = '\r';
+	*p++ = '\n';
+	return p - line;
+}
+
+// UDP lines are grouped into datagrams, TCP lines are written as a single stream, waiting briefly should the socket's buffer be full
+// The caller must hold the socket mutex
+int TwoCanNetwork::SendLines(const char *lines, const size_t length) {
+	if (networkSocket == -1) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_WRITE);
+	}
+
+	if (protocol == NetworkYachtDevicesUdp) {
+		size_t offset = 0;
+		while (offset < length) {
+			size_t datagramLength = std::min(length - offset, (size_t)CONST_NETWORK_DATAGRAM_SIZE);
+			// Split on a line boundary
+			if (offset + datagramLength < length) {
+				const char *lastLine = (const char *)memrchr(&lines[offset], '\n', datagramLength);
+				if (lastLine != NULL) {
+					datagramLength = lastLine - &lines[offset] + 1;
+				}
+			}
+			if (sendto(networkSocket, &lines[offset], datagramLength, MSG_DONTWAIT, (struct sockaddr *)&gatewayAddress, gatewayAddressLength) < 0) {
+				wxLogMessage(_T("TwoCan Network, Write Error %s"), strerror(errno));
+				return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_WRITE);
+			}
+			offset += datagramLength;
+		}
+		return TWOCAN_RESULT_SUCCESS;
+	}
+
+	size_t offset = 0;
+	while (offset < length) {
+		ssize_t bytesSent = send(networkSocket, &lines[offset], length - offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (bytesSent > 0) {
+			offset += bytesSent;
+			continue;
+		}
+		if ((bytesSent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+			struct pollfd pollDescriptor = { networkSocket, POLLOUT, 0 };
+			if (poll(&pollDescriptor, 1, CONST_SOCKET_BACKPRESSURE_TIMEOUT) == 1) {
+				continue;
+			}
+		}
+		else if ((bytesSent < 0) && (errno == EINTR)) {
+			continue;
+		}
+		wxLogMessage(_T("TwoCan Network, Write Error %s"), strerror(errno));
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_WRITE);
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Write, Transmit a CAN frame onto the NMEA 2000 network via the gateway
+int TwoCanNetwork::Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload) {
+	CanFrame frame;
+	size_t framesWritten;
+	frame.id = canId;
+	memset(frame.data, 0xFF, CONST_PAYLOAD_LENGTH);
+	memcpy(frame.data, payload, std::min(payloadLength, (unsigned char)CONST_PAYLOAD_LENGTH));
+	return WriteFrames(&frame, 1, &framesWritten);
+}
+
+// Encode the batch of frames and write them with as few system calls as possible.
+// The mutex is held throughout, as the read thread clears the outgoing messages should the connection be lost
+int TwoCanNetwork::WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten) {
+	std::string lines;
+	char line[CONST_NETWORK_MAX_LINE];
+
+	*framesWritten = 0;
+	lines.reserve(frameCount * 32);
+
+	const std::lock_guard<std::mutex> lock(socketMutex);
+
+	for (size_t i = 0; i < frameCount; i++) {
+		size_t lineLength = EncodeFrame(&frames[i], line);
+		lines.append(line, lineLength);
+	}
+
+	int returnCode = TWOCAN_RESULT_SUCCESS;
+	if (lines.size() > 0) {
+		returnCode = SendLines(lines.data(), lines.size());
+	}
+	if (returnCode == TWOCAN_RESULT_SUCCESS) {
+		*framesWritten = frameCount;
+	}
+	return returnCode;
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanNetwork::Entry() {
+	// Merely loops continuously waiting for data from the gateway
+	Read();
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanNetwork::OnExit() {
+	// Nothing to do ??
+}
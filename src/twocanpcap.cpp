@@ -24,169 +24,421 @@
 // Date: 04/07/2021
 // Version History: 
 // 1.0 Initial Release
+// 1.1 - 12/01/2022 Memory mapped file access, packets are decoded in place
+// 1.2 - 18/01/2022 Support pcapng, byte swapped & nanosecond pcap, replay using packet timestamps, batch posting
+// 1.3 - 28/09/2022 Wait for frames to be due in short slices, checking whether the thread is to exit
 
 
 #include <twocanpcap.h>
 
-TwoCanPcap::TwoCanPcap(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
+TwoCanPcapFile::TwoCanPcapFile(void) {
+	readOffset = 0;
+	isPcapNg = false;
+	isSwapped = false;
+	unitsPerSecond = 1e6;
+	linkType = 0;
+	lastTimestamp = 0;
 }
 
-TwoCanPcap::~TwoCanPcap() {
+TwoCanPcapFile::~TwoCanPcapFile(void) {
+	Close();
 }
 
-int TwoCanPcap::Open(const wxString& fileName) {
-    std::vector<byte>  readBuffer(1024, 0);
-	std::streamsize bytesRead;
-	// Open the log file
-	logFileName = wxStandardPaths::Get().GetDocumentsDir() + wxFileName::GetPathSeparator() + fileName;
-	
-	wxLogMessage(_T("TwoCan Pcap, Opening log file: %s"),logFileName);
-	
-	logFileStream.open(logFileName, std::ifstream::in | std::ifstream::binary);	
-
-	if (logFileStream.fail()) {
-		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_FILE_NOT_FOUND);
+int TwoCanPcapFile::Open(const wxString& fileName) {
+	int returnCode = logFile.Open(fileName);
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		return returnCode;
 	}
 	
 	// Test the log file format by reading the pcap file header
     // refer to https://tools.ietf.org/id/draft-gharris-opsawg-pcap-00.html
-	logFileStream.read(reinterpret_cast<char *>(readBuffer.data()), PCAP_FILE_HEADER_LENGTH); 
-
-	bytesRead = logFileStream.gcount();
+	size_t bytesRead = PCAP_FILE_HEADER_LENGTH;
+	const byte *readBuffer = logFile.Map(0, &bytesRead);
 
-	if (bytesRead != PCAP_FILE_HEADER_LENGTH) {
+	if ((readBuffer == NULL) || (bytesRead != PCAP_FILE_HEADER_LENGTH)) {
         wxLogMessage(_T("TwoCan Pcap, Error reading pcap header"));
         return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
 	}
 
     unsigned int magicNumber = readBuffer[0] | (readBuffer[1] << 8) | (readBuffer[2] << 16) | (readBuffer[3] << 24);
-	unsigned int majorVersion = readBuffer[4] | (readBuffer[5] << 8);
-	unsigned int minorVersion = readBuffer[6] | (readBuffer[7] << 8);
+
+	wxLogMessage(_T("TwoCan Pcap, Magic Number: %X"), magicNumber);
+
+	// pcapng files start with a Section Header Block
+	if (magicNumber == PCAPNG_SECTION_HEADER_BLOCK) {
+		isPcapNg = true;
+		
+		// Walk the first few blocks to find the Interface Description Blocks
+		byte frame[CONST_FRAME_LENGTH];
+		unsigned long long timestamp;
+		Rewind();
+		for (int i = 0; (i < 16) && (NextPcapNgPacket(frame, &timestamp) != PcapPacketEnd); i++) {
+		}
+		
+		bool hasSocketCan = false;
+		for (auto it : interfaces) {
+			wxLogMessage(_T("TwoCan Pcap, Interface Link Type: %u, Resolution: %.0f"), it.linkType, it.unitsPerSecond);
+			if (it.linkType == LINKTYPE_CAN_SOCKETCAN) {
+				hasSocketCan = true;
+			}
+		}
+		
+		Rewind();
+		
+		if (!hasSocketCan) {
+			wxLogMessage(_T("TwoCan Pcap, PCAPNG file has no Socket CAN interfaces"));
+			return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
+		}
+		
+		wxLogMessage(_T("TwoCan Pcap, PCAPNG File successfully opened"));
+		return TWOCAN_RESULT_SUCCESS;
+	}
+
+    // Check for a valid magic number, 0xA1B2C3D4 (seconds & microseconds) or 0xA1B23C4D (seconds & nanoseconds)	
+	// in either byte order
+	switch (magicNumber) {
+		case PCAP_MAGIC_MICROSECONDS:
+			isSwapped = false;
+			unitsPerSecond = 1e6;
+			break;
+		case PCAP_MAGIC_NANOSECONDS:
+			isSwapped = false;
+			unitsPerSecond = 1e9;
+			break;
+		case PCAP_MAGIC_MICROSECONDS_SWAPPED:
+			isSwapped = true;
+			unitsPerSecond = 1e6;
+			break;
+		case PCAP_MAGIC_NANOSECONDS_SWAPPED:
+			isSwapped = true;
+			unitsPerSecond = 1e9;
+			break;
+		default:
+			wxLogMessage(_T("TwoCan Pcap, PCAP file invalid magic number: %X"), magicNumber);
+			return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
+	}
+
+	isPcapNg = false;
+
+	unsigned int majorVersion = Read16(&readBuffer[4]);
+	unsigned int minorVersion = Read16(&readBuffer[6]);
 		
     // Reserved 8,9,10,11,
 	// Reserved12, 13, 14,15
 		
-	unsigned int snapLen = readBuffer[16] | (readBuffer[17] << 8) | (readBuffer[18] << 16) | (readBuffer[19] << 24);
-	unsigned int linkType = readBuffer[20] | (readBuffer[21] << 8) | (readBuffer[22] << 16) | ((readBuffer[23] & 0x0F) << 24);
-	unsigned char frameCyclicSequence = (readBuffer[23] & 0xF0) >> 4;
+	unsigned int snapLen = Read32(&readBuffer[16]);
+	unsigned int linkTypeField = Read32(&readBuffer[20]);
+	linkType = linkTypeField & 0x0FFFFFFF;
+	unsigned char frameCyclicSequence = (linkTypeField & 0xF0000000) >> 28;
 
-	wxLogMessage(_T("TwoCan Pcap, Magic Number: %X"), magicNumber);
 	wxLogMessage(_T("TwoCan Pcap, Version: %d.%d"), majorVersion, minorVersion);
 	wxLogMessage(_T("TwoCan Pcap, Snap Length: %d"), snapLen);
 	wxLogMessage(_T("TwoCan Pcap, Link Type: %d"), linkType);
 	wxLogMessage(_T("TwoCan Pcap, Frame Cyclic Sequence: %d"), frameCyclicSequence);
 
-    // Check for a valid magic number, 0xA1B2C3D4 (seconds & microseconds) or 0xA1B23C4D (seconds & nanoseconds)	
-    if ((magicNumber != 0xA1B2C3D4) && (magicNumber != 0xA1B23C4D)) { 
-		wxLogMessage(_T("TwoCan Pcap, PCAP file invalid magic number: %X"), magicNumber);
-        return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
-	}
-
     // Check that link type is valid, ie. SocketCAN	
 	if (linkType != LINKTYPE_CAN_SOCKETCAN) { 
 		wxLogMessage(_T("TwoCan Pcap, PCAP file is not Socket CAN: %u"), linkType);
         return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_INVALID_LOGFILE_FORMAT);
 	}
 	
+	Rewind();
+	
 	wxLogMessage(_T("TwoCan Pcap, File successfully opened"));
 	return TWOCAN_RESULT_SUCCESS;
 }
 
+void TwoCanPcapFile::Close(void) {
+	logFile.Close();
+}
+
+void TwoCanPcapFile::Rewind(void) {
+	// pcapng starts with the Section Header Block, which resets the interfaces
+	readOffset = isPcapNg ? 0 : PCAP_FILE_HEADER_LENGTH;
+	interfaces.clear();
+	lastTimestamp = 0;
+}
+
+int TwoCanPcapFile::NextPacket(byte *frame, unsigned long long *timestamp) {
+	return isPcapNg ? NextPcapNgPacket(frame, timestamp) : NextPcapPacket(frame, timestamp);
+}
+
+int TwoCanPcapFile::NextPcapPacket(byte *frame, unsigned long long *timestamp) {
+	// Read packet header
+	size_t bytesRead = PCAP_PACKET_HEADER_LENGTH;
+	const byte *packetHeader = logFile.Map(readOffset, &bytesRead);
+
+	if ((packetHeader == NULL) || (bytesRead != PCAP_PACKET_HEADER_LENGTH)) {
+		return PcapPacketEnd;
+	}
+
+	// Bytes 0 - 3 seconds, 4 - 7 microseconds or nanoseconds depending on the magic number, 12 - 15 original packet length
+	// The captured length is the number of bytes actually stored in the file
+	unsigned int seconds = Read32(&packetHeader[0]);
+	unsigned int fraction = Read32(&packetHeader[4]);
+	unsigned int capturePacketLength = Read32(&packetHeader[8]);
+
+	if (capturePacketLength > PCAP_MAX_PACKET_LENGTH) {
+		// Corrupt packet header, no way to resynchronise
+		wxLogMessage(_T("TwoCan Pcap, Invalid packet length: %u"), capturePacketLength);
+		return PcapPacketEnd;
+	}
+
+	// Read packet data, in place
+	bytesRead = capturePacketLength;
+	const byte *packetData = logFile.Map(readOffset + PCAP_PACKET_HEADER_LENGTH, &bytesRead);
+
+	if ((packetData == NULL) || (bytesRead != capturePacketLength)) {
+		// Truncated packet at the end of the file
+		return PcapPacketEnd;
+	}
+
+	readOffset += PCAP_PACKET_HEADER_LENGTH + capturePacketLength;
+
+	*timestamp = ((unsigned long long)seconds * 1000000) + (unsigned long long)(fraction * (1e6 / unitsPerSecond));
+
+	return DecodePacket(packetData, capturePacketLength, frame) ? PcapPacketFrame : PcapPacketSkip;
+}
+
+int TwoCanPcapFile::NextPcapNgPacket(byte *frame, unsigned long long *timestamp) {
+	// Block Type & Block Total Length
+	size_t bytesRead = PCAPNG_BLOCK_HEADER_LENGTH + 4;
+	const byte *block = logFile.Map(readOffset, &bytesRead);
+
+	if ((block == NULL) || (bytesRead < PCAPNG_BLOCK_HEADER_LENGTH)) {
+		return PcapPacketEnd;
+	}
+
+	// The Section Header Block type is a palindrome, the byte order magic that follows determines the byte order of the section
+	unsigned int blockType = block[0] | (block[1] << 8) | (block[2] << 16) | (block[3] << 24);
+	if (blockType == PCAPNG_SECTION_HEADER_BLOCK) {
+		if (bytesRead != PCAPNG_BLOCK_HEADER_LENGTH + 4) {
+			return PcapPacketEnd;
+		}
+		unsigned int byteOrderMagic = block[8] | (block[9] << 8) | (block[10] << 16) | (block[11] << 24);
+		if (byteOrderMagic == PCAPNG_BYTE_ORDER_MAGIC) {
+			isSwapped = false;
+		}
+		else if (byteOrderMagic == PCAPNG_BYTE_ORDER_MAGIC_SWAPPED) {
+			isSwapped = true;
+		}
+		else {
+			wxLogMessage(_T("TwoCan Pcap, PCAPNG invalid byte order magic: %X"), byteOrderMagic);
+			return PcapPacketEnd;
+		}
+		// Interface ids are local to each section
+		interfaces.clear();
+	}
+	else {
+		blockType = Read32(&block[0]);
+	}
+
+	unsigned int blockLength = Read32(&block[4]);
+	if ((blockLength < PCAPNG_MIN_BLOCK_LENGTH) || ((blockLength % 4) != 0) || (blockLength > PCAP_MAX_PACKET_LENGTH)) {
+		wxLogMessage(_T("TwoCan Pcap, PCAPNG invalid block length: %u"), blockLength);
+		return PcapPacketEnd;
+	}
+
+	// Map the entire block, in place
+	bytesRead = blockLength;
+	block = logFile.Map(readOffset, &bytesRead);
+	if ((block == NULL) || (bytesRead != blockLength)) {
+		return PcapPacketEnd;
+	}
+
+	readOffset += blockLength;
+
+	const byte *body = &block[PCAPNG_BLOCK_HEADER_LENGTH];
+	unsigned int bodyLength = blockLength - PCAPNG_MIN_BLOCK_LENGTH;
+
+	switch (blockType) {
+
+		case PCAPNG_INTERFACE_DESCRIPTION_BLOCK:
+			ParseInterfaceDescription(body, bodyLength);
+			return PcapPacketSkip;
+
+		case PCAPNG_ENHANCED_PACKET_BLOCK: {
+			// Interface Id, Timestamp (High), Timestamp (Low), Captured Length, Original Length, Packet Data
+			if (bodyLength < 20) {
+				return PcapPacketSkip;
+			}
+			unsigned int interfaceId = Read32(&body[0]);
+			unsigned long long rawTimestamp = ((unsigned long long)Read32(&body[4]) << 32) | Read32(&body[8]);
+			unsigned int capturePacketLength = Read32(&body[12]);
+			if ((interfaceId >= interfaces.size()) || (capturePacketLength > bodyLength - 20)) {
+				return PcapPacketSkip;
+			}
+			lastTimestamp = (unsigned long long)(rawTimestamp * (1e6 / interfaces[interfaceId].unitsPerSecond));
+			*timestamp = lastTimestamp;
+			if (interfaces[interfaceId].linkType != LINKTYPE_CAN_SOCKETCAN) {
+				return PcapPacketSkip;
+			}
+			return DecodePacket(&body[20], capturePacketLength, frame) ? PcapPacketFrame : PcapPacketSkip;
+		}
+
+		case PCAPNG_SIMPLE_PACKET_BLOCK: {
+			// Original Length, Packet Data. Implicitly the first interface and has no timestamp
+			if ((bodyLength < 4) || (interfaces.size() == 0) || (interfaces[0].linkType != LINKTYPE_CAN_SOCKETCAN)) {
+				return PcapPacketSkip;
+			}
+			unsigned int capturePacketLength = Read32(&body[0]);
+			if (capturePacketLength > bodyLength - 4) {
+				capturePacketLength = bodyLength - 4;
+			}
+			*timestamp = lastTimestamp;
+			return DecodePacket(&body[4], capturePacketLength, frame) ? PcapPacketFrame : PcapPacketSkip;
+		}
+
+		default:
+			// Section Header, Name Resolution, Interface Statistics etc.
+			return PcapPacketSkip;
+	}
+}
+
+// Link Type, Reserved, Snap Length followed by options
+void TwoCanPcapFile::ParseInterfaceDescription(const byte *body, const unsigned int bodyLength) {
+	PcapInterface pcapInterface;
+	pcapInterface.linkType = (bodyLength >= 2) ? Read16(&body[0]) : 0;
+	pcapInterface.unitsPerSecond = 1e6;
+
+	unsigned int position = 8;
+	while (position + 4 <= bodyLength) {
+		unsigned short optionCode = Read16(&body[position]);
+		unsigned short optionLength = Read16(&body[position + 2]);
+		if ((optionCode == PCAPNG_OPTION_END) || (position + 4 + optionLength > bodyLength)) {
+			break;
+		}
+		if ((optionCode == PCAPNG_OPTION_IF_TSRESOL) && (optionLength >= 1)) {
+			// Most significant bit indicates a negative power of two, otherwise a negative power of ten
+			byte resolution = body[position + 4];
+			if (resolution & 0x80) {
+				pcapInterface.unitsPerSecond = ldexp(1.0, resolution & 0x7F);
+			}
+			else {
+				pcapInterface.unitsPerSecond = pow(10.0, resolution);
+			}
+		}
+		// Options are padded to 32 bits
+		position += 4 + ((optionLength + 3) & ~3);
+	}
+
+	interfaces.push_back(pcapInterface);
+}
+
+// Convert a SocketCAN packet to a TwoCan frame, returns false if not a 29 bit extended frame
+bool TwoCanPcapFile::DecodePacket(const byte *packetData, const unsigned int packetLength, byte *frame) {
+	if ((packetLength < PCAP_CAN_HEADER_LENGTH) || ((packetData[0] & PCAP_CAN_EFF_FLAG) == 0)) {
+		return false;
+	}
+
+	// can_id is stored in network byte order
+	frame[3] = packetData[0] & 0x1F;
+	frame[2] = packetData[1];
+	frame[1] = packetData[2];
+	frame[0] = packetData[3];
+
+	// Data length code, pad any unused bytes
+	unsigned int dataLength = packetData[4];
+	if (dataLength > CONST_PAYLOAD_LENGTH) {
+		dataLength = CONST_PAYLOAD_LENGTH;
+	}
+	if (dataLength > packetLength - PCAP_CAN_HEADER_LENGTH) {
+		dataLength = packetLength - PCAP_CAN_HEADER_LENGTH;
+	}
+	memcpy(&frame[CONST_HEADER_LENGTH], &packetData[PCAP_CAN_HEADER_LENGTH], dataLength);
+	memset(&frame[CONST_HEADER_LENGTH + dataLength], 0xFF, CONST_PAYLOAD_LENGTH - dataLength);
+	return true;
+}
+
+TwoCanPcap::TwoCanPcap(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
+}
+
+TwoCanPcap::~TwoCanPcap() {
+}
+
+int TwoCanPcap::Open(const wxString& fileName) {
+	// Open the log file
+	logFileName = wxStandardPaths::Get().GetDocumentsDir() + wxFileName::GetPathSeparator() + fileName;
+	
+	wxLogMessage(_T("TwoCan Pcap, Opening log file: %s"),logFileName);
+	
+	return pcapFile.Open(logFileName);
+}
+
 int TwoCanPcap::Close(void) {
-	if (logFileStream.is_open()) {
-		logFileStream.close();
+	if (pcapFile.IsOpen()) {
+		pcapFile.Close();
 		wxLogMessage(_T("TwoCan Pcap, Log File closed"));
 	}
 	return TWOCAN_RESULT_SUCCESS;
 }
 
-
+// Frames are replayed at the rate they were captured and posted to the TwoCan device in batches
 void TwoCanPcap::Read() {
-	
-	std::vector<byte>  readBuffer(1024, 0);
-	std::streamsize bytesRead;
-    std::vector<byte> canFrame(CONST_FRAME_LENGTH);
+	byte frame[CONST_FRAME_LENGTH];
+	unsigned long long timestamp;
+	unsigned long long batchStart = 0;
+	// Relates the capture time to the wall clock time
+	unsigned long long captureAnchor = 0;
+	unsigned long long replayAnchor = 0;
+	bool isAnchored = false;
+	std::vector<byte> postedFrames;
+	postedFrames.reserve(PCAP_BATCH_FRAMES * CONST_FRAME_LENGTH);
 
-	unsigned int capturePacketLength;
+	// Position cursor at begining of packet data
+	pcapFile.Rewind();
 
-    // Position cursor at begining of packet data
-    logFileStream.clear();
-	logFileStream.seekg(PCAP_FILE_HEADER_LENGTH, std::ios::beg); 
-	
+	while (!TestDestroy()) {
 
-    while (!logFileStream.eof()) {
+		int result = pcapFile.NextPacket(frame, &timestamp);
 
-        if (!TestDestroy()) {
-		
-            readBuffer.clear();
-
-            // Read packet header
-            logFileStream.read(reinterpret_cast<char *>(readBuffer.data()), PCAP_PACKET_HEADER_LENGTH); 
-
-            bytesRead = logFileStream.gcount();
-
-            if (bytesRead == PCAP_PACKET_HEADER_LENGTH) {
-                // BUG BUG Note that depending on magic number, microseconds may instead be nanoseconds (also Endianess)
-                unsigned int seconds = readBuffer[0] | (readBuffer[1] << 8) | (readBuffer[2] << 16) | (readBuffer[3] << 24);
-                unsigned int microSeconds = readBuffer[4] | (readBuffer[5] << 8) | (readBuffer[6] << 16) | (readBuffer[7] << 24);
-                capturePacketLength = readBuffer[8] | (readBuffer[9] << 8) | (readBuffer[10] << 16) | (readBuffer[11] << 24);
-                int actualPacketLength = readBuffer[12] | (readBuffer[13] << 8) | (readBuffer[14] << 16) | (readBuffer[15] << 24);
-
-                // Read packet data
-                readBuffer.clear();
-
-                logFileStream.read(reinterpret_cast<char *>(readBuffer.data()), actualPacketLength); 
-
-                bytesRead = logFileStream.gcount();
-
-                if (bytesRead == actualPacketLength) {
-
-                    PcapCanFrame *cf = (PcapCanFrame *)readBuffer.data();
-
-                    // BUG BUG Should check that this is an extended frame
-                    canFrame[3] = cf->can_id & 0xFF;
-                    canFrame[2] = (cf->can_id >> 8) & 0xFF;
-                    canFrame[1] = (cf->can_id >> 16) & 0xFF;
-                    canFrame[0] = (cf->can_id >> 24) & 0xFF;
-
-                    // BUG BUG Should check that DLC == 8                         
-                    canFrame[4] = cf->data[0];
-                    canFrame[5] = cf->data[1];
-                    canFrame[6] = cf->data[2];
-                    canFrame[7] = cf->data[3];
-                    canFrame[8] = cf->data[4];
-                    canFrame[9] = cf->data[5];
-                    canFrame[10] = cf->data[6];
-                    canFrame[11] = cf->data[7];
-                        
-                    // Post frame to TwoCan device
-                    deviceQueue->Post(canFrame);
-                    // BUG BUG Should really calculate the delay based on the packet time
-                    wxThread::Sleep(20);
-            
-                }
-                else {
-                    // BUG BUG Error reading data
-                }
-            }
-            else {
-                // BUG BUG Error reading packet header   
-            }
-
-            // If end of file, rewind to beginning of packet data
-            if (logFileStream.eof()) {
-                logFileStream.clear();
-                logFileStream.seekg(PCAP_FILE_HEADER_LENGTH, std::ios::beg); 
-            }
-        }
-        
-        else {
-			// Thread Exiting
-			break;
+		if (result == PcapPacketSkip) {
+			continue;
 		}
-        
-	} // end not eof
-	
+
+		if (result == PcapPacketEnd) {
+			// If end of file, post any remaining frames and rewind to beginning of packet data
+			if (postedFrames.size() > 0) {
+				deviceQueue->Post(postedFrames);
+				postedFrames.clear();
+			}
+			pcapFile.Rewind();
+			isAnchored = false;
+			wxThread::Sleep(20);
+			continue;
+		}
+
+		// Post the current batch once it spans the batch interval or is full
+		if ((postedFrames.size() > 0) && ((timestamp < batchStart) || (timestamp - batchStart >= PCAP_BATCH_INTERVAL) ||
+			(postedFrames.size() >= PCAP_BATCH_FRAMES * CONST_FRAME_LENGTH))) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+
+		if (postedFrames.size() == 0) {
+			batchStart = timestamp;
+			unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+			if ((!isAnchored) || (timestamp < captureAnchor) || (timestamp - captureAnchor > (now - replayAnchor) + PCAP_MAX_REPLAY_GAP)) {
+				// First frame, timestamps went backwards or a long gap in the capture
+				captureAnchor = timestamp;
+				replayAnchor = now;
+				isAnchored = true;
+			}
+			else {
+				// Wait until this frame is due, checking between each slice whether we are exiting
+				unsigned long long due = replayAnchor + (timestamp - captureAnchor);
+				while ((due > now + 1000) && (!TestDestroy())) {
+					unsigned long long wait = (due - now) / 1000;
+					wxThread::Sleep(wait < PCAP_REPLAY_SLEEP_SLICE ? wait : PCAP_REPLAY_SLEEP_SLICE);
+					now = TwoCanUtils::GetTimeInMicroseconds();
+				}
+			}
+		}
+
+		postedFrames.insert(postedFrames.end(), frame, frame + CONST_FRAME_LENGTH);
+
+	} // end not exiting
+
 }
 
 // Entry, the method that is executed upon thread start
@@ -31,12 +31,26 @@
 // 2.0 - 04/07/2021 Bi-Directional Gateway, Kvaser support on Mac OSX, Fast Message Assembly & SID generation fix, PCAP log file support 
 // 2.1 - 20/05/2022 Minor fix to GGA/DBT in Gateway, DSC & MOB Sentences, Waypoint creation, epoch time fixes (time_t)0
 // wxWidgets 3.15 support for MacOSX, Fusion Media control, OCPN Messaging for NMEA 2000 Transmit, Extend PGN 130312 for Engine Exhaust
+// 2.2 - 01/08/2022 Flight recorder trigger, frames are queued to the transmit scheduler rather than sent with delays
+// Gateway throttled when the network is busy, Bus load statistics for other plugins, Wake the device thread on termination
+// Fast message frames queued as a single burst, NMEA 183 sentences encoded directly into a reusable frame arena
+// NMEA 183 sentences queued to the gateway's thread for encoding rather than encoded on the OpenCPN main thread
+// Gateway discards echoes of the sentences it converted from NMEA 2000 and sentences from ignored talkers
+// Gateway coalesces PGN's generated by several sentences
+// Batched transmission of hexadecimal or base64 payloads, transmit function for co-loaded plugins
+// Route export, waypoints packed directly into PGN 129285 & 130074 messages
+// Gateway front end rejects corrupt and unconverted sentences before they are queued
+// Exported routes that exceed the transmit queue are resubmitted as it drains
 // Outstanding Features: 
 // 1. Localization ??
 //
 
 #include "twocanplugin.h"
 
+// The plugin instance used by the transmit function that is invoked directly by other plugins
+static TwoCan *transmitPlugin = nullptr;
+static std::mutex transmitMutex;
+
 // The class factories, used to create and destroy instances of the PlugIn
 extern "C" DECL_EXP opencpn_plugin* create_pi(void *ppimgr) {
 	return new TwoCan(ppimgr);
@@ -90,6 +104,11 @@ int TwoCan::Init(void) {
 	// which is what happens upon first startup. Bugger, there must be a better way.
 	twoCanDevice = nullptr;
 	twoCanEncoder = nullptr;
+	twoCanGateway = nullptr;
+	exportTimer = nullptr;
+	exportRetries = 0;
+	isGatewayThrottled = FALSE;
+	throttledSentences = 0;
 	twoCanAutopilot = nullptr;
 	twoCanMedia = nullptr;
 	
@@ -99,6 +118,11 @@ int TwoCan::Init(void) {
 	// if the rug is pulled from underneath us
 	isRunning = TRUE;
 
+	{
+		const std::lock_guard<std::mutex> lock(transmitMutex);
+		transmitPlugin = this;
+	}
+
 	// Load the configuration items
 	if (LoadConfiguration()) {
 		// Initialize and run the TwoCanDevice in it's own thread
@@ -124,6 +148,11 @@ bool TwoCan::DeInit(void) {
 	// Notify other threads to end their work cleanly
 	isRunning = FALSE;
 
+	{
+		const std::lock_guard<std::mutex> lock(transmitMutex);
+		transmitPlugin = nullptr;
+	}
+
 	// Persist our network address to prevent address claim conflicts next time we start
 	if (deviceMode == TRUE) {
 		if (configSettings) {
@@ -140,6 +169,13 @@ bool TwoCan::DeInit(void) {
 			}
 		}
 	}
+
+	StopExport();
+	if (exportTimer != nullptr) {
+		exportTimer->Unbind(wxEVT_TIMER, &TwoCan::OnExportTimer, this);
+		delete exportTimer;
+		exportTimer = nullptr;
+	}
 	// Do not need to explicitly call the destructor for detached threads
 	return TRUE;
 }
@@ -185,25 +221,37 @@ wxBitmap* TwoCan::GetPlugInBitmap() {
 
 // Convert NMEA 183 sentences to NMEA 2000 messages
 void TwoCan::SetNMEASentence(wxString &sentence) {
-	if ((isRunning) && (twoCanEncoder != nullptr)  && (twoCanDevice != nullptr) && (deviceMode == TRUE) && (enableGateway == TRUE)) {
-		std::vector<CanMessage> nmeaMessages;
+	if ((isRunning) && (twoCanGateway != nullptr)  && (twoCanDevice != nullptr) && (deviceMode == TRUE) && (enableGateway == TRUE)) {
+		// Reject corrupt sentences and those that are never converted, cheaply and before any parsing
+		if (!twoCanGateway->IsAccepted(sentence)) {
+			return;
+		}
 
-		if (twoCanEncoder->EncodeMessage(sentence, &nmeaMessages) == TRUE) {
-			unsigned int id;
-			int returnCode;
-			// Some NMEA 183 sentence conversions generate multipe NMEA 2000 PGN's
-			// Also if the PGN is a fast message, there will be multiple frames
-			// So we need a vector of frames to be sent
-			for (auto it : nmeaMessages) {
-				TwoCanUtils::EncodeCanHeader(&id, &it.header);
-				returnCode = twoCanDevice->TransmitFrame(id, it.payload.data());
-				if (returnCode != TWOCAN_RESULT_SUCCESS) {
-					wxLogMessage(_T("TwoCan Plugin, Error sending converted NMEA 183 sentence: %d"), returnCode);
+		// Don't convert sentences that we generated ourselves back to NMEA 2000, nor those from ignored talkers
+		if (twoCanGateway->IsSuppressed(sentence)) {
+			return;
+		}
+
+		// If the network is busy, only forward safety related sentences (MOB, DSC & DSE)
+		if (twoCanDevice->GetBusLoad() > CONST_BUSLOAD_GATEWAY_LIMIT) {
+			if (!TwoCanGateway::IsEssential(sentence)) {
+				if (!isGatewayThrottled) {
+					wxLogMessage(_T("TwoCan Plugin, Network busy, gateway discarding non essential sentences"));
+					isGatewayThrottled = TRUE;
 				}
-				wxThread::Sleep(CONST_TEN_MILLIS);
-				
+				throttledSentences++;
+				return;
 			}
 		}
+		else if (isGatewayThrottled) {
+			wxLogMessage(_T("TwoCan Plugin, Gateway resumed, discarded %d sentences"), throttledSentences);
+			isGatewayThrottled = FALSE;
+			throttledSentences = 0;
+		}
+
+		// Queue the sentence and return immediately, it is encoded and transmitted by the gateway's thread
+		// If the queue is full the gateway discards the sentence and logs the overflow
+		twoCanGateway->Enqueue(sentence);
 	} 
 }
 
@@ -211,7 +259,11 @@ void TwoCan::SetNMEASentence(wxString &sentence) {
 void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 	// Receive MOB events from OpenCPN and generate corresponding NMEA 2000 message, PGN 127233
 	if (message_id == _T("OCPN_MAN_OVERBOARD")) {
-		if ((deviceMode == TRUE) && (twoCanDevice != nullptr) && (twoCanEncoder != nullptr)) {
+		// Capture the network traffic surrounding the incident
+		if (twoCanDevice != nullptr) {
+			twoCanDevice->TriggerRecorder(_T("Man Overboard (OpenCPN)"));
+		}
+		if ((deviceMode == TRUE) && (twoCanDevice != nullptr) && (twoCanGateway != nullptr)) {
 			wxJSONValue root;
 			wxJSONReader reader;
 			if (reader.Parse(message_body, &root) > 0) {
@@ -248,19 +300,9 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 						nmea0183.Mob.Position.Longitude.Easting = it->m_lon >= 0 ? EASTWEST::East : EASTWEST::West;
 						nmea0183.Mob.Write(sentence);
 
-						std::vector<CanMessage> messages;
-
-						if (twoCanEncoder->EncodeMessage(sentence, &messages) == TRUE) {
-							unsigned int id;
-							int returnCode;
-							for (auto it : messages) {
-								TwoCanUtils::EncodeCanHeader(&id, &it.header);
-								returnCode = twoCanDevice->TransmitFrame(id, it.payload.data());
-								if (returnCode != TWOCAN_RESULT_SUCCESS) {
-									wxLogMessage(_T("TwoCan Plugin, Error sending MOB message: %d"), returnCode);
-								}
-								wxThread::Sleep(CONST_TEN_MILLIS);
-							}
+						int returnCode = twoCanGateway->Enqueue(sentence);
+						if (returnCode != TWOCAN_RESULT_SUCCESS) {
+							wxLogMessage(_T("TwoCan Plugin, Error sending MOB message: %d"), returnCode);
 						}
 
 						break;
@@ -270,20 +312,46 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 		}
 	}
 
+	// Request the flight recorder write recent traffic to disk, the message body is an optional description of the trigger
+	else if (message_id == _T("TWOCAN_RECORDER_TRIGGER")) {
+		if (twoCanDevice != nullptr) {
+			twoCanDevice->TriggerRecorder(message_body.IsEmpty() ? _T("Plugin Message") : message_body);
+		}
+	}
+
+	// Report the network utilisation to the requesting plugin
+	else if (message_id == _T("TWOCAN_BUSLOAD_REQUEST")) {
+		if (twoCanDevice != nullptr) {
+			BusLoadStatistics shortStatistics;
+			BusLoadStatistics longStatistics;
+			twoCanDevice->GetBusLoadStatistics(&shortStatistics, CONST_BUSLOAD_WINDOW_SHORT);
+			twoCanDevice->GetBusLoadStatistics(&longStatistics, CONST_BUSLOAD_WINDOW_LONG);
+
+			wxJSONValue root;
+			wxJSONWriter writer;
+			wxString jsonResponse;
+			root["busload"]["load"] = shortStatistics.loadPercent;
+			root["busload"]["framespersecond"] = shortStatistics.framesPerSecond;
+			root["busload"]["bytespersecond"] = shortStatistics.bytesPerSecond;
+			root["busload"]["averageload"] = longStatistics.loadPercent;
+			for (int priority = 0; priority < 8; priority++) {
+				root["busload"]["priority"][priority]["framespersecond"] = shortStatistics.priorityFramesPerSecond[priority];
+				root["busload"]["priority"][priority]["bytespersecond"] = shortStatistics.priorityBytesPerSecond[priority];
+			}
+			writer.Write(root, jsonResponse);
+			SendPluginMessage(_T("TWOCAN_BUSLOAD_RESPONSE"), jsonResponse);
+		}
+	}
+
 	// Control Fusion Media player, media player commands are generated by TwoCan Media plugin
 	else if (message_id == _T("TWOCAN_MEDIA_REQUEST")) {
 		if ((deviceMode == TRUE) && (enableMusic == TRUE) && (twoCanDevice != nullptr) && (twoCanMedia != nullptr)) {
 			std::vector<CanMessage> messages;
-			unsigned int id;
 			int returnCode;
 			if (twoCanMedia->EncodeMediaCommand(message_body, &messages)) {
-				for (auto it : messages) {
-					TwoCanUtils::EncodeCanHeader(&id, &it.header);
-					returnCode = twoCanDevice->TransmitFrame(id, it.payload.data());
-					if (returnCode != TWOCAN_RESULT_SUCCESS) {
-						wxLogMessage(_T("TwoCan Plugin, Error sending Media Player command: %d"), returnCode);
-					}
-					wxThread::Sleep(CONST_TEN_MILLIS);
+				returnCode = twoCanDevice->TransmitMessages(&messages);
+				if (returnCode != TWOCAN_RESULT_SUCCESS) {
+					wxLogMessage(_T("TwoCan Plugin, Error sending Media Player command: %d"), returnCode);
 				}
 			}
 		}
@@ -292,11 +360,9 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 	// Handle request to export waypoints via NMEA 2000 - initiated by Two Tools plugin
 	// Not used as the Toys plugin uses the TWOCAN_TRAMSIT_MESSAGE mechanism
 	else if (message_id == _T("TWOCAN_EXPORT_WAYPOINTS")) {
-		if ((deviceMode == TRUE) && (enableWaypoint == TRUE) && (twoCanDevice != nullptr) && (twoCanEncoder != nullptr)) {
+		if ((deviceMode == TRUE) && (enableWaypoint == TRUE) && (twoCanDevice != nullptr)) {
 			wxJSONValue root;
 			wxJSONReader reader;
-			NMEA0183 nmea0183;
-			SENTENCE sentence;
 
 			if (reader.Parse(message_body, &root) > 0) {
 				wxLogMessage("TwoCan plugin, JSON Error in following text:");
@@ -314,29 +380,16 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 						// No counterpart for PGN 130074 description to store the description value
 						//root["navico"]["exportwaypoint"]["description"]
 
-						// Use the existing NMEA 183 WPL encoder to encode the NMEA 2000 message. 
-						// As described above, a little inefficient
-						nmea0183.TalkerID = "EC";
-						nmea0183.Wpl.To = root["navico"]["exportwaypoint"]["name"].AsString();
-						nmea0183.Wpl.Position.Latitude.Latitude = root["navico"]["exportwaypoint"]["latitude"].AsDouble();
-						nmea0183.Wpl.Position.Latitude.Northing = nmea0183.Wpl.Position.Latitude.Latitude >= 0 ? NORTHSOUTH::North : NORTHSOUTH::South;
-						nmea0183.Wpl.Position.Longitude.Longitude = root["navico"]["exportwaypoint"]["longitude"].AsDouble(); // GetJsonDouble(value);
-						nmea0183.Wpl.Position.Longitude.Easting = nmea0183.Wpl.Position.Longitude.Longitude >= 0 ? EASTWEST::East : EASTWEST::West;
-						nmea0183.Wpl.Write(sentence);
-
-						std::vector<CanMessage> messages;
-
-						if (twoCanEncoder->EncodeMessage(sentence, &messages) == TRUE) {
-							unsigned int id;
-							int returnCode;
-							for (auto it : messages) {
-								TwoCanUtils::EncodeCanHeader(&id, &it.header);
-								returnCode = twoCanDevice->TransmitFrame(id, it.payload.data());
-								if (returnCode != TWOCAN_RESULT_SUCCESS) {
-									wxLogMessage(_T("TwoCan Plugin, Error sending Waypoint export message: %d"), returnCode);
-								}
-								wxThread::Sleep(CONST_TEN_MILLIS);
-							}
+						// Encode the waypoint directly as PGN 130074, rather than via a NMEA 183 WPL sentence
+						PlugIn_Waypoint waypoint(root["navico"]["exportwaypoint"]["latitude"].AsDouble(), root["navico"]["exportwaypoint"]["longitude"].AsDouble(),
+							wxEmptyString, root["navico"]["exportwaypoint"]["name"].AsString());
+						std::vector<const PlugIn_Waypoint *> waypoints = { &waypoint };
+						std::vector<PayloadWriter> payloads;
+						size_t waypointListCount = TwoCanEncoder::EncodeWaypointLists(waypoints, &payloads);
+
+						int returnCode = TransmitExportPayloads(payloads, waypointListCount);
+						if (returnCode != TWOCAN_RESULT_SUCCESS) {
+							wxLogMessage(_T("TwoCan Plugin, Error sending Waypoint export message: %d"), returnCode);
 						}
 					}
 				}
@@ -344,6 +397,48 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 		}
 	}
 
+	// Export an OpenCPN route to NMEA 2000 devices such as chartplotters, eg. {"GUID":"..."}
+	// The waypoints are sent in as few PGN 130074 messages as possible, followed by the route in PGN 129285 messages
+	else if (message_id == _T("TWOCAN_EXPORT_ROUTE")) {
+		if ((deviceMode == TRUE) && (enableWaypoint == TRUE) && (twoCanDevice != nullptr)) {
+			wxJSONValue root;
+			wxJSONReader reader;
+
+			if (reader.Parse(message_body, &root) > 0) {
+				wxLogMessage("TwoCan plugin, JSON Error in following text:");
+				wxLogMessage("%s", message_body);
+				wxArrayString jsonErrors = reader.GetErrors();
+				for (auto it : jsonErrors) {
+					wxLogMessage(it);
+				}
+				return;
+			}
+			else {
+				std::unique_ptr<PlugIn_Route> exportRoute;
+				exportRoute = GetRoute_Plugin(root[_T("GUID")].AsString());
+				if ((exportRoute == nullptr) || (exportRoute->pWaypointList == nullptr)) {
+					wxLogMessage(_T("TwoCan Plugin, Route for export not found: %s"), root[_T("GUID")].AsString());
+					return;
+				}
+
+				std::vector<const PlugIn_Waypoint *> waypoints;
+				for (auto it : *exportRoute->pWaypointList) {
+					waypoints.push_back(it);
+				}
+
+				std::vector<PayloadWriter> payloads;
+				size_t waypointListCount = TwoCanEncoder::EncodeWaypointLists(waypoints, &payloads);
+				TwoCanEncoder::EncodeRouteInformation(exportRoute->m_NameString, TwoCanEncoder::GetExportRouteId(exportRoute->m_GUID), waypoints, &payloads);
+
+				wxLogMessage(_T("TwoCan Plugin, Exporting route %s, %d waypoints in %d messages"), exportRoute->m_NameString, (int)waypoints.size(), (int)payloads.size());
+				int returnCode = TransmitExportPayloads(payloads, waypointListCount);
+				if (returnCode != TWOCAN_RESULT_SUCCESS) {
+					wxLogMessage(_T("TwoCan Plugin, Error sending Route export messages: %d"), returnCode);
+				}
+			}
+		}
+	}
+
 	// Allow a plugin to send NMEA 2000 frames onto the network
 	else if (message_id == _T("TWOCAN_TRANSMIT_FRAME")) {
 		if ((deviceMode == TRUE) && (twoCanDevice != nullptr)) {
@@ -389,26 +484,206 @@ void TwoCan::SetPluginMessage(wxString& message_id, wxString& message_body) {
 		}
 	}
 
+	// Allow a plugin to send many NMEA 2000 messages in a single call. Payloads are hexadecimal strings (or base64)
+	// rather than arrays of integers, eg. {"nmea2000":[{"pgn":130074,"priority":3,"destination":255,"data":"0A00FF..."},{"pgn":...,"base64":"CgD/..."}]}
+	else if (message_id == _T("TWOCAN_TRANSMIT_FRAMES")) {
+		if ((deviceMode == TRUE) && (twoCanDevice != nullptr)) {
+			wxJSONValue root;
+			wxJSONReader reader;
+
+			if (reader.Parse(message_body, &root) > 0) {
+				wxLogMessage("TwoCan plugin, JSON Error in following text:");
+				wxLogMessage("%s", message_body);
+				wxArrayString jsonErrors = reader.GetErrors();
+				for (auto it : jsonErrors) {
+					wxLogMessage(it);
+				}
+				return;
+			}
+			else if (root["nmea2000"].IsArray()) {
+				wxJSONValue messageList = root["nmea2000"];
+				std::vector<PayloadWriter> payloads(messageList.Size());
+				std::vector<TwoCanRawMessage> messages(messageList.Size());
+
+				for (int i = 0; i < messageList.Size(); i++) {
+					wxJSONValue message = messageList[i];
+					if (!DecodeRawPayload(message, &payloads[i])) {
+						wxLogMessage("TwoCan Plugin, Invalid payload for raw message %d of %d, PGN: %d", i + 1, messageList.Size(), message["pgn"].AsInt());
+						return;
+					}
+					// Checked before narrowing to the raw message's byte fields, the device checks the PGN & priority again
+					if ((message["pgn"].AsInt() < 0) || (message["priority"].AsInt() < 0) || (message["priority"].AsInt() > 7) ||
+						(message["destination"].AsInt() < 0) || (message["destination"].AsInt() > CONST_GLOBAL_ADDRESS)) {
+						wxLogMessage("TwoCan Plugin, Invalid header for raw message %d of %d, PGN: %d", i + 1, messageList.Size(), message["pgn"].AsInt());
+						return;
+					}
+					messages[i].pgn = message["pgn"].AsInt();
+					messages[i].priority = message["priority"].AsInt();
+					messages[i].destination = message["destination"].AsInt();
+					messages[i].length = payloads[i].size();
+					messages[i].data = payloads[i].data();
+				}
+
+				size_t messagesQueued;
+				int returnCode = twoCanDevice->TransmitRawMessages(messages.data(), messages.size(), &messagesQueued);
+				if (returnCode != TWOCAN_RESULT_SUCCESS) {
+					wxLogMessage("TwoCan Plugin, Error sending raw messages: %d, %d of %d sent", returnCode, (int)messagesQueued, (int)messages.size());
+				}
+			}
+		}
+	}
+
+	// A co-loaded plugin may request the address of the transmit function so that it can send messages without any JSON encoding
+	else if (message_id == _T("TWOCAN_TRANSMIT_REQUEST")) {
+		TwoCanTransmitFunction transmitFunction = &TwoCan::TransmitRawMessages;
+		wxJSONValue root;
+		wxJSONWriter writer;
+		wxString jsonResponse;
+		root["transmit"]["version"] = CONST_TRANSMIT_FUNCTION_VERSION;
+		// As a string, a JSON number may not hold a 64 bit address
+		root["transmit"]["function"] = wxString::Format(_T("%llu"), (unsigned long long)(uintptr_t)transmitFunction);
+		writer.Write(root, jsonResponse);
+		SendPluginMessage(_T("TWOCAN_TRANSMIT_RESPONSE"), jsonResponse);
+	}
+
 	// Handle Autopilot Plugin dialog commands
 	else if (message_id == _T("TWOCAN_AUTOPILOT_COMMAND")) {
 		if ((deviceMode == TRUE) && (autopilotModel != FLAGS_AUTOPILOT_NONE) && (twoCanDevice != nullptr) && (twoCanAutopilot != nullptr)) {
 			std::vector<CanMessage> messages;
-			unsigned int id;
 			int returnCode;
 			if (twoCanAutopilot->EncodeAutopilotCommand(message_body, &messages)) {
-				for (auto it : messages) {
-					TwoCanUtils::EncodeCanHeader(&id, &it.header);
-					returnCode = twoCanDevice->TransmitFrame(id, it.payload.data());
-					if (returnCode != TWOCAN_RESULT_SUCCESS) {
-						wxLogMessage(_T("TwoCan Plugin, Error sending Autopilot command: %d"), returnCode);
-					}
-					wxThread::Sleep(CONST_TEN_MILLIS);
+				returnCode = twoCanDevice->TransmitMessages(&messages);
+				if (returnCode != TWOCAN_RESULT_SUCCESS) {
+					wxLogMessage(_T("TwoCan Plugin, Error sending Autopilot command: %d"), returnCode);
 				}
 			}
 		}
 	}
 }
 
+// Transmit exported waypoints and routes, the first waypointListCount payloads are PGN 130074, the remainder PGN 129285.
+// A 200 waypoint route is about 100 fast messages (3200 frames), more than the transmit queue holds, so the messages
+// are retained until queued. Should an earlier export still be waiting, these follow it.
+int TwoCan::TransmitExportPayloads(const std::vector<PayloadWriter>& payloads, const size_t waypointListCount) {
+	bool isWaiting = !exportMessages.empty();
+
+	for (size_t i = 0; i < payloads.size(); i++) {
+		exportMessages.push_back({ (i < waypointListCount) ? 130074U : 129285U, payloads[i] });
+	}
+
+	if (isWaiting) {
+		return TWOCAN_RESULT_SUCCESS;
+	}
+	exportRetries = 0;
+	return SubmitExportMessages();
+}
+
+// Queue as many of the waiting export messages as the transmit queue accepts. If it is full, the timer resubmits the remainder,
+// any other error abandons the export
+int TwoCan::SubmitExportMessages(void) {
+	std::vector<TwoCanRawMessage> messages(exportMessages.size());
+	size_t messagesQueued = 0;
+
+	for (size_t i = 0; i < exportMessages.size(); i++) {
+		messages[i].pgn = exportMessages[i].pgn;
+		messages[i].priority = CONST_PRIORITY_LOW;
+		messages[i].destination = CONST_GLOBAL_ADDRESS;
+		messages[i].length = exportMessages[i].payload.size();
+		messages[i].data = exportMessages[i].payload.data();
+	}
+
+	int returnCode = twoCanDevice->TransmitRawMessages(messages.data(), messages.size(), &messagesQueued);
+	exportMessages.erase(exportMessages.begin(), exportMessages.begin() + messagesQueued);
+	if (messagesQueued > 0) {
+		exportRetries = 0;
+	}
+
+	if ((returnCode != TWOCAN_RESULT_SUCCESS) && (((returnCode & 0xFF0000) >> 16) == TWOCAN_ERROR_TRANSMIT_QUEUE_FULL)) {
+		if (exportTimer == nullptr) {
+			exportTimer = new wxTimer();
+			exportTimer->Bind(wxEVT_TIMER, &TwoCan::OnExportTimer, this);
+		}
+		if (!exportTimer->IsRunning()) {
+			exportTimer->Start(CONST_EXPORT_RETRY_INTERVAL, wxTIMER_CONTINUOUS);
+		}
+		return TWOCAN_RESULT_SUCCESS;
+	}
+
+	StopExport();
+	return returnCode;
+}
+
+// Resubmit the export messages that did not fit in the transmit queue, giving up should the queue not drain
+void TwoCan::OnExportTimer(wxTimerEvent &event) {
+	if ((!isRunning) || (twoCanDevice == nullptr) || (exportMessages.empty())) {
+		StopExport();
+		return;
+	}
+
+	if (++exportRetries > CONST_EXPORT_RETRY_LIMIT) {
+		wxLogMessage(_T("TwoCan Plugin, Transmit queue not draining, abandoned %d export messages"), (int)exportMessages.size());
+		StopExport();
+		return;
+	}
+
+	int returnCode = SubmitExportMessages();
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		wxLogMessage(_T("TwoCan Plugin, Error sending export messages: %d"), returnCode);
+	}
+}
+
+// Discard any export messages still waiting, eg. when the device is stopped
+void TwoCan::StopExport(void) {
+	if ((exportTimer != nullptr) && (exportTimer->IsRunning())) {
+		exportTimer->Stop();
+	}
+	exportMessages.clear();
+}
+
+// Invoked directly by co-loaded plugins, possibly from their own threads
+int TwoCan::TransmitRawMessages(const TwoCanRawMessage *messages, const size_t messageCount, size_t *messagesQueued) {
+	size_t queuedCount = 0;
+	int returnCode = SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_PLUGIN, TWOCAN_ERROR_TRANSMIT_FAILURE);
+
+	{
+		const std::lock_guard<std::mutex> lock(transmitMutex);
+		if ((transmitPlugin != nullptr) && (transmitPlugin->isRunning) && (deviceMode == TRUE) && (transmitPlugin->twoCanDevice != nullptr)) {
+			returnCode = transmitPlugin->twoCanDevice->TransmitRawMessages(messages, messageCount, &queuedCount);
+		}
+	}
+
+	if (messagesQueued != nullptr) {
+		*messagesQueued = queuedCount;
+	}
+	return returnCode;
+}
+
+// Hexadecimal pairs, upper or lower case, or base64
+bool TwoCan::DecodeRawPayload(wxJSONValue &message, PayloadWriter *payload) {
+	payload->clear();
+
+	if (message["data"].IsString()) {
+		wxString hexString = message["data"].AsString();
+		if ((hexString.length() % 2) != 0) {
+			return FALSE;
+		}
+		for (size_t i = 0; i < hexString.length(); i += 2) {
+			if ((!wxIsxdigit(hexString[i])) || (!wxIsxdigit(hexString[i + 1]))) {
+				return FALSE;
+			}
+			payload->push_back(wxHexToDec(hexString.Mid(i, 2)));
+		}
+	}
+	else if (message["base64"].IsString()) {
+		wxMemoryBuffer decodedData = wxBase64Decode(message["base64"].AsString());
+		for (size_t i = 0; i < decodedData.GetDataLen(); i++) {
+			payload->push_back(((byte *)decodedData.GetData())[i]);
+		}
+	}
+
+	return ((!payload->empty()) && (!payload->IsOverflowed()));
+}
+
 // Event Handlers
 // Frame received event handler. Events queued from TwoCanDevice.
 // NMEA 0183 sentences are passed via the SetString()/GetString() functions
@@ -416,6 +691,10 @@ void TwoCan::OnSentenceReceived(wxCommandEvent &event) {
 	switch (event.GetId()) {
 		case SENTENCE_RECEIVED_EVENT:
 			if (isRunning) {
+				// Remember the sentence so that the gateway does not convert it back to NMEA 2000 when OpenCPN echoes it to us
+				if (twoCanGateway != nullptr) {
+					twoCanGateway->RecordOutbound(event.GetString());
+				}
 				PushNMEABuffer(event.GetString());
 				// If the preference dialog is open and the debug tab is toggled, display the NMEA 183 sentences
 				// Superfluous as they can be seen in the Connections tab.
@@ -425,23 +704,6 @@ void TwoCan::OnSentenceReceived(wxCommandEvent &event) {
 			}
 			break;
 
-		case DSE_EXPIRED_EVENT: 
-			// A received DSC Sentence has timed out waiting for a DSE sentence, so we send PGN 129808 without the DSE data
-			if (isRunning) {
-				CanHeader header;
-				header.source = networkAddress;
-				header.destination = CONST_GLOBAL_ADDRESS;
-				header.priority = CONST_PRIORITY_MEDIUM;
-				header.pgn = std::atoi(event.GetString());
-
-				std::vector<byte> *payload = (std::vector<byte> *) event.GetClientData();
-				int returnCode = twoCanDevice->FragmentFastMessage(&header, payload->size(), payload->data());
-				if (returnCode != TWOCAN_RESULT_SUCCESS) {
-					wxLogMessage("TwoCan Plugin, Error sending expired DSC message: %d", returnCode);
-				}
-			}
-			break;
-
 		default:
 			event.Skip();
 			break;
@@ -503,9 +765,20 @@ bool TwoCan::LoadConfiguration(void) {
 		configSettings->Read(_T("Address"), &networkAddress, 0);
 		configSettings->Read(_T("Heartbeat"), &enableHeartbeat, FALSE);
 		configSettings->Read(_T("Gateway"), &enableGateway, FALSE);
+		configSettings->Read(_T("GatewayIgnoredTalkers"), &gatewayIgnoredTalkers, wxEmptyString);
+		configSettings->Read(_T("GatewayCoalesceWindow"), &gatewayCoalesceWindow, CONST_GATEWAY_COALESCE_WINDOW);
 		configSettings->Read(_T("Waypoint"), &enableWaypoint, FALSE);
 		configSettings->Read(_T("Music"), &enableMusic, FALSE);
 		configSettings->Read(_T("Autopilot"), &autopilotModel, 0);
+		configSettings->Read(_T("Recorder"), &enableRecorder, FALSE);
+		configSettings->Read(_T("RecorderSeconds"), &recorderSeconds, CONST_RECORDER_SECONDS);
+		configSettings->Read(_T("RecorderFormat"), &recorderFormat, RecorderPcap);
+#if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
+		configSettings->Read(_T("GeneratorRate"), &generatorRate, CONST_GENERATOR_RATE);
+		configSettings->Read(_T("GeneratorTargets"), &generatorTargets, CONST_GENERATOR_TARGETS);
+		configSettings->Read(_T("GeneratorLoss"), &generatorLoss, 0.0);
+		configSettings->Read(_T("GeneratorReorder"), &generatorReorder, 0.0);
+#endif
 		// Not ready to implement yet, probably never will....
 		//configSettings->Read(_T("SignalK"), &enableSignalK, FALSE);
 		return TRUE;
@@ -518,6 +791,8 @@ bool TwoCan::LoadConfiguration(void) {
 		networkAddress = 0;
 		enableHeartbeat = FALSE;
 		enableGateway = FALSE;
+		gatewayIgnoredTalkers = wxEmptyString;
+		gatewayCoalesceWindow = CONST_GATEWAY_COALESCE_WINDOW;
 		enableWaypoint = FALSE;
 		enableMusic = FALSE;
 		enableSignalK = FALSE;
@@ -539,9 +814,20 @@ bool TwoCan::SaveConfiguration(void) {
 		configSettings->Write(_T("Address"), networkAddress);
 		configSettings->Write(_T("Heartbeat"), enableHeartbeat);
 		configSettings->Write(_T("Gateway"), enableGateway);
+		configSettings->Write(_T("GatewayIgnoredTalkers"), gatewayIgnoredTalkers);
+		configSettings->Write(_T("GatewayCoalesceWindow"), gatewayCoalesceWindow);
 		configSettings->Write(_T("Waypoint"), enableWaypoint);
 		configSettings->Write(_T("Music"), enableMusic);
 		configSettings->Write(_T("Autopilot"), autopilotModel);
+		configSettings->Write(_T("Recorder"), enableRecorder);
+		configSettings->Write(_T("RecorderSeconds"), recorderSeconds);
+		configSettings->Write(_T("RecorderFormat"), recorderFormat);
+#if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
+		configSettings->Write(_T("GeneratorRate"), generatorRate);
+		configSettings->Write(_T("GeneratorTargets"), generatorTargets);
+		configSettings->Write(_T("GeneratorLoss"), generatorLoss);
+		configSettings->Write(_T("GeneratorReorder"), generatorReorder);
+#endif
 		// Not ready to implement yet....
 		//configSettings->Write(_T("SignalK"), enableSignalK);
 
@@ -552,12 +838,38 @@ bool TwoCan::SaveConfiguration(void) {
 	}
 }
 
+// The gateway transmits via the device, so it is terminated before the device
+void TwoCan::StopGateway(void) {
+	wxThread::ExitCode gatewayExitCode;
+	wxThreadError threadError;
+	if (twoCanGateway != nullptr) {
+		// The gateway wakes every poll interval to check whether it is being deleted, Delete waits for it
+		// and joins the thread, so it must not be waited upon again
+		if (twoCanGateway->IsRunning()) {
+			threadError = twoCanGateway->Delete(&gatewayExitCode, wxTHREAD_WAIT_BLOCK);
+			if (threadError != wxTHREAD_NO_ERROR) {
+				wxLogMessage(_T("TwoCan Plugin, TwoCan Gateway Thread Delete Error: %d"), threadError);
+			}
+		}
+		delete twoCanGateway;
+		twoCanGateway = nullptr;
+	}
+}
+
 void TwoCan::StopDevice(void) {
 	wxThread::ExitCode threadExitCode;
 	wxThreadError threadError;
+	StopGateway();
+	StopExport();
+	// Other plugins may be invoking the transmit function
+	const std::lock_guard<std::mutex> lock(transmitMutex);
 	if (twoCanDevice != nullptr) {
 		if (twoCanDevice->IsRunning()) {
 			wxLogMessage(_T("TwoCan Plugin, Terminating device thread id (0x%lx)\n"), twoCanDevice->GetId());
+#if (defined (__APPLE__) && defined (__MACH__)) || defined (__LINUX__)
+			// The device thread blocks waiting for frames, wake it so that it notices it is being deleted
+			twoCanDevice->Interrupt();
+#endif
 			threadError = twoCanDevice->Delete(&threadExitCode, wxTHREAD_WAIT_BLOCK);
 			if (threadError == wxTHREAD_NO_ERROR) {
 				wxLogMessage(_T("TwoCan Plugin, TwoCan Device Thread Delete Result: %p"), threadExitCode);
@@ -603,6 +915,8 @@ void TwoCan::StopDevice(void) {
 }
 
 void TwoCan::StartDevice(void) {
+	// Other plugins may be invoking the transmit function
+	const std::lock_guard<std::mutex> lock(transmitMutex);
 	twoCanDevice = new TwoCanDevice(this);
 	int returnCode = twoCanDevice->Init(canAdapter);
 	if ((returnCode == TWOCAN_RESULT_SUCCESS) || (((returnCode & 0xFF0000) >> 16) == TWOCAN_ERROR_INVALID_WRITE_FUNCTION)) {
@@ -617,7 +931,16 @@ void TwoCan::StartDevice(void) {
 			// If the gateway is enabled, the plugin will convert NMEA 183 sentences to NMEA 2000 messages
 			if ((deviceMode == TRUE) && (enableGateway == TRUE)) {
 				twoCanEncoder = new TwoCanEncoder(this);
-				wxLogMessage(_T("TwoCan Plugin, Created Bi-Directional Gateway"));
+				twoCanGateway = new TwoCanGateway(twoCanEncoder, [this](const CanFrame *frames, const size_t frameCount) { return twoCanDevice->TransmitFrames(frames, frameCount); });
+				twoCanGateway->SetIgnoredTalkers(gatewayIgnoredTalkers);
+				if (twoCanGateway->Run() != wxTHREAD_NO_ERROR) {
+					wxLogError(_T("TwoCan Plugin, Unable to start Bi-Directional Gateway thread"));
+					delete twoCanGateway;
+					twoCanGateway = nullptr;
+				}
+				else {
+					wxLogMessage(_T("TwoCan Plugin, Created Bi-Directional Gateway"));
+				}
 			}
 
 			// Fusion Media Player Integration
@@ -0,0 +1,174 @@
+// Copyright(C) 2018-2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanRecorder - Flight recorder, captures the network traffic surrounding an incident
+// Owner: twocanplugin@hotmail.com
+// Date: 20/01/2022
+// Version History: 
+// 1.0 Initial Release
+
+#include "twocanrecorder.h"
+
+TwoCanRecorder::TwoCanRecorder(const int seconds, const int format) : wxThread(wxTHREAD_JOINABLE) {
+	recordSeconds = (seconds > 0) ? seconds : CONST_RECORDER_SECONDS;
+	recordFormat = format;
+	// Size the ring to hold the retained period plus the period recorded after the trigger
+	ringCapacity = (unsigned long long)(recordSeconds + CONST_RECORDER_POST_TRIGGER) * CONST_RECORDER_MAX_FRAME_RATE;
+	ringBuffer.resize(ringCapacity);
+	writeIndex = 0;
+	isTriggered = FALSE;
+}
+
+TwoCanRecorder::~TwoCanRecorder(void) {
+}
+
+void TwoCanRecorder::Trigger(const wxString& reason) {
+	wxMutexLocker lock(triggerMutex);
+	if (!isTriggered) {
+		isTriggered = TRUE;
+		triggerReason = reason;
+		triggerSemaphore.Post();
+		wxLogMessage(_T("TwoCan Recorder, Triggered: %s"), reason);
+	}
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanRecorder::Entry() {
+	while (!TestDestroy()) {
+		if (triggerSemaphore.WaitTimeout(100) == wxSEMA_NO_ERROR) {
+			// Continue recording for a few seconds to capture the traffic after the incident
+			for (int i = 0; (i < CONST_RECORDER_POST_TRIGGER * 10) && (!TestDestroy()); i++) {
+				wxThread::Sleep(100);
+			}
+
+			wxString reason;
+			{
+				wxMutexLocker lock(triggerMutex);
+				reason = triggerReason;
+				isTriggered = FALSE;
+			}
+
+			int returnCode = Dump(reason);
+			if (returnCode != TWOCAN_RESULT_SUCCESS) {
+				wxLogError(_T("TwoCan Recorder, Error writing recording: %d"), returnCode);
+			}
+		}
+	}
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanRecorder::OnExit() {
+	// Nothing to do ??
+}
+
+int TwoCanRecorder::Dump(const wxString& reason) {
+	// Copy the ring buffer without blocking the receive thread
+	unsigned long long endIndex = writeIndex.load(std::memory_order_acquire);
+	unsigned long long startIndex = (endIndex > ringCapacity) ? endIndex - ringCapacity : 0;
+
+	std::vector<RecorderFrame> recordedFrames;
+	recordedFrames.reserve(endIndex - startIndex);
+	for (unsigned long long i = startIndex; i < endIndex; i++) {
+		recordedFrames.push_back(ringBuffer[i % ringCapacity]);
+	}
+
+	// Discard the oldest entries if they were overwritten (or were being overwritten) whilst being copied
+	unsigned long long currentIndex = writeIndex.load(std::memory_order_acquire);
+	unsigned long long firstValidIndex = (currentIndex + 1 > ringCapacity) ? currentIndex + 1 - ringCapacity : 0;
+	if (firstValidIndex > startIndex) {
+		size_t overwritten = (size_t)std::min<unsigned long long>(firstValidIndex - startIndex, recordedFrames.size());
+		recordedFrames.erase(recordedFrames.begin(), recordedFrames.begin() + overwritten);
+	}
+
+	// Only retain the requested period
+	unsigned long long cutoffTime = TwoCanUtils::GetTimeInMicroseconds() - ((unsigned long long)(recordSeconds + CONST_RECORDER_POST_TRIGGER) * 1000000);
+	auto firstFrame = recordedFrames.begin();
+	while ((firstFrame != recordedFrames.end()) && (firstFrame->timestamp < cutoffTime)) {
+		++firstFrame;
+	}
+
+	std::vector<byte> fileBuffer;
+	if (recordFormat == RecorderPcap) {
+		AppendPcapHeader(&fileBuffer);
+	}
+	for (auto it = firstFrame; it != recordedFrames.end(); ++it) {
+		if (recordFormat == RecorderPcap) {
+			AppendPcapFrame(&fileBuffer, &(*it));
+		}
+		else {
+			AppendBinaryFrame(&fileBuffer, &(*it));
+		}
+	}
+
+	// construct a filename with the following format twocan-recorder-2018-12-31_210735.pcap
+	wxString fileName = wxDateTime::Now().Format("twocan-recorder-%Y-%m-%d_%H%M%S") + ((recordFormat == RecorderPcap) ? _T(".pcap") : _T(".bin"));
+	wxFile recordingFile;
+	if (!recordingFile.Open(wxString::Format("%s%c%s", wxStandardPaths::Get().GetDocumentsDir(), wxFileName::GetPathSeparator(), fileName), wxFile::write)) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_OPEN_LOGFILE);
+	}
+	recordingFile.Write(fileBuffer.data(), fileBuffer.size());
+	recordingFile.Close();
+
+	wxLogMessage(_T("TwoCan Recorder, Recorded %lu frames to %s, trigger: %s"), (unsigned long)(recordedFrames.end() - firstFrame), fileName, reason);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// pcap file header, microsecond resolution, Socket CAN link type (227)
+void TwoCanRecorder::AppendPcapHeader(std::vector<byte> *buffer) {
+	const byte pcapHeader[] = { 0xD4, 0xC3, 0xB2, 0xA1, // Magic Number
+		0x02, 0x00, 0x04, 0x00, // Version 2.4
+		0x00, 0x00, 0x00, 0x00, // Reserved
+		0x00, 0x00, 0x00, 0x00, // Reserved
+		0x10, 0x00, 0x00, 0x00, // Snap Length
+		0xE3, 0x00, 0x00, 0x00 }; // Link Type
+	buffer->insert(buffer->end(), pcapHeader, pcapHeader + sizeof(pcapHeader));
+}
+
+// pcap packet header followed by a Socket CAN frame, can_id is in network byte order
+void TwoCanRecorder::AppendPcapFrame(std::vector<byte> *buffer, const RecorderFrame *recorderFrame) {
+	unsigned int seconds = (unsigned int)(recorderFrame->timestamp / 1000000);
+	unsigned int microSeconds = (unsigned int)(recorderFrame->timestamp % 1000000);
+	byte packet[16 + 16];
+	TwoCanUtils::ConvertIntegerToByteArray(seconds, &packet[0]);
+	TwoCanUtils::ConvertIntegerToByteArray(microSeconds, &packet[4]);
+	TwoCanUtils::ConvertIntegerToByteArray(16, &packet[8]);
+	TwoCanUtils::ConvertIntegerToByteArray(16, &packet[12]);
+	// Extended Frame Format flag
+	packet[16] = recorderFrame->frame[3] | 0x80;
+	packet[17] = recorderFrame->frame[2];
+	packet[18] = recorderFrame->frame[1];
+	packet[19] = recorderFrame->frame[0];
+	packet[20] = CONST_PAYLOAD_LENGTH;
+	packet[21] = 0;
+	packet[22] = 0;
+	packet[23] = 0;
+	memcpy(&packet[24], &recorderFrame->frame[CONST_HEADER_LENGTH], CONST_PAYLOAD_LENGTH);
+	buffer->insert(buffer->end(), packet, packet + sizeof(packet));
+}
+
+// 8 byte timestamp (LSB first) followed by the TwoCan frame
+void TwoCanRecorder::AppendBinaryFrame(std::vector<byte> *buffer, const RecorderFrame *recorderFrame) {
+	for (int i = 0; i < 8; i++) {
+		buffer->push_back((recorderFrame->timestamp >> (8 * i)) & 0xFF);
+	}
+	buffer->insert(buffer->end(), recorderFrame->frame, recorderFrame->frame + CONST_FRAME_LENGTH);
+}
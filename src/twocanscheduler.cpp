@@ -0,0 +1,159 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanScheduler - Prioritised, paced transmission of NMEA 2000 frames
+// Owner: twocanplugin@hotmail.com
+// Date: 01/08/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 - 05/08/2022 Frames that are due are written as a batch
+// 1.2 - 10/08/2022 Throttle when the measured bus load is high
+// 1.3 - 05/09/2022 Queue encoded frames directly
+
+#include "twocanscheduler.h"
+
+TwoCanScheduler::TwoCanScheduler(SchedulerWriteFunction writeFunction, const int targetLoad, TwoCanBusLoad *networkLoad) : wxThread(wxTHREAD_JOINABLE), queueCondition(queueMutex) {
+	writeFrames = writeFunction;
+	busLoad = networkLoad;
+	queuedFrames = 0;
+	transmittedFrames = 0;
+	failedFrames = 0;
+	// eg. at 25% load, one frame every 2.4 milliseconds
+	frameInterval = (CONST_SCHEDULER_FRAME_TIME * 100) / ((targetLoad > 0) && (targetLoad <= 100) ? targetLoad : CONST_SCHEDULER_TARGET_LOAD);
+	nextTransmitTime = 0;
+}
+
+TwoCanScheduler::~TwoCanScheduler(void) {
+}
+
+// Queue frames for transmission, invoked from any thread
+int TwoCanScheduler::Enqueue(const unsigned int id, const byte *data, const size_t frameCount) {
+	CanFrame scheduledFrame;
+	scheduledFrame.id = id;
+	byte priority = (id >> 26) & 0x07;
+
+	wxMutexLocker lock(queueMutex);
+
+	if (queuedFrames + frameCount > CONST_SCHEDULER_MAX_FRAMES) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_TRANSMIT_QUEUE_FULL);
+	}
+
+	for (size_t i = 0; i < frameCount; i++) {
+		memcpy(scheduledFrame.data, &data[i * CONST_PAYLOAD_LENGTH], CONST_PAYLOAD_LENGTH);
+		frameQueues[priority].push_back(scheduledFrame);
+	}
+	queuedFrames += frameCount;
+
+	queueCondition.Signal();
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Queue frames that have already been encoded, the frames may have differing CAN Id's
+int TwoCanScheduler::Enqueue(const CanFrame *frames, const size_t frameCount) {
+	wxMutexLocker lock(queueMutex);
+
+	if (queuedFrames + frameCount > CONST_SCHEDULER_MAX_FRAMES) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DEVICE, TWOCAN_ERROR_TRANSMIT_QUEUE_FULL);
+	}
+
+	for (size_t i = 0; i < frameCount; i++) {
+		frameQueues[(frames[i].id >> 26) & 0x07].push_back(frames[i]);
+	}
+	queuedFrames += frameCount;
+
+	queueCondition.Signal();
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Number of frames waiting to be transmitted
+size_t TwoCanScheduler::GetQueueDepth(void) {
+	wxMutexLocker lock(queueMutex);
+	return queuedFrames;
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanScheduler::Entry() {
+	CanFrame batch[CONST_SCHEDULER_BURST];
+	size_t batchCount;
+	size_t framesWritten;
+
+	while (!TestDestroy()) {
+
+		// Pace the transmissions, frames are selected after waiting so that a higher priority frame queued meanwhile goes first
+		unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+		if (nextTransmitTime > now) {
+			wxMicroSleep(nextTransmitTime - now);
+			now = nextTransmitTime;
+		}
+		else if (now - nextTransmitTime > CONST_SCHEDULER_BURST * frameInterval) {
+			// Idle, permit a short burst
+			nextTransmitTime = now - (CONST_SCHEDULER_BURST * frameInterval);
+		}
+
+		// Number of frames now due
+		size_t permittedFrames = 1 + (size_t)((now - nextTransmitTime) / frameInterval);
+		if (permittedFrames > CONST_SCHEDULER_BURST) {
+			permittedFrames = CONST_SCHEDULER_BURST;
+		}
+
+		// Back off if the network is busy
+		bool isThrottled = (busLoad != nullptr) && (busLoad->GetLoad() > CONST_BUSLOAD_THROTTLE_LIMIT);
+		if (isThrottled) {
+			permittedFrames = 1;
+		}
+
+		{
+			wxMutexLocker lock(queueMutex);
+
+			if (queuedFrames == 0) {
+				// Wake periodically to check whether the thread is being terminated
+				queueCondition.WaitTimeout(100);
+				continue;
+			}
+
+			batchCount = 0;
+			for (int priority = 0; (priority < CONST_SCHEDULER_PRIORITIES) && (batchCount < permittedFrames); priority++) {
+				while ((!frameQueues[priority].empty()) && (batchCount < permittedFrames)) {
+					batch[batchCount++] = frameQueues[priority].front();
+					frameQueues[priority].pop_front();
+				}
+			}
+			queuedFrames -= batchCount;
+		}
+
+		framesWritten = 0;
+		if (writeFrames(batch, batchCount, &framesWritten) != TWOCAN_RESULT_SUCCESS) {
+			wxLogError(_T("TwoCan Scheduler, Error transmitting frames, %d of %d sent"), (int)framesWritten, (int)batchCount);
+		}
+		transmittedFrames += framesWritten;
+		failedFrames += batchCount - framesWritten;
+
+		nextTransmitTime += batchCount * frameInterval * (isThrottled ? 2 : 1);
+	}
+
+	wxLogMessage(_T("TwoCan Scheduler, Transmitted frames: %llu, Failed: %llu, Discarded: %d"), transmittedFrames, failedFrames, (int)queuedFrames);
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanScheduler::OnExit() {
+	// Nothing to do ??
+}
@@ -0,0 +1,320 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanSerial - Implements a SLCAN (Lawicel) serial USB interface for Linux, without requiring slcand
+// Owner: twocanplugin@hotmail.com
+// Date: 25/01/2022
+// Version History:
+// 1.0 Initial Release
+// 1.1 - 28/09/2022 Any tty device may be selected, including pseudo terminals (/dev/pts/N)
+//
+
+#include "twocanserial.h"
+
+TwoCanSerial::TwoCanSerial(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
+	serialPortHandle = -1;
+}
+
+TwoCanSerial::~TwoCanSerial() {
+}
+
+// List the USB serial devices that may be SLCAN adapters, ACM devices (CANable, CANtact) or FTDI devices (Lawicel)
+std::vector<wxString> TwoCanSerial::ListSerialInterfaces() {
+	std::vector<wxString> serialInterfaces;
+	DIR *deviceDirectory = opendir("/dev");
+	if (deviceDirectory != NULL) {
+		struct dirent *deviceEntry;
+		while ((deviceEntry = readdir(deviceDirectory)) != NULL) {
+			if ((strncmp(deviceEntry->d_name, "ttyACM", 6) == 0) || (strncmp(deviceEntry->d_name, "ttyUSB", 6) == 0)) {
+				serialInterfaces.push_back(wxString::Format("/dev/%s", deviceEntry->d_name));
+			}
+		}
+		closedir(deviceDirectory);
+	}
+	return serialInterfaces;
+}
+
+// Any tty device beneath /dev, USB serial devices (/dev/ttyACM0, /dev/ttyUSB0) or pseudo terminals (/dev/pts/3)
+bool TwoCanSerial::IsSerialInterface(const wxString& portName) {
+	if (!portName.StartsWith(_T("/dev/"))) {
+		return false;
+	}
+	int fileHandle = open(portName.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+	if (fileHandle == -1) {
+		// Unable to test, the name of a USB serial device is sufficient, Open will report the error
+		return (portName.StartsWith(_T("/dev/tty")) || portName.StartsWith(_T("/dev/pts/")));
+	}
+	bool isTerminal = isatty(fileHandle);
+	close(fileHandle);
+	return isTerminal;
+}
+
+// Open the tty device, any tty device may be used, including a pseudo terminal
+int TwoCanSerial::Open(const wxString& portName) {
+
+	serialPortHandle = open(portName.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+	if (serialPortHandle == -1) {
+		wxLogMessage(_T("TwoCan Serial, Error opening %s: %s"), portName, strerror(errno));
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CREATE_SERIALPORT);
+	}
+
+	// Ensure it is a tty device
+	if (!isatty(serialPortHandle)) {
+		wxLogMessage(_T("TwoCan Serial, %s is not a TTY device"), portName);
+		close(serialPortHandle);
+		serialPortHandle = -1;
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CONFIGURE_ADAPTER);
+	}
+
+	// Configure the serial port settings
+	struct termios serialPortSettings;
+
+	if (tcgetattr(serialPortHandle, &serialPortSettings) == -1) {
+		wxLogMessage(_T("TwoCan Serial, Error getting serial port configuration"));
+		close(serialPortHandle);
+		serialPortHandle = -1;
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CONFIGURE_ADAPTER);
+	}
+
+	// Raw mode, 8 bit characters, no echo, no flow control or character translation
+	cfmakeraw(&serialPortSettings);
+	serialPortSettings.c_iflag &= ~(IXON | IXOFF | IXANY);
+	serialPortSettings.c_cflag |= CLOCAL | CREAD;
+
+	// Reads return whatever is available, the read loop uses select to wait for data
+	serialPortSettings.c_cc[VMIN] = 0;
+	serialPortSettings.c_cc[VTIME] = 0;
+
+	// Set baud rate, ignored by USB ACM devices
+	if ((cfsetispeed(&serialPortSettings, B115200) == -1) || (cfsetospeed(&serialPortSettings, B115200) == -1)) {
+		wxLogMessage(_T("TwoCan Serial, Error setting baud rate"));
+		close(serialPortHandle);
+		serialPortHandle = -1;
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CONFIGURE_ADAPTER);
+	}
+
+	if (tcsetattr(serialPortHandle, TCSANOW, &serialPortSettings) == -1) {
+		wxLogMessage(_T("TwoCan Serial, Error applying tty device settings"));
+		close(serialPortHandle);
+		serialPortHandle = -1;
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CONFIGURE_ADAPTER);
+	}
+
+	// Discard anything received prior to opening
+	tcflush(serialPortHandle, TCIFLUSH);
+
+	// Configure the adapter for the NMEA 2000 network, close the bus, set the bus speed to 250k and then reopen the bus
+	SendCommand(SLCAN_CLOSE);
+	wxThread::Sleep(CONST_TEN_MILLIS);
+
+	if (!SendCommand(SLCAN_250K)) {
+		wxLogMessage(_T("TwoCan Serial, Error setting CAN bus speed"));
+	}
+	wxThread::Sleep(CONST_TEN_MILLIS);
+
+	if (!SendCommand(SLCAN_OPEN)) {
+		wxLogMessage(_T("TwoCan Serial, Error opening CAN bus"));
+		close(serialPortHandle);
+		serialPortHandle = -1;
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_CONFIGURE_ADAPTER);
+	}
+
+	wxLogMessage(_T("TwoCan Serial, Opened CAN bus on %s"), portName);
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+int TwoCanSerial::Close(void) {
+	if (serialPortHandle != -1) {
+		if (SendCommand(SLCAN_CLOSE)) {
+			wxLogMessage(_T("TwoCan Serial, Closed CAN bus"));
+		}
+		close(serialPortHandle);
+		serialPortHandle = -1;
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Write a SLCAN command
+bool TwoCanSerial::SendCommand(const char *command) {
+	size_t commandLength = strlen(command);
+	return (write(serialPortHandle, command, commandLength) == (ssize_t)commandLength);
+}
+
+// Decode a SLCAN extended frame, Tiiiiiiiildd..dd, the CAN Id is transmitted MSB first whereas TwoCan frames are LSB first
+// Standard frames, remote frames and command acknowledgements are ignored, as are any trailing timestamps
+bool TwoCanSerial::ParseFrame(const char *line, const size_t length, byte *frame) {
+	if ((length < SLCAN_EXTENDED_HEADER_LENGTH) || (line[0] != SLCAN_EXTENDED_FRAME)) {
+		return false;
+	}
+
+	unsigned int payloadLength = line[9] - '0';
+	if ((payloadLength > CONST_PAYLOAD_LENGTH) || (length < SLCAN_EXTENDED_HEADER_LENGTH + (payloadLength * 2))) {
+		return false;
+	}
+
+	for (int i = 0; i < CONST_HEADER_LENGTH; i++) {
+		if (!TwoCanLogParser::DecodeHexByte(&line[1 + (i * 2)], &frame[CONST_HEADER_LENGTH - 1 - i])) {
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < payloadLength; i++) {
+		if (!TwoCanLogParser::DecodeHexByte(&line[SLCAN_EXTENDED_HEADER_LENGTH + (i * 2)], &frame[CONST_HEADER_LENGTH + i])) {
+			return false;
+		}
+	}
+
+	// Pad any unused bytes
+	memset(&frame[CONST_HEADER_LENGTH + payloadLength], 0xFF, CONST_PAYLOAD_LENGTH - payloadLength);
+	return true;
+}
+
+// Read from the tty device. Each read is scanned for line terminators in bulk,
+// the frames found are posted to the TwoCan Device as a single batch, and any incomplete frame is carried over to the next read.
+void TwoCanSerial::Read() {
+	char serialBuffer[SLCAN_READ_BUFFER_SIZE];
+	size_t bufferLength = 0;
+
+	byte frame[CONST_FRAME_LENGTH];
+	std::vector<byte> postedFrames;
+	postedFrames.reserve(SLCAN_BATCH_FRAMES * CONST_FRAME_LENGTH);
+
+	while (!TestDestroy()) {
+
+		struct timeval readTimeout = { 0, SLCAN_READ_TIMEOUT };
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(serialPortHandle, &readSet);
+
+		if (select((serialPortHandle + 1), &readSet, NULL, NULL, &readTimeout) <= 0) {
+			continue;
+		}
+
+		ssize_t bytesRead = read(serialPortHandle, serialBuffer + bufferLength, sizeof(serialBuffer) - bufferLength);
+
+		if (bytesRead < 0) {
+			if ((errno == EAGAIN) || (errno == EINTR)) {
+				continue;
+			}
+			// Most likely the adapter has been unplugged
+			wxLogError(_T("TwoCan Serial, Error reading tty device: %s"), strerror(errno));
+			break;
+		}
+
+		if (bytesRead == 0) {
+			continue;
+		}
+
+		bufferLength += bytesRead;
+
+		const char *lineStart = serialBuffer;
+		const char *bufferEnd = serialBuffer + bufferLength;
+		const char *lineEnd;
+
+		while ((lineEnd = (const char *)memchr(lineStart, SLCAN_LINE_TERMINATOR, bufferEnd - lineStart)) != NULL) {
+
+			// Skip any error responses (which have no terminator) or line feeds preceding the frame
+			while ((lineStart < lineEnd) && ((*lineStart == SLCAN_BELL) || (*lineStart == '\n'))) {
+				lineStart++;
+			}
+
+			if (ParseFrame(lineStart, lineEnd - lineStart, frame)) {
+				postedFrames.insert(postedFrames.end(), frame, frame + CONST_FRAME_LENGTH);
+				if (postedFrames.size() == SLCAN_BATCH_FRAMES * CONST_FRAME_LENGTH) {
+					deviceQueue->Post(postedFrames);
+					postedFrames.clear();
+				}
+			}
+
+			lineStart = lineEnd + 1;
+		}
+
+		if (postedFrames.size() > 0) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+
+		// Carry over any incomplete frame, unless the buffer is full without a terminator in which case it is garbage
+		bufferLength = bufferEnd - lineStart;
+		if (bufferLength == sizeof(serialBuffer)) {
+			bufferLength = 0;
+		}
+		else if (bufferLength > 0) {
+			memmove(serialBuffer, lineStart, bufferLength);
+		}
+
+	} // while thread is alive
+
+}
+
+// Write, Transmit a CAN frame onto the NMEA 2000 network
+int TwoCanSerial::Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload) {
+	static const char hexDigits[] = "0123456789ABCDEF";
+	char data[SLCAN_EXTENDED_FRAME_LENGTH];
+
+	if (payloadLength > CONST_PAYLOAD_LENGTH) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_TRANSMIT_FAILURE);
+	}
+
+	// "T" indicates a CAN v2.0 Extended Frame (29 bit Id), followed by the CAN Id MSB first
+	data[0] = SLCAN_EXTENDED_FRAME;
+	for (int i = 0; i < CONST_HEADER_LENGTH; i++) {
+		byte value = (canId >> (24 - (i * 8))) & 0xFF;
+		data[1 + (i * 2)] = hexDigits[value >> 4];
+		data[2 + (i * 2)] = hexDigits[value & 0x0F];
+	}
+
+	data[9] = '0' + payloadLength;
+
+	for (int i = 0; i < payloadLength; i++) {
+		data[SLCAN_EXTENDED_HEADER_LENGTH + (i * 2)] = hexDigits[payload[i] >> 4];
+		data[SLCAN_EXTENDED_HEADER_LENGTH + 1 + (i * 2)] = hexDigits[payload[i] & 0x0F];
+	}
+
+	size_t dataLength = SLCAN_EXTENDED_HEADER_LENGTH + (payloadLength * 2);
+	data[dataLength++] = SLCAN_LINE_TERMINATOR;
+
+	if (write(serialPortHandle, data, dataLength) != (ssize_t)dataLength) {
+		wxLogMessage(_T("TwoCan Serial, Error transmitting frame: %s"), strerror(errno));
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_TRANSMIT_FAILURE);
+	}
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Unique number derived from the MAC Address, as per the SocketCAN interface
+int TwoCanSerial::GetUniqueNumber(unsigned long *uniqueNumber) {
+	return TwoCanSocket::DeriveUniqueNumber(uniqueNumber);
+}
+
+// Entry, the method that is executed upon thread start
+wxThread::ExitCode TwoCanSerial::Entry() {
+	// Merely loops continuously waiting for frames to be received by the CAN Adapter
+	Read();
+	wxLogMessage(_T("TwoCan Serial, CAN bus read thread exiting"));
+	return (wxThread::ExitCode)TWOCAN_RESULT_SUCCESS;
+}
+
+// OnExit, called when thread is being destroyed
+void TwoCanSerial::OnExit() {
+	// Nothing to do ??
+}
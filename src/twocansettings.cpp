@@ -33,6 +33,7 @@
 // 1.9 - 20/08/2020 Rusoku adapter support on Mac OSX, OCPN 5.2 Plugin Manager support
 // 2.0 - 04/07/2021 Bi-directional gateway, PCAP log files
 // 2.1 - 20/05/2022 Add configuration items for Media Player, Waypoint Creation and Autopilot (not yet implemented)
+// 2.2 - 25/07/2022 List SLCAN serial adapters on Linux
 // Outstanding Features: 
 // 1. Prevent selection of driver that is not physically present
 // 2. Prevent user selecting both LogFile reader and Log Raw frames !
@@ -440,6 +441,7 @@ wxString driversFolder = pluginDataFolder +  _T("drivers") + wxFileName::GetPath
 	// BUG BUG Should add a #define for this string constant
 	adapters["Log File Reader"] = "Log File Reader";
 	adapters["Pcap File Reader"] = "Pcap File Reader";
+	adapters["Traffic Generator"] = "Traffic Generator";
 	// Add any physical CAN Adapters
 	std::vector<wxString> canAdapters;
 	// Enumerate installed CAN adapters
@@ -464,13 +466,21 @@ wxString driversFolder = pluginDataFolder +  _T("drivers") + wxFileName::GetPath
 		}
 		
 	}
+
+	// Add any SLCAN serial adapters, accessed directly via their tty device
+	std::vector<wxString> serialAdapters = TwoCanSerial::ListSerialInterfaces();
+	for (auto it = serialAdapters.begin(); it != serialAdapters.end(); ++it) {
+		wxLogMessage(_T("TwoCan Settings, Found serial adapter: %s"), *it);
+		adapters[*it] = *it;
+	}
 	
 #endif
 
 #if defined (__APPLE__) && defined (__MACH__)
-	// Add the built-in Log File Reader, Pcap file reader, Cantact, Kvaser and Rusoku interfaces to the Adapter hashmap
+	// Add the built-in Log File Reader, Pcap file reader, Traffic generator, Cantact, Kvaser and Rusoku interfaces to the Adapter hashmap
 	adapters["Log File Reader"] = "Log File Reader";
 	adapters["Pcap File Reader"] = "Pcap File Reader";
+	adapters["Traffic Generator"] = "Traffic Generator";
 	adapters["Cantact"] = "Cantact";
 	adapters["Kvaser"] = "Kvaser";
 	adapters["Rusoku"] = "Rusoku";
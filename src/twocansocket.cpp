@@ -26,11 +26,18 @@
 // 1.0 Initial Release
 // 1.8 10/5/2020. Derived from abstract class
 // 1.91 20/10/2020. Set to non blocking with timeouts
+// 1.92 25/01/2022. Unique number derivation shared with the Linux SLCAN serial interface
+// 1.93 05/08/2022. Batched writes using sendmmsg, wait for transmit queue space rather than dropping frames
+// 1.94 20/08/2022. Blocking reads using epoll, woken by an eventfd on shutdown, replacing the non blocking select loop
 //
 
 #include <twocansocket.h>
 
 TwoCanSocket::TwoCanSocket(wxMessageQueue<std::vector<byte>> *messageQueue) : TwoCanInterface(messageQueue) {
+	canSocket = -1;
+	epollDescriptor = -1;
+	shutdownEvent = -1;
+	backpressureEvents = 0;
 }
 
 
@@ -64,6 +71,11 @@ struct if_nameindex *interfaceNameIndexes, *nameIndex;
 
 // Generate a unique number derived from the MAC Address to be used as a NMEA 2000 device's unique address
 int TwoCanSocket::GetUniqueNumber(unsigned long *uniqueNumber) {
+	return DeriveUniqueNumber(uniqueNumber);
+}
+
+// Derive the unique number from the MAC address of the first ethernet or wireless interface
+int TwoCanSocket::DeriveUniqueNumber(unsigned long *uniqueNumber) {
 	*uniqueNumber = 0;
     struct if_nameindex *interfaceNameIndexes, *nameIndex;
     // Enumerate all network interfaces
@@ -114,24 +126,53 @@ int TwoCanSocket::GetUniqueNumber(unsigned long *uniqueNumber) {
 
 // Open a socket descriptor
 int TwoCanSocket::Open(const wxString& portName) {
+	int returnCode;
+
+	returnCode = OpenSocket(portName, &canSocket);
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		return returnCode;
+	}
+
+	returnCode = OpenEventLoop();
+	if (returnCode == TWOCAN_RESULT_SUCCESS) {
+		returnCode = WatchSocket(canSocket, 0);
+	}
+
+	if (returnCode != TWOCAN_RESULT_SUCCESS) {
+		CloseEventLoop();
+		close(canSocket);
+		canSocket = -1;
+	}
+
+	return returnCode;
+}
+
+// Create, configure and bind a raw CAN socket for the named interface
+int TwoCanSocket::OpenSocket(const wxString& portName, int *socketDescriptor) {
+	struct sockaddr_can canAddress;
+	struct ifreq canRequest;
 	
-	canSocket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-	if (canSocket < 0) {
+	*socketDescriptor = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+	if (*socketDescriptor < 0) {
 		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_CREATE);
 	}
 
-	strcpy(canRequest.ifr_name, portName.c_str());
+	strncpy(canRequest.ifr_name, portName.c_str(), IFNAMSIZ - 1);
+	canRequest.ifr_name[IFNAMSIZ - 1] = 0;
 	
 	// Get the index of the interface
-	if (ioctl(canSocket, SIOCGIFINDEX, &canRequest) < 0) {
+	if (ioctl(*socketDescriptor, SIOCGIFINDEX, &canRequest) < 0) {
+		close(*socketDescriptor);
 		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_IOCTL);
 	}
 
+	memset(&canAddress, 0, sizeof(canAddress));
 	canAddress.can_family = AF_CAN;
 	canAddress.can_ifindex = canRequest.ifr_ifindex;
 	
 	// Check if the interface is UP
-	if (ioctl(canSocket, SIOCGIFFLAGS, &canRequest) < 0) {
+	if (ioctl(*socketDescriptor, SIOCGIFFLAGS, &canRequest) < 0) {
+		close(*socketDescriptor);
 		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_IOCTL);
 	}
      
@@ -140,21 +181,16 @@ int TwoCanSocket::Open(const wxString& portName) {
 	}
 	else {
 		wxLogMessage(_T("TwoCan Socket, %s interface is DOWN"), portName); 
+		close(*socketDescriptor);
 		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_DOWN);
 	}
 
-	// Set to non blocking
-	fcntl(canSocket, F_SETFL, O_NONBLOCK);
-
-	// set the timeout values
-	socketTimeout.tv_sec = 0;
-	socketTimeout.tv_usec = 100;
-
-	// set the socket timeout
-	setsockopt (canSocket, SOL_SOCKET, SO_RCVTIMEO, &socketTimeout, sizeof(socketTimeout));
+	// The socket remains blocking, reads are only performed once epoll reports data is available 
+	// and both reads and writes pass MSG_DONTWAIT so that neither can stall the caller
 
 	// and then bind
-	if (bind(canSocket, (struct sockaddr *)&canAddress, sizeof(canAddress)) < 0) {
+	if (bind(*socketDescriptor, (struct sockaddr *)&canAddress, sizeof(canAddress)) < 0) {
+		close(*socketDescriptor);
 		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_BIND);
 	}
 
@@ -162,47 +198,146 @@ int TwoCanSocket::Open(const wxString& portName) {
 }
 
 int TwoCanSocket::Close(void) {
-	close(canSocket);
+	CloseEventLoop();
+	if (canSocket != -1) {
+		close(canSocket);
+		canSocket = -1;
+	}
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Create the epoll instance and the eventfd used by Interrupt to wake the read thread
+int TwoCanSocket::OpenEventLoop(void) {
+	epollDescriptor = epoll_create1(0);
+	if (epollDescriptor < 0) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CREATE);
+	}
+
+	shutdownEvent = eventfd(0, EFD_NONBLOCK);
+	if (shutdownEvent < 0) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CREATE);
+	}
+
+	return WatchSocket(shutdownEvent, CONST_SOCKET_SHUTDOWN_EVENT);
+}
+
+// Add a descriptor to the epoll instance, the epoll data identifies the interface
+int TwoCanSocket::WatchSocket(const int socketDescriptor, const unsigned int interfaceIndex) {
+	struct epoll_event socketEvent;
+	socketEvent.events = EPOLLIN;
+	socketEvent.data.u64 = 0;
+	socketEvent.data.u32 = interfaceIndex;
+	if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, socketDescriptor, &socketEvent) < 0) {
+		return SET_ERROR(TWOCAN_RESULT_FATAL, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_CREATE);
+	}
 	return TWOCAN_RESULT_SUCCESS;
 }
 
+void TwoCanSocket::CloseEventLoop(void) {
+	if (shutdownEvent != -1) {
+		close(shutdownEvent);
+		shutdownEvent = -1;
+	}
+	if (epollDescriptor != -1) {
+		close(epollDescriptor);
+		epollDescriptor = -1;
+	}
+}
+
+// Signal the shutdown event, the read thread then exits without waiting for further frames
+void TwoCanSocket::Interrupt(void) {
+	if (shutdownEvent != -1) {
+		uint64_t signal = 1;
+		if (write(shutdownEvent, &signal, sizeof(signal)) != sizeof(signal)) {
+			wxLogMessage(_T("TwoCan Socket, Error signalling shutdown %s"), strerror(errno));
+		}
+	}
+}
+
+bool TwoCanSocket::AcceptFrame(const byte *frame, const int interfaceIndex) {
+	return true;
+}
+
+// Drain the socket using recvmmsg, only extended data frames are of interest. Unused data bytes are padded with 0xFF
+int TwoCanSocket::ReceiveFrames(const int socketDescriptor, const int interfaceIndex, std::vector<byte> *postedFrames) {
+	struct can_frame canSocketFrames[CONST_SOCKET_RECEIVE_FRAMES];
+	struct iovec ioVectors[CONST_SOCKET_RECEIVE_FRAMES];
+	struct mmsghdr messages[CONST_SOCKET_RECEIVE_FRAMES];
+	byte frame[CONST_FRAME_LENGTH];
+	int framesReceived;
+	int totalFrames = 0;
+
+	do {
+		memset(messages, 0, sizeof(messages));
+		for (int i = 0; i < CONST_SOCKET_RECEIVE_FRAMES; i++) {
+			ioVectors[i].iov_base = &canSocketFrames[i];
+			ioVectors[i].iov_len = sizeof(struct can_frame);
+			messages[i].msg_hdr.msg_iov = &ioVectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		framesReceived = recvmmsg(socketDescriptor, messages, CONST_SOCKET_RECEIVE_FRAMES, MSG_DONTWAIT, NULL);
+
+		for (int i = 0; i < framesReceived; i++) {
+			if (((canSocketFrames[i].can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != CAN_EFF_FLAG) || (canSocketFrames[i].can_dlc > CONST_PAYLOAD_LENGTH)) {
+				continue;
+			}
+
+			// Copy the CAN Header and the CAN Data
+			TwoCanUtils::ConvertIntegerToByteArray(canSocketFrames[i].can_id & CAN_EFF_MASK, &frame[0]);
+			memset(&frame[CONST_HEADER_LENGTH], 0xFF, CONST_PAYLOAD_LENGTH);
+			memcpy(&frame[CONST_HEADER_LENGTH], canSocketFrames[i].data, canSocketFrames[i].can_dlc);
+
+			if (!AcceptFrame(frame, interfaceIndex)) {
+				continue;
+			}
+
+			// Tag the frame with the interface on which it was received
+			frame[3] |= (interfaceIndex << CONST_INTERFACE_TAG_SHIFT) & CONST_INTERFACE_TAG_MASK;
+
+			postedFrames->insert(postedFrames->end(), frame, frame + CONST_FRAME_LENGTH);
+			totalFrames++;
+		}
+
+	} while (framesReceived == CONST_SOCKET_RECEIVE_FRAMES);
+
+	if ((framesReceived < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_READ);
+	}
+
+	return totalFrames;
+}
+
+// Block until frames are received or the shutdown event is signalled, frames are posted to the TwoCanDevice as a single batch
 void TwoCanSocket::Read() {
-	struct can_frame canSocketFrame;
-	std::vector<byte> postedFrame(CONST_FRAME_LENGTH);
-	int recvbytes = 0;
-	
-	while (!TestDestroy()) {
-		
-		// Reset the timeout values
-		socketTimeout.tv_sec = 0;
-		socketTimeout.tv_usec = 100;
-
-		fd_set readSet;
-		FD_ZERO(&readSet);
-		FD_SET(canSocket, &readSet);
-
-		if (select((canSocket + 1), &readSet, NULL, NULL, &socketTimeout) >= 0)	{
-
-			if (FD_ISSET(canSocket, &readSet)) {
-				recvbytes = read(canSocket, &canSocketFrame, sizeof(struct can_frame));
-				if (recvbytes > 0) {
-					// Copy the CAN Header										
-					TwoCanUtils::ConvertIntegerToByteArray(canSocketFrame.can_id,&postedFrame[0]);
-					
-					// And the CAN Data
-					for (int i = 0; i < canSocketFrame.can_dlc; i++) {
-						postedFrame[CONST_HEADER_LENGTH + i] = canSocketFrame.data[i];
-					}
-					
-					// Post frame to the TwoCanDevice
-					deviceQueue->Post(postedFrame);
-				}
+	struct epoll_event readyEvents[2];
+	std::vector<byte> postedFrames;
+	bool shutdownSignalled = false;
+
+	postedFrames.reserve(CONST_SOCKET_RECEIVE_FRAMES * CONST_FRAME_LENGTH);
+
+	while ((!shutdownSignalled) && (!TestDestroy())) {
+
+		int readyCount = epoll_wait(epollDescriptor, readyEvents, 2, -1);
+
+		for (int i = 0; i < readyCount; i++) {
+			if (readyEvents[i].data.u32 == CONST_SOCKET_SHUTDOWN_EVENT) {
+				shutdownSignalled = true;
+			}
+			else if (ReceiveFrames(canSocket, 0, &postedFrames) < 0) {
+				wxLogMessage(_T("TwoCan Socket, Read Error %s"), strerror(errno));
 			}
 		}
 
+		if (postedFrames.size() > 0) {
+			deviceQueue->Post(postedFrames);
+			postedFrames.clear();
+		}
+
 	}
 
 }
+
 // Write, Transmit a CAN frame onto the NMEA 2000 network
 int TwoCanSocket::Write(const unsigned int canId, const unsigned char payloadLength, const unsigned char *payload) {
 	struct can_frame canSocketFrame;
@@ -214,7 +349,7 @@ int TwoCanSocket::Write(const unsigned int canId, const unsigned char payloadLen
 	memcpy(canSocketFrame.data,payload,payloadLength);
 	// Now send it
 	int returnCode;
-	returnCode = write(canSocket, &canSocketFrame, sizeof(struct can_frame));
+	returnCode = send(canSocket, &canSocketFrame, sizeof(struct can_frame), MSG_DONTWAIT);
 	if (returnCode != sizeof(struct can_frame)) {
 		wxLogMessage(_T("TwoCan Socket, Write Error %s"), strerror(errno));
 		return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER,TWOCAN_ERROR_SOCKET_WRITE);
@@ -225,6 +360,82 @@ int TwoCanSocket::Write(const unsigned int canId, const unsigned char payloadLen
 
 }
 
+// Write a batch of frames using sendmmsg. If the interface's transmit queue is full (ENOBUFS) or the socket's send buffer
+// is full (EAGAIN), wait for space and retry rather than discarding the frames.
+int TwoCanSocket::WriteFrames(const CanFrame *frames, const size_t frameCount, size_t *framesWritten) {
+	struct can_frame canSocketFrames[CONST_SOCKET_BATCH_FRAMES];
+	struct iovec ioVectors[CONST_SOCKET_BATCH_FRAMES];
+	struct mmsghdr messages[CONST_SOCKET_BATCH_FRAMES];
+	unsigned long long deadline = 0;
+
+	*framesWritten = 0;
+
+	while (*framesWritten < frameCount) {
+		size_t batchCount = std::min(frameCount - *framesWritten, (size_t)CONST_SOCKET_BATCH_FRAMES);
+
+		memset(messages, 0, batchCount * sizeof(struct mmsghdr));
+		for (size_t i = 0; i < batchCount; i++) {
+			const CanFrame *frame = &frames[*framesWritten + i];
+			canSocketFrames[i].can_id = CAN_EFF_FLAG | frame->id;
+			canSocketFrames[i].can_dlc = CONST_PAYLOAD_LENGTH;
+			memcpy(canSocketFrames[i].data, frame->data, CONST_PAYLOAD_LENGTH);
+			ioVectors[i].iov_base = &canSocketFrames[i];
+			ioVectors[i].iov_len = sizeof(struct can_frame);
+			messages[i].msg_hdr.msg_iov = &ioVectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int framesSent = sendmmsg(canSocket, messages, batchCount, MSG_DONTWAIT);
+
+		if (framesSent > 0) {
+			*framesWritten += framesSent;
+			deadline = 0;
+			continue;
+		}
+
+		int lastError = errno;
+
+		if (lastError == EINTR) {
+			continue;
+		}
+
+		if ((lastError != ENOBUFS) && (lastError != EAGAIN)) {
+			wxLogMessage(_T("TwoCan Socket, Write Error %s"), strerror(lastError));
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_WRITE);
+		}
+
+		// Backpressure, give up if the queue has not drained within the timeout
+		unsigned long long now = TwoCanUtils::GetTimeInMicroseconds();
+		if (deadline == 0) {
+			deadline = now + (CONST_SOCKET_BACKPRESSURE_TIMEOUT * 1000);
+			backpressureEvents++;
+		}
+		else if (now > deadline) {
+			wxLogMessage(_T("TwoCan Socket, Transmit queue full, %d frames not sent, queue depth %d bytes"), (int)(frameCount - *framesWritten), GetTransmitQueueDepth());
+			return SET_ERROR(TWOCAN_RESULT_ERROR, TWOCAN_SOURCE_DRIVER, TWOCAN_ERROR_SOCKET_WRITE);
+		}
+
+		struct pollfd pollDescriptor = { canSocket, POLLOUT, 0 };
+		poll(&pollDescriptor, 1, 1);
+
+		// ENOBUFS is raised when the interface's queue is full, yet the socket may still report POLLOUT, so back off briefly
+		if (lastError == ENOBUFS) {
+			wxThread::Sleep(1);
+		}
+	}
+
+	return TWOCAN_RESULT_SUCCESS;
+}
+
+// Number of bytes in the socket's send queue awaiting transmission by the interface
+int TwoCanSocket::GetTransmitQueueDepth(void) {
+	int queueDepth = 0;
+	if (ioctl(canSocket, SIOCOUTQ, &queueDepth) < 0) {
+		return 0;
+	}
+	return queueDepth;
+}
+
 // Entry, the method that is executed upon thread start
 wxThread::ExitCode TwoCanSocket::Entry() {
 	// Merely loops continuously waiting for frames to be received by the CAN Adapter
@@ -234,7 +445,9 @@ wxThread::ExitCode TwoCanSocket::Entry() {
 
 // OnExit, called when thread is being destroyed
 void TwoCanSocket::OnExit() {
-	// Nothing to do ??
+	if (backpressureEvents > 0) {
+		wxLogMessage(_T("TwoCan Socket, Transmit queue full on %d occasions"), backpressureEvents);
+	}
 }
 
 															
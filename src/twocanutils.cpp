@@ -24,6 +24,8 @@
 // Owner: twocanplugin@hotmail.com
 // Date: 6/8/2018
 // Version: 1.0
+// 1.1 - 02/09/2022 Sequence identifiers for transmitted fast messages, per PGN & destination
+// 1.2 - 05/09/2022 Fast message fragmentation shared by the device & encoder
 // Outstanding Features: 
 // 1. Any additional functions ??
 //
@@ -106,12 +108,69 @@ int TwoCanUtils::DecodeCanHeader(const byte *buf, CanHeader *header) {
 	}
 }
 
+// Whether the PGN is transmitted as a multi-frame Fast Message
+bool TwoCanUtils::IsFastMessage(const unsigned int pgn) {
+	static const unsigned int nmeafastMessages[] = { 65240, 126208, 126464, 126996, 126998, 127233, 127237, 127489, 127496, 127506, 128275, 129029, 129038, \
+	129039, 129040, 129041, 129284, 129285, 129540, 129793, 129794, 129795, 129797, 129798, 129801, 129802, 129808, 129809, 129810, 130065, 130074, 130323, \
+	130577, 130820, 130822, 130824 };
+	for (size_t i = 0; i < sizeof(nmeafastMessages)/sizeof(unsigned int); i++) {
+		if (nmeafastMessages[i] == pgn) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 // Generates the ID for Fast Messages. 3 high bits are ID, lower 5 bits are the sequence number
 byte TwoCanUtils::GenerateID(byte previousSID) {
     byte tmp = (previousSID >> 5) + 1;
     return tmp == 8 ? 0: tmp << 5; 
 }
 
+// Sequence identifiers of transmitted fast messages, indexed by PGN & destination.
+// Shared by the device and the NMEA 183 encoder so that consecutive messages of the same PGN always differ
+static std::unordered_map<unsigned int, byte> sequenceIds;
+static std::mutex sequenceMutex;
+
+byte TwoCanUtils::NextSequenceId(const unsigned int pgn, const byte destination) {
+	const std::lock_guard<std::mutex> lock(sequenceMutex);
+	byte *sid = &sequenceIds[(pgn << 8) | destination];
+	byte result = *sid;
+	*sid = GenerateID(result);
+	return result;
+}
+
+// The first frame carries the sequence identifier, the length and 6 bytes, each subsequent frame the sequence identifier and 7 bytes
+// Unused bytes in the last frame are padded with 0xFF
+size_t TwoCanUtils::FragmentFastMessage(const CanHeader *header, const unsigned int payloadLength, const byte *payload, CanFrame *frames) {
+	unsigned int id;
+
+	if (payloadLength > CONST_MAX_FAST_PACKET_LENGTH) {
+		return 0;
+	}
+
+	EncodeCanHeader(&id, header);
+	byte sid = NextSequenceId(header->pgn, header->destination);
+
+	frames[0].id = id;
+	memset(frames[0].data, 0xFF, CONST_PAYLOAD_LENGTH);
+	frames[0].data[0] = sid;
+	frames[0].data[1] = payloadLength;
+	memcpy(&frames[0].data[2], payload, payloadLength < 6 ? payloadLength : 6);
+	size_t frameCount = 1;
+
+	for (unsigned int offset = 6; offset < payloadLength; offset += 7) {
+		sid += 1;
+		frames[frameCount].id = id;
+		memset(frames[frameCount].data, 0xFF, CONST_PAYLOAD_LENGTH);
+		frames[frameCount].data[0] = sid;
+		memcpy(&frames[frameCount].data[1], &payload[offset], (payloadLength - offset) < 7 ? (payloadLength - offset) : 7);
+		frameCount++;
+	}
+
+	return frameCount;
+}
+
 // Encodes a 29 bit CAN header
 int TwoCanUtils::EncodeCanHeader(unsigned int *id, const CanHeader *header) {
 	if ((id != NULL) && (header != NULL)) {
@@ -0,0 +1,135 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanEncoderBenchmark - Time taken to encode NMEA 183 sentences as NMEA 2000 frames
+// Owner: twocanplugin@hotmail.com
+// Date: 28/09/2022
+// Version History:
+// 1.0 Initial Release
+//
+// Encodes a fixed corpus of sentences through TwoCanEncoder::EncodeMessage into a reused frame arena, exactly as the
+// gateway's thread does, and reports the mean time per sentence, overall and for each sentence.
+// Coalescing is disabled so that every sentence is encoded and its frames appended.
+// Usage: twocanencoderbenchmark [passes], each pass encodes the entire corpus, the default is 10000 passes.
+
+#include "twocanencoder.h"
+
+// Sized as the gateway's frame arena
+#include "twocangateway.h"
+
+#include <wx/init.h>
+
+#include <chrono>
+
+// Globals referenced by the encoder, ordinarily defined by the plugin
+int networkAddress = 0x23;
+int supportedPGN = 0;
+bool enableWaypoint = FALSE;
+int gatewayCoalesceWindow = 0;
+const wxEventType wxEVT_SENTENCE_RECEIVED_EVENT = wxNewEventType();
+
+// Typical traffic from a GPS, compass, wind, depth & speed instruments, an autopilot and an AIS receiver
+static const char *sentenceCorpus[] = {
+	"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n",
+	"$GPGLL,4916.45,N,12311.12,W,225444,A,A*5C\r\n",
+	"$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W,A*07\r\n",
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A*25\r\n",
+	"$GPZDA,201530.00,04,07,2002,00,00*60\r\n",
+	"$HCHDG,101.1,,,7.1,W*3C\r\n",
+	"$HCHDM,098.3,M*2B\r\n",
+	"$HEHDT,274.07,T*19\r\n",
+	"$TIROT,-0.3,A*15\r\n",
+	"$IIRSA,10.5,A,,V*4D\r\n",
+	"$WIMWV,214.8,R,0.1,N,A*2D\r\n",
+	"$SDDBT,8.1,f,2.4,M,1.3,F*0B\r\n",
+	"$SDDPT,2.4,0.5,*78\r\n",
+	"$YXMTW,17.9,C*1D\r\n",
+	"$VWVHW,,T,,M,6.2,N,11.5,K*65\r\n",
+	"$GPXTE,A,A,0.67,L,N,A*02\r\n",
+	"$GPRMB,A,0.66,L,003,004,4917.24,N,12309.57,W,001.3,052.5,000.5,V,A*4D\r\n",
+	"$GPAPB,A,A,0.10,R,N,V,V,011,M,DEST,011,M,011,M,A*51\r\n",
+	"$IIXDR,C,19.52,C,TEMP,P,1.02481,B,BARO*4F\r\n",
+	"!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n"
+};
+
+#define CORPUS_SIZE (sizeof(sentenceCorpus) / sizeof(sentenceCorpus[0]))
+
+int main(int argc, char *argv[]) {
+	wxInitializer initializer;
+	if (!initializer.IsOk()) {
+		fprintf(stderr, "Unable to initialize wxWidgets\n");
+		return 1;
+	}
+
+	long passes = 10000;
+	if ((argc > 1) && ((passes = atol(argv[1])) <= 0)) {
+		fprintf(stderr, "Usage: %s [passes]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<wxString> sentences;
+	for (size_t i = 0; i < CORPUS_SIZE; i++) {
+		sentences.push_back(wxString(sentenceCorpus[i]));
+	}
+
+	TwoCanEncoder *twoCanEncoder = new TwoCanEncoder(nullptr);
+	std::vector<CanFrame> transmitFrames;
+	transmitFrames.reserve(CONST_GATEWAY_ARENA_FRAMES);
+
+	// A single pass to warm the caches and check that each sentence encodes
+	size_t frameCounts[CORPUS_SIZE];
+	for (size_t i = 0; i < CORPUS_SIZE; i++) {
+		transmitFrames.clear();
+		twoCanEncoder->EncodeMessage(sentences[i], &transmitFrames);
+		frameCounts[i] = transmitFrames.size();
+		if (frameCounts[i] == 0) {
+			fprintf(stderr, "Warning, no frames encoded for %s", sentenceCorpus[i]);
+		}
+	}
+
+	// Each sentence timed separately, then the corpus as the gateway would encode it
+	printf("Sentence  Frames  ns/sentence\n");
+	for (size_t i = 0; i < CORPUS_SIZE; i++) {
+		auto start = std::chrono::steady_clock::now();
+		for (long pass = 0; pass < passes; pass++) {
+			transmitFrames.clear();
+			twoCanEncoder->EncodeMessage(sentences[i], &transmitFrames);
+		}
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		printf("%.5s     %6d  %11.0f\n", &sentenceCorpus[i][1], (int)frameCounts[i], (double)elapsed / passes);
+	}
+
+	size_t totalFrames = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (long pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < CORPUS_SIZE; i++) {
+			transmitFrames.clear();
+			twoCanEncoder->EncodeMessage(sentences[i], &transmitFrames);
+			totalFrames += transmitFrames.size();
+		}
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("Corpus of %d sentences, %ld passes, %llu frames: %.0f ns/sentence\n", (int)CORPUS_SIZE, passes, (unsigned long long)totalFrames,
+		(double)elapsed / (passes * CORPUS_SIZE));
+
+	delete twoCanEncoder;
+	return 0;
+}
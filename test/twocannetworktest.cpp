@@ -0,0 +1,311 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanNetworkTest - Drives the network gateway interface from a local stand in for the gateway
+// Owner: twocanplugin@hotmail.com
+// Date: 28/09/2022
+// Version History:
+// 1.0 Initial Release
+//
+// Yacht Devices RAW over UDP and TCP and Actisense N2K ASCII over TCP are each exercised on the loopback interface.
+// For UDP the interface binds to the gateway's port on all addresses, so the stand in binds the same port on 127.0.0.2
+// (a more specific address) and the interface is configured to send to it. The test checks the frames received,
+// the lines transmitted, reconnection of a TCP gateway and that a partially transmitted fast message is discarded
+// when the connection is lost.
+
+#include "twocannetwork.h"
+
+#include <wx/init.h>
+
+#include <arpa/inet.h>
+#include <string>
+
+static int failures = 0;
+
+static void Check(const bool condition, const char *description) {
+	fprintf(stderr, "%s: %s\n", condition ? "PASS" : "FAIL", description);
+	if (!condition) {
+		failures++;
+	}
+}
+
+// Create a socket bound to the loopback address, if port is zero an ephemeral port is assigned and returned
+static int BindLocal(const int socketType, const char *address, unsigned short *port) {
+	int socketDescriptor = socket(AF_INET, socketType, 0);
+	if (socketDescriptor < 0) {
+		return -1;
+	}
+
+	int option = 1;
+	setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+	struct sockaddr_in localAddress;
+	socklen_t addressLength = sizeof(localAddress);
+	memset(&localAddress, 0, sizeof(localAddress));
+	localAddress.sin_family = AF_INET;
+	localAddress.sin_addr.s_addr = inet_addr(address);
+	localAddress.sin_port = htons(*port);
+	if ((bind(socketDescriptor, (struct sockaddr *)&localAddress, sizeof(localAddress)) < 0) ||
+		(getsockname(socketDescriptor, (struct sockaddr *)&localAddress, &addressLength) < 0) ||
+		((socketType == SOCK_STREAM) && (listen(socketDescriptor, 1) < 0))) {
+		fprintf(stderr, "Unable to bind %s:%u, %s\n", address, *port, strerror(errno));
+		close(socketDescriptor);
+		return -1;
+	}
+	*port = ntohs(localAddress.sin_port);
+	return socketDescriptor;
+}
+
+// Accept the interface's connection, waiting no longer than the timeout
+static int AcceptGateway(const int listenSocket, const int timeoutMillis) {
+	struct pollfd pollDescriptor = { listenSocket, POLLIN, 0 };
+	if (poll(&pollDescriptor, 1, timeoutMillis) != 1) {
+		return -1;
+	}
+	return accept(listenSocket, NULL, NULL);
+}
+
+// Read whatever the interface sends, until nothing further arrives within the timeout
+static std::string ReadGateway(const int gatewaySocket, const int timeoutMillis) {
+	std::string result;
+	char buffer[CONST_NETWORK_DATAGRAM_SIZE];
+	struct pollfd pollDescriptor = { gatewaySocket, POLLIN, 0 };
+	while (poll(&pollDescriptor, 1, timeoutMillis) > 0) {
+		ssize_t bytesRead = recv(gatewaySocket, buffer, sizeof(buffer), 0);
+		if (bytesRead <= 0) {
+			break;
+		}
+		result.append(buffer, bytesRead);
+	}
+	return result;
+}
+
+static void WriteGateway(const int gatewaySocket, const char *data) {
+	size_t length = strlen(data);
+	if (send(gatewaySocket, data, length, MSG_NOSIGNAL) != (ssize_t)length) {
+		fprintf(stderr, "Error writing to the interface: %s\n", strerror(errno));
+	}
+}
+
+// Collect the frames posted by the interface, which may arrive in one or more batches
+static std::vector<byte> ReceiveFrames(wxMessageQueue<std::vector<byte>> *queue, const size_t frameCount) {
+	std::vector<byte> frames;
+	std::vector<byte> batch;
+	while ((frames.size() < frameCount * CONST_FRAME_LENGTH) && (queue->ReceiveTimeout(1000, batch) == wxMSGQUEUE_NO_ERROR)) {
+		frames.insert(frames.end(), batch.begin(), batch.end());
+	}
+	return frames;
+}
+
+static void StopInterface(TwoCanNetwork *networkInterface) {
+	wxThread::ExitCode threadExitCode;
+	networkInterface->Interrupt();
+	networkInterface->Delete(&threadExitCode, wxTHREAD_WAIT_BLOCK);
+	networkInterface->Close();
+	delete networkInterface;
+}
+
+// PGN 127250 (Heading), priority 2, source 0x23 = CAN Id 0x09F11223
+static const byte headingFrame[CONST_FRAME_LENGTH] = { 0x23, 0x12, 0xF1, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+static const byte transmitPayload[CONST_PAYLOAD_LENGTH] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+
+static void TestYachtDevicesUdp(void) {
+	// Find an unused port, the interface binds it on all addresses and the stand in then binds it on 127.0.0.2
+	unsigned short port = 0;
+	int probeSocket = BindLocal(SOCK_DGRAM, "127.0.0.1", &port);
+	if (probeSocket < 0) {
+		Check(false, "UDP, find an unused port");
+		return;
+	}
+	close(probeSocket);
+
+	wxMessageQueue<std::vector<byte>> deviceQueue;
+	TwoCanNetwork *networkInterface = new TwoCanNetwork(&deviceQueue);
+	Check(networkInterface->Open(wxString::Format(_T("udp://127.0.0.2:%u"), port)) == TWOCAN_RESULT_SUCCESS, "UDP, open the interface");
+
+	int gatewaySocket = BindLocal(SOCK_DGRAM, "127.0.0.2", &port);
+	if ((gatewaySocket < 0) || (networkInterface->Run() != wxTHREAD_NO_ERROR)) {
+		Check(false, "UDP, start the gateway and the read thread");
+		delete networkInterface;
+		return;
+	}
+
+	// Two frames in one datagram, an echo of a transmitted frame is ignored, the final line has no terminator
+	struct sockaddr_in interfaceAddress;
+	memset(&interfaceAddress, 0, sizeof(interfaceAddress));
+	interfaceAddress.sin_family = AF_INET;
+	interfaceAddress.sin_addr.s_addr = inet_addr("127.0.0.1");
+	interfaceAddress.sin_port = htons(port);
+	const char *datagram = "09:06:35.596 R 09F11223 00 01 02 03 04 05 06 07\r\n"
+		"09:06:35.597 T 09F80203 FF FC 43 1E 00 00 FF FF\r\n"
+		"09:06:35.598 R 09F11223 F0 E0 D0 C0";
+	sendto(gatewaySocket, datagram, strlen(datagram), 0, (struct sockaddr *)&interfaceAddress, sizeof(interfaceAddress));
+
+	std::vector<byte> frames = ReceiveFrames(&deviceQueue, 2);
+	Check(frames.size() == 2 * CONST_FRAME_LENGTH, "UDP, two frames received");
+	if (frames.size() == 2 * CONST_FRAME_LENGTH) {
+		const byte secondFrame[CONST_FRAME_LENGTH] = { 0x23, 0x12, 0xF1, 0x09, 0xF0, 0xE0, 0xD0, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF };
+		Check(memcmp(&frames[0], headingFrame, CONST_FRAME_LENGTH) == 0, "UDP, frame decoded");
+		Check(memcmp(&frames[CONST_FRAME_LENGTH], secondFrame, CONST_FRAME_LENGTH) == 0, "UDP, unterminated short frame decoded and padded");
+	}
+
+	Check(networkInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, transmitPayload) == TWOCAN_RESULT_SUCCESS, "UDP, write a frame");
+	Check(ReadGateway(gatewaySocket, 200) == std::string("09F11223 01 02 03 04 05 06 07 08\r\n"), "UDP, transmitted frame encoded");
+
+	StopInterface(networkInterface);
+	close(gatewaySocket);
+}
+
+static void TestYachtDevicesTcp(void) {
+	unsigned short port = 0;
+	int listenSocket = BindLocal(SOCK_STREAM, "127.0.0.1", &port);
+	if (listenSocket < 0) {
+		Check(false, "TCP, listen for the interface");
+		return;
+	}
+
+	wxMessageQueue<std::vector<byte>> deviceQueue;
+	TwoCanNetwork *networkInterface = new TwoCanNetwork(&deviceQueue);
+	Check(networkInterface->Open(wxString::Format(_T("tcp://127.0.0.1:%u"), port)) == TWOCAN_RESULT_SUCCESS, "TCP, open the interface");
+
+	int gatewaySocket = AcceptGateway(listenSocket, 1000);
+	if ((gatewaySocket < 0) || (networkInterface->Run() != wxTHREAD_NO_ERROR)) {
+		Check(false, "TCP, accept the connection and start the read thread");
+		delete networkInterface;
+		close(listenSocket);
+		return;
+	}
+
+	// The second frame is split across two writes
+	WriteGateway(gatewaySocket, "09:06:35.596 R 09F11223 00 01 02 03 04 05 06 07\r\n09:06:35.598 R 09F11");
+	wxThread::Sleep(50);
+	WriteGateway(gatewaySocket, "223 00 01 02 03 04 05 06 07\r\n");
+
+	std::vector<byte> frames = ReceiveFrames(&deviceQueue, 2);
+	Check(frames.size() == 2 * CONST_FRAME_LENGTH, "TCP, two frames received");
+	if (frames.size() == 2 * CONST_FRAME_LENGTH) {
+		Check(memcmp(&frames[0], headingFrame, CONST_FRAME_LENGTH) == 0, "TCP, frame received in bulk decoded");
+		Check(memcmp(&frames[CONST_FRAME_LENGTH], headingFrame, CONST_FRAME_LENGTH) == 0, "TCP, frame split across reads decoded");
+	}
+
+	Check(networkInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, transmitPayload) == TWOCAN_RESULT_SUCCESS, "TCP, write a frame");
+	Check(ReadGateway(gatewaySocket, 200) == std::string("09F11223 01 02 03 04 05 06 07 08\r\n"), "TCP, transmitted frame encoded");
+
+	// Drop the connection, writes fail until the interface reconnects
+	close(gatewaySocket);
+	wxThread::Sleep(200);
+	Check(networkInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, transmitPayload) != TWOCAN_RESULT_SUCCESS, "TCP, write fails whilst disconnected");
+
+	gatewaySocket = AcceptGateway(listenSocket, 2 * CONST_NETWORK_RECONNECT + 1000);
+	Check(gatewaySocket >= 0, "TCP, interface reconnects");
+	if (gatewaySocket >= 0) {
+		// The connection may be accepted before the interface has completed reconnecting
+		wxThread::Sleep(100);
+		Check(networkInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, transmitPayload) == TWOCAN_RESULT_SUCCESS, "TCP, write after reconnection");
+		Check(ReadGateway(gatewaySocket, 200) == std::string("09F11223 01 02 03 04 05 06 07 08\r\n"), "TCP, transmitted frame encoded after reconnection");
+		close(gatewaySocket);
+	}
+
+	StopInterface(networkInterface);
+	close(listenSocket);
+}
+
+static void TestActisenseTcp(void) {
+	unsigned short port = 0;
+	int listenSocket = BindLocal(SOCK_STREAM, "127.0.0.1", &port);
+	if (listenSocket < 0) {
+		Check(false, "Actisense, listen for the interface");
+		return;
+	}
+
+	wxMessageQueue<std::vector<byte>> deviceQueue;
+	TwoCanNetwork *networkInterface = new TwoCanNetwork(&deviceQueue);
+	Check(networkInterface->Open(wxString::Format(_T("actisense://127.0.0.1:%u"), port)) == TWOCAN_RESULT_SUCCESS, "Actisense, open the interface");
+
+	int gatewaySocket = AcceptGateway(listenSocket, 1000);
+	if ((gatewaySocket < 0) || (networkInterface->Run() != wxTHREAD_NO_ERROR)) {
+		Check(false, "Actisense, accept the connection and start the read thread");
+		delete networkInterface;
+		close(listenSocket);
+		return;
+	}
+
+	// A single frame message and a fast message (PGN 129029, 10 bytes) which is fragmented into two frames
+	WriteGateway(gatewaySocket, "A091234.567 23FF2 1F112 0001020304050607\r\nA091234.568 23FF2 1F805 00010203040506070809\r\n");
+
+	std::vector<byte> frames = ReceiveFrames(&deviceQueue, 3);
+	Check(frames.size() == 3 * CONST_FRAME_LENGTH, "Actisense, three frames received");
+	if (frames.size() == 3 * CONST_FRAME_LENGTH) {
+		const byte firstFrame[CONST_FRAME_LENGTH] = { 0x23, 0x05, 0xF8, 0x09, 0x20, 0x0A, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+		const byte secondFrame[CONST_FRAME_LENGTH] = { 0x23, 0x05, 0xF8, 0x09, 0x21, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF };
+		Check(memcmp(&frames[0], headingFrame, CONST_FRAME_LENGTH) == 0, "Actisense, single frame message decoded");
+		Check(memcmp(&frames[CONST_FRAME_LENGTH], firstFrame, CONST_FRAME_LENGTH) == 0, "Actisense, fast message first frame");
+		Check(memcmp(&frames[2 * CONST_FRAME_LENGTH], secondFrame, CONST_FRAME_LENGTH) == 0, "Actisense, fast message second frame");
+	}
+
+	Check(networkInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, transmitPayload) == TWOCAN_RESULT_SUCCESS, "Actisense, write a frame");
+	Check(ReadGateway(gatewaySocket, 200) == std::string("A000000.000 23FF2 1F112 0102030405060708\r\n"), "Actisense, transmitted frame encoded");
+
+	// The frames of a fast message are reassembled and written as a single line
+	CanFrame fastFrames[2];
+	size_t framesWritten;
+	const byte firstData[CONST_PAYLOAD_LENGTH] = { 0x40, 0x0A, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+	const byte secondData[CONST_PAYLOAD_LENGTH] = { 0x41, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF };
+	fastFrames[0].id = 0x09F80523;
+	memcpy(fastFrames[0].data, firstData, CONST_PAYLOAD_LENGTH);
+	fastFrames[1].id = 0x09F80523;
+	memcpy(fastFrames[1].data, secondData, CONST_PAYLOAD_LENGTH);
+	Check((networkInterface->WriteFrames(fastFrames, 2, &framesWritten) == TWOCAN_RESULT_SUCCESS) && (framesWritten == 2), "Actisense, write a fast message");
+	Check(ReadGateway(gatewaySocket, 200) == std::string("A000000.000 23FF2 1F805 00010203040506070809\r\n"), "Actisense, fast message written as one line");
+
+	// Only the first frame is written before the connection is lost, the partial message is discarded on disconnection
+	Check(networkInterface->WriteFrames(&fastFrames[0], 1, &framesWritten) == TWOCAN_RESULT_SUCCESS, "Actisense, write the first frame of a fast message");
+	close(gatewaySocket);
+
+	gatewaySocket = AcceptGateway(listenSocket, 2 * CONST_NETWORK_RECONNECT + 1000);
+	Check(gatewaySocket >= 0, "Actisense, interface reconnects");
+	if (gatewaySocket >= 0) {
+		wxThread::Sleep(100);
+		networkInterface->WriteFrames(&fastFrames[1], 1, &framesWritten);
+		Check(ReadGateway(gatewaySocket, 200).empty(), "Actisense, partial fast message discarded on disconnection");
+		Check(networkInterface->WriteFrames(fastFrames, 2, &framesWritten) == TWOCAN_RESULT_SUCCESS, "Actisense, write a fast message after reconnection");
+		Check(ReadGateway(gatewaySocket, 200) == std::string("A000000.000 23FF2 1F805 00010203040506070809\r\n"), "Actisense, fast message written after reconnection");
+		close(gatewaySocket);
+	}
+
+	StopInterface(networkInterface);
+	close(listenSocket);
+}
+
+int main(int argc, char *argv[]) {
+	wxInitializer initializer;
+	if (!initializer.IsOk()) {
+		fprintf(stderr, "Unable to initialize wxWidgets\n");
+		return 1;
+	}
+
+	TestYachtDevicesUdp();
+	TestYachtDevicesTcp();
+	TestActisenseTcp();
+
+	fprintf(stderr, "%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
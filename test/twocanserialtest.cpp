@@ -0,0 +1,138 @@
+// Copyright(C) 2022 by Steven Adler
+//
+// This file is part of TwoCan, a plugin for OpenCPN.
+//
+// TwoCan is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TwoCan is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with TwoCan. If not, see <https://www.gnu.org/licenses/>.
+//
+// NMEA2000® is a registered Trademark of the National Marine Electronics Association
+
+// Project: TwoCan Plugin
+// Description: NMEA 2000 plugin for OpenCPN
+// Unit: TwoCanSerialTest - Drives the SLCAN serial interface from the master side of a pseudo terminal
+// Owner: twocanplugin@hotmail.com
+// Date: 28/09/2022
+// Version History:
+// 1.0 Initial Release
+//
+// The interface opens the slave side (/dev/pts/N) exactly as it would a USB adapter. The test checks the
+// adapter configuration commands, frames received in bulk and split across reads, frames that are ignored,
+// and the encoding of transmitted frames.
+
+#include "twocanserial.h"
+
+#include <wx/init.h>
+
+#include <stdlib.h>
+#include <poll.h>
+#include <string>
+
+static int failures = 0;
+
+static void Check(const bool condition, const char *description) {
+	fprintf(stderr, "%s: %s\n", condition ? "PASS" : "FAIL", description);
+	if (!condition) {
+		failures++;
+	}
+}
+
+// Read whatever the interface writes to the pseudo terminal, until nothing further arrives within the timeout
+static std::string ReadMaster(const int masterHandle, const int timeoutMillis) {
+	std::string result;
+	char buffer[256];
+	struct pollfd pollDescriptor = { masterHandle, POLLIN, 0 };
+	while (poll(&pollDescriptor, 1, timeoutMillis) > 0) {
+		ssize_t bytesRead = read(masterHandle, buffer, sizeof(buffer));
+		if (bytesRead <= 0) {
+			break;
+		}
+		result.append(buffer, bytesRead);
+	}
+	return result;
+}
+
+static void WriteMaster(const int masterHandle, const char *data) {
+	size_t length = strlen(data);
+	if (write(masterHandle, data, length) != (ssize_t)length) {
+		fprintf(stderr, "Error writing to pseudo terminal: %s\n", strerror(errno));
+	}
+}
+
+// Collect the frames posted by the interface, which may arrive in one or more batches
+static std::vector<byte> ReceiveFrames(wxMessageQueue<std::vector<byte>> *queue, const size_t frameCount) {
+	std::vector<byte> frames;
+	std::vector<byte> batch;
+	while ((frames.size() < frameCount * CONST_FRAME_LENGTH) && (queue->ReceiveTimeout(1000, batch) == wxMSGQUEUE_NO_ERROR)) {
+		frames.insert(frames.end(), batch.begin(), batch.end());
+	}
+	return frames;
+}
+
+int main(int argc, char *argv[]) {
+	wxInitializer initializer;
+	if (!initializer.IsOk()) {
+		fprintf(stderr, "Unable to initialize wxWidgets\n");
+		return 1;
+	}
+
+	int masterHandle = posix_openpt(O_RDWR | O_NOCTTY);
+	if ((masterHandle == -1) || (grantpt(masterHandle) == -1) || (unlockpt(masterHandle) == -1)) {
+		fprintf(stderr, "Unable to create pseudo terminal: %s\n", strerror(errno));
+		return 1;
+	}
+	wxString slaveName = ptsname(masterHandle);
+
+	Check(TwoCanSerial::IsSerialInterface(slaveName), "pseudo terminal is selected as a SLCAN adapter");
+	Check(!TwoCanSerial::IsSerialInterface(_T("/dev/null")), "/dev/null is not selected as a SLCAN adapter");
+	Check(!TwoCanSerial::IsSerialInterface(_T("can0")), "can0 is not selected as a SLCAN adapter");
+
+	wxMessageQueue<std::vector<byte>> deviceQueue;
+	TwoCanSerial *serialInterface = new TwoCanSerial(&deviceQueue);
+
+	Check(serialInterface->Open(slaveName) == TWOCAN_RESULT_SUCCESS, "open the pseudo terminal");
+	Check(ReadMaster(masterHandle, 200) == std::string("C\rS5\rO\r"), "close, set 250k and open the CAN bus");
+
+	if (serialInterface->Run() != wxTHREAD_NO_ERROR) {
+		fprintf(stderr, "Unable to start the read thread\n");
+		return 1;
+	}
+
+	// PGN 127250 (Heading), priority 2, source 0x23 = CAN Id 0x09F11223
+	// A bell (error response), a standard frame and a short frame are ignored, the second frame is split across two writes
+	WriteMaster(masterHandle, "\aT09F1122380001020304050607\rt12380011223344556677\rT09F1122\r");
+	WriteMaster(masterHandle, "T09F11223");
+	wxThread::Sleep(50);
+	WriteMaster(masterHandle, "4F0E0D0C0\r");
+
+	std::vector<byte> frames = ReceiveFrames(&deviceQueue, 2);
+	Check(frames.size() == 2 * CONST_FRAME_LENGTH, "two frames received");
+	if (frames.size() == 2 * CONST_FRAME_LENGTH) {
+		const byte firstFrame[CONST_FRAME_LENGTH] = { 0x23, 0x12, 0xF1, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+		const byte secondFrame[CONST_FRAME_LENGTH] = { 0x23, 0x12, 0xF1, 0x09, 0xF0, 0xE0, 0xD0, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF };
+		Check(memcmp(&frames[0], firstFrame, CONST_FRAME_LENGTH) == 0, "frame received in bulk decoded, CAN Id LSB first");
+		Check(memcmp(&frames[CONST_FRAME_LENGTH], secondFrame, CONST_FRAME_LENGTH) == 0, "frame split across reads decoded, short payload padded");
+	}
+
+	const byte payload[CONST_PAYLOAD_LENGTH] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+	Check(serialInterface->Write(0x09F11223, CONST_PAYLOAD_LENGTH, payload) == TWOCAN_RESULT_SUCCESS, "write a frame");
+	Check(ReadMaster(masterHandle, 200) == std::string("T09F1122380102030405060708\r"), "transmitted frame encoded, CAN Id MSB first");
+
+	wxThread::ExitCode threadExitCode;
+	serialInterface->Delete(&threadExitCode, wxTHREAD_WAIT_BLOCK);
+	serialInterface->Close();
+	delete serialInterface;
+	close(masterHandle);
+
+	fprintf(stderr, "%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}